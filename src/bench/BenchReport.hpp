@@ -0,0 +1,101 @@
+/* ./src/bench/BenchReport.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * BenchReport.hpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Collects repeated wall clock timings of a benchmark and
+ *              writes a summary as one JSON object per line, so runs
+ *              can be compared across builds and machines.
+ */
+
+#ifndef BENCHREPORT_HPP_
+#define BENCHREPORT_HPP_
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+
+using namespace std;
+
+class BenchReport
+{
+public:
+  BenchReport(const string filename) :
+    file_(stdout)
+  {
+    if (!filename.empty() && filename != "-")
+      {
+        file_ = fopen(filename.c_str(), "w");
+        if (file_ == NULL)
+          throw runtime_error("Cannot open benchmark output '" + filename
+              + "'");
+      }
+  }
+
+  ~BenchReport()
+  {
+    if (file_ != stdout)
+      fclose(file_);
+  }
+
+  // Writes the header record describing the data set
+  void
+  header(const string& data, const size_t popSize, const size_t numInfected,
+      const int reps)
+  {
+    fprintf(file_,
+        "{\"record\":\"header\",\"data\":\"%s\",\"popsize\":%lu,\"infected\":%lu,\"reps\":%d,\"threads\":%d}\n",
+        data.c_str(), popSize, numInfected, reps, omp_get_max_threads());
+    fflush(file_);
+  }
+
+  // Writes a summary of seconds, one entry per repetition, each of
+  // which processed items units of work
+  void
+  write(const string& name, vector<double> seconds, const double items = 1.0)
+  {
+    if (seconds.empty())
+      return;
+
+    sort(seconds.begin(), seconds.end());
+    double total = 0.0;
+    for (size_t k = 0; k < seconds.size(); ++k)
+      total += seconds[k];
+    double median = seconds[seconds.size() / 2];
+
+    fprintf(file_,
+        "{\"record\":\"bench\",\"name\":\"%s\",\"reps\":%lu,\"min\":%.9f,\"median\":%.9f,\"mean\":%.9f,\"items\":%.0f,\"per_sec\":%.3f}\n",
+        name.c_str(), seconds.size(), seconds.front(), median, total
+            / seconds.size(), items, median > 0.0 ? items / median : 0.0);
+    fflush(file_);
+  }
+
+private:
+  FILE* file_;
+};
+
+#endif /* BENCHREPORT_HPP_ */
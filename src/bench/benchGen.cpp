@@ -0,0 +1,401 @@
+/* ./src/bench/benchGen.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * benchGen.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Generates a synthetic population and epidemic in the
+ *              file formats read by sinrEpi::init and
+ *              GillespieSim::loadCovariates, for benchmarking without
+ *              field data.  The same seed gives the same files.
+ *
+ * USAGE:
+ *
+ *   benchGen <output prefix> <pop size> <num infections> [premises per km^2]
+ *            [network density] [seed]
+ *
+ * Writes <prefix>.{fm,sh,cp,freq,sp}, <prefix>_dist.txt, and the
+ * epidemic <prefix>.{ipt,dc,ni,contact.xml}.  The observation time
+ * is printed on exit and must be passed to benchMCMC and benchGillespie.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <gsl/gsl_math.h>
+
+#include "CTStreamWriter.hpp"
+
+using namespace std;
+
+#define NUMSPECIES 9
+#define DISTCUTOFF 15.0  // km; pairs further apart are not written
+#define CTWINDOW 21.0    // Days of contact tracing before notification
+#define CTRATE 0.5       // Traced contacts per day
+#define PROBCTINFEC 0.3  // Probability an infection is by a traced contact
+
+struct Premises
+{
+  double x, y;
+  int group[3]; // Feedmill, slaughterhouse and company
+  double I, N, R;
+  size_t parent;
+  bool infected, dc, byContact;
+
+  Premises() :
+    x(0.0), y(0.0), I(GSL_POSINF), N(GSL_POSINF), R(GSL_POSINF), parent(0),
+        infected(false), dc(false), byContact(false)
+  {
+    group[0] = group[1] = group[2] = 0;
+  }
+};
+
+static const char* networkSuffix[3] =
+  { ".fm", ".sh", ".cp" };
+static const char* networkType[3] =
+  { "feedmill", "shouse", "company" };
+
+
+
+void
+writeNetwork(const string filename, const vector<Premises>& pop,
+    const int net)
+{
+  // Lower triangle of the 0/1 matrix for one network
+  ofstream file(filename.c_str());
+  if (!file.is_open())
+    throw runtime_error("Cannot open " + filename);
+
+  string line;
+  for (size_t i = 0; i < pop.size(); ++i)
+    {
+      line.assign(i + 1, '0');
+      for (size_t j = 0; j < i; ++j)
+        if (pop[i].group[net] == pop[j].group[net])
+          line[j] = '1';
+      file << line << "\n";
+    }
+}
+
+
+
+void
+findNeighbours(const vector<Premises>& pop, const double side,
+    vector<vector<size_t> >& neighbours, vector<vector<double> >& dists)
+{
+  // Pairs within DISTCUTOFF, using a grid of DISTCUTOFF sized cells
+  int cells = max(1, (int) (side / DISTCUTOFF));
+  double cellSize = side / cells;
+  vector<vector<size_t> > grid(cells * cells);
+  for (size_t i = 0; i < pop.size(); ++i)
+    {
+      int cx = min(cells - 1, (int) (pop[i].x / cellSize));
+      int cy = min(cells - 1, (int) (pop[i].y / cellSize));
+      grid[cx + cells * cy].push_back(i);
+    }
+
+  neighbours.assign(pop.size(), vector<size_t> ());
+  dists.assign(pop.size(), vector<double> ());
+  for (size_t i = 0; i < pop.size(); ++i)
+    {
+      int cx = min(cells - 1, (int) (pop[i].x / cellSize));
+      int cy = min(cells - 1, (int) (pop[i].y / cellSize));
+      for (int gx = max(0, cx - 1); gx <= min(cells - 1, cx + 1); ++gx)
+        for (int gy = max(0, cy - 1); gy <= min(cells - 1, cy + 1); ++gy)
+          {
+            const vector<size_t>& cell = grid[gx + cells * gy];
+            for (size_t k = 0; k < cell.size(); ++k)
+              {
+                size_t j = cell[k];
+                if (j == i)
+                  continue;
+                double d = hypot(pop[i].x - pop[j].x, pop[i].y - pop[j].y);
+                if (d < DISTCUTOFF)
+                  {
+                    neighbours[i].push_back(j);
+                    dists[i].push_back(d);
+                  }
+              }
+          }
+    }
+}
+
+
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 4)
+    {
+      cerr
+          << "Usage: benchGen <output prefix> <pop size> <num infections> [premises per km^2] [network density] [seed]"
+          << endl;
+      return 1;
+    }
+
+  string prefix = argv[1];
+  size_t popSize = atoi(argv[2]);
+  size_t numInfec = atoi(argv[3]);
+  double density = argc > 4 ? atof(argv[4]) : 1.0;
+  double netDensity = argc > 5 ? atof(argv[5]) : 0.01;
+  unsigned long seed = argc > 6 ? atol(argv[6]) : 1;
+
+  if (popSize < 2 || numInfec < 1 || numInfec > popSize / 2 || density
+      <= 0.0 || netDensity <= 0.0 || netDensity > 1.0)
+    {
+      cerr << "Invalid arguments: need 1 <= infections <= pop size/2, "
+          << "density > 0 and 0 < network density <= 1" << endl;
+      return 1;
+    }
+
+  gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, seed);
+
+  try
+    {
+      // Locations, species and network memberships
+      double side = sqrt(popSize / density);
+      int numGroups = max(1, (int) floor(1.0 / netDensity + 0.5));
+      vector<Premises> pop(popSize);
+      vector<vector<size_t> > members[3];
+      for (int net = 0; net < 3; ++net)
+        members[net].resize(numGroups);
+
+      for (size_t i = 0; i < popSize; ++i)
+        {
+          pop[i].x = gsl_rng_uniform(rng) * side;
+          pop[i].y = gsl_rng_uniform(rng) * side;
+          for (int net = 0; net < 3; ++net)
+            {
+              pop[i].group[net] = gsl_rng_uniform_int(rng, numGroups);
+              members[net][pop[i].group[net]].push_back(i);
+            }
+        }
+
+      for (int net = 0; net < 3; ++net)
+        writeNetwork(prefix + networkSuffix[net], pop, net);
+
+      ofstream freq((prefix + ".freq").c_str());
+      ofstream sp((prefix + ".sp").c_str());
+      if (!freq.is_open() || !sp.is_open())
+        throw runtime_error("Cannot open .freq or .sp file");
+      for (size_t i = 0; i < popSize; ++i)
+        {
+          freq << gsl_ran_gamma(rng, 2.0, 0.5) << " " << gsl_ran_gamma(rng,
+              2.0, 0.5) << " " << gsl_ran_gamma(rng, 2.0, 0.5) << " "
+              << gsl_ran_gamma(rng, 2.0, 0.5) << "\n";
+
+          string species(NUMSPECIES, '0');
+          species[gsl_rng_uniform_int(rng, NUMSPECIES)] = '1';
+          sp << species << "\n";
+        }
+
+      // Distances.  The trailing space is stripped by GillespieSim.
+      vector<vector<size_t> > neighbours;
+      vector<vector<double> > dists;
+      findNeighbours(pop, side, neighbours, dists);
+      FILE* distFile = fopen((prefix + "_dist.txt").c_str(), "w");
+      if (distFile == NULL)
+        throw runtime_error("Cannot open distance file");
+      size_t numPairs = 0;
+      for (size_t i = 0; i < popSize; ++i)
+        for (size_t k = 0; k < neighbours[i].size(); ++k)
+          {
+            fprintf(distFile, "%lu %lu %.3f \n", i, neighbours[i][k],
+                dists[i][k]);
+            ++numPairs;
+          }
+      fclose(distFile);
+
+      // Epidemic: each infection has a parent infected while the
+      // parent was infectious, mostly a spatial neighbour
+      vector<size_t> infected;
+      size_t index = gsl_rng_uniform_int(rng, popSize);
+      pop[index].infected = true;
+      pop[index].I = 0.0;
+      pop[index].parent = index;
+      infected.push_back(index);
+
+      while (infected.size() < numInfec)
+        {
+          Premises& parent = pop[infected[gsl_rng_uniform_int(rng,
+              infected.size())]];
+          size_t parentLabel = &parent - &pop[0];
+          if (parent.N == GSL_POSINF)
+            parent.N = parent.I + 4.0 + gsl_ran_exponential(rng, 3.0);
+
+          size_t child;
+          if (!neighbours[parentLabel].empty() && gsl_rng_uniform(rng) < 0.7)
+            child = neighbours[parentLabel][gsl_rng_uniform_int(rng,
+                neighbours[parentLabel].size())];
+          else
+            child = gsl_rng_uniform_int(rng, popSize);
+          if (pop[child].infected)
+            continue;
+
+          pop[child].infected = true;
+          pop[child].I = parent.I + gsl_rng_uniform_pos(rng) * (parent.N
+              - parent.I);
+          pop[child].parent = parentLabel;
+          pop[child].byContact = gsl_rng_uniform(rng) < PROBCTINFEC;
+          infected.push_back(child);
+        }
+
+      vector<double> notifTimes;
+      for (size_t k = 0; k < infected.size(); ++k)
+        {
+          Premises& p = pop[infected[k]];
+          if (p.N == GSL_POSINF)
+            p.N = p.I + 4.0 + gsl_ran_exponential(rng, 3.0);
+          p.R = p.N + 1.0;
+          notifTimes.push_back(p.N);
+        }
+
+      // Observe up to the 90th percentile of notification times, so
+      // about a tenth of the infections are occult
+      sort(notifTimes.begin(), notifTimes.end());
+      double obsTime = notifTimes[(notifTimes.size() * 9) / 10] + 1e-3;
+
+      // Dangerous contacts: culled neighbours of known infections
+      vector<size_t> dcs;
+      for (size_t k = 0; k < infected.size() && dcs.size() < numInfec / 5; ++k)
+        {
+          const Premises& p = pop[infected[k]];
+          size_t label = infected[k];
+          if (p.N >= obsTime - 1.0 || neighbours[label].empty())
+            continue;
+          size_t dc = neighbours[label][gsl_rng_uniform_int(rng,
+              neighbours[label].size())];
+          if (pop[dc].infected || pop[dc].dc)
+            continue;
+          pop[dc].dc = true;
+          pop[dc].N = pop[dc].R = p.N + gsl_rng_uniform_pos(rng);
+          dcs.push_back(dc);
+        }
+
+      // Epidemic files
+      ofstream ipt((prefix + ".ipt").c_str());
+      ofstream dc((prefix + ".dc").c_str());
+      ofstream ni((prefix + ".ni").c_str());
+      if (!ipt.is_open() || !dc.is_open() || !ni.is_open())
+        throw runtime_error("Cannot open epidemic files");
+      ipt.precision(9);
+      dc.precision(9);
+      ni.precision(9);
+
+      size_t numKnown = 0;
+      for (size_t k = 0; k < infected.size(); ++k)
+        {
+          const Premises& p = pop[infected[k]];
+          if (p.N >= obsTime)
+            continue;
+          ipt << infected[k] << " " << p.I << " " << p.N << " " << min(p.R,
+              obsTime) << "\n";
+          if (gsl_rng_uniform(rng) < 0.1)
+            ni << infected[k] << " " << p.I - gsl_rng_uniform(rng) * 5.0
+                << "\n";
+          ++numKnown;
+        }
+      for (size_t k = 0; k < dcs.size(); ++k)
+        {
+          const Premises& p = pop[dcs[k]];
+          dc << dcs[k] << " " << p.N << " " << p.R << "\n";
+          ni << dcs[k] << " " << p.N - 2.0 << "\n";
+        }
+
+      // Contact tracing, one block per known infection.  Each traced
+      // contact is written once, in the block of a known individual.
+      CTStreamWriter ct(prefix + ".contact.xml", CTStreamWriter::XMLFORMAT);
+      unsigned char typeCode[3];
+      for (int net = 0; net < 3; ++net)
+        typeCode[net] = ct.typeCode(networkType[net]);
+
+      vector<vector<CTRecord> > blocks(popSize);
+      for (size_t k = 1; k < infected.size(); ++k)
+        {
+          size_t label = infected[k];
+          const Premises& p = pop[label];
+          const Premises& parent = pop[p.parent];
+          if (!p.byContact)
+            continue;
+
+          unsigned char type = typeCode[gsl_rng_uniform_int(rng, 3)];
+          if (p.N < obsTime && p.I >= p.N - CTWINDOW)
+            blocks[label].push_back(CTRecord(p.parent, true, type, p.I, true));
+          else if (parent.N < obsTime && p.I >= parent.N - CTWINDOW)
+            blocks[p.parent].push_back(CTRecord(label, false, type, p.I, true));
+        }
+
+      size_t numContacts = 0;
+      for (size_t k = 0; k < infected.size(); ++k)
+        {
+          size_t label = infected[k];
+          const Premises& p = pop[label];
+          if (p.N >= obsTime)
+            continue;
+
+          double start = p.N - CTWINDOW;
+          vector<CTRecord>& block = blocks[label];
+          unsigned int n = gsl_ran_poisson(rng, CTRATE * CTWINDOW);
+          for (unsigned int c = 0; c < n; ++c)
+            {
+              int net = gsl_rng_uniform_int(rng, 3);
+              const vector<size_t>& group = members[net][p.group[net]];
+              size_t other = group[gsl_rng_uniform_int(rng, group.size())];
+              if (other == label)
+                continue;
+              block.push_back(CTRecord(other, gsl_rng_uniform(rng) < 0.5,
+                  typeCode[net], start + gsl_rng_uniform_pos(rng) * CTWINDOW));
+            }
+          sort(block.begin(), block.end());
+          ct.writeBlock(label, start, block);
+          numContacts += block.size();
+        }
+      ct.close();
+
+      cout << "Population: " << popSize << " premises, " << numPairs
+          << " distance pairs, " << numGroups << " groups per network" << endl;
+      cout << "Epidemic: " << infected.size() << " infections, " << numKnown
+          << " known, " << dcs.size() << " DCs, " << numContacts
+          << " traced contacts" << endl;
+      cout.precision(9);
+      cout << "Observation time: " << obsTime << endl;
+    }
+  catch (exception& e)
+    {
+      cerr << "Error generating data: " << e.what() << endl;
+      gsl_rng_free(rng);
+      return 2;
+    }
+
+  gsl_rng_free(rng);
+  return 0;
+}
@@ -0,0 +1,153 @@
+/* ./src/bench/benchGillespie.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * benchGillespie.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Times the GillespieSim loaders and simulation on a data
+ *              set written by benchGen.  Each repetition simulates from
+ *              a different index case, drawn from a fixed seed.
+ *              "prepare" is the set up of the initial state, including
+ *              the contact rates, and "restore" the return to it from a
+ *              snapshot, which "simulate" includes.
+ *
+ * USAGE:
+ *
+ *   benchGillespie <data prefix> <pop size> <obs time> [reps] [max time] [output] [seed]
+ *
+ * Results are written as one JSON object per line to output (default
+ * <data prefix>.gillespie.bench), or to stdout if output is "-".
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl_rng.h>
+#include <omp.h>
+
+#include "GillespieSim.hpp"
+#include "BenchReport.hpp"
+
+using namespace std;
+
+#define NUMPARMS ModelTraits::numParms  // See ModelTraits.hpp
+
+// Parameter values as in aiGillespieConfTemplate.xml
+static const double benchParms[NUMPARMS] =
+  { 1e-6, 0.8, 0.6, 0.008, 0.018, 0.0074, 0.2, 0.6, 0.3, 0.3, 0.3, 0.3, 0.3,
+      0.3, 0.3, 0.3 };
+
+// Incubation (extreme value) and notification to removal time
+#define BENCH_A 0.1
+#define BENCH_B 0.5
+#define BENCH_C 1.0
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 4)
+    {
+      cerr
+          << "Usage: benchGillespie <data prefix> <pop size> <obs time> [reps] [max time] [output] [seed]"
+          << endl;
+      return 1;
+    }
+
+  string prefix = argv[1];
+  size_t popSize = atoi(argv[2]);
+  double obsTime = atof(argv[3]);
+  int reps = argc > 4 ? atoi(argv[4]) : 5;
+  double maxTime = argc > 5 ? atof(argv[5]) : obsTime;
+  string output = argc > 6 ? argv[6] : prefix + ".gillespie.bench";
+  unsigned long seed = argc > 7 ? atol(argv[7]) : 1;
+
+  vector<double> params(benchParms, benchParms + NUMPARMS);
+  vector<double> tCovariates, tEpiData, tPrepare, tRestore, tSimulate,
+      tPerEvent;
+  double numEvents = 0.0;
+
+  try
+    {
+      BenchReport report(output);
+      report.header(prefix, popSize, 0, reps);
+
+      for (int r = 0; r < reps; ++r)
+        {
+          // GillespieSim frees its rng
+          gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
+          gsl_rng_set(rng, seed + r);
+          GillespieSim simulation(popSize, rng);
+
+          double t = omp_get_wtime();
+          simulation.loadCovariates(prefix);
+          tCovariates.push_back(omp_get_wtime() - t);
+
+          t = omp_get_wtime();
+          simulation.loadEpiData(prefix + ".ipt", obsTime, BENCH_A, BENCH_B,
+              BENCH_C);
+          tEpiData.push_back(omp_get_wtime() - t);
+
+          simulation.resetPopulation();
+          simulation.setStartTime(0.0);
+          simulation.setMaxTime(maxTime);
+          simulation.setMaxN(popSize);
+          double inTime = simulation.rng_extreme(BENCH_A, BENCH_B);
+          simulation.setIndexCase(gsl_rng_uniform_int(rng, popSize), 0.0,
+              inTime, inTime + BENCH_C);
+
+          t = omp_get_wtime();
+          simulation.prepare(params, BENCH_A, BENCH_B, BENCH_C);
+          tPrepare.push_back(omp_get_wtime() - t);
+
+          boost::shared_ptr<const GillespieSim::Snapshot> state =
+              simulation.snapshot();
+          t = omp_get_wtime();
+          simulation.restore(*state);
+          tRestore.push_back(omp_get_wtime() - t);
+
+          t = omp_get_wtime();
+          simulation.simulate(*state);
+          t = omp_get_wtime() - t;
+
+          tSimulate.push_back(t);
+          numEvents += simulation.numEvents();
+          if (simulation.numEvents() > 0)
+            tPerEvent.push_back(t / simulation.numEvents());
+        }
+
+      report.write("loadCovariates", tCovariates);
+      report.write("loadEpiData", tEpiData);
+      report.write("prepare", tPrepare);
+      report.write("restore", tRestore);
+      report.write("simulate", tSimulate, numEvents / reps);
+      report.write("simulate_event", tPerEvent);
+    }
+  catch (exception& e)
+    {
+      cerr << "Benchmark failed: " << e.what() << endl;
+      return 2;
+    }
+
+  return 0;
+}
@@ -0,0 +1,395 @@
+/* ./src/bench/benchMCMC.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * benchMCMC.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Times the epiMCMC data loaders and likelihood functions
+ *              on a data set written by benchGen.  Moves, additions and
+ *              deletions are drawn from a fixed seed and never accepted
+ *              (except the initial occults), so runs are repeatable.
+ *
+ * USAGE:
+ *
+ *   benchMCMC <data prefix> <pop size> <obs time> [reps] [moves] [output] [seed]
+ *
+ * Results are written as one JSON object per line to output (default
+ * <data prefix>.mcmc.bench), or to stdout if output is "-".
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <omp.h>
+
+#include "aifuncs.h"
+#include "BenchReport.hpp"
+
+using namespace std;
+
+#define NUMPARMS ModelTraits::numParms  // See ModelTraits.hpp
+#define NUMSPECIES ModelTraits::numSpecies
+
+// Globals required by aifuncs and random.cpp
+int total_pop_size;
+double ObsTime;
+McmcProfiler profiler;
+gsl_rng* rng;
+
+// Parameter values as in aiGillespieConfTemplate.xml
+static const double benchParms[NUMPARMS] =
+  { 1e-6, 0.8, 0.6, 0.008, 0.018, 0.0074, 0.2, 0.6, 0.3, 0.3, 0.3, 0.3, 0.3,
+      0.3, 0.3, 0.3 };
+
+
+
+void
+benchLoaders(BenchReport& report, const string& prefix, const size_t popSize,
+    const int reps)
+{
+  vector<double> whole, fm, species, contacts;
+  string distFile = prefix + "_dist.txt";
+
+  for (int r = 0; r < reps; ++r)
+    {
+      double t = omp_get_wtime();
+      {
+        sinrEpi data;
+        data.init(popSize, prefix.c_str(), prefix.c_str(), distFile.c_str(),
+            NUMSPECIES, ObsTime);
+        whole.push_back(omp_get_wtime() - t);
+      }
+
+      t = omp_get_wtime();
+      {
+        contactMat mat;
+        if (mat.init((prefix + ".fm").c_str(), popSize) != 0)
+          throw runtime_error("Cannot read feedmill matrix");
+        fm.push_back(omp_get_wtime() - t);
+      }
+
+      t = omp_get_wtime();
+      {
+        SpeciesMatrix mat;
+        if (mat.initialize((prefix + ".sp").c_str(), popSize, NUMSPECIES) != 0)
+          throw runtime_error("Cannot read species file");
+        species.push_back(omp_get_wtime() - t);
+      }
+
+      vector<infection> individuals;
+      for (size_t i = 0; i < popSize; ++i)
+        individuals.push_back(infection(i, ObsTime, ObsTime, ObsTime, 0,
+            SUSCEPTIBLE));
+      t = omp_get_wtime();
+      SAXContactParse((prefix + ".contact.xml").c_str(), individuals);
+      contacts.push_back(omp_get_wtime() - t);
+    }
+
+  report.write("load_sinrEpi", whole);
+  report.write("load_contact_matrix", fm);
+  report.write("load_species", species);
+  report.write("load_contact_xml", contacts);
+}
+
+
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 4)
+    {
+      cerr
+          << "Usage: benchMCMC <data prefix> <pop size> <obs time> [reps] [moves] [output] [seed]"
+          << endl;
+      return 1;
+    }
+
+  string prefix = argv[1];
+  size_t popSize = atoi(argv[2]);
+  ObsTime = atof(argv[3]);
+  int reps = argc > 4 ? atoi(argv[4]) : 5;
+  int numMoves = argc > 5 ? atoi(argv[5]) : 1000;
+  string output = argc > 6 ? argv[6] : prefix + ".mcmc.bench";
+  unsigned long seed = argc > 7 ? atol(argv[7]) : 1;
+  total_pop_size = popSize;
+
+  gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, seed);
+
+  try
+    {
+      BenchReport report(output);
+
+      sinrEpi epidata;
+      string distFile = prefix + "_dist.txt";
+      if (epidata.init(popSize, prefix.c_str(), prefix.c_str(),
+          distFile.c_str(), NUMSPECIES, ObsTime) != 0)
+        throw runtime_error("Cannot initialise data from " + prefix);
+
+      epiParms parms(NUMPARMS);
+      for (size_t k = 0; k < NUMPARMS; ++k)
+        parms.beta[k] = benchParms[k];
+      parms.f = 60.0;
+      parms.g = 1.3;
+
+      initSpatialKernel(epidata, SpatialKernel::EXPONENTIAL);
+      prepareSpatialKernel(parms);
+      prepareSusceptibility(parms, epidata);
+      initConnections(parms, epidata);
+      initContactCache(epidata);
+      initInfecKernel(parms, 1e-10, false);
+      epidata.updateI1();
+
+      // Impute occults, one for every ten known infections, so the
+      // delete and move benchmarks see a realistic state
+      vector<double> prodCurr(epidata.infected.size());
+      vector<double> prodCan;
+      compute_log_prod_pressure(parms, epidata, &prodCurr);
+      size_t numOccults = epidata.knownInfections / 10 + 1;
+      while (epidata.numAdditions() < numOccults)
+        {
+          double I = ObsTime - gsl_ran_exponential(rng, 5.0);
+          if (I <= epidata.infected[epidata.I1]->I)
+            continue;
+          epidata.addInfec(gsl_rng_uniform_int(rng, epidata.susceptible.size()),
+              I, ObsTime, ObsTime);
+          double logProd = 0.0;
+          prodCan = prodCurr;
+          addInfec_log_prod(parms, epidata, logProd, &prodCurr, &prodCan);
+          prodCurr = prodCan;
+        }
+
+      report.header(prefix, popSize, epidata.infected.size(), reps);
+      benchLoaders(report, prefix, popSize, reps);
+
+      // Full likelihood components
+      vector<double> tLogProd, tA1, tA2, tBgPress, tLogCT, tLik;
+      LikComponents lik;
+      for (int r = 0; r < reps; ++r)
+        {
+          double t = omp_get_wtime();
+          lik.logProd = compute_log_prod_pressure(parms, epidata, &prodCurr);
+          tLogProd.push_back(omp_get_wtime() - t);
+
+          t = omp_get_wtime();
+          lik.A1 = compute_A1(parms, epidata);
+          tA1.push_back(omp_get_wtime() - t);
+
+          t = omp_get_wtime();
+          lik.A2 = compute_A2(parms, epidata);
+          tA2.push_back(omp_get_wtime() - t);
+
+          t = omp_get_wtime();
+          lik.bgPress = compute_bgPress(parms, epidata);
+          tBgPress.push_back(omp_get_wtime() - t);
+
+          t = omp_get_wtime();
+          lik.logCT = computeLogCT(parms, epidata);
+          tLogCT.push_back(omp_get_wtime() - t);
+
+          t = omp_get_wtime();
+          computeLikelihood(parms, epidata, &prodCurr, lik);
+          tLik.push_back(omp_get_wtime() - t);
+        }
+      report.write("compute_log_prod_pressure", tLogProd);
+      report.write("compute_A1", tA1);
+      report.write("compute_A2", tA2);
+      report.write("compute_bgPress", tBgPress);
+      report.write("computeLogCT", tLogCT);
+      report.write("computeLikelihood", tLik);
+      prodCan = prodCurr;
+
+      cerr << "logProd=" << lik.logProd << " bgPress=" << lik.bgPress
+          << " A1=" << lik.A1 << " A2=" << lik.A2 << " logCT=" << lik.logCT
+          << endl;
+
+      // Infection time moves
+      vector<int> moveIndex;
+      vector<double> moveI;
+      while ((int) moveIndex.size() < numMoves)
+        {
+          int m = gsl_rng_uniform_int(rng, epidata.infected.size());
+          const infection* indiv = epidata.infected[m];
+          double I = indiv->I + gsl_ran_gaussian(rng, 1.0);
+          if (I >= indiv->N || I < indiv->niAt)
+            continue;
+          moveIndex.push_back(m);
+          moveI.push_back(I);
+        }
+
+      vector<double> tuLogProd, tuLogCT, tuBgPress, tuA1, tuA2, tuLik;
+      for (int r = 0; r < reps; ++r)
+        {
+          double sLogProd = 0, sLogCT = 0, sBgPress = 0, sA1 = 0, sA2 = 0,
+              sLik = 0;
+          for (int k = 0; k < numMoves; ++k)
+            {
+              int m = moveIndex[k];
+              parms.Ican = moveI[k];
+
+              double t = omp_get_wtime();
+              update_log_prod(m, parms, epidata, lik.logProd, &prodCurr,
+                  &prodCan);
+              sLogProd += omp_get_wtime() - t;
+              prodCan = prodCurr;
+
+              t = omp_get_wtime();
+              update_logCT(m, parms, epidata, lik.logCT);
+              sLogCT += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              update_bgPress(m, parms, epidata, lik.bgPress);
+              sBgPress += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              update_A1(m, parms, epidata, lik.A1);
+              sA1 += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              update_A2(m, parms, epidata, lik.A2);
+              sA2 += omp_get_wtime() - t;
+
+              LikComponents likCan;
+              t = omp_get_wtime();
+              updateLikelihood(m, parms, epidata, lik, &prodCurr, &prodCan,
+                  likCan);
+              sLik += omp_get_wtime() - t;
+              prodCan = prodCurr;
+            }
+          tuLogProd.push_back(sLogProd);
+          tuLogCT.push_back(sLogCT);
+          tuBgPress.push_back(sBgPress);
+          tuA1.push_back(sA1);
+          tuA2.push_back(sA2);
+          tuLik.push_back(sLik);
+        }
+      report.write("update_log_prod", tuLogProd, numMoves);
+      report.write("update_logCT", tuLogCT, numMoves);
+      report.write("update_bgPress", tuBgPress, numMoves);
+      report.write("update_A1", tuA1, numMoves);
+      report.write("update_A2", tuA2, numMoves);
+      report.write("updateLikelihood", tuLik, numMoves);
+
+      // Additions, each undone before the next
+      vector<double> taLogProd, taLogCT, taBgPress, taA1, taA2;
+      vector<double> tdLogProd, tdLogCT, tdBgPress, tdA1, tdA2;
+      for (int r = 0; r < reps; ++r)
+        {
+          double sLogProd = 0, sLogCT = 0, sBgPress = 0, sA1 = 0, sA2 = 0;
+          for (int k = 0; k < numMoves; ++k)
+            {
+              double I = ObsTime - gsl_ran_exponential(rng, 5.0);
+              if (I <= epidata.infected[epidata.I1]->I)
+                I = ObsTime;
+              epidata.addInfec(gsl_rng_uniform_int(rng,
+                  epidata.susceptible.size()), I, ObsTime, ObsTime);
+
+              double t = omp_get_wtime();
+              addInfec_log_prod(parms, epidata, lik.logProd, &prodCurr,
+                  &prodCan);
+              sLogProd += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              addInfec_logCT(parms, epidata, lik.logCT);
+              sLogCT += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              addInfec_bgPress(parms, epidata, lik.bgPress);
+              sBgPress += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              addInfec_A1(parms, epidata, lik.A1);
+              sA1 += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              addInfec_A2(parms, epidata, lik.A2);
+              sA2 += omp_get_wtime() - t;
+
+              epidata.delInfec(epidata.infected.size() - 1);
+              prodCan = prodCurr;
+            }
+          taLogProd.push_back(sLogProd);
+          taLogCT.push_back(sLogCT);
+          taBgPress.push_back(sBgPress);
+          taA1.push_back(sA1);
+          taA2.push_back(sA2);
+
+          // Deletions of the imputed occults
+          sLogProd = sLogCT = sBgPress = sA1 = sA2 = 0;
+          for (int k = 0; k < numMoves; ++k)
+            {
+              int m = epidata.knownInfections + gsl_rng_uniform_int(rng,
+                  epidata.numAdditions());
+
+              double t = omp_get_wtime();
+              delInfec_log_prod(m, parms, epidata, lik.logProd, &prodCurr,
+                  &prodCan);
+              sLogProd += omp_get_wtime() - t;
+              prodCan = prodCurr;
+
+              t = omp_get_wtime();
+              delInfec_logCT(m, parms, epidata, lik.logCT);
+              sLogCT += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              delInfec_bgPress(m, parms, epidata, lik.bgPress);
+              sBgPress += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              delInfec_A1(m, parms, epidata, lik.A1);
+              sA1 += omp_get_wtime() - t;
+
+              t = omp_get_wtime();
+              delInfec_A2(m, parms, epidata, lik.A2);
+              sA2 += omp_get_wtime() - t;
+            }
+          tdLogProd.push_back(sLogProd);
+          tdLogCT.push_back(sLogCT);
+          tdBgPress.push_back(sBgPress);
+          tdA1.push_back(sA1);
+          tdA2.push_back(sA2);
+        }
+      report.write("addInfec_log_prod", taLogProd, numMoves);
+      report.write("addInfec_logCT", taLogCT, numMoves);
+      report.write("addInfec_bgPress", taBgPress, numMoves);
+      report.write("addInfec_A1", taA1, numMoves);
+      report.write("addInfec_A2", taA2, numMoves);
+      report.write("delInfec_log_prod", tdLogProd, numMoves);
+      report.write("delInfec_logCT", tdLogCT, numMoves);
+      report.write("delInfec_bgPress", tdBgPress, numMoves);
+      report.write("delInfec_A1", tdA1, numMoves);
+      report.write("delInfec_A2", tdA2, numMoves);
+    }
+  catch (exception& e)
+    {
+      cerr << "Benchmark failed: " << e.what() << endl;
+      gsl_rng_free(rng);
+      return 2;
+    }
+
+  gsl_rng_free(rng);
+  return 0;
+}
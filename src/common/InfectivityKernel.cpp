@@ -0,0 +1,233 @@
+/* ./src/common/InfectivityKernel.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * InfectivityKernel.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "InfectivityKernel.hpp"
+
+// Upper limit on the table size, beyond which we fall back to EXACT
+#define MAXCELLS (1 << 20)
+#define MAXREFINE 12
+
+
+InfectivityKernel::InfectivityKernel() :
+  f_(0.0), g_(0.0), step_(0.0), invStep_(0.0), tTable_(0.0), tSat_(0.0),
+      HSatOffset_(0.0), maxRelError_(0.0), mode_(EXACT)
+{
+}
+
+
+
+void
+InfectivityKernel::set(const double f, const double g, const double relTol,
+    const double tMax)
+{
+  f_ = f;
+  g_ = g;
+  mode_ = EXACT;
+  hCoef_.clear();
+  HCoef_.clear();
+  maxRelError_ = 0.0;
+
+  if (f <= 0.0 || g <= 0.0 || relTol <= 0.0)
+    return;
+
+  // f exp(-gt) < relTol beyond tSat, so h = 1 and H = t - log(f+1)/g
+  // there to within relTol
+  tSat_ = f > relTol ? log(f / relTol) / g : 0.0;
+  HSatOffset_ = log(f + 1) / g;
+
+  // The interpolation error is at most step^4/384 max|h''''|, and
+  // |h''''| <= g^4/8 for the logistic.  h is smallest at 0.
+  double hMin = hExact(0.0);
+  step_ = pow(384.0 * relTol * hMin * 8.0, 0.25) / g;
+
+  for (int refine = 0; refine < MAXREFINE; ++refine)
+    {
+      tabulate(min(tMax, tSat_));
+      if (hCoef_.empty())
+        return;
+      maxRelError_ = measureError();
+      if (maxRelError_ <= relTol)
+        {
+          mode_ = TABULATED;
+          return;
+        }
+      step_ *= 0.5;
+    }
+
+  hCoef_.clear();
+  HCoef_.clear();
+}
+
+
+
+void
+InfectivityKernel::tabulate(const double tMax)
+{
+  //! Builds the Hermite cubics from exact values and
+  //! derivatives (h' = g h (1-h), H' = h) at each knot
+
+  double cells = ceil(tMax / step_);
+  if (cells > MAXCELLS)
+    cells = MAXCELLS;
+  if (cells < 1)
+    {
+      hCoef_.clear();
+      HCoef_.clear();
+      return;
+    }
+
+  size_t n = (size_t) cells;
+  invStep_ = 1.0 / step_;
+  tTable_ = n * step_;
+  hCoef_.resize(4 * n);
+  HCoef_.resize(4 * n);
+
+  double h0 = hExact(0.0);
+  double H0 = 0.0;
+  for (size_t i = 0; i < n; ++i)
+    {
+      double t1 = (i + 1) * step_;
+      double h1 = hExact(t1);
+      double H1 = integralExact(t1);
+
+      double hm0 = step_ * g_ * h0 * (1 - h0);
+      double hm1 = step_ * g_ * h1 * (1 - h1);
+      double* c = &hCoef_[4 * i];
+      c[0] = h0;
+      c[1] = hm0;
+      c[2] = 3 * (h1 - h0) - 2 * hm0 - hm1;
+      c[3] = 2 * (h0 - h1) + hm0 + hm1;
+
+      double Hm0 = step_ * h0;
+      double Hm1 = step_ * h1;
+      c = &HCoef_[4 * i];
+      c[0] = H0;
+      c[1] = Hm0;
+      c[2] = 3 * (H1 - H0) - 2 * Hm0 - Hm1;
+      c[3] = 2 * (H0 - H1) + Hm0 + Hm1;
+
+      h0 = h1;
+      H0 = H1;
+    }
+}
+
+
+
+double
+InfectivityKernel::measureError() const
+{
+  //! Maximum relative error at the quarter points of each
+  //! cell.  The first cell of H is evaluated exactly, so is
+  //! skipped.
+
+  double maxErr = 0.0;
+  size_t n = numCells();
+  for (size_t i = 0; i < n; ++i)
+    {
+      for (int q = 1; q < 4; ++q)
+        {
+          double x = i + 0.25 * q;
+          double t = x * step_;
+          double hErr = fabs(cubic(hCoef_, x) / hExact(t) - 1);
+          maxErr = max(maxErr, hErr);
+          if (i > 0)
+            {
+              double HErr = fabs(cubic(HCoef_, x) / integralExact(t) - 1);
+              maxErr = max(maxErr, HErr);
+            }
+        }
+    }
+  return maxErr;
+}
+
+
+
+double
+InfectivityKernel::hExact(const double t) const
+{
+  double expg = exp(g_ * t);
+  return expg / (f_ + expg);
+}
+
+
+
+double
+InfectivityKernel::integralExact(const double t) const
+{
+  return 1 / g_ * log((f_ + exp(g_ * t)) / (f_ + 1));
+}
+
+
+
+double
+InfectivityKernel::h(const double t) const
+{
+  if (mode_ == EXACT || t < 0.0)
+    return hExact(t);
+  else if (t < tTable_)
+    return cubic(hCoef_, t * invStep_);
+  else if (t >= tSat_)
+    return 1.0;
+  else
+    return hExact(t);
+}
+
+
+
+double
+InfectivityKernel::integral(const double t) const
+{
+  if (mode_ == EXACT || t < step_)
+    return integralExact(t);
+  else if (t < tTable_)
+    return cubic(HCoef_, t * invStep_);
+  else if (t >= tSat_)
+    return t - HSatOffset_;
+  else
+    return integralExact(t);
+}
+
+
+
+void
+InfectivityKernel::h(const double t[], double out[], const size_t n) const
+{
+  for (size_t i = 0; i < n; ++i)
+    out[i] = h(t[i]);
+}
+
+
+
+void
+InfectivityKernel::integral(const double t[], double out[], const size_t n) const
+{
+  for (size_t i = 0; i < n; ++i)
+    out[i] = integral(t[i]);
+}
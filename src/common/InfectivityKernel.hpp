@@ -0,0 +1,99 @@
+/* ./src/common/InfectivityKernel.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * InfectivityKernel.hpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Evaluates the infectivity function
+ *                h(t) = exp(gt) / (f + exp(gt))
+ *              and its integral
+ *                H(t) = 1/g log((f + exp(gt)) / (f + 1))
+ *              from piecewise cubic Hermite tables built once f and g
+ *              are known, to a given relative error.  EXACT mode
+ *              evaluates the closed forms, for validation.
+ */
+
+#ifndef INFECTIVITYKERNEL_HPP_
+#define INFECTIVITYKERNEL_HPP_
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+class InfectivityKernel
+{
+public:
+  enum mode_e { EXACT=0, TABULATED };
+
+  InfectivityKernel();
+
+  // Tabulates h and H for t in [0,tMax] to relative error relTol.
+  // Beyond the point where h is within relTol of 1, the asymptotes
+  // are used.
+  void set(const double f, const double g, const double relTol = 1e-10,
+           const double tMax = 1e6);
+  void setMode(const mode_e mode) { mode_ = mode; }
+  mode_e mode() const { return mode_; }
+
+  // True if tabulating for exactly these f and g
+  bool matches(const double f, const double g) const
+  {
+    return mode_ == TABULATED && f == f_ && g == g_;
+  }
+
+  double h(const double t) const;
+  double integral(const double t) const;
+  void h(const double t[], double out[], const size_t n) const;
+  void integral(const double t[], double out[], const size_t n) const;
+
+  double hExact(const double t) const;
+  double integralExact(const double t) const;
+
+  size_t numCells() const { return hCoef_.size() / 4; }
+  double maxRelError() const { return maxRelError_; }
+
+private:
+  double f_, g_;
+  double step_, invStep_;
+  double tTable_;      // End of the tables
+  double tSat_;        // h is 1 to within relTol beyond here
+  double HSatOffset_;  // H(t) = t - HSatOffset_ beyond tSat_
+  double maxRelError_;
+  mode_e mode_;
+  vector<double> hCoef_;  // Cubic coefficients, 4 per cell
+  vector<double> HCoef_;
+
+  void tabulate(const double tMax);
+  double measureError() const;
+
+  static double
+  cubic(const vector<double>& coef, const double x)
+  {
+    size_t i = (size_t) x;
+    double u = x - i;
+    const double* c = &coef[4 * i];
+    return c[0] + u * (c[1] + u * (c[2] + u * c[3]));
+  }
+};
+
+#endif /* INFECTIVITYKERNEL_HPP_ */
@@ -0,0 +1,171 @@
+/* ./src/common/ModelTraits.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * ModelTraits.hpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Fixes the model dimensions at compile time: the layout
+ *              of the parameter vector, the number of species and
+ *              which contact networks are active.  PairRates<Traits>
+ *              evaluates the pair rates for a model, and the terms of
+ *              inactive networks compile away.
+ *
+ *              AIModelTraits is the full avian influenza model, and
+ *              SpatialModelTraits the same model without networks.
+ *              ModelTraits is the model built into the MCMC and the
+ *              simulators: the spatial model if SPATIAL_MODEL is
+ *              defined, otherwise the AI model.
+ */
+
+#ifndef MODELTRAITS_HPP_
+#define MODELTRAITS_HPP_
+
+#include <cstddef>
+
+
+struct AIModelTraits
+{
+  // Parameter layout
+  enum {
+    BETA0 = 0,       // Background
+    BETA_FM,         // Feed mill
+    BETA_SH,         // Slaughterhouse
+    BETA_CP,         // Company
+    BETA_SPATIAL_I,  // Spatial, from infected premises
+    BETA_SPATIAL_N,  // Spatial, from notified premises
+    RHO,             // Spatial kernel
+    SPECIES          // Susceptibility of the first species
+  };
+
+  static const size_t numSpecies = 9;
+  static const size_t numParms = SPECIES + numSpecies;
+
+  // The simulators' parameter vector carries on past the model's with
+  // a dummy and then the Gompertz infection to notification parameters
+  enum {
+    I2N_A = numParms + 1,
+    I2N_B
+  };
+
+  // Scales the feed mill and slaughterhouse contact rates into
+  // infection rates.  Left to the caller, as PairRates does not apply it.
+  static double ctMultiplier() { return 10.0; }
+
+  // Active networks
+  static const bool feedMill = true;
+  static const bool slaughterhouse = true;
+  static const bool company = true;
+};
+
+
+
+struct SpatialModelTraits : public AIModelTraits
+{
+  // The AI parameter layout, so that files are interchangeable, with
+  // the network parameters ignored
+  static const bool feedMill = false;
+  static const bool slaughterhouse = false;
+  static const bool company = false;
+};
+
+
+
+#ifdef SPATIAL_MODEL
+typedef SpatialModelTraits ModelTraits;
+#else
+typedef AIModelTraits ModelTraits;
+#endif
+
+
+
+template <class Traits>
+struct PairRates
+{
+  // Network is anything with contactMat members fm_Mat, sh_Mat and
+  // cp_Mat and a cFreq table, Kernel anything with at(i, j, rho).
+  // Species susceptibility is left to the caller, as is any scaling of
+  // the feed mill and slaughterhouse contact rates.
+
+  template <class Network>
+  static inline double
+  fmContact(Network& net, const size_t i, const size_t j)
+  {
+    //! Feed mill contact rate from i to j
+    if (!Traits::feedMill)
+      return 0.0;
+    return net.fm_Mat.isConn(i, j) * (0.5 * net.cFreq[j].fm * (3
+        / (net.cFreq[j].fm_N)));
+  }
+
+  template <class Network>
+  static inline double
+  shContact(Network& net, const size_t i, const size_t j)
+  {
+    //! Slaughterhouse contact rate from i to j
+    if (!Traits::slaughterhouse)
+      return 0.0;
+    return net.sh_Mat.isConn(i, j) * (0.5 * net.cFreq[j].sh * (3
+        / (net.cFreq[j].sh_N)));
+  }
+
+  template <class Network>
+  static inline double
+  company(const double* beta, Network& net, const size_t i, const size_t j)
+  {
+    //! Company infection rate from i to j
+    if (!Traits::company)
+      return 0.0;
+    return beta[Traits::BETA_CP] * net.cp_Mat.isConn(i, j);
+  }
+
+  template <class Network, class Kernel>
+  static inline double
+  infected(const double* beta, Network& net, Kernel& kernel,
+      const size_t i, const size_t j, const double fmWeight,
+      const double shWeight)
+  {
+    //! Rate from infected i to j, with the feed mill and slaughterhouse
+    //! contact rates weighted by fmWeight and shWeight
+    double rate = beta[Traits::BETA_SPATIAL_I] * kernel.at(i, j,
+        beta[Traits::RHO]);
+    if (Traits::feedMill)
+      rate += fmWeight * fmContact(net, i, j);
+    if (Traits::slaughterhouse)
+      rate += shWeight * shContact(net, i, j);
+    if (Traits::company)
+      rate += company(beta, net, i, j);
+    return rate;
+  }
+
+  template <class Kernel>
+  static inline double
+  notified(const double* beta, Kernel& kernel, const size_t i, const size_t j)
+  {
+    //! Rate from notified i to j
+    return beta[Traits::BETA_SPATIAL_N] * kernel.at(i, j, beta[Traits::RHO]);
+  }
+};
+
+typedef PairRates<AIModelTraits> AIPairRates;
+typedef PairRates<SpatialModelTraits> SpatialPairRates;
+
+#endif /* MODELTRAITS_HPP_ */
@@ -0,0 +1,151 @@
+/* ./src/common/PopulationStore.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * PopulationStore.hpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Structure-of-arrays copy of the event times, status and
+ *              contact tracing window start of every individual, indexed
+ *              by label, with a dense array of infective labels.  The
+ *              owning population writes through to it whenever it
+ *              changes one of these fields, so likelihood loops can
+ *              read contiguous arrays instead of whole individuals.
+ */
+
+#ifndef POPULATIONSTORE_HPP_
+#define POPULATIONSTORE_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+class PopulationStore
+{
+public:
+  // By label
+  vector<double> I;
+  vector<double> N;
+  vector<double> R;
+  vector<double> contactStart;
+  vector<unsigned char> status;  // 1 if infected, else 0
+  vector<int> infecPos;          // Position in infectives, -1 if not infected
+
+  // By position
+  vector<size_t> infectives;    // Labels of the infectives, in population order
+
+  size_t
+  size() const
+  {
+    return I.size();
+  }
+
+  void
+  resize(const size_t n)
+  {
+    I.resize(n);
+    N.resize(n);
+    R.resize(n);
+    contactStart.resize(n);
+    status.assign(n, 0);
+    infecPos.assign(n, -1);
+    infectives.clear();
+  }
+
+  // Copies the event times of an individual stored at its label
+  template<typename Indiv>
+    void
+    set(const Indiv& indiv)
+    {
+      I[indiv.label] = indiv.I;
+      N[indiv.label] = indiv.N;
+      R[indiv.label] = indiv.R;
+      contactStart[indiv.label] = indiv.contactStart;
+    }
+
+  // Copies a whole population, stored in label order
+  template<typename Iterator>
+    void
+    assign(Iterator begin, Iterator end)
+    {
+      resize(end - begin);
+      for (Iterator it = begin; it != end; ++it)
+        set(*it);
+    }
+
+  // Rebuilds the infective index from a sequence of pointers or
+  // iterators to the infectives
+  template<typename Iterator>
+    void
+    indexInfectives(Iterator begin, Iterator end)
+    {
+      for (vector<size_t>::const_iterator it = infectives.begin(); it
+          != infectives.end(); ++it)
+        {
+          infecPos[*it] = -1;
+          status[*it] = 0;
+        }
+
+      infectives.clear();
+      for (Iterator it = begin; it != end; ++it)
+        addInfective((*it)->label);
+    }
+
+  // Appends an infective to the index
+  void
+  addInfective(const size_t label)
+  {
+    infecPos[label] = infectives.size();
+    infectives.push_back(label);
+    status[label] = 1;
+  }
+
+  // Time functions, as in sinrEpi and Population
+  double
+  exposureI(const size_t i, const size_t j) const
+  {
+    // Time for which susceptible j is exposed to infective i
+    return min(N[i], I[j]) - min(I[i], I[j]);
+  }
+
+  double
+  exposureN(const size_t i, const size_t j) const
+  {
+    // Time for which susceptible j is exposed to notified i
+    return min(R[i], I[j]) - min(I[j], N[i]);
+  }
+
+  double
+  ITime(const size_t i) const
+  {
+    return N[i] - I[i];
+  }
+
+  double
+  NTime(const size_t i) const
+  {
+    return R[i] - N[i];
+  }
+};
+
+#endif /* POPULATIONSTORE_HPP_ */
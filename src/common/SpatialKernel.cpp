@@ -0,0 +1,202 @@
+/* ./src/common/SpatialKernel.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SpatialKernel.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ */
+
+#include <cmath>
+#include <cfloat>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "SpatialKernel.hpp"
+
+
+SpatialKernel::SpatialKernel(const family_e family, const double d0) :
+  family_(family), d0_(d0), n_(0), last_(0)
+{
+  rowStart_.assign(1, 0);
+  clearSlots();
+}
+
+
+
+void
+SpatialKernel::setDistances(const float* dist, const size_t n)
+{
+  n_ = n;
+  rowStart_.assign(n + 1, 0);
+  target_.clear();
+  bin_.clear();
+
+  vector<float> distances;
+  for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t j = 0; j < n; ++j)
+        {
+          float d = dist[i + n * j];
+          if (!(d >= -FLT_MAX && d <= FLT_MAX))
+            continue; // Infinite or missing
+          target_.push_back(j);
+          distances.push_back(d);
+        }
+      rowStart_[i + 1] = target_.size();
+    }
+
+  // Bin edges by distinct distance
+  vector<float> sorted(distances);
+  sort(sorted.begin(), sorted.end());
+  sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+  binDistance_.assign(sorted.begin(), sorted.end());
+
+  bin_.resize(distances.size());
+  for (size_t e = 0; e < distances.size(); ++e)
+    bin_[e] = lower_bound(sorted.begin(), sorted.end(), distances[e])
+        - sorted.begin();
+
+  clearSlots();
+}
+
+
+
+void
+SpatialKernel::setFamily(const family_e family)
+{
+  family_ = family;
+  clearSlots();
+}
+
+
+
+SpatialKernel::family_e
+SpatialKernel::familyFromString(const string& name)
+{
+  if (name == "exponential")
+    return EXPONENTIAL;
+  else if (name == "powerlaw")
+    return POWERLAW;
+  else if (name == "cauchy")
+    return CAUCHY;
+  else
+    throw invalid_argument("Unknown spatial kernel family");
+}
+
+
+
+double
+SpatialKernel::evaluate(const double distance, const double decay) const
+{
+  switch (family_)
+    {
+  case POWERLAW:
+    return pow(distance / d0_, -decay);
+  case CAUCHY:
+    return (1 + decay * decay * d0_ * d0_) / (1 + decay * decay * distance
+        * distance);
+  default:
+    return exp(-decay * (distance - d0_));
+    }
+}
+
+
+
+void
+SpatialKernel::prepare(const double decay)
+{
+  int k = findSlot(decay);
+  if (k >= 0)
+    {
+      last_ = k;
+      return;
+    }
+
+  // Replace the least recently prepared slot
+  k = 1 - last_;
+  vector<double> binValue(binDistance_.size());
+  for (size_t b = 0; b < binDistance_.size(); ++b)
+    binValue[b] = evaluate(binDistance_[b], decay);
+
+  Slot& slot = slot_[k];
+  slot.values.resize(bin_.size());
+  for (size_t e = 0; e < bin_.size(); ++e)
+    slot.values[e] = binValue[bin_[e]];
+  slot.decay = decay;
+  last_ = k;
+}
+
+
+
+int
+SpatialKernel::findSlot(const double decay) const
+{
+  if (slot_[last_].decay == decay)
+    return last_;
+  else if (slot_[1 - last_].decay == decay)
+    return 1 - last_;
+  else
+    return -1;
+}
+
+
+
+void
+SpatialKernel::clearSlots()
+{
+  for (int k = 0; k < 2; ++k)
+    {
+      slot_[k].decay = numeric_limits<double>::quiet_NaN(); // Never matches
+      slot_[k].values.clear();
+    }
+}
+
+
+
+double
+SpatialKernel::at(const size_t i, const size_t j, const double decay) const
+{
+  const uint32_t* begin = &target_[0] + rowStart_[i];
+  const uint32_t* end = &target_[0] + rowStart_[i + 1];
+  const uint32_t* edge = lower_bound(begin, end, (uint32_t) j);
+  if (edge == end || *edge != j)
+    return 0.0;
+
+  size_t e = edge - &target_[0];
+  int k = findSlot(decay);
+  if (k >= 0)
+    return slot_[k].values[e];
+  else
+    return evaluate(binDistance_[bin_[e]], decay);
+}
+
+
+
+const double*
+SpatialKernel::values(const size_t i, const double decay) const
+{
+  int k = findSlot(decay);
+  if (k < 0)
+    return NULL;
+  return &slot_[k].values[0] + rowStart_[i];
+}
@@ -0,0 +1,106 @@
+/* ./src/common/SpatialKernel.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SpatialKernel.hpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Caches spatial kernel values for every pair of premises
+ *              with a finite distance.  Edges are stored by source, and
+ *              their distances are binned by distinct value, so preparing
+ *              a new decay parameter costs one kernel evaluation per
+ *              distinct distance.  Values for the two most recently
+ *              prepared decays are kept, so current and candidate
+ *              parameters can coexist during an MCMC update.
+ */
+
+#ifndef SPATIALKERNEL_HPP_
+#define SPATIALKERNEL_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+using namespace std;
+
+class SpatialKernel
+{
+public:
+  // All families are 1 at the reference distance d0:
+  //   EXPONENTIAL  exp(-decay (d - d0))
+  //   POWERLAW     (d / d0)^-decay
+  //   CAUCHY       (1 + (decay d0)^2) / (1 + (decay d)^2)
+  enum family_e { EXPONENTIAL=0, POWERLAW, CAUCHY };
+
+  SpatialKernel(const family_e family = EXPONENTIAL, const double d0 = 5.0);
+
+  // Takes the edges from a dense n x n distance matrix stored as
+  // dist[i + n*j], keeping the finite distances
+  void setDistances(const float* dist, const size_t n);
+
+  void setFamily(const family_e family);
+  family_e family() const { return family_; }
+  static family_e familyFromString(const string& name);
+
+  // Caches kernel values for decay.  Not thread safe, so call it from
+  // serial code before parallel regions that use decay.
+  void prepare(const double decay);
+
+  // Kernel from i to j, zero if they have no finite distance.  Falls
+  // back to direct evaluation if decay has not been prepared.
+  double at(const size_t i, const size_t j, const double decay) const;
+
+  double evaluate(const double distance, const double decay) const;
+
+  // Contiguous per-source arrays.  values() is NULL if decay has not
+  // been prepared.
+  size_t size() const { return n_; }
+  size_t degree(const size_t i) const { return rowStart_[i+1] - rowStart_[i]; }
+  const uint32_t* targets(const size_t i) const { return &target_[rowStart_[i]]; }
+  const double* values(const size_t i, const double decay) const;
+
+  size_t numEdges() const { return target_.size(); }
+  size_t numBins() const { return binDistance_.size(); }
+
+private:
+  struct Slot
+  {
+    double decay;
+    vector<double> values;  // Per edge
+  };
+
+  family_e family_;
+  double d0_;
+  size_t n_;
+  vector<size_t> rowStart_;
+  vector<uint32_t> target_;
+  vector<uint32_t> bin_;        // Distance bin of each edge
+  vector<double> binDistance_;  // Distinct distances
+  Slot slot_[2];
+  int last_;
+
+  int findSlot(const double decay) const;
+  void clearSlots();
+};
+
+#endif /* SPATIALKERNEL_HPP_ */
@@ -0,0 +1,385 @@
+/* ./src/data/CTStreamWriter.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * CTStreamWriter.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ */
+
+#include <stdexcept>
+#include <cstdarg>
+#include <cstring>
+
+#include "CTStreamWriter.hpp"
+#include "EpiRiskException.hpp"
+
+// Must agree with XmlCTWriter.hpp
+#define CTSTREAM_DTD_PUBLIC_ID "contact-tracing-20070517.dtd"
+#define CTSTREAM_DTD_URI "http://www.maths.lancs.ac.uk/~jewellc/files/contact-tracing-20070517.dtd"
+
+
+CTStreamWriter::CTStreamWriter(const string filename, const format_e format) :
+  file_(NULL), gzFile_(NULL), format_(format), numBlocks_(0)
+{
+  if (format_ == COMPRESSEDFORMAT)
+    gzFile_ = gzopen(filename.c_str(), "wb");
+  else
+    file_ = fopen(filename.c_str(), format_ == BINARYFORMAT ? "wb" : "w");
+
+  if (!isOpen())
+    throw EpiRisk::output_exception("Cannot open contact tracing output file");
+
+  writeHeader();
+}
+
+
+
+CTStreamWriter::~CTStreamWriter()
+{
+  try
+    {
+      close();
+    }
+  catch (...)
+    {
+      // Nothing more can be done in a destructor
+    }
+}
+
+
+
+CTStreamWriter::format_e
+CTStreamWriter::formatFromFilename(const string filename)
+{
+  //! Binary streams are identified by a .ctb or .ctb.gz suffix
+  const string binSuffix(".ctb");
+  const string gzSuffix(".ctb.gz");
+  if (filename.size() > gzSuffix.size() &&
+      filename.compare(filename.size() - gzSuffix.size(), gzSuffix.size(), gzSuffix) == 0)
+    return COMPRESSEDFORMAT;
+  else if (filename.size() > binSuffix.size() &&
+      filename.compare(filename.size() - binSuffix.size(), binSuffix.size(), binSuffix) == 0)
+    return BINARYFORMAT;
+  else
+    return XMLFORMAT;
+}
+
+
+
+unsigned char
+CTStreamWriter::typeCode(const char* type)
+{
+  //! Returns the code for type, registering it (and emitting
+  //! a definition record for binary streams) if unseen.
+
+  map<string,unsigned char>::const_iterator found = typeCodes_.find(type);
+  if (found != typeCodes_.end()) return found->second;
+
+  if (typeNames_.size() > 255)
+    throw logic_error("Too many contact types for CTStreamWriter");
+
+  unsigned char code = typeNames_.size();
+  typeNames_.push_back(type);
+  typeCodes_.insert(make_pair(string(type),code));
+
+  if (format_ != XMLFORMAT) writeTypeDef(code);
+
+  return code;
+}
+
+
+
+const string&
+CTStreamWriter::typeName(const unsigned char code) const
+{
+  return typeNames_.at(code);
+}
+
+
+
+void
+CTStreamWriter::writeHeader()
+{
+  if (format_ != XMLFORMAT)
+    {
+      put(CTSTREAM_MAGIC, CTSTREAM_MAGIC_LEN);
+    }
+  else
+    {
+      print("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\" ?>\n");
+      print("<!DOCTYPE tracedcontacts PUBLIC \"%s\" \"%s\">\n",
+            CTSTREAM_DTD_PUBLIC_ID, CTSTREAM_DTD_URI);
+      print("<tracedcontacts xmlns=\"tracedcontacts\">\n");
+    }
+}
+
+
+
+void
+CTStreamWriter::writeTypeDef(const unsigned char code)
+{
+  const string& name = typeNames_[code];
+  unsigned char len = name.size() > 255 ? 255 : name.size();
+
+  put("T", 1);
+  put(&code, 1);
+  put(&len, 1);
+  put(name.data(), len);
+}
+
+
+
+void
+CTStreamWriter::writeBlock(const size_t id, const double start, const vector<CTRecord>& contacts)
+{
+  //! Writes a complete <contact> block for individual id
+
+  if (!isOpen())
+    throw logic_error("Write to closed CTStreamWriter");
+
+  if (format_ != XMLFORMAT)
+    {
+      uint64_t myId = id;
+      uint64_t n = contacts.size();
+      put("C", 1);
+      put(&myId, sizeof(myId));
+      put(&start, sizeof(start));
+      put(&n, sizeof(n));
+
+      for (vector<CTRecord>::const_iterator it = contacts.begin(); it != contacts.end(); ++it)
+        {
+          uint64_t conId = it->id;
+          unsigned char flags = (it->incoming ? CTSTREAM_INCOMING : 0) | (it->caused ? CTSTREAM_CAUSED : 0);
+          put(&conId, sizeof(conId));
+          put(&it->time, sizeof(it->time));
+          put(&it->type, 1);
+          put(&flags, 1);
+        }
+    }
+  else
+    {
+      print("  <contact id=\"%lu\" start=\"%.9lf\">\n", id, start);
+
+      for (vector<CTRecord>::const_iterator it = contacts.begin(); it != contacts.end(); ++it)
+        {
+          const char* tag = it->incoming ? "from" : "to";
+          print("    <%s%s id=\"%lu\">\n      <type>%s</type>\n      <time>%.9lf</time>\n    </%s>\n",
+                tag, it->caused ? " caused=\"true\"" : "", it->id,
+                typeNames_.at(it->type).c_str(), it->time, tag);
+        }
+
+      print("  </contact>\n");
+    }
+
+  numBlocks_++;
+}
+
+
+
+void
+CTStreamWriter::close()
+{
+  //! Writes the stream trailer and closes the file.  The file
+  //! is closed even if the trailer cannot be written.
+
+  if (!isOpen()) return;
+
+  bool ok = true;
+  try
+    {
+      if (format_ != XMLFORMAT)
+        put("E", 1);
+      else
+        print("</tracedcontacts>\n");
+    }
+  catch (EpiRisk::output_exception&)
+    {
+      ok = false;
+    }
+
+  // Buffered data is only written out here, so a full disk may
+  // only show up now
+  if (gzFile_ != NULL)
+    ok = gzclose(gzFile_) == Z_OK && ok;
+  else
+    ok = fclose(file_) == 0 && ok;
+
+  file_ = NULL;
+  gzFile_ = NULL;
+
+  if (!ok)
+    throw EpiRisk::output_exception("Error closing contact tracing output file");
+}
+
+
+
+void
+CTStreamWriter::put(const void* data, const size_t size)
+{
+  if (size == 0) return;
+
+  bool ok;
+  if (gzFile_ != NULL)
+    ok = gzwrite(gzFile_, data, size) == (int)size;
+  else
+    ok = fwrite(data, 1, size, file_) == size;
+
+  if (!ok)
+    throw EpiRisk::output_exception("Error writing contact tracing data");
+}
+
+
+
+void
+CTStreamWriter::print(const char* format, ...)
+{
+  char buffer[512];
+  va_list args;
+
+  va_start(args, format);
+  int len = vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+
+  if (len < 0 || len >= (int)sizeof(buffer))
+    throw EpiRisk::output_exception("Contact tracing record too long");
+
+  put(buffer, len);
+}
+
+
+
+CTStreamReader::CTStreamReader(const string filename) :
+  file_(NULL)
+{
+  // gzread reads uncompressed files transparently
+  file_ = gzopen(filename.c_str(), "rb");
+  if (file_ == NULL)
+    throw EpiRisk::parse_exception("Cannot open contact tracing stream");
+
+  char magic[CTSTREAM_MAGIC_LEN];
+  if (gzread(file_, magic, CTSTREAM_MAGIC_LEN) != CTSTREAM_MAGIC_LEN ||
+      memcmp(magic, CTSTREAM_MAGIC, CTSTREAM_MAGIC_LEN) != 0)
+    {
+      gzclose(file_);
+      file_ = NULL;
+      throw EpiRisk::parse_exception("Not a binary contact tracing stream");
+    }
+}
+
+
+
+CTStreamReader::~CTStreamReader()
+{
+  if (file_ != NULL) gzclose(file_);
+}
+
+
+
+bool
+CTStreamReader::isBinary(const string filename)
+{
+  gzFile file = gzopen(filename.c_str(), "rb");
+  if (file == NULL) return false;
+
+  char magic[CTSTREAM_MAGIC_LEN];
+  bool rv = gzread(file, magic, CTSTREAM_MAGIC_LEN) == CTSTREAM_MAGIC_LEN &&
+            memcmp(magic, CTSTREAM_MAGIC, CTSTREAM_MAGIC_LEN) == 0;
+  gzclose(file);
+
+  return rv;
+}
+
+
+
+const string&
+CTStreamReader::typeName(const unsigned char code) const
+{
+  return typeNames_.at(code);
+}
+
+
+
+bool
+CTStreamReader::next(size_t& id, double& start, vector<CTRecord>& contacts)
+{
+  //! Reads the next individual's contacts, consuming any
+  //! type definitions on the way.
+
+  unsigned char tag;
+
+  while (true)
+    {
+      get(&tag, 1);
+
+      if (tag == 'E')
+        {
+          return false;
+        }
+      else if (tag == 'T')
+        {
+          unsigned char code, len;
+          char name[256];
+          get(&code, 1);
+          get(&len, 1);
+          get(name, len);
+          if (code >= typeNames_.size()) typeNames_.resize(code + 1);
+          typeNames_[code] = string(name, len);
+        }
+      else if (tag == 'C')
+        {
+          uint64_t myId, n;
+          get(&myId, sizeof(myId));
+          get(&start, sizeof(start));
+          get(&n, sizeof(n));
+          id = myId;
+
+          contacts.resize(n);
+          for (uint64_t k = 0; k < n; ++k)
+            {
+              uint64_t conId;
+              unsigned char flags;
+              get(&conId, sizeof(conId));
+              get(&contacts[k].time, sizeof(double));
+              get(&contacts[k].type, 1);
+              get(&flags, 1);
+              contacts[k].id = conId;
+              contacts[k].incoming = flags & CTSTREAM_INCOMING;
+              contacts[k].caused = flags & CTSTREAM_CAUSED;
+            }
+          return true;
+        }
+      else
+        {
+          throw EpiRisk::parse_exception("Corrupt binary contact tracing stream");
+        }
+    }
+}
+
+
+
+void
+CTStreamReader::get(void* data, const size_t size)
+{
+  if (size == 0) return;
+  if (gzread(file_, data, size) != (int)size)
+    throw EpiRisk::parse_exception("Premature end of binary contact tracing stream");
+}
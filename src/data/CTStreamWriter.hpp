@@ -0,0 +1,141 @@
+/* ./src/data/CTStreamWriter.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * CTStreamWriter.hpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Writes contact tracing data to disk one individual
+ *              at a time, either as contact tracing XML (readable by
+ *              SAXContactParse and XmlCTWriter::readFromFile) or as
+ *              a compact, optionally gzip compressed, binary stream.
+ *              CTStreamReader reads the binary stream back.
+ */
+
+#ifndef CTSTREAMWRITER_HPP_
+#define CTSTREAMWRITER_HPP_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+
+#include <stdint.h>
+#include <zlib.h>
+
+using namespace std;
+
+
+// Binary stream layout (host byte order):
+//   "INFERCT1"                                     file magic
+//   'T' <uint8 code> <uint8 len> <len chars>       contact type definition
+//   'C' <uint64 id> <double start> <uint64 n>      individual header, followed
+//       n x { <uint64 id> <double time> <uint8 type> <uint8 flags> }
+//   'E'                                            end of stream
+#define CTSTREAM_MAGIC "INFERCT1"
+#define CTSTREAM_MAGIC_LEN 8
+#define CTSTREAM_INCOMING 0x01
+#define CTSTREAM_CAUSED 0x02
+
+
+struct CTRecord
+{
+  //! A single traced contact belonging to an individual
+  double time;
+  size_t id;
+  unsigned char type;
+  bool incoming;
+  bool caused;
+
+  CTRecord() : time(0.0), id(0), type(0), incoming(true), caused(false) {}
+  CTRecord(const size_t id_, const bool incoming_, const unsigned char type_,
+           const double time_, const bool caused_ = false) :
+    time(time_), id(id_), type(type_), incoming(incoming_), caused(caused_) {}
+
+  bool operator<(const CTRecord& rhs) const { return time < rhs.time; }
+};
+
+
+
+class CTStreamWriter
+{
+  //! Streams <contact> blocks straight to disk.  Memory use
+  //! is bounded by the largest single block written.
+public:
+  enum format_e { XMLFORMAT=0, BINARYFORMAT, COMPRESSEDFORMAT };
+
+  CTStreamWriter(const string filename, const format_e format=XMLFORMAT);
+  ~CTStreamWriter();
+
+  // Returns the code for a contact type string, registering it if new
+  unsigned char typeCode(const char* type);
+  const string& typeName(const unsigned char code) const;
+
+  void writeBlock(const size_t id, const double start, const vector<CTRecord>& contacts);
+  void close();
+
+  format_e format() const { return format_; }
+  size_t numBlocks() const { return numBlocks_; }
+
+  // Picks BINARYFORMAT for a ".ctb" suffix, COMPRESSEDFORMAT for
+  // ".ctb.gz", otherwise XMLFORMAT
+  static format_e formatFromFilename(const string filename);
+
+private:
+  FILE* file_;
+  gzFile gzFile_;
+  format_e format_;
+  size_t numBlocks_;
+  vector<string> typeNames_;
+  map<string,unsigned char> typeCodes_;
+
+  void writeHeader();
+  void writeTypeDef(const unsigned char code);
+  void put(const void* data, const size_t size);
+  void print(const char* format, ...);
+  bool isOpen() const { return file_ != NULL || gzFile_ != NULL; }
+};
+
+
+
+class CTStreamReader
+{
+  //! Reads a binary (plain or gzip compressed) contact tracing
+  //! stream one individual at a time.
+public:
+  CTStreamReader(const string filename);
+  ~CTStreamReader();
+
+  // Reads the next <contact> block, returning false at end of stream
+  bool next(size_t& id, double& start, vector<CTRecord>& contacts);
+  const string& typeName(const unsigned char code) const;
+
+  // True if filename starts with the binary stream magic
+  static bool isBinary(const string filename);
+
+private:
+  gzFile file_;
+  vector<string> typeNames_;
+
+  void get(void* data, const size_t size);
+};
+
+#endif /* CTSTREAMWRITER_HPP_ */
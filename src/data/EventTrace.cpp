@@ -0,0 +1,314 @@
+/* ./src/data/EventTrace.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * EventTrace.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+
+#include <omp.h>
+
+#include "EventTrace.hpp"
+#include "EpiRiskException.hpp"
+
+
+EventTrace::EventTrace(const string filename, const size_t bufferSize,
+    const size_t numBuffers) :
+  file_(NULL), bufferSize_(bufferSize), numBuffers_(numBuffers),
+  rings_(max(omp_get_max_threads(), omp_get_num_procs())), stopping_(false),
+  failed_(false), dropped_(0)
+{
+  if (sizeof(TraceRecord) != 32)
+    throw logic_error("TraceRecord is not packed into 32 bytes");
+  if (bufferSize_ == 0 || numBuffers_ < 2)
+    throw invalid_argument("Trace needs at least two non-empty buffers");
+
+  file_ = fopen(filename.c_str(), "wb");
+  if (file_ == NULL)
+    throw EpiRisk::output_exception("Cannot open trace output file");
+  fwrite(EVENTTRACE_MAGIC, 1, EVENTTRACE_MAGIC_LEN, file_);
+
+  for (size_t t = 0; t < rings_.size(); ++t)
+    {
+      rings_[t].records.resize(numBuffers_ * bufferSize_);
+      rings_[t].sizes.resize(numBuffers_);
+    }
+
+  pthread_mutex_init(&mutex_, NULL);
+  pthread_cond_init(&submittedCond_, NULL);
+  pthread_cond_init(&writtenCond_, NULL);
+  if (pthread_create(&writer_, NULL, startWriter, this) != 0)
+    {
+      fclose(file_);
+      file_ = NULL;
+      throw runtime_error("Cannot start trace writer thread");
+    }
+}
+
+
+
+EventTrace::~EventTrace()
+{
+  try
+    {
+      close();
+    }
+  catch (...)
+    {
+      // Nothing more can be done in a destructor
+    }
+  pthread_cond_destroy(&writtenCond_);
+  pthread_cond_destroy(&submittedCond_);
+  pthread_mutex_destroy(&mutex_);
+}
+
+
+
+void
+EventTrace::record(const event_e event, const size_t sender,
+    const size_t receiver, const int type, const double time,
+    const double hFunc, const uint32_t run)
+{
+  // Throwing would terminate inside a parallel region
+  size_t thread = omp_get_thread_num();
+  if (thread >= rings_.size())
+    {
+#pragma omp atomic
+      ++dropped_;
+      return;
+    }
+
+  Ring& ring = rings_[thread];
+  TraceRecord& rec = ring.records[(ring.submitted % numBuffers_)
+      * bufferSize_ + ring.fill];
+  rec.time = time;
+  rec.hFunc = hFunc;
+  rec.sender = sender;
+  rec.receiver = receiver;
+  rec.run = run;
+  rec.thread = thread;
+  rec.event = event;
+  rec.type = type;
+
+  if (++ring.fill == bufferSize_)
+    submit(ring);
+}
+
+
+
+void
+EventTrace::submit(Ring& ring)
+{
+  //! Hands the current buffer to the writer, waiting for the next
+  //! one if it has not been written yet
+
+  pthread_mutex_lock(&mutex_);
+  ring.sizes[ring.submitted % numBuffers_] = ring.fill;
+  ++ring.submitted;
+  pthread_cond_signal(&submittedCond_);
+  while (ring.submitted - ring.written == numBuffers_)
+    pthread_cond_wait(&writtenCond_, &mutex_);
+  pthread_mutex_unlock(&mutex_);
+
+  ring.fill = 0;
+}
+
+
+
+void*
+EventTrace::startWriter(void* self)
+{
+  static_cast<EventTrace*> (self)->writeLoop();
+  return NULL;
+}
+
+
+
+void
+EventTrace::writeLoop()
+{
+  //! Writes submitted buffers until closed
+
+  size_t next = 0;
+  pthread_mutex_lock(&mutex_);
+  while (1)
+    {
+      Ring* ring = NULL;
+      for (size_t k = 0; k < rings_.size(); ++k)
+        {
+          Ring& candidate = rings_[(next + k) % rings_.size()];
+          if (candidate.submitted > candidate.written)
+            {
+              ring = &candidate;
+              next = (next + k + 1) % rings_.size();
+              break;
+            }
+        }
+
+      if (ring != NULL)
+        {
+          size_t buffer = ring->written % numBuffers_;
+          size_t size = ring->sizes[buffer];
+          pthread_mutex_unlock(&mutex_);
+          size_t n = fwrite(&ring->records[buffer * bufferSize_],
+              sizeof(TraceRecord), size, file_);
+          pthread_mutex_lock(&mutex_);
+          if (n != size)
+            failed_ = true;
+          ++ring->written;
+          ring->total += size;
+          pthread_cond_broadcast(&writtenCond_);
+        }
+      else if (stopping_)
+        break;
+      else
+        pthread_cond_wait(&submittedCond_, &mutex_);
+    }
+  pthread_mutex_unlock(&mutex_);
+}
+
+
+
+void
+EventTrace::flush()
+{
+  if (file_ == NULL)
+    return;
+
+  for (size_t t = 0; t < rings_.size(); ++t)
+    if (rings_[t].fill > 0)
+      submit(rings_[t]);
+
+  pthread_mutex_lock(&mutex_);
+  for (size_t t = 0; t < rings_.size(); ++t)
+    while (rings_[t].written < rings_[t].submitted)
+      pthread_cond_wait(&writtenCond_, &mutex_);
+  bool failed = failed_;
+  pthread_mutex_unlock(&mutex_);
+
+  fflush(file_);
+  if (failed)
+    throw EpiRisk::output_exception("Cannot write trace output file");
+  if (dropped_ > 0)
+    {
+      dropped_ = 0; // Reported once
+      throw logic_error("Trace records dropped from more threads than when the trace was opened");
+    }
+}
+
+
+
+void
+EventTrace::close()
+{
+  if (file_ == NULL)
+    return;
+
+  flush();
+
+  pthread_mutex_lock(&mutex_);
+  stopping_ = true;
+  pthread_cond_signal(&submittedCond_);
+  pthread_mutex_unlock(&mutex_);
+  pthread_join(writer_, NULL);
+
+  fclose(file_);
+  file_ = NULL;
+}
+
+
+
+size_t
+EventTrace::numRecords() const
+{
+  //! Records written, complete after flush() or close()
+  size_t total = 0;
+  for (size_t t = 0; t < rings_.size(); ++t)
+    total += rings_[t].total;
+  return total;
+}
+
+
+
+const char*
+EventTrace::eventName(const int event)
+{
+  static const char* names[] = { "contact", "infection", "notification",
+      "removal" };
+  return event >= 0 && event <= REMOVAL ? names[event] : "unknown";
+}
+
+
+
+EventTraceReader::EventTraceReader(const string filename)
+{
+  file_ = fopen(filename.c_str(), "rb");
+  if (file_ == NULL)
+    throw EpiRisk::data_exception("Cannot open trace file");
+
+  char magic[EVENTTRACE_MAGIC_LEN];
+  if (fread(magic, 1, EVENTTRACE_MAGIC_LEN, file_) != EVENTTRACE_MAGIC_LEN
+      || memcmp(magic, EVENTTRACE_MAGIC, EVENTTRACE_MAGIC_LEN) != 0)
+    {
+      fclose(file_);
+      throw EpiRisk::parse_exception("Not an event trace file");
+    }
+}
+
+
+
+EventTraceReader::~EventTraceReader()
+{
+  fclose(file_);
+}
+
+
+
+bool
+EventTraceReader::next(TraceRecord& rec)
+{
+  size_t n = fread(&rec, 1, sizeof(TraceRecord), file_);
+  if (n == 0)
+    return false;
+  if (n != sizeof(TraceRecord))
+    throw EpiRisk::parse_exception("Truncated event trace record");
+  return true;
+}
+
+
+
+bool
+EventTraceReader::isTrace(const string filename)
+{
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (file == NULL)
+    return false;
+  char magic[EVENTTRACE_MAGIC_LEN];
+  bool rv = fread(magic, 1, EVENTTRACE_MAGIC_LEN, file) == EVENTTRACE_MAGIC_LEN
+      && memcmp(magic, EVENTTRACE_MAGIC, EVENTTRACE_MAGIC_LEN) == 0;
+  fclose(file);
+  return rv;
+}
@@ -0,0 +1,149 @@
+/* ./src/data/EventTrace.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * EventTrace.hpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Records simulation events (contacts, infections,
+ *              notifications and removals) as fixed size binary
+ *              records.  Each OpenMP thread fills its own ring of
+ *              buffers without locking, and full buffers are written
+ *              to the trace file by a background thread.  A thread
+ *              only waits if all of its buffers are waiting to be
+ *              written.  EventTraceReader reads the file back.
+ */
+
+#ifndef EVENTTRACE_HPP_
+#define EVENTTRACE_HPP_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <pthread.h>
+
+using namespace std;
+
+
+// Trace file layout (host byte order):
+//   "INFERTR1"                 file magic
+//   n x TraceRecord            in the order buffers were written, so
+//                              records from different threads interleave
+#define EVENTTRACE_MAGIC "INFERTR1"
+#define EVENTTRACE_MAGIC_LEN 8
+#define EVENTTRACE_NONE 0xffffffff  // No sender, eg background infection
+#define EVENTTRACE_CACHELINE 64
+
+
+struct TraceRecord
+{
+  //! A single traced event.  type is the simulator's own contact
+  //! type code, and hFunc the infectivity of the sender at the time.
+  double time;
+  double hFunc;
+  uint32_t sender;
+  uint32_t receiver;
+  uint32_t run;      // Replicate, set by the caller
+  uint16_t thread;
+  uint8_t event;     // EventTrace::event_e
+  uint8_t type;
+};
+
+
+
+class EventTrace
+{
+public:
+  enum event_e { CONTACT=0, INFECTION, NOTIFICATION, REMOVAL };
+
+  // Each thread gets numBuffers buffers of bufferSize records
+  EventTrace(const string filename, const size_t bufferSize = 4096,
+             const size_t numBuffers = 4);
+  ~EventTrace();
+
+  // Called from any thread of the current OpenMP team.  Records
+  // from threads beyond those the trace was sized for are dropped,
+  // and reported by flush().
+  void record(const event_e event, const size_t sender, const size_t receiver,
+              const int type, const double time, const double hFunc,
+              const uint32_t run = 0);
+
+  // Writes partly filled buffers and waits for the writer.  Call
+  // outside parallel regions.
+  void flush();
+  void close();
+
+  size_t numRecords() const; // Written, after flush() or close()
+
+  static const char* eventName(const int event);
+
+private:
+  struct Ring
+  {
+    vector<TraceRecord> records;  // numBuffers x bufferSize
+    vector<size_t> sizes;         // Records in each submitted buffer
+    size_t fill;                  // Records in the current buffer
+    size_t submitted, written;    // Buffers, guarded by mutex_
+    size_t total;
+    char pad[EVENTTRACE_CACHELINE]; // Keeps fill off neighbouring rings' cache lines
+    Ring() : fill(0), submitted(0), written(0), total(0) {}
+  };
+
+  FILE* file_;
+  size_t bufferSize_;
+  size_t numBuffers_;
+  vector<Ring> rings_;
+
+  pthread_t writer_;
+  pthread_mutex_t mutex_;
+  pthread_cond_t submittedCond_;
+  pthread_cond_t writtenCond_;
+  bool stopping_;
+  bool failed_;
+  size_t dropped_;  // Records from threads without a ring
+
+  void submit(Ring& ring);
+  void writeLoop();
+  static void* startWriter(void* self);
+};
+
+
+
+class EventTraceReader
+{
+  //! Reads a trace file one record at a time
+public:
+  EventTraceReader(const string filename);
+  ~EventTraceReader();
+
+  // Reads the next record, returning false at end of file
+  bool next(TraceRecord& rec);
+
+  // True if filename starts with the trace magic
+  static bool isTrace(const string filename);
+
+private:
+  FILE* file_;
+};
+
+#endif /* EVENTTRACE_HPP_ */
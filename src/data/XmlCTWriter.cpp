@@ -23,15 +23,16 @@
 // Name: XmlCTWriter                                                //
 // Author: C.Jewell                                                 //
 // Created: 23/11/2007                                              //
-// Purpose: Implements a DOM to hold, and write to disk, simulated  //
-//           contact tracing data                                   //
-// Requirements: Xerces-c XML parsing library                       //
+// Purpose: Holds, and streams to disk, simulated contact tracing   //
+//           data                                                   //
+// Requirements: Xerces-c XML parsing library (reading only)        //
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
 #include <sstream>
+#include <algorithm>
+#include <cstdio>
 
-#include <xercesc/parsers/XercesDOMParser.hpp>
 #include <xercesc/dom/DOM.hpp>
 #include <xercesc/sax/HandlerBase.hpp>
 #include <xercesc/util/XMLString.hpp>
@@ -39,45 +40,15 @@
 
 #include "XmlCTWriter.hpp"
 #include "EpiRiskException.hpp"
-//#include "DOMErrorHandler.hpp"
 
-//! Ctor is created using a DOMDocument factory
-XmlCTData::XmlCTData(DOMDocument* _factory) :
-  domFactory(_factory), hasStartTime(false), hasID(false), ctData(NULL)
+//! Ctor takes the writer that owns the contact type table
+XmlCTData::XmlCTData(XmlCTWriter* _writer) :
+  writer(_writer), myID(0), myStartTime(0.0), hasStartTime(false), hasID(false)
 {
-  try
-    {
-      ctData = domFactory->createElement(UNI("contact"));
-    }
-  catch (const XMLException& e)
-    {
-      char* msg = XMLString::transcode(e.getMessage());
-      cerr << msg << endl;
-      XMLString::release(&msg);
-      throw runtime_error("Exception occurred in XmlCTData::XmlCTData");
-    }
-  catch (...)
-    {
-      throw runtime_error("Unknown exception in XmlCTData::XmlCTData");
-    }
 }
 
 XmlCTData::~XmlCTData()
 {
-  DOMNode* parent = ctData->getParentNode();
-
-  if (parent != NULL)
-    {
-      parent->removeChild(ctData);
-    }
-  if (ctData != NULL)
-    {
-      ctData->release();
-    }
-  else
-    {
-      cerr << "Not releasing ctData in " << __PRETTY_FUNCTION__ << endl;
-    }
 }
 
 //! Sets the contact tracing start time
@@ -85,30 +56,6 @@ void
 XmlCTData::setCTStartTime(const double time)
 {
   myStartTime = time;
-  try
-    {
-      ctData->setAttribute(UNI("start"), UNINUM(time));
-    }
-  catch (const DOMException& e)
-    {
-      stringstream msg;
-      msg << "DOMException code: " << e.code;
-      throw runtime_error(msg.str().c_str());
-    }
-  catch (const XMLException& e)
-    {
-      throw runtime_error("XMLException setting CT start time");
-    }
-  catch (const exception& e)
-    {
-      cerr << e.what() << endl;
-      throw runtime_error("Exception setting CT start time");
-    }
-  catch (...)
-    {
-      throw runtime_error("Exception setting CT start time");
-    }
-
   hasStartTime = true;
 }
 
@@ -116,34 +63,14 @@ XmlCTData::setCTStartTime(const double time)
 void
 XmlCTData::setID(const size_t id)
 {
-  try
-    {
-      ctData->setAttribute(UNI("id"), UNINUM(id));
-    }
-  catch (const XMLException& e)
-    {
-      throw runtime_error("XMLException setting CT id");
-    }
-  catch (...)
-    {
-      throw runtime_error("Exception setting CT id");
-    }
-
+  myID = id;
   hasID = true;
 }
 
 size_t
 XmlCTData::getID()
 {
-  ctData->getAttribute(UNI("id"));
-
-  char* ascString = XMLString::transcode(ctData->getAttribute(UNI("id")));
-
-  size_t label = atoi(ascString);
-
-  XMLString::release(&ascString);
-
-  return label;
+  return myID;
 }
 
 bool
@@ -151,12 +78,38 @@ XmlCTData::hasContacts()
 {
   //! Returns true if ctData has contacts
 
-  if (ctData->hasChildNodes())
-    return true;
-  else
-    return false;
+  return !contacts.empty();
+}
+
+void
+XmlCTData::clear()
+{
+  //! Removes all contacts
+  contacts.clear();
+}
+
+void
+XmlCTData::assign(const XmlCTData& other)
+{
+  //! Replaces the contacts and start time with other's.  Type codes
+  //! are translated if other belongs to a different writer.
+
+  contacts = other.contacts;
+  if (other.writer != writer)
+    for (vector<CTRecord>::iterator it = contacts.begin(); it != contacts.end(); ++it)
+      it->type = writer->typeCode(other.writer->typeName(it->type).c_str());
+  myStartTime = other.myStartTime;
+  hasStartTime = other.hasStartTime;
 }
 
+//! Predicate for XmlCTData::truncate
+struct BeforeTime
+{
+  double t;
+  BeforeTime(const double t_) : t(t_) {}
+  bool operator()(const CTRecord& rec) const { return rec.time < t; }
+};
+
 void
 XmlCTData::truncate()
 {
@@ -166,62 +119,8 @@ XmlCTData::truncate()
   if (!hasStartTime)
     throw logic_error("Cannot truncate: no contact start time specified");
 
-  char* strTime;
-  double conTime;
-  DOMElement* child;
-  DOMElement* item;
-  DOMNodeList* contactInfo;
-  DOMElement * time;
-  const XMLCh* value;
-  DOMNodeList* children = ctData->getChildNodes();
-  vector<DOMElement*> removeElements;
-
-  //cout << "Num contacts = " << children->getLength() << endl;
-  try
-    {
-
-      // Find element < myStartTime
-      for (int i = 0; i < children->getLength(); ++i)
-        {
-          item = (DOMElement*) children->item(i);
-
-          if (item->getNodeType() != DOMNode::ELEMENT_NODE) continue;
-
-          contactInfo = item->getElementsByTagName(UNI("time"));
-          time = (DOMElement*) contactInfo->item(0);
-          value = time->getFirstChild()->getNodeValue();
-          strTime = XMLString::transcode(value);
-          conTime = atof(strTime);
-          XMLString::release(&strTime);
-
-          if (conTime < myStartTime)
-            {
-              removeElements.push_back(item);
-            }
-        }
-
-      // Remove them:
-      for (int i = 0; i < removeElements.size(); ++i)
-        {
-          ctData->removeChild(removeElements.at(i));
-        }
-
-    }
-  catch (DOMException& e)
-    {
-      cerr << XMLString::transcode(e.getMessage()) << endl;
-      throw runtime_error("DOMException in function truncate");
-    }
-  catch (XMLException& e)
-    {
-      cerr << XMLString::transcode(e.getMessage()) << endl;
-      throw runtime_error("XMLException in function truncate");
-    }
-  catch (...)
-    {
-      throw runtime_error("Unknown exception in function truncate");
-    }
-
+  contacts.erase(remove_if(contacts.begin(), contacts.end(), BeforeTime(myStartTime)),
+                 contacts.end());
 }
 
 void
@@ -230,137 +129,41 @@ XmlCTData::appendContact(const size_t _id, const bool _incoming,
 {
   // Appends contact data <from> information to ctData
 
-  DOMElement* from;
-  DOMElement* type;
-  DOMElement * time;
-  DOMText* value;
-
-  XMLCh* conType = XMLString::transcode(_type);
-
-  try
-    {
-      if (_incoming == true)
-        from = domFactory->createElement(UNI("from"));
-      else
-        from = domFactory->createElement(UNI("to"));
-      from->setAttribute(UNI("id"), UNINUM(_id));
-      if (_caused == true)
-        from->setAttribute(UNI("caused"), UNI("true"));
-
-      type = domFactory->createElement(UNI("type"));
-      value = domFactory->createTextNode(conType);
-      type->appendChild(value);
-
-      time = domFactory->createElement(UNI("time"));
-      value = domFactory->createTextNode(UNINUM(_time));
-      time->appendChild(value);
-
-      from->appendChild(type);
-      from->appendChild(time);
-
-      ctData->appendChild(from);
-
-      XMLString::release(&conType);
-    }
-  catch (const XMLException& e)
-    {
-      cerr << XMLString::transcode(e.getMessage()) << endl;
-      throw runtime_error(
-          "XMLException thrown in XmlCTWriter::appendContact(const XmlCTData*, const size_t, const Contype_e, const double)");
-    }
-  catch (...)
-    {
-      throw runtime_error(
-          "Unknown exception thrown in XmlCTWriter::appendContact(const XmlCTData*, const size_t, const Contype_e, const double)");
-    }
-}
-
-DOMElement*
-XmlCTData::getCtData()
-{
-  //! Returns a pointer to the contact tracing data contained here
-  return ctData;
+  contacts.push_back(CTRecord(_id, _incoming, writer->typeCode(_type), _time, _caused));
 }
 
 void
-XmlCTData::attachCtData(const DOMElement* toAttach)
+XmlCTData::dump(ostream& os)
 {
-  //! Attaches pre-existing ct data
-  //! Note: No validation of the data occurs here!
-  // Performs deep copy of toAttach
+  //! Writes the <contact> block to os as XML
 
-  if (ctData != NULL)
-    { // Get rid of pre-existing data.
-      ctData->release();
-    }
+  char buffer[100];
 
-  ctData = (DOMElement*) toAttach->cloneNode(true);
-}
+  sprintf(buffer, "<contact id=\"%lu\" start=\"%.9lf\">", myID, myStartTime);
+  os << buffer << "\n";
 
-void
-XmlCTData::dumpNode(const DOMNode* toDump)
-{
-  XMLCh tempStr[100];
-  XMLString::transcode("LS", tempStr, 99);
-  DOMImplementation* myImpl = DOMImplementationRegistry::getDOMImplementation(tempStr);
-  DOMLSSerializer* theSerializer =
-      ((DOMImplementationLS*) myImpl)->createLSSerializer();
-  if (theSerializer->getDomConfig()->canSetParameter(
-      XMLUni::fgDOMWRTFormatPrettyPrint, true))
-    theSerializer->getDomConfig()->setParameter(
-        XMLUni::fgDOMWRTFormatPrettyPrint, true);
-
-  XMLFormatTarget *myFormTarget = new StdOutFormatTarget();
-  DOMLSOutput* theOutput = ((DOMImplementationLS*) myImpl)->createLSOutput();
-  theOutput->setByteStream(myFormTarget);
-
-  try
+  for (vector<CTRecord>::const_iterator it = contacts.begin(); it != contacts.end(); ++it)
     {
-      // do the serialization through DOMLSSerializer::write();
-      theSerializer->write(toDump, theOutput);
+      const char* tag = it->incoming ? "from" : "to";
+      sprintf(buffer, "%.9lf", it->time);
+      os << "  <" << tag << (it->caused ? " caused=\"true\"" : "")
+         << " id=\"" << it->id << "\">\n"
+         << "    <type>" << writer->typeName(it->type) << "</type>\n"
+         << "    <time>" << buffer << "</time>\n"
+         << "  </" << tag << ">\n";
     }
-  catch (const XMLException& toCatch)
-    {
-      char* message = XMLString::transcode(toCatch.getMessage());
-      cout << "Exception message is: \n" << message << "\n";
-      XMLString::release(&message);
-    }
-  catch (const DOMException& toCatch)
-    {
-      char* message = XMLString::transcode(toCatch.msg);
-      cout << "Exception message is: \n" << message << "\n";
-      XMLString::release(&message);
-    }
-  catch (...)
-    {
-      cout << "Unexpected Exception \n";
-    }
-
-  theOutput->release();
-  theSerializer->release();
-  delete myFormTarget;
 
+  os << "</contact>" << endl;
 }
 
 XmlCTWriter::XmlCTWriter() :
-  parser(NULL)
+  stream(NULL), numBlocks(0)
 {
-  // Initialises the DOM
+  // Xerces is only needed for readFromFile
 
   try
     {
       XMLPlatformUtils::Initialize();
-
-      impl = DOMImplementation::getImplementation();
-      myDoctype = impl->createDocumentType(UNI("tracedcontacts"),
-          UNI(DTD_PUBLIC_ID), UNI(DTD_URI));
-
-      ctDoc = impl->createDocument(UNI("tracedcontacts"),
-          UNI("tracedcontacts"), myDoctype);
-      ctDoc->setXmlStandalone(0);
-
-
-      rootElem = ctDoc->getDocumentElement();
     }
   catch (const XMLException& e)
     {
@@ -379,38 +182,42 @@ XmlCTWriter::XmlCTWriter() :
 
 XmlCTWriter::~XmlCTWriter()
 {
-  // Destroy the DOM tree
-  ctDoc->release();
-  if (parser)
-    parser->release();
+  if (stream)
+    delete stream;
   XMLPlatformUtils::Terminate();
 }
 
+unsigned char
+XmlCTWriter::typeCode(const char* type)
+{
+  //! Returns the code for a contact type, registering it if new
+
+  map<string,unsigned char>::const_iterator found = typeCodes.find(type);
+  if (found != typeCodes.end()) return found->second;
+
+  if (typeNames.size() > 255)
+    throw logic_error("Too many contact types in XmlCTWriter");
+
+  unsigned char code = typeNames.size();
+  typeNames.push_back(type);
+  typeCodes.insert(make_pair(string(type), code));
+
+  return code;
+}
+
+const string&
+XmlCTWriter::typeName(const unsigned char code) const
+{
+  return typeNames.at(code);
+}
+
 XmlCTData*
 XmlCTWriter::createCTData(size_t label)
 {
   // Returns an object of type XmlCTData which is used to add contacts to
 
-  XmlCTData* myData;
-
-  try
-    {
-      myData = new XmlCTData(ctDoc);
-      myData->setID(label);
-    }
-  catch (const XMLException& e)
-    {
-      cerr << XMLString::transcode(e.getMessage()) << endl;
-      XMLPlatformUtils::Terminate();
-      throw runtime_error(
-          "Exception occurred in XmlCTWriter::createCTData(size_t,double)");
-    }
-  catch (...)
-    {
-      XMLPlatformUtils::Terminate();
-      throw runtime_error(
-          "Unknown exception in XmlCTWriter::createCTData(size_t,double)");
-    }
+  XmlCTData* myData = new XmlCTData(this);
+  myData->setID(label);
 
   return myData;
 }
@@ -418,137 +225,155 @@ XmlCTWriter::createCTData(size_t label)
 void
 XmlCTWriter::addCTData(XmlCTData* const _Data)
 {
-  // Adds a <contact> node
+  //! Publishes a <contact> block.  The block is final at this
+  //! point: it is written straight to the output stream if one
+  //! is open, otherwise queued for writeToFile.
 
-  DOMNode* newNode;
-
-  try
-    {
-      newNode = _Data->getCtData();
-    }
-  catch (const DOMException& e)
+  if (stream != NULL)
     {
-      stringstream msg;
-      msg << "Error importing node into output document.  DOM Exception code: " << e.code << endl;
-      throw runtime_error(msg.str().c_str());
+      writeBlock(_Data->myID, _Data->myStartTime, _Data->contacts);
     }
-  catch (...)
+  else
     {
-      XMLPlatformUtils::Terminate();
-      throw runtime_error(
-          "Unknown exception importing node in XmlCTWriter::addCTData(XmlCTData*)");
+      pending.push_back(Block());
+      pending.back().id = _Data->myID;
+      pending.back().start = _Data->myStartTime;
+      pending.back().contacts = _Data->contacts;
     }
 
-  try {
-    rootElem->appendChild(newNode);
-  }
-  catch (const DOMException& e)
-      {
-        stringstream msg;
-        msg << "Error appending node.  DOM Exception code: " << e.code << endl;
-        throw runtime_error(msg.str().c_str());
-      }
-    catch (...)
-      {
-        XMLPlatformUtils::Terminate();
-        throw runtime_error(
-            "Unknown exception appending node in XmlCTWriter::addCTData(XmlCTData*)");
-      }
+  numBlocks++;
 }
 
+bool
+XmlCTWriter::hasContacts()
+{
+  //! Returns true if any <contact> blocks have been added
+  return numBlocks > 0;
+}
 
 void
 XmlCTWriter::resetDOM()
 {
-  //! Resets the DOM, deleting all
-  // contact information
+  //! Discards queued contact information
 
-  DOMNodeList* contacts = rootElem->getChildNodes();
+  pending.clear();
+  numBlocks = 0;
+}
 
-  for(size_t i=0; i < contacts->getLength(); ++i) {
-    rootElem->removeChild(contacts->item(i));
-  }
+void
+XmlCTWriter::open(const string filename)
+{
+  //! Opens filename for streaming output.  Blocks are then
+  //! written as they are added, so memory use stays bounded.
+  //! Format follows the suffix: .ctb binary, .ctb.gz compressed
+  //! binary, otherwise XML.
+
+  if (stream != NULL)
+    delete stream;
+
+  stream = new CTStreamWriter(filename, CTStreamWriter::formatFromFilename(filename));
+  streamFilename = filename;
+  streamCodes.clear();
 
+  for (vector<Block>::const_iterator it = pending.begin(); it != pending.end(); ++it)
+    writeBlock(it->id, it->start, it->contacts);
+  pending.clear();
 }
 
 void
-XmlCTWriter::writeToFile(const string filename)
+XmlCTWriter::writeBlock(const size_t id, const double start, const vector<CTRecord>& contacts)
 {
-  // Writes out to a file
+  // Translates our type codes into the stream's and writes
 
-  DOMLSSerializer* ctWriter =
-      ((DOMImplementationLS*) impl)->createLSSerializer();
-  XMLFormatTarget* formatTarget = new LocalFileFormatTarget(filename.c_str());
-  DOMLSOutput* theOutput = ((DOMImplementationLS*) impl)->createLSOutput();
-  theOutput->setByteStream(formatTarget);
+  while (streamCodes.size() < typeNames.size())
+    streamCodes.push_back(stream->typeCode(typeNames[streamCodes.size()].c_str()));
 
-  if (ctWriter->getDomConfig()->canSetParameter(
-      XMLUni::fgDOMWRTFormatPrettyPrint, true))
-    {
-      ctWriter->getDomConfig()->setParameter(XMLUni::fgDOMWRTFormatPrettyPrint,
-          true);
-    }
+  bool sameCodes = true;
+  for (size_t k = 0; k < streamCodes.size(); ++k)
+    if (streamCodes[k] != k) { sameCodes = false; break; }
 
-  try {
-    ctDoc->normalizeDocument();
-  }
-  catch (const DOMException& e)
-      {
-        cerr << XMLString::transcode(e.getMessage()) << endl;
-        XMLPlatformUtils::Terminate();
-        throw runtime_error("DOMException in XMLCTWriter::writeToFile(char*) whilst normalising document");
-      }
-  catch (...)
-      {
-        XMLPlatformUtils::Terminate();
-        throw runtime_error(
-            "Unknown exception in XMLCTWriter::writeToFile(char*) whilst normalising document");
-      }
-  try
+  if (sameCodes)
     {
-      ctWriter->write(ctDoc, theOutput);
+      stream->writeBlock(id, start, contacts);
     }
-  catch (const XMLException& e)
+  else
     {
-      cerr << XMLString::transcode(e.getMessage()) << endl;
-      XMLPlatformUtils::Terminate();
-      throw runtime_error("XMLException in XMLCTWriter::writeToFile(char*)");
+      vector<CTRecord> translated(contacts);
+      for (vector<CTRecord>::iterator it = translated.begin(); it != translated.end(); ++it)
+        it->type = streamCodes[it->type];
+      stream->writeBlock(id, start, translated);
     }
-  catch (const DOMException& e)
+}
+
+void
+XmlCTWriter::writeToFile(const string filename)
+{
+  // Writes out to a file, closing the output stream.  If a stream
+  // is open it must be on filename, else its blocks would be lost.
+
+  if (stream != NULL && streamFilename != filename)
+    throw logic_error("XmlCTWriter::writeToFile: output stream is open on '"
+                      + streamFilename + "', not '" + filename + "'");
+
+  try
     {
-      cerr << XMLString::transcode(e.getMessage()) << endl;
-      XMLPlatformUtils::Terminate();
-      throw runtime_error("DOMException in XMLCTWriter::writeToFile(char*)");
+      if (stream == NULL)
+        open(filename);
+
+      stream->close();
     }
-  catch (...)
+  catch (const exception& e)
     {
-      XMLPlatformUtils::Terminate();
-      throw runtime_error(
-          "Unknown exception in XMLCTWriter::writeToFile(char*)");
+      cerr << e.what() << endl;
+      delete stream;
+      stream = NULL;
+      throw runtime_error("Exception in XMLCTWriter::writeToFile(char*)");
     }
 
-  theOutput->release();
-  ctWriter->release();
-  delete formatTarget;
-
+  delete stream;
+  stream = NULL;
+  streamFilename.clear();
 }
 
 void
 XmlCTWriter::readFromFile(const string filename, map<int, XmlCTData*> ctData)
 {
-  // Reads existing contact.xml in
+  // Reads existing contact tracing data in, either XML or
+  // a binary stream written by CTStreamWriter
+
+  if (CTStreamReader::isBinary(filename))
+    readBinary(filename, ctData);
+  else
+    readXml(filename, ctData);
+}
 
+void
+XmlCTWriter::readBinary(const string filename, map<int, XmlCTData*>& ctData)
+{
+  CTStreamReader reader(filename);
+  size_t label;
+  double ctStartTime;
+  vector<CTRecord> contacts;
 
-//  XercesDOMParser* parser = new XercesDOMParser();
-//  parser->setValidationScheme(XercesDOMParser::Val_Never);
-//  parser->setDoNamespaces(false); // optional
-//
-//  ErrorHandler* errHandler = (ErrorHandler*) new HandlerBase();
-//  parser->setErrorHandler(errHandler);
-//
-//  parser->setCreateEntityReferenceNodes(true);
-//  parser->setIncludeIgnorableWhitespace(false);
+  while (reader.next(label, ctStartTime, contacts))
+    {
+      map<int, XmlCTData*>::iterator found = ctData.find(label);
+      if (found == ctData.end())
+        throw EpiRisk::parse_exception("Label not found in contact data");
+      XmlCTData* indiv = found->second;
+
+      indiv->setCTStartTime(ctStartTime);
+      indiv->setID(label);
+      indiv->clear();
+
+      for (vector<CTRecord>::const_iterator it = contacts.begin(); it != contacts.end(); ++it)
+        indiv->appendContact(it->id, it->incoming, reader.typeName(it->type).c_str(), it->time, it->caused);
+    }
+}
 
+void
+XmlCTWriter::readXml(const string filename, map<int, XmlCTData*>& ctData)
+{
   DOMDocument* doc;
   XMLCh tempStr[100];
   XMLString::transcode("LS", tempStr, 99);
@@ -560,8 +385,8 @@ XmlCTWriter::readFromFile(const string filename, map<int, XmlCTData*> ctData)
       parser->getDomConfig()->setParameter(XMLUni::fgDOMValidate, false);
   if (parser->getDomConfig()->canSetParameter(XMLUni::fgDOMNamespaces, false))
       parser->getDomConfig()->setParameter(XMLUni::fgDOMNamespaces, false);
-  if (parser->getDomConfig()->canSetParameter(XMLUni::fgDOMElementContentWhitespace, true))
-      parser->getDomConfig()->setParameter(XMLUni::fgDOMElementContentWhitespace , true);
+  if (parser->getDomConfig()->canSetParameter(XMLUni::fgDOMElementContentWhitespace, false))
+      parser->getDomConfig()->setParameter(XMLUni::fgDOMElementContentWhitespace , false);
 
 
   try
@@ -599,6 +424,10 @@ XmlCTWriter::readFromFile(const string filename, map<int, XmlCTData*> ctData)
   XMLCh* contactTag = XMLString::transcode("contact");
   XMLCh* idAttr = XMLString::transcode("id");
   XMLCh* startTimeAttr = XMLString::transcode("start");
+  XMLCh* causedAttr = XMLString::transcode("caused");
+  XMLCh* typeTag = XMLString::transcode("type");
+  XMLCh* timeTag = XMLString::transcode("time");
+  XMLCh* fromTag = XMLString::transcode("from");
   char* cCharBuff;
   int label;
   double ctStartTime;
@@ -621,41 +450,51 @@ XmlCTWriter::readFromFile(const string filename, map<int, XmlCTData*> ctData)
       XMLString::release(&cCharBuff);
 
       // Add contacts to map
-      try
-        {
-          map<int, XmlCTData*>::iterator found = ctData.find(label);
-          if (found == ctData.end())
-            throw logic_error("Label not found in contact data");
-          indiv = found->second;
-        }
-      catch (range_error& e)
-        {
-          throw EpiRisk::parse_exception(e.what());
-        }
+      map<int, XmlCTData*>::iterator found = ctData.find(label);
+      if (found == ctData.end())
+        throw EpiRisk::parse_exception("Label not found in contact data");
+      indiv = found->second;
 
       indiv->setCTStartTime(ctStartTime);
       indiv->setID(label);
+      indiv->clear();
 
-      try {
-        indiv->ctData->release();
-        indiv->ctData = (DOMElement*) ctDoc->importNode(currElem,true);
-      }
-      catch (DOMException& e) {
-        char* msg = XMLString::transcode(e.getMessage());
-        cerr << "Exception importing input contact to contact tracing: " << msg << endl;
-        XMLString::release(&msg);
-        throw EpiRisk::parse_exception("DOMException parsing contact data");
-      }
-      catch (...) {
-        throw EpiRisk::parse_exception("Unexpected error reading contact tracing data");
-      }
+      // Copy each <from>/<to> element into compact records
+      for (DOMNode* child = currElem->getFirstChild(); child != NULL; child = child->getNextSibling())
+        {
+          if (child->getNodeType() != DOMNode::ELEMENT_NODE) continue;
+          DOMElement* conElem = (DOMElement*) child;
+
+          bool incoming = XMLString::equals(conElem->getTagName(), fromTag);
+          bool caused = conElem->hasAttribute(causedAttr);
+
+          cCharBuff = XMLString::transcode(conElem->getAttribute(idAttr));
+          size_t conId = atoi(cCharBuff);
+          XMLString::release(&cCharBuff);
 
+          DOMNode* typeNode = conElem->getElementsByTagName(typeTag)->item(0);
+          DOMNode* timeNode = conElem->getElementsByTagName(timeTag)->item(0);
+          if (typeNode == NULL || timeNode == NULL)
+            throw EpiRisk::parse_exception("Contact without <type> or <time> in contact data");
+
+          cCharBuff = XMLString::transcode(timeNode->getTextContent());
+          double conTime = atof(cCharBuff);
+          XMLString::release(&cCharBuff);
+
+          cCharBuff = XMLString::transcode(typeNode->getTextContent());
+          indiv->appendContact(conId, incoming, cCharBuff, conTime, caused);
+          XMLString::release(&cCharBuff);
+        }
     }
 
   // Cleanup
   XMLString::release(&contactTag);
   XMLString::release(&idAttr);
   XMLString::release(&startTimeAttr);
+  XMLString::release(&causedAttr);
+  XMLString::release(&typeTag);
+  XMLString::release(&timeTag);
+  XMLString::release(&fromTag);
 
   parser->release();
 
@@ -17,15 +17,17 @@
  * You should have received a copy of the GNU General Public License
  * along with InFER.  If not, see <http://www.gnu.org/licenses/>. 
  */
-
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Name: XmlCTWriter                                                //
 // Author: C.Jewell                                                 //
 // Created: 23/11/2007                                              //
-// Purpose: Implements a DOM to hold, and write to disk, simulated  //
-//           contact tracing data                                   //
-// Requirements: Xerces-c XML parsing library                       //
+// Purpose: Holds, and streams to disk, simulated contact tracing   //
+//           data.  Each individual's contacts are kept as compact  //
+//           records until published with addCTData, at which point //
+//           the block is written out (or queued until writeToFile  //
+//           if no output stream is open).                          //
+// Requirements: Xerces-c XML parsing library (reading only)        //
 //                                                                  //
 //////////////////////////////////////////////////////////////////////
 
@@ -47,10 +49,7 @@
 #include <xercesc/util/PlatformUtils.hpp>
 #include <xercesc/util/XMLString.hpp>
 #include <xercesc/dom/DOM.hpp>
-#include <xercesc/framework/StdOutFormatTarget.hpp>
-#include <xercesc/framework/LocalFileFormatTarget.hpp>
 #include <xercesc/util/OutOfMemoryException.hpp>
-#include <xercesc/dom/DOMDocumentTraversal.hpp>
 
 #if defined(XERCES_NEW_IOSTREAMS)
 #include <iostream>
@@ -60,6 +59,9 @@
 #define _UNICODE 1
 
 
+#include "CTStreamWriter.hpp"
+
+
 // Namespaces
 
 XERCES_CPP_NAMESPACE_USE
@@ -84,12 +86,15 @@ using namespace std;
 
 // Class decls
 
+class XmlCTWriter;
+
 class XmlCTData
 {
 private:
-  DOMDocument* domFactory;
+  XmlCTWriter* writer;
+  size_t myID;
   double myStartTime;
-  DOMElement* ctData;
+  vector<CTRecord> contacts;
 
 protected:
 
@@ -98,7 +103,7 @@ protected:
 
 public:
   
-  XmlCTData(DOMDocument*);
+  XmlCTData(XmlCTWriter*);
   ~XmlCTData();
   void setCTStartTime(const double time);
   void setID(const size_t id);
@@ -110,12 +115,10 @@ public:
 		     const double _time,
 		     const bool _caused = false); 
   bool hasContacts();
+  void clear();
+  void assign(const XmlCTData& other); // Copies contacts, from any writer
 
-  DOMElement* getCtData(); // Returns CT Data
-  void attachCtData(const DOMElement* toAttach); // Attaches existing ctdata
-  void detachCtData(); // Resets the DOM
-
-  void dumpNode(const DOMNode* toDump);
+  void dump(ostream& os); // Writes the <contact> block to os
 
   friend class XmlCTWriter;
 };
@@ -125,11 +128,25 @@ public:
 class XmlCTWriter {
 
 private:
-  DOMImplementation* impl;
-  DOMDocumentType* myDoctype;
-  DOMDocument* ctDoc;
-  DOMElement* rootElem;
-  DOMLSParser* parser;
+  struct Block
+  {
+    size_t id;
+    double start;
+    vector<CTRecord> contacts;
+  };
+
+  vector<string> typeNames;
+  map<string,unsigned char> typeCodes;
+
+  CTStreamWriter* stream;
+  string streamFilename;
+  vector<unsigned char> streamCodes; // Our type codes -> stream's
+  vector<Block> pending;
+  size_t numBlocks;
+
+  void writeBlock(const size_t id, const double start, const vector<CTRecord>& contacts);
+  void readBinary(const string filename, map<int, XmlCTData*>& ctData);
+  void readXml(const string filename, map<int, XmlCTData*>& ctData);
 
 public:
   XmlCTWriter();
@@ -138,11 +155,12 @@ public:
   void addCTData(XmlCTData* const ctData);
   bool hasContacts();
   void resetDOM();
+  void open(const string filename);
   void writeToFile(const string filename);
   void readFromFile(const string filename, map<int, XmlCTData*> ctData);
 
-
-
+  unsigned char typeCode(const char* type);
+  const string& typeName(const unsigned char code) const;
 
 };
 
@@ -22,6 +22,9 @@
 #include "contactMatrix.h"
 #endif
 
+#include <cstdio>
+#include <string>
+
 #define SET_BIT(x,y) *(*(contact_bitmap+y)+x/8) |= (0x80 >> ((x)%8))
 #define GET_BIT(y,x) (*(*(contact_bitmap+y)+x/8) & (0x80 >> ((x)%8)))
 
@@ -56,23 +59,56 @@ int contactMat::init(const char *filename, int myN_total) {
 
 
   ifstream inFile;
-  char *line = new char[N_total+1];
 
-  inFile.open(filename,ios::in);
+  inFile.open(filename,ios::in | ios::binary);
   if(!inFile.is_open()) {
     cerr << "Error opening contact matrix file '" << filename << "'" << endl;
     return(-1);
   }
 
+  // Work out the format from the start of the file
+  int rv;
+  char magic[CONTACTMAT_MAGIC_LEN];
+  inFile.read(magic,CONTACTMAT_MAGIC_LEN);
+  if(inFile.gcount() == CONTACTMAT_MAGIC_LEN &&
+     string(magic,CONTACTMAT_MAGIC_LEN) == CONTACTMAT_MAGIC) {
+    rv = readBinary(inFile);
+  }
+  else {
+    inFile.clear();
+    inFile.seekg(0);
+    string first;
+    getline(inFile,first);
+    inFile.clear();
+    inFile.seekg(0);
+    if(first.empty() || first[0] == '#' || first.find(' ') != string::npos)
+      rv = readEdges(inFile);
+    else
+      rv = readText(inFile);
+  }
+
+  inFile.close();
+
+  return(rv);
+}
+
+
+
+int contactMat::readText(ifstream& inFile) {
+  // Lower triangle as rows of '0' and '1'
+  char *line = new char[N_total+1];
+
   for(int i=0; i < N_total; ++i) {
     if(inFile.eof()) {
       cerr << "Premature EOF in contactMat::fileGen" << endl;
+      delete[] line;
       return(-1);
     }
 
     inFile.getline(line,N_total+1);
     if(line[0] == '\0') {
       cerr << "Empty line encountered!" << endl;
+      delete[] line;
       return(-1);
     }
 
@@ -84,7 +120,86 @@ int contactMat::init(const char *filename, int myN_total) {
     }
   }
 
-  inFile.close();
+  delete[] line;
+  return(0);
+}
+
+
+
+int contactMat::readEdges(ifstream& inFile) {
+  // "i j" pairs, one per line
+  string line;
+  long i,j;
+  for(i=0; i < N_total; ++i) SET_BIT(i,i); // As in the text format
+  while(getline(inFile,line)) {
+    if(line.empty() || line[0] == '#' || line[0] == '\r') continue;
+    if(sscanf(line.c_str(),"%ld %ld",&i,&j) != 2) {
+      cerr << "Malformed edge '" << line << "'" << endl;
+      return(-1);
+    }
+    if(i < 0 || j < 0 || i >= N_total || j >= N_total) {
+      cerr << "Edge " << i << " " << j << " outside population" << endl;
+      return(-1);
+    }
+    SET_BIT(j,i);
+    SET_BIT(i,j);
+  }
+
+  return(0);
+}
+
+
+
+int contactMat::readBinary(ifstream& inFile) {
+  // Bit-packed lower triangle after the magic
+  unsigned char size[8];
+  inFile.read((char*)size,8);
+  if(inFile.gcount() != 8) {
+    cerr << "Premature EOF in contactMat::readBinary" << endl;
+    return(-1);
+  }
+  unsigned long long N = 0;
+  for(int k=7; k >= 0; --k) N = (N << 8) | size[k];
+  if(N != (unsigned long long)N_total) {
+    cerr << "Contact matrix is for " << N << " individuals, not " << N_total << endl;
+    return(-1);
+  }
+
+  for(int k=0; k < N_total; ++k) SET_BIT(k,k); // As in the text format
+
+  unsigned long long numBytes = ((unsigned long long)N_total*(N_total-1)/2 + 7) / 8;
+  vector<char> buffer(1 << 16);
+  int i=1, j=0; // Position of the next bit
+  while(numBytes > 0) {
+    size_t chunk = numBytes < buffer.size() ? numBytes : buffer.size();
+    inFile.read(&buffer[0],chunk);
+    if((size_t)inFile.gcount() != chunk) {
+      cerr << "Premature EOF in contactMat::readBinary" << endl;
+      return(-1);
+    }
+    numBytes -= chunk;
+
+    for(size_t byte=0; byte < chunk; ++byte) {
+      if(buffer[byte] == 0x00) {
+        j += 8;
+        while(j >= i && i < N_total) {
+          j -= i;
+          ++i;
+        }
+        continue;
+      }
+      for(int bit=0; bit < 8 && i < N_total; ++bit) {
+        if(buffer[byte] & (0x80 >> bit)) {
+          SET_BIT(j,i);
+          SET_BIT(i,j);
+        }
+        if(++j == i) {
+          ++i;
+          j = 0;
+        }
+      }
+    }
+  }
 
   return(0);
 }
@@ -96,3 +211,20 @@ float contactMat::isConn(int x, int y) {
   else return 0.0;
 }
 
+
+
+
+size_t contactMat::connections(int x, vector<int>& conns) {
+  // Fills conns with the individuals connected to x,
+  // skipping empty bytes of the bitmap row.
+  conns.clear();
+  char* row = *(contact_bitmap+x);
+  for(int byte=0; byte < N_total/8 + 1; ++byte) {
+    if(row[byte] == 0x00) continue;
+    for(int bit=0; bit < 8; ++bit) {
+      int y = byte*8 + bit;
+      if(y < N_total && (row[byte] & (0x80 >> bit))) conns.push_back(y);
+    }
+  }
+  return conns.size();
+}
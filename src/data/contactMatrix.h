@@ -18,7 +18,14 @@
  * along with InFER.  If not, see <http://www.gnu.org/licenses/>. 
  */
 
-/* contactMatrix takes the *lower* triangle of a contact matrix and stores it as a bitmap */
+/* contactMatrix takes the *lower* triangle of a contact matrix and stores it as a bitmap.
+   init() reads three file formats:
+     - text: row i is i characters '0' or '1' for columns j < i, then the diagonal
+     - edge list: one "i j" pair of 0-based labels per line, '#' lines are comments
+     - binary: CONTACTMAT_MAGIC, the population size as a little endian 64 bit
+       integer, then the lower triangle (j < i) packed row by row, most
+       significant bit first, padded to a whole byte at the end
+   The diagonal is always set for the edge list and binary formats. */
 
 #ifndef INCLUDE_CONTACTMATRIX_H
 #define INCLUDE_CONTACTMATRIX_H
@@ -26,13 +33,21 @@
 #include <iostream>
 #include <fstream>
 #include <math.h>
+#include <vector>
 
 using namespace std;
 
+#define CONTACTMAT_MAGIC "CMTX"
+#define CONTACTMAT_MAGIC_LEN 4
+
 class contactMat {
  private:
   int N_total;
   char **contact_bitmap;
+
+  int readText(ifstream&);
+  int readEdges(ifstream&);
+  int readBinary(ifstream&);
  public:
 
   contactMat();
@@ -40,6 +55,7 @@ class contactMat {
   
   int init(const char*,int);
   float isConn(int,int);
+  size_t connections(int,vector<int>&);
 };
 
 #endif
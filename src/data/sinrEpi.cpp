@@ -194,6 +194,11 @@ int sinrEpi::init(const size_t myN_total,
 
 
 
+  // Copy the hot fields into the store
+  syncStore();
+
+
+
   /* Set up the contact matrix */
   sprintf(filename,"%s.fm",contactPrefix);
   cout << "Reading feedmill matrix from " << filename << "...";
@@ -341,6 +346,9 @@ int sinrEpi::addInfec(Spos_t susc_pos, eventTime_t thisI, eventTime_t thisN, eve
   susceptible.at(susc_pos)->status = INFECTED;
   infected.push_back(susceptible.at(susc_pos));
   susceptible.erase(susceptible.begin()+susc_pos);
+
+  store.set(*infected.back());
+  store.addInfective(infected.back()->label);
   return(0);
 }
 
@@ -355,17 +363,26 @@ int sinrEpi::delInfec(Ipos_t infec_pos)
   susceptible.back()->status = SUSCEPTIBLE;
   susceptible.back()->I = susceptible.back()->N;
   infected.erase(infected.begin()+infec_pos);
+
+  store.set(*susceptible.back());
+  store.indexInfectives(infected.begin(),infected.end());
   return(0);
 }
 
 
 
+void sinrEpi::setI(Ilabel_t label, eventTime_t time)
+{
+  individuals[label].I = time;
+  store.I[label] = time;
+}
+
 
 
-double sinrEpi::exposureI(Ipos_t i, Ipos_t j)
+void sinrEpi::syncStore()
 {
-  // NB: This gives time that susceptible j is exposed to infective i before becoming infected
-  return GSL_MIN(individuals[i].N,individuals[j].I) - GSL_MIN(individuals[i].I,individuals[j].I);
+  store.assign(individuals.begin(),individuals.end());
+  store.indexInfectives(infected.begin(),infected.end());
 }
 
 
@@ -378,14 +395,14 @@ double sinrEpi::exposureIBeforeCT(Ipos_t i, Ipos_t j)
  
   double stopTime;
   double startTime;
-  double earliestContactStart = GSL_MIN(individuals[i].contactStart,
-					individuals[j].contactStart);
+  double earliestContactStart = GSL_MIN(store.contactStart[i],
+					store.contactStart[j]);
 
-  stopTime = GSL_MIN(individuals[i].N,individuals[j].I);
+  stopTime = GSL_MIN(store.N[i],store.I[j]);
   stopTime = GSL_MIN(earliestContactStart,stopTime);
 
-  startTime = GSL_MIN(individuals[j].I,individuals[i].I);
-  startTime = GSL_MIN(earliestContactStart,stopTime);
+  startTime = GSL_MIN(store.I[j],store.I[i]);
+  startTime = GSL_MIN(earliestContactStart,startTime);
 
   return stopTime - startTime;
 }
@@ -397,40 +414,17 @@ double sinrEpi::ITimeBeforeCT(Ipos_t i)
   // Returns the amount of time between I and start of CT window
   // Non-neg if CTstart > I, 0 otherwise
 
-  double iTime = individuals.at(i).contactStart - individuals[i].I;
+  double iTime = store.contactStart.at(i) - store.I[i];
 
   if(iTime > 0) return iTime;
   else return 0.0;
 }
 
 
-double sinrEpi::exposureN(Ipos_t i, Ipos_t j)
-{
-  // NB: This gives time that susceptible j is exposed to notified i before becoming infected
-  return GSL_MIN(individuals[i].R,individuals[j].I) - GSL_MIN(individuals[j].I,individuals[i].N);
-}
-
-
-
-double sinrEpi::ITime(Ipos_t i) 
-{
-  // NB: Gives the time for which i was infectious but not notified
-  return individuals.at(i).N - individuals[i].I;
-}
-
-
-
-double sinrEpi::NTime(Ipos_t i) {
-  // NB: Gives the time for which i was notified
-  return individuals[i].R - individuals[i].N;
-}
-
-
-
 double sinrEpi::STime(Ipos_t i)
 {
   // NB: Gives the time for which i was susceptible
-  return individuals[i].I - infected[I1]->I;
+  return store.I[i] - store.I[infected[I1]->label];
 }
 
 
@@ -441,8 +435,9 @@ Ipos_t sinrEpi::updateI1()
 
   Ipos_t myI1_index = 0;
 
-  for(unsigned int h=0; h < infected.size(); ++h) {
-    if(infected[h]->I < infected[myI1_index]->I) {
+  const vector<size_t>& labels = store.infectives;
+  for(unsigned int h=0; h < labels.size(); ++h) {
+    if(store.I[labels[h]] < store.I[labels[myI1_index]]) {
       myI1_index = h;
     }
   }
@@ -506,8 +501,8 @@ double sinrEpi::sumI()
   // Add up all the infection times excluding I1
 
   double sumI = 0.0;
-  for(size_t i = 0; i<infected.size(); ++i) {
-    if(i != I1) sumI += infected[i]->I;
+  for(size_t i = 0; i<store.infectives.size(); ++i) {
+    if(i != I1) sumI += store.I[store.infectives[i]];
   }
   return sumI;
 }
@@ -35,6 +35,7 @@
 #include "contactMatrix.h"
 #include "speciesMat.h"
 #include "infection.hpp"
+#include "PopulationStore.hpp"
 #include "SAXContactParse.hpp"
 
 using namespace std;
@@ -84,6 +85,7 @@ class sinrEpi {
   contactMat cp_Mat, fm_Mat, sh_Mat;
   vector<frequencies> cFreq;
   SpeciesMatrix species;
+  PopulationStore store; // Hot fields by label, kept in step with individuals
 
   /* Public methods */
 
@@ -97,12 +99,14 @@ class sinrEpi {
 		   const double _obsTime);
   int addInfec(Ilabel_t,eventTime_t,eventTime_t,eventTime_t);
   int delInfec(Ipos_t);
-  double exposureI(Ipos_t,Ipos_t); // Time for which j is exposed to infected i
+  void setI(Ilabel_t,eventTime_t); // Sets an infection time, keeping store in step
+  void syncStore(); // Recopies store from individuals and infected
+  double exposureI(Ipos_t i,Ipos_t j) { return store.exposureI(i,j); } // Time for which j is exposed to infected i
   double exposureIBeforeCT(Ipos_t,Ipos_t);
   double ITimeBeforeCT(Ipos_t);
-  double exposureN(Ipos_t,Ipos_t); // Time for which j is exposed to notified i
-  double ITime(Ipos_t); // Time for which i was infective
-  double NTime(Ipos_t); // Time for which i was notified
+  double exposureN(Ipos_t i,Ipos_t j) { return store.exposureN(i,j); } // Time for which j is exposed to notified i
+  double ITime(Ipos_t i) { return store.ITime(i); } // Time for which i was infective
+  double NTime(Ipos_t i) { return store.NTime(i); } // Time for which i was notified
   double STime(Ipos_t); // Time for which i was susceptible
   Ipos_t updateI1(); // Updates and returns I1
   Ipos_t I2(); // Finds I2
@@ -19,8 +19,12 @@
  */
 
 // Implementation of species storage class
+#include <algorithm>
+
 #include "speciesMat.h"
 
+const uint8_t SpeciesMatrix::NOSPECIES;
+
 SpeciesMatrix::SpeciesMatrix() :
   nPremises(0),
   nSpecies(0),
@@ -33,16 +37,11 @@ SpeciesMatrix::SpeciesMatrix() :
 
 SpeciesMatrix::~SpeciesMatrix()
 {
-  // Destructor cleans up nicely.
-  if(isInit == 1) {
-  for(size_t i=0; i < nSpecies; ++i) {
-    delete[] speciesMat[i];
-  }
-
-  delete[] speciesMat;
-  }
+  // Destructor
 }
 
+
+
 int SpeciesMatrix::initialize(const char filename[],const size_t n, const size_t p)
 {
   // Constructor takes args filename (name of matrix file),
@@ -55,14 +54,13 @@ int SpeciesMatrix::initialize(const char filename[],const size_t n, const size_t
   nPremises = n;
   nSpecies = p;
 
-  // Create an array of pointers to array
-  //  - this is our "rows"
-  speciesMat = new bool*[nPremises];
-
-  for(size_t row=0; row < nPremises; ++row) {
-    speciesMat[row] = new bool[nSpecies];
+  if(nSpecies >= NOSPECIES) {
+    cerr << "Too many species (" << nSpecies << ")" << endl;
+    return(-3);
   }
 
+  speciesCode.assign(nPremises,NOSPECIES);
+
   // Open our input file and read in the contents
   inputFile.open(filename,ios::in);
   if(!inputFile.is_open()) {
@@ -78,17 +76,22 @@ int SpeciesMatrix::initialize(const char filename[],const size_t n, const size_t
       return(-2);
     }
 
+    // Take the first species flagged
     for(size_t col=0; col < nSpecies; ++col) {
       if(line.at(col) == '1') {
-	speciesMat[row][col] = 1;
-      }
-      else {
-	speciesMat[row][col] = 0;
+	speciesCode[row] = col;
+	break;
       }
     }
   }
 
   isInit = 1;
+
+  // Rebuild for any parameters set before the data arrived
+  vector<double> susc;
+  susc.swap(speciesSusc);
+  setSusceptibility(susc.empty() ? NULL : &susc[0],susc.size());
+
   return 0;
 }
 
@@ -98,7 +101,7 @@ double SpeciesMatrix::at(const size_t premises, const size_t species)
 {
   // Returns an entry in the species matrix
   if(premises < nPremises && species < nSpecies) {
-    if(speciesMat[premises][species] == 0) {
+    if(speciesCode[premises] != species) {
     return 0.0;
     }
     else {
@@ -110,3 +113,20 @@ double SpeciesMatrix::at(const size_t premises, const size_t species)
     throw "Range error";
   }
 }
+
+
+
+void SpeciesMatrix::setSusceptibility(const double susc[], const size_t n)
+{
+  // Gathers each premises' susceptibility through its species code
+  if(premSusc.size() == nPremises && speciesSusc.size() == n &&
+     equal(speciesSusc.begin(),speciesSusc.end(),susc)) return;
+
+  speciesSusc.assign(susc,susc+n);
+
+  vector<double> table(NOSPECIES+1,1.0);
+  for(size_t k=0; k < n && k < nSpecies; ++k) table[k] = susc[k];
+
+  premSusc.resize(nPremises);
+  for(size_t i=0; i < nPremises; ++i) premSusc[i] = table[speciesCode[i]];
+}
@@ -20,7 +20,9 @@
 
 // This class sets up a storage matrix for species
 // It takes a matrix of 1's and 0's with only 1 or 0 occurances
-// of a 1 in any row.
+// of a 1 in any row.  Each row is stored as a one byte species
+// code, and a per-premises susceptibility vector is kept for the
+// current species parameters.
 
 #ifndef _INCLUDE_SPECIESMAT_H
 #define _INCLUDE_SPECIESMAT_H
@@ -28,21 +30,36 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
+
+#include <stdint.h>
 
 using namespace std;
  
 class SpeciesMatrix {
  private:
-  bool** speciesMat;
+  vector<uint8_t> speciesCode;
+  vector<double> speciesSusc;  // Susceptibility parameter per species
+  vector<double> premSusc;     // Susceptibility per premises
   size_t nPremises,nSpecies;
-  int rv;
   bool isInit;
 
  public:
+  static const uint8_t NOSPECIES = 255;
+
   SpeciesMatrix();
   ~SpeciesMatrix();
   int initialize(const char[],const size_t, const size_t);
   double at(const size_t,const size_t);
+
+  // Species of a premises, NOSPECIES if none is set
+  uint8_t code(const size_t premises) const { return speciesCode[premises]; }
+
+  // Refreshes the susceptibility vector from n species parameters.
+  // Premises with no species, or a species beyond n, get 1.0.  Does
+  // nothing if the parameters are unchanged.
+  void setSusceptibility(const double[], const size_t);
+  double susceptibility(const size_t premises) const { return premSusc[premises]; }
 };
 
 #endif
@@ -22,8 +22,10 @@
 // Name: adaptive.cpp                                              //
 // Author: C.P.Jewell                                              //
 // Purpose: McmcOutput contains the output from an MCMC algorithm. //
-//          It calculates the variance-covariance matrix of the    //
-//           posterior at time intervals set at initialisation.    //
+//          It maintains the mean and the Cholesky factor of the   //
+//          variance-covariance matrix of the posterior online,    //
+//          using Welford updates and rank-one Cholesky updates,   //
+//          at O(p^2) cost per iteration.                          //
 /////////////////////////////////////////////////////////////////////
 
 
@@ -33,11 +35,14 @@
   #include "adaptive.h"
 
   double mySigma[] = {1,1,1,1,1}
-  McmcOutput myOutput(5,100,10000,mySigma}
+  McmcOutput myOutput(5,100,mySigma}
+
+  // Optionally, adapt every iteration from iteration 500 onwards
+  myOutput.setSchedule(500,1);
 
   //MCMC Loop:
   for(int mcmcIter = 0; mcmcIter < 100000; ++mcmcIter) {
-    
+
     // Generate proposal:
 
     gsl_matrix* propSD = McmcOutput.scaleChol(2.38)
@@ -48,50 +53,64 @@
     // Add the current state to the posterior
 
     McmcOutput.add(parms)
-  } 
+  }
 
 */
 
 
 
+#include <cmath>
+
 #include "adaptive.h"
 
-McmcOutput::McmcOutput(const int& p, const int n, const int& max_iter, double sigma[]) : 
-    rowCount(0), 
+// Relative size of the ridge added to the initial co-moment
+// factor so that it is positive definite from the start
+#define ADAPTIVE_RIDGE 1e-6
+
+
+
+McmcOutput::McmcOutput(const int& p, const int n_, double sigma[]) : 
+    n(0),
+    mean(p,0.0),
+    work(p,0.0),
+    publishedMean(p,0.0),
+    numPublished(0),
     numParms(p), 
-    bandSize(n),
+    adaptStart(n_),
+    adaptInterval(n_),
+    adaptStop(0),
+    ridge(p,0.0),
+    lastScale(0.0),
     varChanged(0)
 {
 
-  // Sets up a n x p matrix to contain our band of output
-  // we also set up two p x p matrices to hold the variance/covariance 
-  // matrix as well as its lower triangular Cholesky decomp.
+  // Sets up the running mean and the p x p Cholesky factors.
+  // All storage is allocated here, so add() and scaleChol()
+  // do no allocation.
 
   /* Parameters:
         p - number of parameters in model
         n - the interval in iterations between variance matrix updates
-        max_iter - the number of MCMC iterations requested
         sigma - an array of length p containing starting values for the proposal variances
   */
 
-  // Vector to hold the sum
-  for(int i=0; i<numParms; ++i) {
-    sum.push_back(0.0);
-    sumOfSquares.push_back(vector<double>(i+1,0.0));
-  }
-
-  // Variance Matrix - NB calloc sets all elements to 0
-  varianceMatrix = gsl_matrix_calloc(numParms,numParms);
-
-  // The lower triangle of this matrix will be the Cholesky decomp
+  // NB calloc sets all elements to 0
+  cholComoment = gsl_matrix_calloc(numParms,numParms);
+  cholPublished = gsl_matrix_calloc(numParms,numParms);
+  cholWork = gsl_matrix_calloc(numParms,numParms);
   cholMatrix = gsl_matrix_calloc(numParms,numParms);
 
-  // Fill the diagonal with our sigma^{(0)}
-  for(int i=0; i<numParms; ++i) {
-    gsl_matrix_set(varianceMatrix,i,i,sigma[i]);
-  }
+  for(size_t i=0; i<numParms; ++i) {
+    // Start with the proposal variances sigma^{(0)}, which
+    // scaleChol() returns unscaled until the first publish()
+    gsl_matrix_set(cholPublished,i,i,sqrt(sigma[i]));
+    gsl_matrix_set(cholMatrix,i,i,sqrt(sigma[i]));
 
-  doChol(); // And set up the cholesky matrix
+    // A small ridge keeps the co-moment factor non-singular
+    // until it is downdated away in removeRidge()
+    ridge[i] = sqrt(ADAPTIVE_RIDGE * sigma[i]);
+    gsl_matrix_set(cholComoment,i,i,ridge[i]);
+  }
 
 }
 
@@ -101,74 +120,84 @@ McmcOutput::~McmcOutput()
 {
   // Clean up our dynamic memory nicely 
 
-  gsl_matrix_free(varianceMatrix);
+  gsl_matrix_free(cholComoment);
+  gsl_matrix_free(cholPublished);
+  gsl_matrix_free(cholWork);
   gsl_matrix_free(cholMatrix);
 
 }
 
 
 
-inline int McmcOutput::doChol() 
+void McmcOutput::setSchedule(const size_t start, const size_t interval, const size_t stop)
 {
-
-  // Performs a Cholesky decomposition on the variance matrix
-  // gsl_linalg_cholesky_decomp overwrites the input matrix with
-  // the answer, so to preserve the variance matrix we have to copy it.
-  // Note that if the Cholesky decomp fails, then we are left with garbage in 
-  // the cholMatrix class member, so we try the decomposition in a temporary matrix
-  // and copy this to cholMatrix if successful. 
-
-  // Turn the default error handler off since we want to handle
-  // any errors output by the Choleskey decomp ourselves
-  gsl_set_error_handler_off();
-
-  // Copy the variance matrix
-  gsl_matrix* tempMatrix = gsl_matrix_alloc(numParms,numParms);
-  gsl_matrix_memcpy(tempMatrix,varianceMatrix);
-
-  // Attempt cholesky decomp
-  if (gsl_linalg_cholesky_decomp(tempMatrix) != GSL_EDOM) { // If successful, copy result to cholMatrix
-    gsl_matrix_memcpy(cholMatrix,tempMatrix);
-    cout << "Cholesky done!\n";
-  }
-  else cout << "Cholesky not possible!\n";  // If not, then don't copy and move on.
-  return(0);
+  adaptStart = start;
+  adaptInterval = interval > 0 ? interval : 1;
+  adaptStop = stop;
 }
 
 
 
-void McmcOutput::reset()
+bool McmcOutput::cholUpdate(gsl_matrix* L, double x[], const double sign)
 {
-  // Called when we have filled out our output band
+  // Replaces lower triangular L with the Cholesky factor of
+  // L L^T + sign * x x^T in O(p^2).  x is overwritten.  Returns
+  // false if a downdate (sign < 0) would not be positive definite,
+  // in which case L is left part-updated.
+
+  for(size_t k=0; k<numParms; ++k) {
+    double Lkk = gsl_matrix_get(L,k,k);
+    double r2 = Lkk*Lkk + sign*x[k]*x[k];
+    if(r2 <= 0.0 || Lkk == 0.0) return false;
+
+    double r = sqrt(r2);
+    double c = r / Lkk;
+    double s = x[k] / Lkk;
+    gsl_matrix_set(L,k,k,r);
+
+    for(size_t i=k+1; i<numParms; ++i) {
+      double Lik = (gsl_matrix_get(L,i,k) + sign*s*x[i]) / c;
+      gsl_matrix_set(L,i,k,Lik);
+      x[i] = c*x[i] - s*Lik;
+    }
+  }
 
-  varianceUpdate(); // Update our empirical variance/covariance matrix
-  rowCount = 0; // Reset the row counter to 0 for the new output band
+  return true;
 }
 
 
 
-void McmcOutput::varianceUpdate() 
+void McmcOutput::removeRidge()
 {
-  // Recalculates the variance-covariance matrix
+  // Downdates the initial ridge out of the co-moment factor.  If
+  // that fails the sample variance is singular (e.g. a parameter
+  // has not moved), so the ridge is kept.
 
-  double var = 0.0; // Our variance or covariance 
+  gsl_matrix_memcpy(cholWork,cholComoment);
 
-  if((rowCount % bandSize) != 0 || rowCount == 0) return; // If we're not ready to update, don't!
+  bool ok = true;
+  for(size_t i=0; i<numParms && ok; ++i) {
+    for(size_t j=0; j<numParms; ++j) work[j] = 0.0;
+    work[i] = ridge[i];
+    ok = cholUpdate(cholWork,&work[0],-1.0);
+  }
 
-  // We now iterate over the rows and columns of the variance matrix
+  if(ok) gsl_matrix_memcpy(cholComoment,cholWork);
 
-  for(int i=0; i<numParms; ++i) {
+  ridge.clear();
+}
 
-    var = sumOfSquares[i][i]/rowCount - sum[i]/rowCount * sum[i]/rowCount;
-    gsl_matrix_set(varianceMatrix,i,i,var);
 
-    for(int j=0; j<i; ++j) {
-      var = sumOfSquares[i][j]/rowCount - sum[i]/rowCount * sum[j]/rowCount;
-      gsl_matrix_set(varianceMatrix,i,j,var);
-      gsl_matrix_set(varianceMatrix,j,i,var);
-    }
 
-  }
+void McmcOutput::publish()
+{
+  // Sets the proposal factor to that of the current
+  // empirical variance matrix, sum of squares / n
+
+  gsl_matrix_memcpy(cholPublished,cholComoment);
+  gsl_matrix_scale(cholPublished,1.0/sqrt((double)n));
+  publishedMean = mean;
+  numPublished++;
 
   varChanged = 1;
 }
@@ -176,33 +205,33 @@ void McmcOutput::varianceUpdate()
 
 
 void McmcOutput::add(const epiParms& parms)
-  // Adds a new row of MCMC output to the class data member
-  // and calls varianceUpdate() at intervals set by bandSize
+  // Adds a new row of MCMC output, updating the mean and the
+  // co-moment factor, and publishes a new variance matrix
+  // according to the adaptation schedule.
 {
 
-  // Add to sum vector and sum of squares matrix
-  for(int i=0; i<numParms; ++i) {
-    sum[i] += parms.beta[i];
-    sumOfSquares[i][i] += parms.beta[i] * parms.beta[i];
-    for(int j=0; j < i; ++j) {
-      sumOfSquares[i][j] += parms.beta[i]*parms.beta[j];
-    }
-  }
-
-  rowCount++;
+  n++;
 
-  if((rowCount % bandSize) == 0 && rowCount != 0) {
-    varianceUpdate();
+  // Welford update: with d = x - mean_{n-1},
+  //   mean_n = mean_{n-1} + d / n
+  //   C_n = C_{n-1} + (n-1)/n * d d^T
+  for(size_t i=0; i<numParms; ++i) {
+    work[i] = parms.beta[i] - mean[i];
+    mean[i] += work[i] / n;
   }
-}
-
 
+  if(n > 1) {
+    double w = sqrt((double)(n-1) / n);
+    for(size_t i=0; i<numParms; ++i) work[i] *= w;
+    cholUpdate(cholComoment,&work[0],1.0);
+  }
 
-gsl_matrix* McmcOutput::varCovar()
-{
-  // Returns a pointer to the variance/covariance matrix
+  if(n < adaptStart || n < 2) return;
+  if(adaptStop > 0 && n > adaptStop) return;
+  if((n - adaptStart) % adaptInterval != 0) return;
 
-  return varianceMatrix;
+  if(!ridge.empty()) removeRidge();
+  publish();
 }
 
 
@@ -220,11 +249,21 @@ bool McmcOutput::varCheckCurr()
 gsl_matrix* McmcOutput::scaleChol(const double scaleFactor) 
 {
   // Returns a pointer to a matrix containing the Cholesky decomposition
-  // of the scaled variance matrix
-
-  if(varChanged == 1) {
-    gsl_matrix_scale(varianceMatrix,scaleFactor);
-    doChol();
+  // of the scaled variance matrix.  The factor is stored transposed
+  // (upper triangular), as rmnorm expects.  Until the first empirical
+  // variance is published, the initial sigma is returned unscaled.
+
+  if(!isAdapted()) return cholMatrix;
+
+  if(varChanged == 1 || scaleFactor != lastScale) {
+    double f = sqrt(scaleFactor);
+    gsl_matrix_set_zero(cholMatrix);
+    for(size_t i=0; i<numParms; ++i) {
+      for(size_t j=0; j<=i; ++j) {
+        gsl_matrix_set(cholMatrix,j,i,f*gsl_matrix_get(cholPublished,i,j));
+      }
+    }
+    lastScale = scaleFactor;
     varChanged = 0;
   }
 
@@ -233,14 +272,36 @@ gsl_matrix* McmcOutput::scaleChol(const double scaleFactor)
 
 
 
+double McmcOutput::logGaussian(const double x[])
+{
+  // -1/2 z^T z, where L z = x - mean is solved by
+  // forward substitution in O(p^2)
+
+  double rv = 0.0;
+  for(size_t i=0; i<numParms; ++i) {
+    double zi = x[i] - publishedMean[i];
+    for(size_t j=0; j<i; ++j) zi -= gsl_matrix_get(cholPublished,i,j) * work[j];
+    zi /= gsl_matrix_get(cholPublished,i,i);
+    work[i] = zi;
+    rv -= 0.5 * zi * zi;
+  }
+
+  return rv;
+}
+
+
+
 void McmcOutput::print()
 {
   // Prints out the variance matrix
   // ONLY USED FOR DEBUGGING PURPOSES
 
-  for(int i=0;i<numParms;++i) {
-    for(int j=0;j<numParms;++j) {
-      printf("%f ", gsl_matrix_get(varianceMatrix,j,i));
+  for(size_t i=0;i<numParms;++i) {
+    for(size_t j=0;j<numParms;++j) {
+      double var = 0.0;
+      for(size_t k=0; k<=i && k<=j; ++k)
+        var += gsl_matrix_get(cholPublished,i,k) * gsl_matrix_get(cholPublished,j,k);
+      printf("%f ", var);
     }
     cout << "\n";
   }
@@ -22,8 +22,10 @@
 // Name: adaptive.cpp                                              //
 // Author: C.P.Jewell                                              //
 // Purpose: McmcOutput contains the output from an MCMC algorithm. //
-//          It calculates the variance-covariance matrix of the    //
-//           posterior at time intervals set at initialisation.    //
+//          It maintains the mean and the Cholesky factor of the   //
+//          variance-covariance matrix of the posterior online,    //
+//          using Welford updates and rank-one Cholesky updates,   //
+//          at O(p^2) cost per iteration.                          //
 /////////////////////////////////////////////////////////////////////
 
 
@@ -33,7 +35,10 @@
   #include "adaptive.h"
 
   double mySigma[] = {1,1,1,1,1}
-  McmcOutput myOutput(5,100,10000,mySigma}
+  McmcOutput myOutput(5,100,mySigma}
+
+  // Optionally, adapt every iteration from iteration 500 onwards
+  myOutput.setSchedule(500,1);
 
   //MCMC Loop:
   for(int mcmcIter = 0; mcmcIter < 100000; ++mcmcIter) {
@@ -58,39 +63,52 @@
 #include <vector>
 
 #include <gsl/gsl_matrix.h>
-#include <gsl/gsl_linalg.h>
-#include <gsl/gsl_blas.h>
-#include <gsl/gsl_statistics_double.h>
 #include <gsl/gsl_errno.h>
 
 #include "sinrEpi.h"
 
 class McmcOutput {
 private:
-  double n;
-  vector< vector<double> > sumOfSquares;
-  vector<double> sum;
-
-  gsl_matrix* varianceMatrix;
-  gsl_matrix* cholMatrix;
-
-  int rowCount;
-  const size_t numParms, bandSize;
+  size_t n;
+  vector<double> mean;
+  vector<double> work;
+  vector<double> publishedMean; // Mean at the last publish()
+  size_t numPublished;
+
+  gsl_matrix* cholComoment; // Lower Cholesky factor of the sum of squared deviations
+  gsl_matrix* cholPublished; // Factor of the variance matrix currently in use
+  gsl_matrix* cholWork;
+  gsl_matrix* cholMatrix; // Scaled proposal factor returned by scaleChol
+
+  const size_t numParms;
+  size_t adaptStart, adaptInterval, adaptStop;
+  vector<double> ridge; // Initial regularisation, empty once removed
+  double lastScale;
   bool varChanged;
 
-  inline int doChol();
-  void varianceUpdate();
-  void reset();
-  gsl_matrix* varCovar();
+  bool cholUpdate(gsl_matrix*, double[], const double);
+  void removeRidge();
+  void publish();
 
 public:
-  McmcOutput(const int&,const int, const int&, double[]);
+  McmcOutput(const int&,const int, double[]);
   ~McmcOutput();
   void add(const epiParms&);
   void print();
 
+  // The empirical variance is used from iteration start onwards,
+  // refreshed every interval iterations, and frozen after stop
+  // iterations (stop == 0 adapts indefinitely).
+  void setSchedule(const size_t start, const size_t interval, const size_t stop = 0);
+
   gsl_matrix* scaleChol(const double);
   bool varCheckCurr(); 
+
+  // Log density, up to a constant, of the Gaussian with the
+  // published mean and variance.  Used as a cheap surrogate
+  // for the posterior once isAdapted().
+  double logGaussian(const double x[]);
+  bool isAdapted() const { return numPublished > 0; }
                        
 };
 
@@ -142,7 +142,14 @@ main(int argc, char *argv[])
       exit(-1);
     }
 
+  initSpatialKernel(epidata, spatialFamily);
+  prepareSpatialKernel(parms);
+  prepareSusceptibility(parms, epidata);
   initConnections(parms, epidata);
+  initContactCache(epidata);
+  OccultGraph occultGraph;
+  if (parallelOccults)
+    initOccultGraph(epidata, occultGraph);
 
   cout << "Read epi data.  Continuing..." << endl;
 
@@ -195,11 +202,24 @@ main(int argc, char *argv[])
   cout << "b: " << priors.b << "\n";
   cout << "f: " << parms.f << "\n";
   cout << "g: " << parms.g << "\n";
+  initInfecKernel(parms, kernelTol, kernelExact);
+  if (getInfecKernel().mode() == InfectivityKernel::TABULATED)
+    cout << "Infectivity tabulated: " << getInfecKernel().numCells()
+        << " cells, max rel error " << getInfecKernel().maxRelError() << "\n";
+  else
+    cout << "Infectivity evaluated exactly\n";
   cout << "Observation Time: " << ObsTime << "\n";
   cout << "============\n\n";
   cout << "No iterations: " << max_iter << "\n";
+  if (essTarget > 0.0)
+    cout << "Stop at ESS " << essTarget << ", split-Rhat " << rhatTarget
+        << " (checked every " << diagInterval << " iterations)\n";
   cout << "Output file: '" << output_filename << "'\n";
   cout << "Block update: " << block_update << "\n";
+  cout << "Delayed acceptance: " << delayedAcceptance << "\n";
+  cout << "Parallel occult moves: " << parallelOccults << "\n";
+  if (profileMetrics)
+    cout << "Metrics every " << metricsInterval << " iterations\n";
   cout << "I1 = " << epidata.I1 << endl;
 
   /* Now we run the model........................*/
@@ -230,8 +250,16 @@ main(int argc, char *argv[])
   parms_can.f = parms.f;
   parms_can.g = parms.g;
 
-  McmcOutput multVariance(parms.p, 50, max_iter, sigma_mult);
-  McmcOutput multaddVariance(parms.p, 50, max_iter, sigma_add);
+  McmcDiagnostics diagnostics(parms.p);
+  int numIter = max_iter;
+
+  vector<double> daWork(parms.p);
+  size_t daScreened = 0, daRejected = 0;
+
+  McmcOutput multVariance(parms.p, adaptInterval, sigma_mult);
+  McmcOutput multaddVariance(parms.p, adaptInterval, sigma_add);
+  multVariance.setSchedule(adaptStart, adaptInterval, adaptStop);
+  multaddVariance.setSchedule(adaptStart, adaptInterval, adaptStop);
 
   gsl_matrix* identityMatrix = gsl_matrix_alloc(parms.p, parms.p);
   gsl_matrix_set_identity(identityMatrix);
@@ -264,13 +292,32 @@ main(int argc, char *argv[])
       return (-1);
     }
 
+  // Opens metrics output file
+  if (profileMetrics)
+    {
+      char metricsFilename[200];
+      sprintf(metricsFilename, "%s.metrics", output_filename);
+      try
+        {
+          profiler.open(metricsFilename);
+        }
+      catch (exception& e)
+        {
+          cerr << "Exception thrown opening metrics file\n" << "\tException: "
+              << e.what() << endl;
+          return (-1);
+        }
+    }
+
   /* Compute the conditional posterior to start */
 
-  log_prodCurr = compute_log_prod_pressure(parms, epidata, prodCurr_ptr);
-  logCT = computeLogCT(parms, epidata);
-  bgPress = compute_bgPress(parms, epidata);
-  A1 = compute_A1(parms, epidata);
-  A2 = compute_A2(parms, epidata);
+  LikComponents lik;
+  computeLikelihood(parms, epidata, prodCurr_ptr, lik);
+  log_prodCurr = lik.logProd;
+  logCT = lik.logCT;
+  bgPress = lik.bgPress;
+  A1 = lik.A1;
+  A2 = lik.A2;
   loglikCurr = log_prodCurr - bgPress - A1 - A2 + logCT;
   cout << "log_prodCurr: " << log_prodCurr << endl;
   cout << "bgPress: " << bgPress << endl;
@@ -337,6 +384,9 @@ main(int argc, char *argv[])
 
   for (int h = 0; h < max_iter; ++h)
     {
+      prepareSpatialKernel(parms); // Keep the current decay cached
+      prepareSusceptibility(parms, epidata);
+
       if (h % 100 == 0)
         {
           percent_done = (float) h / (float) max_iter * 100;
@@ -365,18 +415,20 @@ main(int argc, char *argv[])
 
       /* Draw betas by MH */
 
+      double betaStart = profiler.now();
+      bool betaAccepted = false;
       log_piCurr = loglikCurr;
 
       // Conditional density:
 
-      log_piCurr += log(gsl_ran_gamma_pdf(parms.beta[0], priors.lambda[0], 1.0
-          / priors.nu[0]));
-      log_piCurr += log(gsl_ran_beta_pdf(parms.beta[1], priors.lambda[1],
-          priors.nu[1]));
-      log_piCurr += log(gsl_ran_beta_pdf(parms.beta[2], priors.lambda[2],
-          priors.nu[2]));
+      log_piCurr += log(gsl_ran_gamma_pdf(parms.beta[ModelTraits::BETA0],
+          priors.lambda[ModelTraits::BETA0], 1.0 / priors.nu[ModelTraits::BETA0]));
+      log_piCurr += log(gsl_ran_beta_pdf(parms.beta[ModelTraits::BETA_FM],
+          priors.lambda[ModelTraits::BETA_FM], priors.nu[ModelTraits::BETA_FM]));
+      log_piCurr += log(gsl_ran_beta_pdf(parms.beta[ModelTraits::BETA_SH],
+          priors.lambda[ModelTraits::BETA_SH], priors.nu[ModelTraits::BETA_SH]));
 
-      for (int k = 3; k < parms.p; ++k)
+      for (int k = ModelTraits::BETA_CP; k < parms.p; ++k)
         { // Calculate \pi(\beta)
           log_piCurr += log(gsl_ran_gamma_pdf(parms.beta[k], priors.lambda[k],
               1.0 / priors.nu[k]));
@@ -408,34 +460,13 @@ main(int argc, char *argv[])
                 * 2.38 / parms.p), parms_can.beta, addOffset);
         }
 
-      if (!parms_can.isBetaNegative() && parms_can.beta[5] > 0.000
-          && parms_can.beta[6] > 0.1 && parms_can.beta[4] >= parms_can.beta[5])
+      if (!parms_can.isBetaNegative()
+          && parms_can.beta[ModelTraits::BETA_SPATIAL_N] > 0.000
+          && parms_can.beta[ModelTraits::RHO] > 0.1
+          && parms_can.beta[ModelTraits::BETA_SPATIAL_I]
+              >= parms_can.beta[ModelTraits::BETA_SPATIAL_N])
         { // Parameter constraints
 
-          log_prodCan = compute_log_prod_pressure(parms_can, epidata,
-              prodCan_ptr);
-          logCT_can = computeLogCT(parms_can, epidata);
-          bgPress_can = compute_bgPress(parms_can, epidata);
-          A1_can = compute_A1(parms_can, epidata);
-          A2_can = compute_A2(parms_can, epidata);
-          loglikCan = log_prodCan - bgPress_can - A1_can - A2_can + logCT_can;
-
-          log_piCan = loglikCan;
-
-          log_piCan += log(gsl_ran_gamma_pdf(parms_can.beta[0],
-              priors.lambda[0], 1.0 / priors.nu[0]));
-          log_piCan += log(gsl_ran_beta_pdf(parms_can.beta[1],
-              priors.lambda[1], priors.nu[1]));
-          log_piCan += log(gsl_ran_beta_pdf(parms_can.beta[2],
-              priors.lambda[2], priors.nu[2]));
-          for (int k = 3; k < parms.p; ++k)
-            {
-              log_piCan += log(gsl_ran_gamma_pdf(parms_can.beta[k],
-                  priors.lambda[k], 1.0 / priors.nu[k]));
-            }
-
-          p = gsl_rng_uniform(rng);
-
           double q_ratio = 0;
 
           for (int k = 0; k < addOffset; ++k)
@@ -453,44 +484,101 @@ main(int argc, char *argv[])
                 }
             }
 
-#ifdef __DEBUG__
-          if(h > 1)
+          // Delayed acceptance: screen the proposal against the
+          // Gaussian surrogate, and only compute the likelihood for
+          // proposals that pass.  The second stage divides out the
+          // surrogate ratio, so the posterior is unchanged.
+          bool screened = false;
+          bool passed = true;
+          double logSurRatio = 0.0;
+          if (delayedAcceptance && multVariance.isAdapted())
             {
-              cout << "Betas: log_prodCurr=" << log_prodCurr
-              << ", bgPress_curr=" << bgPress
-              << ", logCT=" << logCT
-              << ", A1_curr=" << A1
-              << ", A2_curr=" << A2
-              << ", log_piCurr=" << log_piCurr
-              << "\n";
-
-              cout << "Betas: log_prodCan=" << log_prodCan
-              << ", bgPress=" << bgPress_can
-              << ", logCT_can=" << logCT_can
-              << ", A1_can=" << A1_can
-              << ", A2_can=" << A2_can
-              << ", log_piCan=" << log_piCan
-              << "\n";
+              double logSurCan, logSurCurr;
+              if (surrogateLogPost(multVariance, parms_can, &daWork[0], logSurCan)
+                  && surrogateLogPost(multVariance, parms, &daWork[0], logSurCurr))
+                {
+                  screened = true;
+                  logSurRatio = logSurCan - logSurCurr;
+                  passed = log(gsl_rng_uniform(rng)) < logSurRatio + q_ratio;
+                  daScreened++;
+                  if (!passed) daRejected++;
+                }
             }
+
+          if (passed)
+            {
+              LikComponents likCan;
+              computeLikelihood(parms_can, epidata, prodCan_ptr, likCan);
+              log_prodCan = likCan.logProd;
+              logCT_can = likCan.logCT;
+              bgPress_can = likCan.bgPress;
+              A1_can = likCan.A1;
+              A2_can = likCan.A2;
+              loglikCan = log_prodCan - bgPress_can - A1_can - A2_can + logCT_can;
+
+              log_piCan = loglikCan;
+
+              log_piCan += log(gsl_ran_gamma_pdf(parms_can.beta[ModelTraits::BETA0],
+                  priors.lambda[ModelTraits::BETA0], 1.0 / priors.nu[ModelTraits::BETA0]));
+              log_piCan += log(gsl_ran_beta_pdf(parms_can.beta[ModelTraits::BETA_FM],
+                  priors.lambda[ModelTraits::BETA_FM], priors.nu[ModelTraits::BETA_FM]));
+              log_piCan += log(gsl_ran_beta_pdf(parms_can.beta[ModelTraits::BETA_SH],
+                  priors.lambda[ModelTraits::BETA_SH], priors.nu[ModelTraits::BETA_SH]));
+              for (int k = ModelTraits::BETA_CP; k < parms.p; ++k)
+                {
+                  log_piCan += log(gsl_ran_gamma_pdf(parms_can.beta[k],
+                      priors.lambda[k], 1.0 / priors.nu[k]));
+                }
+
+              p = gsl_rng_uniform(rng);
+
+#ifdef __DEBUG__
+              if(h > 1)
+                {
+                  cout << "Betas: log_prodCurr=" << log_prodCurr
+                  << ", bgPress_curr=" << bgPress
+                  << ", logCT=" << logCT
+                  << ", A1_curr=" << A1
+                  << ", A2_curr=" << A2
+                  << ", log_piCurr=" << log_piCurr
+                  << "\n";
+
+                  cout << "Betas: log_prodCan=" << log_prodCan
+                  << ", bgPress=" << bgPress_can
+                  << ", logCT_can=" << logCT_can
+                  << ", A1_can=" << A1_can
+                  << ", A2_can=" << A2_can
+                  << ", log_piCan=" << log_piCan
+                  << "\n";
+                }
 #endif
 
-          if (log(p) < log_piCan - log_piCurr + q_ratio)
-            { // Do we accept or reject our proposal?
-              parms = parms_can;
-              log_prodCurr = log_prodCan;
-              loglikCurr = loglikCan;
-              bgPress = bgPress_can;
-              logCT = logCT_can;
-              A1 = A1_can;
-              A2 = A2_can;
-              //SWITCH_PROD_PTR;
-              *prodCurr_ptr = *prodCan_ptr;
-              accept[0] = accept[0] + 1;
+              double logAlpha = log_piCan - log_piCurr;
+              logAlpha += screened ? -logSurRatio : q_ratio;
+
+              if (log(p) < logAlpha)
+                { // Do we accept or reject our proposal?
+                  parms = parms_can;
+                  log_prodCurr = log_prodCan;
+                  loglikCurr = loglikCan;
+                  bgPress = bgPress_can;
+                  logCT = logCT_can;
+                  A1 = A1_can;
+                  A2 = A2_can;
+                  //SWITCH_PROD_PTR;
+                  *prodCurr_ptr = *prodCan_ptr;
+                  accept[0] = accept[0] + 1;
+                  betaAccepted = true;
+                }
+              else
+                {
+                  parms_can = parms;
+                  *prodCan_ptr = *prodCurr_ptr;
+                }
             }
           else
             {
               parms_can = parms;
-              *prodCan_ptr = *prodCurr_ptr;
             }
         }
       else
@@ -500,14 +588,32 @@ main(int argc, char *argv[])
           //cout << "Condition false" << "\n";
         }
 
+      if (profiler.isEnabled())
+        profiler.proposal(PROP_BETA, betaAccepted, profiler.now() - betaStart);
+
+      // The beta block may have left candidate species parameters
+      prepareSusceptibility(parms, epidata);
+
       /* Now we fiddle with the infections times :-) */
 
+      if (parallelOccults)
+        { // Move every infection time bar I1 in independent batches
+          ProposalTimer timer(profiler, PROP_PARALLELMOVE);
+          int numMoved = parallelMoveSweep(parms, priors, epidata, rng,
+              occultGraph, *prodCurr_ptr, log_prodCurr, bgPress, A1, A2, logCT);
+          accept[7] += numMoved;
+          if (numMoved > 0)
+            timer.accept();
+          loglikCurr = log_prodCurr - bgPress - A1 - A2 + logCT;
+        }
+
       for (int k = 0; k < infecFiddle; ++k)
         {
           epidata.updateI1();
 
           *prodCan_ptr = *prodCurr_ptr;
           float choose = gsl_ran_flat(rng, 0, 3);
+          ProposalTimer timer(profiler); // Type set once known
           //float choose = 0.5;
 
 
@@ -576,6 +682,7 @@ main(int argc, char *argv[])
                       inProp = (*proposal_func)(priors.a, priors.b); // Choose a new I->N time
                       parms.Ican = epidata.infected[move_index]->N - inProp; // Set the new infection time
                       state = 1;
+                      timer.setType(PROP_MOVE1);
                     }
                   else
                     { // Contact -> Contact
@@ -585,6 +692,7 @@ main(int argc, char *argv[])
                       parms.Ican = myContacts[conPos]->time; // Set new I->N time
                       inProp = epidata.infected[move_index]->N - parms.Ican;
                       state = 2;
+                      timer.setType(PROP_MOVE2);
                     }
                 }
               else
@@ -592,6 +700,7 @@ main(int argc, char *argv[])
                   if (crossDim)
                     { // Frequency -> Contact
                       // Propose a contact time
+                      timer.setType(PROP_MOVE3);
                       if (myContacts.empty())
                         continue; // Abort if we've not got any infectious contacts to move to.
                       size_t conPos = gsl_rng_uniform_int(rng,
@@ -606,6 +715,7 @@ main(int argc, char *argv[])
                       inProp = (*proposal_func)(priors.a, priors.b); // Choose a new I->N time
                       parms.Ican = epidata.infected[move_index]->N - inProp; // Set the new infection time
                       state = 4;
+                      timer.setType(PROP_MOVE4);
                     }
                 }
 
@@ -623,17 +733,20 @@ main(int argc, char *argv[])
               if (parms.Ican < epidata.individuals[move_index].niAt)
                 continue;
 
-              logCT_can = update_logCT(move_index, parms, epidata, logCT);
+              LikComponents likCurr =
+                { log_prodCurr, logCT, bgPress, A1, A2 };
+              LikComponents likCan;
+              updateLikelihood(move_index, parms, epidata, likCurr,
+                  prodCurr_ptr, prodCan_ptr, likCan);
+              logCT_can = likCan.logCT;
 
               if (logCT_can != GSL_NEGINF)
                 { // If our proposal makes sense...
 
-                  bgPress_can = update_bgPress(move_index, parms, epidata,
-                      bgPress);
-                  A1_can = update_A1(move_index, parms, epidata, A1);
-                  A2_can = update_A2(move_index, parms, epidata, A2);
-                  log_prodCan = update_log_prod(move_index, parms, epidata,
-                      log_prodCurr, prodCurr_ptr, prodCan_ptr);
+                  bgPress_can = likCan.bgPress;
+                  A1_can = likCan.A1;
+                  A2_can = likCan.A2;
+                  log_prodCan = likCan.logProd;
                   loglikCan = log_prodCan - bgPress_can - A1_can - A2_can
                       + logCT_can;
 
@@ -722,7 +835,7 @@ main(int argc, char *argv[])
                   if (log(gsl_rng_uniform(rng)) < log_piCan - log_piCurr
                       + qRatio)
                     {
-                      epidata.infected[move_index]->I = parms.Ican;
+                      epidata.setI(epidata.infected[move_index]->label, parms.Ican);
                       log_prodCurr = log_prodCan;
                       loglikCurr = loglikCan;
                       *prodCurr_ptr = *prodCan_ptr;
@@ -739,6 +852,7 @@ main(int argc, char *argv[])
                           epidata.updateI1();
                         }
                       ++accept[7];
+                      timer.accept();
 
 //                      cout << "MOVED " << epidata.infected[move_index]->label
 //                          << ", index = " << move_index << endl;
@@ -758,6 +872,8 @@ main(int argc, char *argv[])
 
               /* Propose a new infection */
 
+              timer.setType(PROP_ADD);
+
               move_index = gsl_rng_uniform_int(rng, epidata.susceptible.size());
 
               //#ifdef __DEBUG__
@@ -828,6 +944,7 @@ main(int argc, char *argv[])
                           < epidata.infected[epidata.I1]->I)
                         epidata.I1 = epidata.infected.size() - 1; // If we've proposed a new I1, update epidata.I1
                       ++accept[8];
+                      timer.accept();
 
                     }
                   else
@@ -846,6 +963,8 @@ main(int argc, char *argv[])
                 {
                   /* Delete an infection */
 
+                  timer.setType(PROP_DELETE);
+
                   move_index = epidata.knownInfections + gsl_rng_uniform_int(
                       rng, epidata.numAdditions());
 
@@ -910,6 +1029,7 @@ main(int argc, char *argv[])
                       loglikCurr = loglikCan;
                       *prodCurr_ptr = *prodCan_ptr;
                       ++accept[9];
+                      timer.accept();
                     }
                   else
                     {
@@ -934,8 +1054,10 @@ main(int argc, char *argv[])
       multVariance.add(parmsTemp);
 
       //vector<double> tempProd = *prodCurr_ptr;
+      // logCT is updated incrementally, so allow for rounding drift
+      // relative to its size; anything larger is a real error
       double reallogCT = computeLogCT(parms, epidata);
-      if (fabs(reallogCT - logCT) > 0.0000000001)
+      if (fabs(reallogCT - logCT) > 1e-9 * (1.0 + fabs(reallogCT)))
         {
 //          cout << "Iteration: " << h << ", Current logCT = " << logCT
 //              << ", Real logCT = " << reallogCT << endl;
@@ -946,6 +1068,9 @@ main(int argc, char *argv[])
           // 		cout << "================================" << endl;
           abort();
         }
+      // Resync so the drift does not accumulate
+      loglikCurr += reallogCT - logCT;
+      logCT = reallogCT;
 
       // Write results to file
       if ((h % THINBY) == 0)
@@ -967,35 +1092,78 @@ main(int argc, char *argv[])
           occultWriter.write(epidata.infected.begin(), epidata.infected.end());
         }
 
+      if (metricsInterval > 0 && (h + 1) % metricsInterval == 0)
+        profiler.write(h + 1);
+
+      // Convergence diagnostics, stopping early once targets are met
+      diagnostics.add(parms.beta, epidata.numAdditions());
+      if (essTarget > 0.0 && diagInterval > 0 && (h + 1) % diagInterval == 0 && h + 1 >= minIter)
+        {
+          cout << "\n";
+          diagnostics.print(cout);
+          if (diagnostics.converged(essTarget, rhatTarget))
+            {
+              cout << "ESS and split-Rhat targets met.  Stopping." << endl;
+              numIter = h + 1;
+              break;
+            }
+        }
+
     } /* END OF MCMC LOOP */
 
   time(&t_end);
+  profiler.close(numIter);
   //debugOut.close();
   resultsFile.close();
 
   cout << "Model ran in " << difftime(t_end, t_start) / 60 << " minutes"
       << endl;
-  cout << "Acceptance beta0: " << (float) accept[0] / (float) max_iter * 100
+  diagnostics.print(cout);
+  cout << "Acceptance beta0: " << (float) accept[0] / (float) numIter * 100
       << "%" << endl;
-  cout << "Acceptance beta1: " << (float) accept[1] / (float) max_iter * 100
+  cout << "Acceptance beta1: " << (float) accept[1] / (float) numIter * 100
       << "%" << endl;
-  cout << "Acceptance beta2: " << (float) accept[2] / (float) max_iter * 100
+  cout << "Acceptance beta2: " << (float) accept[2] / (float) numIter * 100
       << "%" << endl;
-  cout << "Acceptance beta3: " << (float) accept[3] / (float) max_iter * 100
+  cout << "Acceptance beta3: " << (float) accept[3] / (float) numIter * 100
       << "%" << endl;
-  cout << "Acceptance beta4: " << (float) accept[4] / (float) max_iter * 100
+  cout << "Acceptance beta4: " << (float) accept[4] / (float) numIter * 100
       << "%" << endl;
-  cout << "Acceptance beta5: " << (float) accept[5] / (float) max_iter * 100
+  cout << "Acceptance beta5: " << (float) accept[5] / (float) numIter * 100
       << "%" << endl;
-  cout << "Acceptance delta: " << (float) accept[6] / (float) max_iter * 100
+  cout << "Acceptance delta: " << (float) accept[6] / (float) numIter * 100
       << "%" << endl;
-  cout << "Acceptance move I: " << (float) accept[7] / (float) max_iter * 100
+  cout << "Acceptance move I: " << (float) accept[7] / (float) numIter * 100
       << "%" << endl;
   cout << "Acceptance add I: " << accept[8] << endl;
   cout << "Acceptance del I: " << accept[9] << endl;
+  if (delayedAcceptance)
+    cout << "Delayed acceptance: " << daRejected << " of " << daScreened
+        << " screened beta proposals rejected by the surrogate" << endl;
   return (0);
 }
 
+bool
+surrogateLogPost(McmcOutput& variance, const epiParms& beta, double work[],
+    double& logPost)
+{
+  // Surrogate log posterior density of beta: a Gaussian on log(beta)
+  // fitted by the adaptive variance, with the log Jacobian.
+  // Returns false if any beta is zero.
+
+  double logJacobian = 0.0;
+  for (int k = 0; k < beta.p; ++k)
+    {
+      if (beta.beta[k] <= 0.0)
+        return false;
+      work[k] = log(beta.beta[k]);
+      logJacobian += work[k];
+    }
+
+  logPost = variance.logGaussian(work) - logJacobian;
+  return true;
+}
+
 int
 inputConf()
 {
@@ -1173,6 +1341,71 @@ inputConf()
             {
               xi = atof(value);
             }
+          else if (strcmp(variable, "ess_target") == 0)
+            {
+              essTarget = atof(value);
+            }
+          else if (strcmp(variable, "rhat_target") == 0)
+            {
+              rhatTarget = atof(value);
+            }
+          else if (strcmp(variable, "diag_interval") == 0)
+            {
+              diagInterval = atoi(value);
+            }
+          else if (strcmp(variable, "min_iterations") == 0)
+            {
+              minIter = atoi(value);
+            }
+          else if (strcmp(variable, "delayed_acceptance") == 0)
+            {
+              delayedAcceptance = atoi(value) != 0;
+            }
+          else if (strcmp(variable, "spatial_kernel") == 0)
+            {
+              try
+                {
+                  spatialFamily = SpatialKernel::familyFromString(value);
+                }
+              catch (invalid_argument& e)
+                {
+                  cerr << "Unknown spatial_kernel '" << value
+                      << "': use exponential, powerlaw or cauchy" << endl;
+                  exit(-1);
+                }
+            }
+          else if (strcmp(variable, "kernel_tol") == 0)
+            {
+              kernelTol = atof(value);
+            }
+          else if (strcmp(variable, "kernel_exact") == 0)
+            {
+              kernelExact = atoi(value) != 0;
+            }
+          else if (strcmp(variable, "parallel_occults") == 0)
+            {
+              parallelOccults = atoi(value) != 0;
+            }
+          else if (strcmp(variable, "metrics") == 0)
+            {
+              profileMetrics = atoi(value) != 0;
+            }
+          else if (strcmp(variable, "metrics_interval") == 0)
+            {
+              metricsInterval = atoi(value);
+            }
+          else if (strcmp(variable, "adapt_start") == 0)
+            {
+              adaptStart = atoi(value);
+            }
+          else if (strcmp(variable, "adapt_interval") == 0)
+            {
+              adaptInterval = atoi(value);
+            }
+          else if (strcmp(variable, "adapt_stop") == 0)
+            {
+              adaptStop = atoi(value);
+            }
         } // End if statement
     } // End while statement
 
@@ -47,12 +47,14 @@
 #include "sinrEpi.h"
 #include "contactMatrix.h"
 #include "adaptive.h"
+#include "diagnostics.h"
+#include "profiling.h"
 #include "random.h"
 #include "occultWriter.h"
 
 /* Constants */
 
-#define DIM_PARMS 16
+#define DIM_PARMS ModelTraits::numParms  // See ModelTraits.hpp
 
 
 using namespace std;
@@ -60,6 +62,7 @@ using namespace std;
 int fileInit(char*,float*,int);
 int main(int, char**);
 int inputConf();
+bool surrogateLogPost(McmcOutput&, const epiParms&, double[], double&);
 
 // Global variables
 
@@ -87,6 +90,21 @@ double ObsTime;
 time_t t_start, t_end;
 int infecFiddle;
 double xi;
+double essTarget = 0.0; // Stop once min ESS reaches this; 0 disables
+double rhatTarget = 1.01;
+int diagInterval = 1000;
+int minIter = 0;
+bool delayedAcceptance = false;
+double kernelTol = 1e-10; // Relative error of the tabulated h and its integral
+bool kernelExact = false;
+SpatialKernel::family_e spatialFamily = SpatialKernel::EXPONENTIAL;
+bool parallelOccults = false; // Move infection times in independent parallel batches
+bool profileMetrics = false; // Write per-proposal timings to <output>.metrics
+int metricsInterval = 1000;
+int adaptStart = 50; // Adaptive proposal schedule, see McmcOutput::setSchedule
+int adaptInterval = 50;
+int adaptStop = 0; // 0 adapts indefinitely
+McmcProfiler profiler;
 
 
 #endif
@@ -50,19 +50,52 @@ void initConnections(epiParms &parms, sinrEpi &epidata) {
       
     
 
+/* Pair rates for the model built in */
+
+typedef PairRates<ModelTraits> Rates;
+
+
+
+/* Spatial kernel values, cached per decay parameter beta[RHO] */
+
+static SpatialKernel spatialKernel;
+
+void initSpatialKernel(sinrEpi &epidata, const SpatialKernel::family_e family)
+{
+  spatialKernel.setFamily(family);
+  spatialKernel.setDistances(epidata.rho,epidata.N_total);
+}
+
+
+
+void prepareSpatialKernel(epiParms &parms)
+{
+  spatialKernel.prepare(parms.beta[ModelTraits::RHO]);
+}
+
+
+
+void prepareSusceptibility(epiParms &parms, sinrEpi &epidata)
+{
+  // Species parameters are beta[SPECIES..p-1].  Call from serial code
+  // whenever parms differs from the last call.
+  if(parms.p > ModelTraits::SPECIES)
+    epidata.species.setSusceptibility(parms.beta+ModelTraits::SPECIES,parms.p-ModelTraits::SPECIES);
+  else epidata.species.setSusceptibility(NULL,0);
+}
+
+
+
 /* Functions to compute A1 and A2 */
 
 inline double spatialRate(epiParms &parms, sinrEpi &epidata, int i, int j)
 {
   // Computes company network and spatial component of the model
 
-  double beta(0.0);
-
-  // Company
-  beta += parms.beta[3] * epidata.cp_Mat.isConn(i,j);
+  double beta = Rates::company(parms.beta,epidata,i,j);
 
   //Spatial
-  beta += parms.beta[4] * exp(-parms.beta[6] * (*(epidata.rho+i+epidata.N_total*j) - 5));
+  beta += parms.beta[ModelTraits::BETA_SPATIAL_I] * spatialKernel.at(i,j,parms.beta[ModelTraits::RHO]);
 
   // Species susceptibility
   beta *= species(parms,epidata,i,j);
@@ -74,16 +107,19 @@ inline double spatialRate(epiParms &parms, sinrEpi &epidata, int i, int j)
 
 inline double networkRate(epiParms &parms, sinrEpi &epidata, int i, int j)
 {
-  // Computes the network component of the model
+  // Computes the network component of the model.  Zero for models
+  // without feed mill or slaughterhouse networks.
+
+  if(!ModelTraits::feedMill && !ModelTraits::slaughterhouse) return 0.0;
 
   double beta(0.0);
   ///////////NB: Multiplier is 10 for contact tracing egs! /////
 
   // Feed Mills
-  beta = parms.beta[1] * 10 * epidata.fm_Mat.isConn(i,j) * ( 0.5 * epidata.cFreq[j].fm * ( 3 / (epidata.cFreq[j].fm_N) ) );
+  beta = parms.beta[ModelTraits::BETA_FM] * ModelTraits::ctMultiplier() * Rates::fmContact(epidata,i,j);
 
   // Slaughterhouse
-  beta += parms.beta[2] * 10 * epidata.sh_Mat.isConn(i,j) * ( 0.5 * epidata.cFreq[j].sh * ( 3 / (epidata.cFreq[j].sh_N) ) );
+  beta += parms.beta[ModelTraits::BETA_SH] * ModelTraits::ctMultiplier() * Rates::shContact(epidata,i,j);
 
   // Species susceptibility
   beta *= species(parms,epidata,i,j);
@@ -94,7 +130,7 @@ inline double networkRate(epiParms &parms, sinrEpi &epidata, int i, int j)
 
 double fmRate(epiParms &parms, sinrEpi &epidata, int i, int j)
 {
-  double beta = parms.beta[1] * 10 * epidata.fm_Mat.isConn(i,j) * ( 0.5 * epidata.cFreq[j].fm * ( 3 / (epidata.cFreq[j].fm_N) ) );
+  double beta = parms.beta[ModelTraits::BETA_FM] * ModelTraits::ctMultiplier() * Rates::fmContact(epidata,i,j);
   return beta *= species(parms,epidata,i,j);
 }
 
@@ -102,17 +138,8 @@ double fmRate(epiParms &parms, sinrEpi &epidata, int i, int j)
 
 double species(epiParms &parms, sinrEpi &epidata, int i, int j)
 {
-  double beta(1.0);
-
-  // Species susceptibility
-  for(size_t k=7;k<parms.p;++k) {
-    if(epidata.species.at(j,k-7) == 1) {
-      beta = parms.beta[k];
-      break;
-    }
-  }
-
-  return beta;
+  // Species susceptibility, as refreshed by prepareSusceptibility
+  return epidata.species.susceptibility(j);
 }
 
 
@@ -129,11 +156,9 @@ double beta(epiParms &parms, sinrEpi &epidata, int i, int j)
 
 double betastar(epiParms &parms, sinrEpi &epidata, int i, int j) 
 {
-  // Returns the value of \beta^\star.  Notice the beta[5] cf speciesRate!
-
-  double beta(0.0);
+  // Returns the value of \beta^\star.  Notice the BETA_SPATIAL_N cf speciesRate!
 
-  beta = parms.beta[5] * exp(-parms.beta[6] * (*(epidata.rho+i+epidata.N_total*j) - 5));
+  double beta = Rates::notified(parms.beta,spatialKernel,i,j);
 
   // Species susceptibility
   beta *= species(parms,epidata,i,j);
@@ -163,7 +188,7 @@ inline double binomComponent(epiParms &parms, infection* s, double t)
 
   if(s->isInfecByWhoAt(FEEDMILL,t,myIndiv)) {
     isInfecByContact = true;
-    answer *= parms.beta[1] * hFunc(parms,t - myIndiv->I);
+    answer *= parms.beta[ModelTraits::BETA_FM] * hFunc(parms,t - myIndiv->I);
 #ifdef CONTACT_DEBUG
     cout << "FM infec: 1" << endl;
 #endif
@@ -181,7 +206,7 @@ inline double binomComponent(epiParms &parms, infection* s, double t)
   niIter = nonInfecContacts.begin();
 
   while( niIter != nonInfecContacts.end() ) {
-    double myBeta = parms.beta[1] * hFunc(parms,(*niIter)->time - (*niIter)->source->I);
+    double myBeta = parms.beta[ModelTraits::BETA_FM] * hFunc(parms,(*niIter)->time - (*niIter)->source->I);
     answer *= 1 - myBeta;
     niIter++;
   }
@@ -192,7 +217,7 @@ inline double binomComponent(epiParms &parms, infection* s, double t)
 
   if(s->isInfecByWhoAt(SHOUSE,t,myIndiv)) {
     isInfecByContact = true;
-    answer *= parms.beta[2] * hFunc(parms,t - myIndiv->I);
+    answer *= parms.beta[ModelTraits::BETA_SH] * hFunc(parms,t - myIndiv->I);
 #ifdef CONTACT_DEBUG
     cout << "SH infec: 1" << endl;
 #endif
@@ -211,7 +236,7 @@ inline double binomComponent(epiParms &parms, infection* s, double t)
   niIter = nonInfecContacts.begin();
   
   while( niIter != nonInfecContacts.end() ) {
-    double myBeta = parms.beta[2] * hFunc(parms,(*niIter)->time - (*niIter)->source->I);
+    double myBeta = parms.beta[ModelTraits::BETA_SH] * hFunc(parms,(*niIter)->time - (*niIter)->source->I);
     answer *= 1 - myBeta;
     niIter++;
   }
@@ -222,6 +247,144 @@ inline double binomComponent(epiParms &parms, infection* s, double t)
 
 
 
+static inline bool isInfectiousWith(const Contact& c, const infection* moved, double Imoved, double& sourceI)
+{
+  // As Contact::isInfectious, with moved's infection time taken as Imoved
+
+  sourceI = c.source == moved ? Imoved : c.source->I;
+  return c.source->status != SUSCEPTIBLE && sourceI <= c.time && c.time < c.source->N;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////
+// Contact tracing cache
+/////////////////////////////////////////////////////////////////////////
+
+// The binomial terms for a contact depend only on its source's infection
+// time and on beta for its type (f and g being fixed for the run), so their
+// logs are memoised per contact.  Two slots per contact let the current and
+// candidate betas coexist during beta updates.  Each contact is only touched
+// while evaluating its own individual, so threads working on different
+// individuals never share entries.
+
+struct CTCacheSlot {
+  double sourceI, beta;
+  double logInfec, logNonInfec;  // log(beta*h) and log(1 - beta*h)
+};
+
+struct CTCacheEntry {
+  CTCacheSlot slot[2];
+  int last;  // Most recently used slot
+};
+
+static vector<size_t> ctOffset;                // First entry of each individual
+static vector<CTCacheEntry> ctEntries;
+static vector< vector<size_t> > ctContactees;  // Individuals contacted by each label
+
+
+
+void initContactCache(sinrEpi& epidata)
+{
+  // Lays out one cache entry per contact, in contact order
+
+  CTCacheEntry empty;
+  for(int k=0; k<2; ++k) {
+    empty.slot[k].sourceI = GSL_NAN;  // Never matches
+    empty.slot[k].beta = GSL_NAN;
+  }
+  empty.last = 0;
+
+  size_t numEntries = 0;
+  ctOffset.resize(epidata.individuals.size());
+  ctContactees.assign(epidata.individuals.size(),vector<size_t>());
+
+  for(size_t j=0; j<epidata.individuals.size(); ++j) {
+    ctOffset[j] = numEntries;
+    set<Contact>& contacts = epidata.individuals[j].contacts;
+    numEntries += contacts.size();
+    for(set<Contact>::iterator c = contacts.begin(); c != contacts.end(); ++c) {
+      vector<size_t>& contactees = ctContactees.at(c->source->label);
+      if(contactees.empty() || contactees.back() != j) contactees.push_back(j);
+    }
+  }
+
+  ctEntries.assign(numEntries,empty);
+}
+
+
+
+static inline void contactLogTerms(epiParms& parms, size_t entry, const Contact& c, double beta,
+				   double sourceI, double& logInfec, double& logNonInfec)
+{
+  // Log binomial terms for a contact, from the cache if possible
+
+  if(ctEntries.empty()) {
+    double betaH = beta * hFunc(parms,c.time - sourceI);
+    logInfec = log(betaH);
+    logNonInfec = log(1 - betaH);
+    return;
+  }
+
+  CTCacheEntry& e = ctEntries[entry];
+  int k = e.last;
+  if(e.slot[k].sourceI != sourceI || e.slot[k].beta != beta) {
+    k = 1 - k;
+    if(e.slot[k].sourceI != sourceI || e.slot[k].beta != beta) {
+      double betaH = beta * hFunc(parms,c.time - sourceI);
+      e.slot[k].sourceI = sourceI;
+      e.slot[k].beta = beta;
+      e.slot[k].logInfec = log(betaH);
+      e.slot[k].logNonInfec = log(1 - betaH);
+    }
+    e.last = k;
+  }
+
+  logInfec = e.slot[k].logInfec;
+  logNonInfec = e.slot[k].logNonInfec;
+}
+
+
+
+static double logBinomComponent(epiParms& parms, infection* s, double t,
+				const infection* moved=NULL, double Imoved=0.0)
+{
+  // log(binomComponent) accumulated in log space from the cache,
+  // with moved's infection time taken as Imoved
+
+  const CON_e types[] = {FEEDMILL, SHOUSE};
+  const size_t betas[] = {ModelTraits::BETA_FM, ModelTraits::BETA_SH};
+  double answer = 0.0;
+  double sourceI, logInfec, logNonInfec;
+  size_t entry;
+  size_t base = ctEntries.empty() ? 0 : ctOffset[s->label];
+  set<Contact>::iterator cIter;
+
+  for(int k=0; k<2; ++k) {
+
+    double myBeta = parms.beta[betas[k]];
+
+    for(cIter = s->contacts.begin(), entry = base; cIter != s->contacts.end(); ++cIter, ++entry) {
+      if(cIter->time == t && cIter->type == types[k] && isInfectiousWith(*cIter,moved,Imoved,sourceI)) {
+	contactLogTerms(parms,entry,*cIter,myBeta,sourceI,logInfec,logNonInfec);
+	answer += logInfec;
+	break;
+      }
+    }
+
+    for(cIter = s->contacts.begin(), entry = base; cIter != s->contacts.end() && cIter->time < t; ++cIter, ++entry) {
+      if(cIter->type == types[k] && isInfectiousWith(*cIter,moved,Imoved,sourceI)) {
+	contactLogTerms(parms,entry,*cIter,myBeta,sourceI,logInfec,logNonInfec);
+	answer += logNonInfec;
+      }
+    }
+  }
+
+  return answer;
+}
+
+
+
 void drawBetaCan(const int& nParms, const double mu[], gsl_matrix* const sdMat, double mvNormRV[], const int addOffset)
 {
   // Takes an input vector of parameter, mu, and 
@@ -260,10 +423,30 @@ double occultProposal(const double& a, const double& b)
 
 
 
+// Tabulated h and its integral, used while f and g match parms
+
+static InfectivityKernel infecKernel;
+
+void initInfecKernel(epiParms& parms, const double relTol, const bool exact)
+{
+  infecKernel.set(parms.f,parms.g,relTol);
+  if(exact) infecKernel.setMode(InfectivityKernel::EXACT);
+}
+
+
+
+const InfectivityKernel& getInfecKernel()
+{
+  return infecKernel;
+}
+
+
+
 double hFunc(epiParms &parms, double t)
 {
 
   assert(t>=0);
+  if(infecKernel.matches(parms.f,parms.g)) return infecKernel.h(t);
   double exponent = exp(parms.g*t);
   return exponent / (parms.f + exponent);
 }
@@ -276,6 +459,9 @@ inline double infecInteg(epiParms &parms, double t)
   if ( t < 0.0 ) {
     cout << "WARNING: t < 0.0 in " << __PRETTY_FUNCTION__ << endl;
   }
+  else if(infecKernel.matches(parms.f,parms.g)) {
+    return infecKernel.integral(t);
+  }
 
   return 1/parms.g * log( (parms.f+exp(parms.g*t)) / (parms.f+1) );
 }
@@ -292,159 +478,180 @@ double compute_bgPress(epiParms &parms, sinrEpi &epidata)
   double result = 0;
   /* \beta_0 * ( \sum_i (I_i) +  n_sT - (N-1)I1 ) */
   
-  result += parms.beta[0] * (epidata.sumI() + epidata.susceptible.size() * (ObsTime) - (epidata.N_total-1) * epidata.infected[epidata.I1]->I);
+  result += parms.beta[ModelTraits::BETA0] * (epidata.sumI() + epidata.susceptible.size() * (ObsTime) - (epidata.N_total-1) * epidata.infected[epidata.I1]->I);
 
   return result;
 }
 
 
 
-double compute_A1(epiParms &parms, sinrEpi &epidata) {
+static double A1Pressure(epiParms &parms, sinrEpi &epidata, int i)
+{
+  // Integrated pressure from infective i on its connections
 
   double result = 0.0;
-  int i,j;
-  size_t iLabel,jLabel;
-  int num_infectives = epidata.infected.size();
-  int num_susceptibles = epidata.susceptible.size();
-  vector<size_t>::iterator jIter;
+  size_t iLabel = epidata.infected[i]->label;
+  vector<size_t>& connections = epidata.infected[i]->connections;
 
-#pragma omp parallel for default(shared) private(i,j,iLabel,jLabel,jIter) schedule(static)  reduction(+:result)
+  for(vector<size_t>::iterator jIter = connections.begin(); jIter != connections.end(); ++jIter) {
 
-  for(i=0; i<num_infectives; ++i) {
+    size_t jLabel = *jIter;
 
-    iLabel = epidata.infected.at(i)->label;
-    jIter = epidata.infected.at(i)->connections.begin();
+    // Infectious pressure on infectives
+    if(epidata.store.status[jLabel] == INFECTED) {
+      result += spatialRate(parms,epidata,iLabel,jLabel) * infecInteg(parms,epidata.exposureI(iLabel,jLabel));
+      result += networkRate(parms,epidata,iLabel,jLabel) * infecInteg(parms,epidata.exposureIBeforeCT(iLabel,jLabel));
+    }
 
-    while(jIter != epidata.infected.at(i)->connections.end()) {
+    // Infectious pressure on susceptibles
+    else {
+      result += spatialRate(parms,epidata,iLabel,jLabel) *  infecInteg(parms,epidata.ITime(iLabel));
+      result += networkRate(parms,epidata,iLabel,jLabel) * infecInteg(parms,epidata.ITimeBeforeCT(iLabel));
+    }
+  }
 
-      jLabel = *jIter;
-      
-      // Infectious pressure on infectives
-      if(epidata.individuals.at(jLabel).status == INFECTED) {
-	result += spatialRate(parms,epidata,iLabel,jLabel) * infecInteg(parms,epidata.exposureI(iLabel,jLabel));
-	result += networkRate(parms,epidata,iLabel,jLabel) * infecInteg(parms,epidata.exposureIBeforeCT(iLabel,jLabel));
-      }
+  return result;
+}
 
-      // Infectious pressure on susceptibles
-      else {
-	result += spatialRate(parms,epidata,iLabel,jLabel) *  infecInteg(parms,epidata.ITime(iLabel));
-	result += networkRate(parms,epidata,iLabel,jLabel) * infecInteg(parms,epidata.ITimeBeforeCT(iLabel));
-      }
 
-      jIter++;
+
+static double A2Pressure(epiParms &parms, sinrEpi &epidata, int i)
+{
+  // Notified pressure from infective i on its connections
+
+  double result = 0.0;
+  size_t iLabel = epidata.infected[i]->label;
+  vector<size_t>& connections = epidata.infected[i]->connections;
+
+  for(vector<size_t>::iterator jIter = connections.begin(); jIter != connections.end(); ++jIter) {
+
+    size_t jLabel = *jIter;
+
+    if(epidata.store.status[jLabel] == INFECTED) {
+      /* this is the first part  */
+      result += betastar(parms,epidata,iLabel,jLabel) * epidata.exposureN(iLabel,jLabel);
+    }
+
+    else {
+      /* the second part */
+      result += betastar(parms,epidata,iLabel,jLabel) * epidata.NTime(iLabel);
     }
   }
 
   return result;
+}
 
-} /* end of function : compute_A1 */
 
 
+static double logProdPressure(epiParms &parms, sinrEpi &epidata, int j, vector<double> *product_Curr)
+{
+  // Log instantaneous pressure on infective j at its infection
+  // time, stored in product_Curr.  Zero for I1.
 
-double compute_A2(epiParms &parms, sinrEpi &epidata) {
+  if(j == epidata.I1) return 0.0;
 
-  double result = 0.0;
-  int i,j;
-  size_t iLabel,jLabel;
-  int num_infectives = epidata.infected.size();
-  int num_susceptibles = epidata.susceptible.size();
-  vector<size_t>::iterator jIter;
+  const PopulationStore& store = epidata.store;
+  size_t iLabel;
+  size_t jLabel = store.infectives.at(j);
+  double Ij = store.I[jLabel];
+  double Ii,Ni,Ri;
+  double sum_over_j = 0.0;
+  int num_infectives = store.infectives.size();
 
-#pragma omp parallel for default(shared) private(i,j,iLabel,jLabel,jIter) schedule(static) reduction(+:result)
+  if( epidata.infected[j]->isInfecByContact() ) {
+    sum_over_j = 1.0;
+  }
+  else {
 
-  for (i=0; i<num_infectives; ++i) {
+    for(int i=0; i<num_infectives; ++i) {
 
-    iLabel = epidata.infected.at(i)->label;
-    jIter = epidata.infected.at(i)->connections.begin();
+      if ( i!=j ) {
 
-    while(jIter != epidata.infected.at(i)->connections.end()) {
+	iLabel = store.infectives[i];
+	Ii = store.I[iLabel];
+	Ni = store.N[iLabel];
+	Ri = store.R[iLabel];
 
+	if (Ii < Ij && Ij <= Ni) {
 
-      jLabel = *jIter;
+	  sum_over_j += spatialRate(parms,epidata,iLabel,jLabel) * hFunc(parms,Ij - Ii);
 
-      if(epidata.individuals.at(jLabel).status == INFECTED) {
-        /* this is the first part  */
-        result = result + betastar(parms,epidata,iLabel,jLabel) * epidata.exposureN(iLabel,jLabel);
-      }
+	  if(!epidata.infected[j]->infecInCTWindow() && !epidata.infected[i]->inCTWindowAt(Ij)) {
+	    sum_over_j += networkRate(parms,epidata,iLabel,jLabel) * hFunc(parms,Ij - Ii);
+	  }
 
-      else {
-        /* the second part */
-        result = result + betastar(parms,epidata,iLabel,jLabel) * epidata.NTime(iLabel);
+	}
+	else if (Ni < Ij && Ij <= Ri) {
+	  sum_over_j += betastar(parms,epidata,iLabel,jLabel);
+	}
       }
-
-      jIter++;
-
     }
 
+    sum_over_j += parms.beta[ModelTraits::BETA0];
   }
 
-  return result;
+  product_Curr->at(j) = sum_over_j;
+  return log(sum_over_j);
+}
+
+
+
+static double logCTComponent(epiParms& parms, sinrEpi& epidata, int j)
+{
+  // Log binomial contact tracing term for individual j
 
+  infection* indiv = &(epidata.individuals[j]);
+  if(indiv->I == epidata.infected[epidata.I1]->I) return 0.0;
+  return logBinomComponent(parms,indiv,indiv->I);
 }
 
 
 
-/* this is a function to evaluate infectious pressure that individual i gets */
+double compute_A1(epiParms &parms, sinrEpi &epidata) {
 
-double compute_log_prod_pressure(epiParms &parms, sinrEpi &epidata,vector<double> *product_Curr) {
+  double result = 0.0;
+  int i;
+  int num_infectives = epidata.infected.size();
 
-  // Calculate the instantaneous infectious pressure on all i's *from* all j's.
+#pragma omp parallel for default(shared) private(i) schedule(dynamic) reduction(+:result)
+  for(i=0; i<num_infectives; ++i)
+    result += A1Pressure(parms,epidata,i);
+
+  return result;
+
+} /* end of function : compute_A1 */
+
+
+
+double compute_A2(epiParms &parms, sinrEpi &epidata) {
 
-  int i,j;
-  size_t iLabel,jLabel;
-  double Ii,Ij,Ni,Ri;
-  //bool iHasContacts;
-  double sum_over_j = 0.0;
   double result = 0.0;
+  int i;
   int num_infectives = epidata.infected.size();
 
-#pragma omp parallel for default(shared) private(i,j,iLabel,Ii,jLabel,Ij,Ni,Ri,sum_over_j) schedule(static) reduction(+:result)
-  for (j=0; j<num_infectives; ++j) {
-    
-    if ( j != epidata.I1) {
+#pragma omp parallel for default(shared) private(i) schedule(dynamic) reduction(+:result)
+  for (i=0; i<num_infectives; ++i)
+    result += A2Pressure(parms,epidata,i);
 
-      jLabel = epidata.infected.at(j)->label;
-      Ij = epidata.infected.at(j)->I;
+  return result;
 
-      sum_over_j = 0.0;
+}
 
-      if( epidata.infected[j]->isInfecByContact() ) {
-	sum_over_j = 1.0;
-      }
-      else {
 
-	for(i=0; i<num_infectives; ++i) {
-	
-	  if ( i!=j ) {
-
-	    iLabel = epidata.infected[i]->label;
-	    Ii = epidata.infected[i]->I;
-	    Ni = epidata.infected[i]->N;
-	    Ri = epidata.infected[i]->R;
-	    
-	    if (Ii < Ij && Ij <= Ni) {
-	
-              sum_over_j += spatialRate(parms,epidata,iLabel,jLabel) * hFunc(parms,Ij - Ii);
 
-	      if(!epidata.infected[j]->infecInCTWindow() && !epidata.infected[i]->inCTWindowAt(Ij)) {
-		sum_over_j += networkRate(parms,epidata,iLabel,jLabel) * hFunc(parms,Ij - Ii);
-	      }
+/* this is a function to evaluate infectious pressure that individual i gets */
 
-	    }
-	    else if (Ni < Ij && Ij <= Ri) {
-	      sum_over_j += betastar(parms,epidata,iLabel,jLabel);
-	    }
-	  }
-	}
-      
-	sum_over_j += parms.beta[0];
-      }
+double compute_log_prod_pressure(epiParms &parms, sinrEpi &epidata,vector<double> *product_Curr) {
 
+  // Calculate the instantaneous infectious pressure on all i's *from* all j's.
 
-      product_Curr->at(j) = sum_over_j;
-      result = result + log(sum_over_j);
-    }
-  }
+  int j;
+  double result = 0.0;
+  int num_infectives = epidata.infected.size();
+
+#pragma omp parallel for default(shared) private(j) schedule(static) reduction(+:result)
+  for (j=0; j<num_infectives; ++j)
+    result += logProdPressure(parms,epidata,j,product_Curr);
 
   product_Curr->at(epidata.I1) = 1.0;  // Fill in for I1
   return result; 
@@ -460,75 +667,278 @@ double computeLogCT(epiParms& parms, sinrEpi& epidata)
 
   double prod(0.0);
   int j;
-  infection* indiv;
 
-#pragma omp parallel for default(shared) private(j,indiv) schedule(static) reduction(+:prod)
-  for(j=0; j < epidata.individuals.size(); ++j) {
-    indiv = &(epidata.individuals[j]);
-    if(indiv->I == epidata.infected[epidata.I1]->I) continue;
-    prod += log(binomComponent(parms,indiv,indiv->I));
+#pragma omp parallel for default(shared) private(j) schedule(static) reduction(+:prod)
+  for(j=0; j < epidata.individuals.size(); ++j)
+    prod += logCTComponent(parms,epidata,j);
+
+  return prod;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////
+// Task parallel likelihood
+/////////////////////////////////////////////////////////////////////////
+
+// The likelihood components are independent given the epidemic, so rather
+// than a fork/join per component they are evaluated together as OpenMP
+// tasks.  Each component is cut into chunks of roughly equal work so that
+// threads finishing early pick up the remaining chunks.
+
+#define CHUNKS_PER_THREAD 4
+
+static void balancedChunks(const vector<size_t>& weight, size_t numChunks, vector<int>& bounds)
+{
+  // Splits [0,weight.size()) into at most numChunks contiguous
+  // ranges of roughly equal total weight.  Range c is
+  // [bounds[c],bounds[c+1]).
+
+  double total = 0.0;
+  for(size_t i=0; i<weight.size(); ++i) total += weight[i];
+
+  bounds.assign(1,0);
+  double cumulative = 0.0;
+  size_t chunk = 1;
+  for(size_t i=0; i<weight.size(); ++i) {
+    cumulative += weight[i];
+    if(cumulative >= total * chunk / numChunks && i+1 < weight.size()) {
+      bounds.push_back(i+1);
+      while(cumulative >= total * chunk / numChunks) ++chunk;
+    }
+  }
+  bounds.push_back(weight.size());
+}
+
+
+
+static size_t numTaskChunks()
+{
+  return CHUNKS_PER_THREAD * omp_get_max_threads();
+}
+
+
+
+static double sumParts(const vector<double>& parts)
+{
+  // Sums in a fixed order, so results do not depend on scheduling
+
+  double sum = 0.0;
+  for(size_t c=0; c<parts.size(); ++c) sum += parts[c];
+  return sum;
+}
+
+
+
+void computeLikelihood(epiParms& parms, sinrEpi& epidata, vector<double>* product_Curr, LikComponents& lik)
+{
+  // Computes all likelihood components in one parallel region.
+  // A1 and A2 are chunked by number of connections, logCT by
+  // number of contacts.
+
+  ComponentTimer timer(profiler,COMP_LIKELIHOOD);
+  int numInfectives = epidata.infected.size();
+  int numIndividuals = epidata.individuals.size();
+  size_t numChunks = numTaskChunks();
+
+  prepareSpatialKernel(parms);
+  prepareSusceptibility(parms,epidata);
+
+  vector<size_t> weight(numInfectives,1);
+  vector<int> prodBounds, degreeBounds, contactBounds;
+
+  balancedChunks(weight,numChunks,prodBounds);
+  for(int i=0; i<numInfectives; ++i) weight[i] = epidata.infected[i]->connections.size() + 1;
+  balancedChunks(weight,numChunks,degreeBounds);
+  weight.resize(numIndividuals);
+  for(int j=0; j<numIndividuals; ++j) weight[j] = epidata.individuals[j].contacts.size() + 1;
+  balancedChunks(weight,numChunks,contactBounds);
+
+  vector<double> prodParts(prodBounds.size()-1,0.0);
+  vector<double> A1Parts(degreeBounds.size()-1,0.0);
+  vector<double> A2Parts(degreeBounds.size()-1,0.0);
+  vector<double> CTParts(contactBounds.size()-1,0.0);
+  double bgPress = 0.0;
+
+#pragma omp parallel default(shared)
+#pragma omp single
+  {
+#pragma omp task default(shared)
+    bgPress = compute_bgPress(parms,epidata);
+
+    for(size_t c=0; c<A1Parts.size(); ++c) {
+#pragma omp task default(shared) firstprivate(c)
+      for(int i=degreeBounds[c]; i<degreeBounds[c+1]; ++i) A1Parts[c] += A1Pressure(parms,epidata,i);
+#pragma omp task default(shared) firstprivate(c)
+      for(int i=degreeBounds[c]; i<degreeBounds[c+1]; ++i) A2Parts[c] += A2Pressure(parms,epidata,i);
+    }
+
+    for(size_t c=0; c<prodParts.size(); ++c) {
+#pragma omp task default(shared) firstprivate(c)
+      for(int j=prodBounds[c]; j<prodBounds[c+1]; ++j) prodParts[c] += logProdPressure(parms,epidata,j,product_Curr);
+    }
+
+    for(size_t c=0; c<CTParts.size(); ++c) {
+#pragma omp task default(shared) firstprivate(c)
+      for(int j=contactBounds[c]; j<contactBounds[c+1]; ++j) CTParts[c] += logCTComponent(parms,epidata,j);
+    }
+  } // Tasks complete at the implicit barrier
+
+  product_Curr->at(epidata.I1) = 1.0;  // Fill in for I1
+
+  lik.logProd = sumParts(prodParts);
+  lik.logCT = sumParts(CTParts);
+  lik.bgPress = bgPress;
+  lik.A1 = sumParts(A1Parts);
+  lik.A2 = sumParts(A2Parts);
+}
+
+
+
+//////////////////////////////////////////////////////////////////////////////
+// Update functions
+//////////////////////////////////////////////////////////////////////////////
+static int moveI1can(int move_index, epiParms& parms, sinrEpi& epidata)
+{
+  // The index case if infective move_index is moved to parms.Ican
+
+  int I1can = epidata.I1;
+
+  if( move_index == epidata.I1 ) {  // Tests for a new I1
+    int I2 = epidata.I2();   // and if we have, we set our local I1 to I2.
+    if ( parms.Ican > epidata.infected[I2]->I ) I1can = I2;
+  }
+  else if( parms.Ican < epidata.infected[epidata.I1]->I ) {
+    I1can = move_index;
+  }
+
+  return I1can;
+}
+
+
+
+static bool moveHasRow(int move_index, int I1can, epiParms& parms, sinrEpi& epidata)
+{
+  // True if the moved infective's product row is a sum of pressures
+  // rather than 1.0
+
+  return move_index != I1can && !epidata.infected[move_index]->isInfecContactAt(parms.Ican);
+}
+
+
+
+static double moveRowTerm(epiParms& parms, sinrEpi& epidata, int move_index, bool iCanInCTWindow, int i)
+{
+  // Pressure from infective i on the moved infective at parms.Ican
+
+  if ( i==move_index ) return 0.0;
+
+  const PopulationStore& store = epidata.store;
+  size_t moveLabel = store.infectives[move_index];
+  size_t iLabel = store.infectives[i];
+  double Ii = store.I[iLabel];
+  double result = 0.0;
+
+  if (Ii < parms.Ican && parms.Ican <= store.N[iLabel]) {
+    result += spatialRate(parms,epidata,iLabel,moveLabel) * hFunc(parms,parms.Ican - Ii);
+
+    if ( !iCanInCTWindow && !epidata.infected[i]->inCTWindowAt(parms.Ican) ) {
+      result += networkRate(parms,epidata,iLabel,moveLabel) * hFunc(parms,parms.Ican - Ii);
+    }
+  }
+
+  else if (store.N[iLabel] < parms.Ican && parms.Ican <= store.R[iLabel]) {
+    result += betastar(parms,epidata,iLabel,moveLabel);
+  }
+
+  return result;
+}
+
+
+
+static double moveAlterTerm(epiParms& parms, sinrEpi& epidata, int move_index, int I1can,
+			    vector<double>* prodCurr_vec, vector<double>* prodCan_vec, int j)
+{
+  // Fills prodCan_vec->at(j) for the move and returns the change
+  // in its log
+
+  if(j==move_index) return 0.0;  // Done by the caller
+  else if(epidata.infected[j]->isInfecByContact()) { // Nothing changes if j is infected by a contact
+    if( prodCurr_vec->at(j) != 1.0 ) {
+      cerr << "prodCurr_vec->at(" << j << ") = " << prodCurr_vec->at(j) << endl;
+      throw logic_error("Inconsistency in product vector!");
+    }
+    prodCan_vec->at(j) = 1.0;
+    return 0.0;
+  }
+  else {
+    if (prodCurr_vec->at(j) == 1.0 && j != epidata.I1) {
+      cout << "prodCurr_vec->at(" << j << ") = " << prodCurr_vec->at(j) << " and is not infected by contact" << endl;
+    }
+  }
+
+  double Icurr = epidata.infected[move_index]->I;
+  prodCan_vec->at(j) = prodCurr_vec->at(j); // Copy across before modifying.
+  double Ij = epidata.infected[j]->I;
+
+  // First subtract pressure if needs be
+  if ( j == I1can ) prodCan_vec->at(j) = 1.0;
+  else if ( Icurr < Ij && Ij < epidata.infected[move_index]->N ) {
+    prodCan_vec->at(j) -= spatialRate(parms,epidata,epidata.infected[move_index]->label,epidata.infected[j]->label) * hFunc(parms,Ij - Icurr);
+
+    if(!epidata.infected[move_index]->inCTWindowAt(Ij) && !epidata.infected[j]->infecInCTWindow()) {
+      prodCan_vec->at(j) -= networkRate(parms,epidata,epidata.infected[move_index]->label,epidata.infected[j]->label) * hFunc(parms,Ij - Icurr);
+    }
+  }
+
+  // Now add pressure if needs be
+  if(parms.Ican < Ij && Ij < epidata.infected[move_index]->N) {
+
+    // If j is the old I1, meaning that we're proposing a new I1, we calculate pressure on j:
+    if(j == epidata.I1) {
+      prodCan_vec->at(j) = parms.beta[ModelTraits::BETA0]; // Add beta_0
+    }
+
+    // Add non-network pressure
+    prodCan_vec->at(j) += spatialRate(parms,epidata,epidata.infected[move_index]->label,epidata.infected[j]->label) * hFunc(parms,Ij - parms.Ican);
+
+    // Add network pressure if Ij is not in a contact window
+    if(!epidata.infected[move_index]->inCTWindowAt(Ij) && !epidata.infected[j]->infecInCTWindow()) {
+      prodCan_vec->at(j) += networkRate(parms,epidata,epidata.infected[move_index]->label,epidata.infected[j]->label) * hFunc(parms,Ij - parms.Ican);
+    }
   }
 
-  return prod;
+  if(prodCan_vec->at(j) != prodCurr_vec->at(j) ) {
+    return log(prodCan_vec->at(j)) - log(prodCurr_vec->at(j));
+  }
+  return 0.0;
 }
 
 
 
-//////////////////////////////////////////////////////////////////////////////
-// Update functions
-//////////////////////////////////////////////////////////////////////////////
 double update_log_prod(int &move_index, epiParms &parms, 
 		       sinrEpi &epidata, double &log_prod, 
 		       vector<double> *prodCurr_vec, 
 		       vector<double> *prodCan_vec) 
 {
+  ComponentTimer timer(profiler,COMP_UPDATE_LOGPROD);
   double log_prod_can = log_prod;
-  double Icurr = epidata.infected[move_index]->I;
-  double Ij;
   int j,i;
-  int I1can = epidata.I1;  // Necessary to allow us to adjust I1 if needs be
+  int I1can = moveI1can(move_index,parms,epidata);  // Necessary to allow us to adjust I1 if needs be
   int num_infectives = epidata.infected.size();
 
- 
-
   double row_sum = 0.0;  // Hold the new value of \sum^nI_j(beta_ij) for the proposal
 
-  if( move_index == epidata.I1 ) {  // Tests for a new I1
-    int I2 = epidata.I2();   // and if we have, we set our local I1 to I2.
-    if ( parms.Ican > epidata.infected[I2]->I ) I1can = I2;
-//    cout << "Moving I1" << endl;
-  }
-  else if( parms.Ican < epidata.infected[epidata.I1]->I ) {
-    I1can = move_index;
-  }
-
   // First recalculate the product row for our proposed individual
   bool iCanInCTWindow = epidata.infected[move_index]->inCTWindowAt(parms.Ican);
-  bool iCurrInCTWindow = epidata.infected[move_index]->infecInCTWindow();
 
-  if( move_index != I1can  && !epidata.infected[move_index]->isInfecContactAt(parms.Ican)) {
+  if( moveHasRow(move_index,I1can,parms,epidata) ) {
 
     #pragma omp parallel for default(shared) private(i) schedule(static) reduction(+:row_sum)
-    for (i=0; i<num_infectives; ++i) {
-
-      if ( i==move_index ) continue;
-      
-      if (epidata.infected[i]->I < parms.Ican && parms.Ican <= epidata.infected[i]->N) {
-	  row_sum += spatialRate(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label)
-                     * hFunc(parms,parms.Ican - epidata.infected[i]->I);
-
-   	  if ( !iCanInCTWindow && !epidata.infected[i]->inCTWindowAt(parms.Ican) ) {
-	    row_sum += networkRate(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label)
-	               * hFunc(parms,parms.Ican - epidata.infected[i]->I);
-	  }
-      }
-      
-      else if (epidata.infected[i]->N < parms.Ican && parms.Ican <= epidata.infected[i]->R) {
-	row_sum += betastar(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label);
-      }
+    for (i=0; i<num_infectives; ++i)
+      row_sum += moveRowTerm(parms,epidata,move_index,iCanInCTWindow,i);
 
-    }
-    row_sum += parms.beta[0]; // Don't forget to add the omnipresent \beta_0
+    row_sum += parms.beta[ModelTraits::BETA0]; // Don't forget to add the omnipresent \beta_0
   }
   else row_sum = 1.0;
 
@@ -541,91 +951,70 @@ double update_log_prod(int &move_index, epiParms &parms,
   // Now update all other \sum^nI_j(beta_ij) based on this proposed move
   double log_prod_alter = 0.0;
 
-#pragma omp parallel for default(shared) private(Ij,j) schedule(dynamic) reduction(+:log_prod_alter)
-  for(j=0; j < num_infectives; ++j) {
-
-    if(j==move_index) continue;  // Already done move_index
-    else if(epidata.infected[j]->isInfecByContact()) { // Nothing changes if j is infected by a contact
-      if( prodCurr_vec->at(j) != 1.0 ) {
-	cerr << "prodCurr_vec->at(" << j << ") = " << prodCurr_vec->at(j) << endl;
-	throw logic_error("Inconsistency in product vector!");
-	}
-      prodCan_vec->at(j) = 1.0;
-      continue;
-    }
-    else {
-	if (prodCurr_vec->at(j) == 1.0 && j != epidata.I1) {
-		cout << "prodCurr_vec->at(" << j << ") = " << prodCurr_vec->at(j) << " and is not infected by contact" << endl;
-	}
-    }
+#pragma omp parallel for default(shared) private(j) schedule(dynamic) reduction(+:log_prod_alter)
+  for(j=0; j < num_infectives; ++j)
+    log_prod_alter += moveAlterTerm(parms,epidata,move_index,I1can,prodCurr_vec,prodCan_vec,j);
 
-    prodCan_vec->at(j) = prodCurr_vec->at(j); // Copy across before modifying.
-    Ij = epidata.infected[j]->I;
+  log_prod_can += log_prod_alter;
 
-    // First subtract pressure if needs be
-    if ( j == I1can ) prodCan_vec->at(j) = 1.0;
-    else if ( Icurr < Ij && Ij < epidata.infected[move_index]->N ) {
-	prodCan_vec->at(j) -= spatialRate(parms,epidata,epidata.infected[move_index]->label,epidata.infected[j]->label) * hFunc(parms,Ij - Icurr);
-	
-	if(!epidata.infected[move_index]->inCTWindowAt(Ij) && !epidata.infected[j]->infecInCTWindow()) {
-		prodCan_vec->at(j) -= networkRate(parms,epidata,epidata.infected[move_index]->label,epidata.infected[j]->label) * hFunc(parms,Ij - Icurr);
-	}
-    }
+  return(log_prod_can);
+}
 
-    // Now add pressure if needs be
-    if(parms.Ican < Ij && Ij < epidata.infected[move_index]->N) {
+///////////////////////////////////////////////////////////////////////////////////
+/////////////////////////IN PROGRESS///////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////
+static double logCTMove(epiParms& parms, sinrEpi& epidata, infection* s, double Ican)
+{
+  // Log contact tracing terms for all individuals with s moved to Ican.
+  // Returns GSL_NEGINF if the move leaves a contact infection without
+  // an infectious source.
 
-        // If j is the old I1, meaning that we're proposing a new I1, we calculate pressure on j:
-        if(j == epidata.I1) {
-	   prodCan_vec->at(j) = parms.beta[0]; // Add beta_0
-	}
-	
-	// Add non-network pressure
-	prodCan_vec->at(j) += spatialRate(parms,epidata,epidata.infected[move_index]->label,epidata.infected[j]->label) * hFunc(parms,Ij - parms.Ican);
+  double logCTcan = 0.0;
 
-	// Add network pressure if Ij is not in a contact window
-	if(!epidata.infected[move_index]->inCTWindowAt(Ij) && !epidata.infected[j]->infecInCTWindow()) {
-		prodCan_vec->at(j) += networkRate(parms,epidata,epidata.infected[move_index]->label,epidata.infected[j]->label) * hFunc(parms,Ij - parms.Ican);
-	}
-    }
+  for(size_t j=0; j < epidata.individuals.size(); ++j) {
 
+    infection* indiv = &(epidata.individuals[j]);
 
-    // Update log_prod_alter
-    if(prodCan_vec->at(j) != prodCurr_vec->at(j) ) {
-	log_prod_alter += log(prodCan_vec->at(j)) - log(prodCurr_vec->at(j));
+    // Epidemic integrity check - checks for infectious contacts that have been abandoned
+    infection* mySource;
+    if(indiv->isInfecByContact(mySource)) {
+      if(mySource->label == s->label && Ican > indiv->I) {
+	return GSL_NEGINF;
+      }
     }
 
+    logCTcan += logBinomComponent(parms,indiv,indiv == s ? Ican : indiv->I,s,Ican);
   }
 
-  log_prod_can += log_prod_alter;
-
-  return(log_prod_can);
+  return logCTcan;
 }
 
-///////////////////////////////////////////////////////////////////////////////////
-/////////////////////////IN PROGRESS///////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////////
+
+
 double update_logCT(int& move_index,
 		   epiParms& parms,
 		   sinrEpi& epidata,
 		   double& logCTcurr)
 {
-  // Updates the contact tracing binomial portion of the likelihood
+  ComponentTimer timer(profiler,COMP_UPDATE_LOGCT);
+  // Updates the contact tracing binomial portion of the likelihood.
+  // The proposal is substituted on the fly, so epidata is not touched.
+  // With the contact cache, only the terms for the mover and the
+  // individuals it contacted are re-evaluated.
 
   infection* s = epidata.infected.at(move_index);
-  double Icurr = s->I;
-  double logCTcan = 0.0;
 
-  int j;
-  int numInfectives = epidata.infected.size();
-  infection* indiv;
+  if(ctEntries.empty())
+    return logCTMove(parms,epidata,s,parms.Ican);
 
-  //#pragma omp parallel for default(shared) private(j,indiv) schedule(static) reduction(+:logCTcan)
-  for(j=0; j < epidata.individuals.size(); ++j) {
+  double logCTcan = logCTcurr;
+  vector<size_t>& contactees = ctContactees[s->label];
 
-    indiv = &(epidata.individuals[j]);
+  for(vector<size_t>::iterator c = contactees.begin(); c != contactees.end(); ++c) {
+
+    if(*c == s->label) continue;
+    infection* indiv = &(epidata.individuals[*c]);
 
-    // Epidemic integrity check - checks for infectious contacts that have been abandoned
     infection* mySource;
     if(indiv->isInfecByContact(mySource)) {
       if(mySource->label == s->label && parms.Ican > indiv->I) {
@@ -633,16 +1022,10 @@ double update_logCT(int& move_index,
       }
     }
 
-    s->I = parms.Ican; // Swap in the proposal
-
-    logCTcan += log(binomComponent(parms,indiv,indiv->I));
-
-    s->I = Icurr; // Swap back the old time
+    logCTcan += logBinomComponent(parms,indiv,indiv->I,s,parms.Ican) - logBinomComponent(parms,indiv,indiv->I);
   }
 
-//   for(j = 0; j < epidata.susceptible.size(); ++j) {
-// 	logCTcan += log(binomComponent(parms,epidata.susceptible[j],epidata.susceptible[j]->I));
-//   }
+  logCTcan += logBinomComponent(parms,s,parms.Ican,s,parms.Ican) - logBinomComponent(parms,s,s->I);
 
   return logCTcan;
 }
@@ -654,6 +1037,7 @@ double update_bgPress(int &move_index,
 		      sinrEpi &epidata,
 		      double &bg_press) 
 {
+  ComponentTimer timer(profiler,COMP_UPDATE_BGPRESS);
   // update_bg_press returns a candidate partial liklihood for bg_press
 
   double result = bg_press;
@@ -663,14 +1047,14 @@ double update_bgPress(int &move_index,
     
     if(parms.Ican > epidata.infected[epidata.I1]->I) {  // If proposal does not affect I1
       
-      result -= parms.beta[0] * epidata.infected[move_index]->I;
-      result += parms.beta[0] * parms.Ican;
+      result -= parms.beta[ModelTraits::BETA0] * epidata.infected[move_index]->I;
+      result += parms.beta[ModelTraits::BETA0] * parms.Ican;
     }
     else{  // The proposal becomes I1
-      result += parms.beta[0] * (epidata.N_total - 1) * epidata.infected[epidata.I1]->I; // subtract -(N-1)I_{1}
-      result -= parms.beta[0] * (epidata.N_total - 1) * parms.Ican; // Subtract (N-1)I_{move_index}^{can}
-      result -= parms.beta[0] * epidata.infected[move_index]->I; // Subtract \beta0 * I_{move}^{cur} 
-      result += parms.beta[0] * epidata.infected[epidata.I1]->I; // I1 now has a time within which it was susceptible
+      result += parms.beta[ModelTraits::BETA0] * (epidata.N_total - 1) * epidata.infected[epidata.I1]->I; // subtract -(N-1)I_{1}
+      result -= parms.beta[ModelTraits::BETA0] * (epidata.N_total - 1) * parms.Ican; // Subtract (N-1)I_{move_index}^{can}
+      result -= parms.beta[ModelTraits::BETA0] * epidata.infected[move_index]->I; // Subtract \beta0 * I_{move}^{cur} 
+      result += parms.beta[ModelTraits::BETA0] * epidata.infected[epidata.I1]->I; // I1 now has a time within which it was susceptible
     }
   
   
@@ -681,17 +1065,17 @@ double update_bgPress(int &move_index,
     if(parms.Ican > epidata.infected[myI2]->I) { // If our propsal means that I1 is no longer index case
       //cout << "MOVING I1 in bgPress to after I2" << endl;
       //cout << "I2: " << epidata.infected[myI2].label << " (" << myI2 << "), time=" << epidata.infected[myI2].I << endl;
-      result += parms.beta[0] * (epidata.N_total - 1) * epidata.infected[move_index]->I; // Add (N-1)I_1
-      result -= parms.beta[0] * (epidata.N_total - 1) * epidata.infected[myI2]->I; // Subtract (N-1)I_{2}
-      result -= parms.beta[0] * epidata.infected[myI2]->I;  // I2 is now I1 so was never susceptible
-      result += parms.beta[0] * parms.Ican;  // I1 now has a susceptible period so add beta_0 pressure for that.
+      result += parms.beta[ModelTraits::BETA0] * (epidata.N_total - 1) * epidata.infected[move_index]->I; // Add (N-1)I_1
+      result -= parms.beta[ModelTraits::BETA0] * (epidata.N_total - 1) * epidata.infected[myI2]->I; // Subtract (N-1)I_{2}
+      result -= parms.beta[ModelTraits::BETA0] * epidata.infected[myI2]->I;  // I2 is now I1 so was never susceptible
+      result += parms.beta[ModelTraits::BETA0] * parms.Ican;  // I1 now has a susceptible period so add beta_0 pressure for that.
     }
     
     else {  // I1 moves, but stays as the index case
       //cout << "MOVING I1 in bgPress to before I2" << endl;
       //cout << "I2: " << epidata.infected[myI2].label << " (" << myI2 << "), time=" << epidata.infected[myI2].I << endl;
-      result += parms.beta[0] * (epidata.N_total - 1) * epidata.infected[move_index]->I; // Subtract for the old I1
-      result -= parms.beta[0] * (epidata.N_total - 1) * parms.Ican; // Add for the new I1
+      result += parms.beta[ModelTraits::BETA0] * (epidata.N_total - 1) * epidata.infected[move_index]->I; // Subtract for the old I1
+      result -= parms.beta[ModelTraits::BETA0] * (epidata.N_total - 1) * parms.Ican; // Add for the new I1
     }
   }
 
@@ -700,58 +1084,101 @@ double update_bgPress(int &move_index,
 
 
 
+static double moveA1OntoTerm(epiParms& parms, sinrEpi& epidata, int move_index, int j)
+{
+  // Change in the integrated pressure from the moved infective
+  // on its j'th connection
+
+  size_t iLabel = epidata.infected.at(move_index)->label;
+  size_t jLabel = epidata.infected.at(move_index)->connections.at(j);
+  if(jLabel==iLabel) return 0.0;
+
+  double result = 0.0;
+
+  if(epidata.store.status[jLabel] == INFECTED) {  // Pressure onto the infectives
+
+    const PopulationStore& store = epidata.store;
+    double jStop = GSL_MIN(store.I[jLabel],store.contactStart[jLabel]);
+    jStop = GSL_MIN(jStop,store.contactStart[iLabel]);
+
+    result += spatialRate(parms,epidata,iLabel,jLabel) * 
+      (
+       infecInteg(parms,GSL_MIN(store.N[iLabel],store.I[jLabel]) - GSL_MIN(store.I[jLabel],parms.Ican)) - 
+       infecInteg(parms,GSL_MIN(store.N[iLabel],store.I[jLabel]) - GSL_MIN(store.I[jLabel],store.I[iLabel]))
+       );
+    result += networkRate(parms,epidata,iLabel,jLabel) *
+      (
+       infecInteg(parms,GSL_MIN(epidata.infected[move_index]->N,jStop) - GSL_MIN(jStop,parms.Ican)) - 
+       infecInteg(parms,GSL_MIN(epidata.infected[move_index]->N,jStop) - GSL_MIN(jStop,epidata.infected[move_index]->I))
+       );
+  }
+  else {  // Pressure onto the susceptibles, the network part only before CT
+    infection* s = epidata.infected.at(move_index);
+    result += spatialRate(parms,epidata,iLabel,jLabel) *
+      (
+       infecInteg(parms, s->N - parms.Ican) -
+       infecInteg(parms, s->N - s->I)
+       );
+    result += networkRate(parms,epidata,iLabel,jLabel) *
+      (
+       infecInteg(parms, GSL_MAX(s->contactStart - parms.Ican, 0.0)) -
+       infecInteg(parms, GSL_MAX(s->contactStart - s->I, 0.0))
+       );
+  }
+
+  return result;
+}
+
+
+
+static double moveA1FromTerm(epiParms& parms, sinrEpi& epidata, int move_index, int i)
+{
+  // Change in the integrated pressure from infective i on the
+  // moved infective
+
+  if(i==move_index) return 0.0;
+
+  double move_indexStop = GSL_MIN(epidata.infected.at(move_index)->I,epidata.infected.at(move_index)->contactStart);
+  double move_indexStopCan = GSL_MIN(parms.Ican,epidata.infected.at(move_index)->contactStart);
+  double jStop = GSL_MIN(move_indexStop,epidata.infected[i]->contactStart);
+  double jStop_can = GSL_MIN(move_indexStopCan,epidata.infected[i]->contactStart);
+  double result = 0.0;
+
+  result += spatialRate(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label) * 
+    (
+     infecInteg(parms, GSL_MIN(epidata.infected[i]->N, parms.Ican) - GSL_MIN(parms.Ican, epidata.infected[i]->I))  -  
+     infecInteg(parms, GSL_MIN(epidata.infected[i]->N, epidata.infected[move_index]->I) - GSL_MIN(epidata.infected[move_index]->I, epidata.infected[i]->I))
+     );
+  result += networkRate(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label) * 
+    (
+     infecInteg(parms, GSL_MIN(epidata.infected[i]->N, jStop_can) - GSL_MIN(jStop_can, epidata.infected[i]->I))  -  
+     infecInteg(parms, GSL_MIN(epidata.infected[i]->N, jStop) - GSL_MIN(jStop, epidata.infected[i]->I))
+     );
+
+  return result;
+}
+
+
+
 double update_A1(int &move_index,
 		 epiParms &parms,
 		 sinrEpi &epidata,
 		 double A1)
 {
+  ComponentTimer timer(profiler,COMP_UPDATE_A1);
   // update_A1 returns a candidate partial likelihood for A1_can
 
   int num_infectives = epidata.infected.size();
-  int num_susceptibles = epidata.susceptible.size();
+  int num_connections = epidata.infected.at(move_index)->connections.size();
   int i,j;
-  size_t iLabel,jLabel;
   double part_integral = 0.0;
-  double jStop = 0.0;
-  double jStop_can = 0.0;
-  vector<size_t>& connections = epidata.infected.at(move_index)->connections;
 
   /* First calculate the new pressure for our chosen individual on all others in the population */
 
-  int num_connections = connections.size();
-  iLabel = epidata.infected.at(move_index)->label;
-
-  #pragma omp parallel for default(shared) private(j,jStop,jLabel) schedule(static) reduction(+:part_integral)
-  for(j=0; j < num_connections; ++j) { //j's getting infected by move_index here.
-
-    if(j==iLabel) continue;
+  #pragma omp parallel for default(shared) private(j) schedule(static) reduction(+:part_integral)
+  for(j=0; j < num_connections; ++j) //j's getting infected by move_index here.
+    part_integral += moveA1OntoTerm(parms,epidata,move_index,j);
 
-    jLabel = connections.at(j);
-
-    if(epidata.individuals.at(jLabel).status == INFECTED) {  // Pressure onto the infectives
-
-      jStop = GSL_MIN(epidata.individuals.at(jLabel).I,epidata.individuals.at(jLabel).contactStart);
-      jStop = GSL_MIN(jStop,epidata.individuals[iLabel].contactStart);
-      
-      part_integral += spatialRate(parms,epidata,iLabel,jLabel) * 
-	(
-	 infecInteg(parms,GSL_MIN(epidata.infected[move_index]->N,epidata.individuals[jLabel].I) - GSL_MIN(epidata.individuals[jLabel].I,parms.Ican)) - 
-	 infecInteg(parms,GSL_MIN(epidata.infected[move_index]->N,epidata.individuals[jLabel].I) - GSL_MIN(epidata.individuals[jLabel].I,epidata.infected[move_index]->I))
-	 );
-      part_integral += networkRate(parms,epidata,iLabel,jLabel) *
-	(
-	 infecInteg(parms,GSL_MIN(epidata.infected[move_index]->N,jStop) - GSL_MIN(jStop,parms.Ican)) - 
-	 infecInteg(parms,GSL_MIN(epidata.infected[move_index]->N,jStop) - GSL_MIN(jStop,epidata.infected[move_index]->I))
-	 );
-    }
-    else {  // Pressure onto the susceptibles
-      part_integral += beta(parms,epidata,iLabel,jLabel) *
-	(
-	 infecInteg(parms, epidata.infected.at(move_index)->N - parms.Ican) -  
-	 infecInteg(parms, epidata.infected.at(move_index)->N - epidata.infected.at(move_index)->I)
-	 );
-    }
-  }
   A1 += part_integral;
 
 
@@ -760,35 +1187,30 @@ double update_A1(int &move_index,
 
   part_integral = 0.0;
 
-  double move_indexStop = GSL_MIN(epidata.infected.at(move_index)->I,epidata.infected.at(move_index)->contactStart);
-  double move_indexStopCan = GSL_MIN(parms.Ican,epidata.infected.at(move_index)->contactStart);
-
-  #pragma omp parallel for default(shared) private(i,jStop,jStop_can) schedule(static) reduction(+:part_integral)
-  for(i=0; i < num_infectives; ++i) { // Now move_index is getting infected by i.
-
-    if(i==move_index) continue;
+  #pragma omp parallel for default(shared) private(i) schedule(static) reduction(+:part_integral)
+  for(i=0; i < num_infectives; ++i) // Now move_index is getting infected by i.
+    part_integral += moveA1FromTerm(parms,epidata,move_index,i);
 
-    jStop = GSL_MIN(move_indexStop,epidata.infected[i]->contactStart);
-    jStop_can = GSL_MIN(move_indexStopCan,epidata.infected[i]->contactStart);
+  A1 += part_integral;
 
-    part_integral += spatialRate(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label) * 
-      (
-       infecInteg(parms, GSL_MIN(epidata.infected[i]->N, parms.Ican) - GSL_MIN(parms.Ican, epidata.infected[i]->I))  -  
-       infecInteg(parms, GSL_MIN(epidata.infected[i]->N, epidata.infected[move_index]->I) - GSL_MIN(epidata.infected[move_index]->I, epidata.infected[i]->I))
-       );
-    part_integral += networkRate(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label) * 
-      (
-       infecInteg(parms, GSL_MIN(epidata.infected[i]->N, jStop_can) - GSL_MIN(jStop_can, epidata.infected[i]->I))  -  
-       infecInteg(parms, GSL_MIN(epidata.infected[i]->N, jStop) - GSL_MIN(jStop, epidata.infected[i]->I))
-       );
 
-  }
 
-  A1 += part_integral;
+  return(A1);
+}
 
 
 
-  return(A1);
+static double moveA2Term(epiParms& parms, sinrEpi& epidata, int move_index, int i)
+{
+  // Change in the notified pressure from infective i on the moved
+  // infective
+
+  if(i==move_index) return 0.0;
+  return betastar(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label) * 
+    (
+     GSL_MIN(epidata.infected[i]->R,parms.Ican) - GSL_MIN(parms.Ican,epidata.infected[i]->N) - 
+     GSL_MIN(epidata.infected[i]->R,epidata.infected[move_index]->I) + GSL_MIN(epidata.infected[move_index]->I,epidata.infected[i]->N)
+     );
 }
 
 
@@ -796,30 +1218,99 @@ double update_A1(int &move_index,
 /* update_A2 returns a candidate partial likelihood for A2_can */
 
 double update_A2(int &move_index, epiParms &parms, sinrEpi &epidata, double &A2) {
+  ComponentTimer timer(profiler,COMP_UPDATE_A2);
 
   int num_infectives = epidata.infected.size();
   int i;
   double part_integral = 0.0;
 
   #pragma omp parallel for default(shared) private(i) schedule(static) reduction(+:part_integral)
-  for(i=0; i < num_infectives; ++i) {
-    if(i==move_index) continue;
-    part_integral += betastar(parms,epidata,epidata.infected.at(i)->label,epidata.infected.at(move_index)->label) * 
-      (
-       GSL_MIN(epidata.infected[i]->R,parms.Ican) - GSL_MIN(parms.Ican,epidata.infected[i]->N) - 
-       GSL_MIN(epidata.infected[i]->R,epidata.infected[move_index]->I) + GSL_MIN(epidata.infected[move_index]->I,epidata.infected[i]->N)
-       );
-  }
+  for(i=0; i < num_infectives; ++i)
+    part_integral += moveA2Term(parms,epidata,move_index,i);
 
   return(A2 + part_integral);
 }
 
 
 
+void updateLikelihood(int& move_index, epiParms& parms, sinrEpi& epidata,
+		      const LikComponents& curr, vector<double>* prodCurr_vec,
+		      vector<double>* prodCan_vec, LikComponents& can)
+{
+  // The update_* functions for an infection time move, as one task
+  // graph.  The loops over infectives and over the mover's connections
+  // are chunked as in computeLikelihood, so no task opens a nested
+  // parallel region.  can.logCT is GSL_NEGINF if the move is invalid.
+
+  prepareSpatialKernel(parms);
+  prepareSusceptibility(parms,epidata);
+
+  int numInfectives = epidata.infected.size();
+  int numConnections = epidata.infected[move_index]->connections.size();
+  size_t numChunks = numTaskChunks();
+
+  int I1can = moveI1can(move_index,parms,epidata);
+  bool hasRow = moveHasRow(move_index,I1can,parms,epidata);
+  bool iCanInCTWindow = epidata.infected[move_index]->inCTWindowAt(parms.Ican);
+
+  vector<size_t> weight(numInfectives,1);
+  vector<int> infectiveBounds, connectionBounds;
+  balancedChunks(weight,numChunks,infectiveBounds);
+  weight.assign(numConnections,1);
+  balancedChunks(weight,numChunks,connectionBounds);
+
+  size_t numInfectiveChunks = infectiveBounds.size()-1;
+  vector<double> rowParts(numInfectiveChunks,0.0);
+  vector<double> alterParts(numInfectiveChunks,0.0);
+  vector<double> A1FromParts(numInfectiveChunks,0.0);
+  vector<double> A2Parts(numInfectiveChunks,0.0);
+  vector<double> A1OntoParts(connectionBounds.size()-1,0.0);
+
+  double logCT = curr.logCT;
+  double bgPress = curr.bgPress;
+
+#pragma omp parallel default(shared)
+#pragma omp single
+  {
+#pragma omp task default(shared)
+    can.logCT = update_logCT(move_index,parms,epidata,logCT);
+#pragma omp task default(shared)
+    can.bgPress = update_bgPress(move_index,parms,epidata,bgPress);
+
+    for(size_t c=0; c<numInfectiveChunks; ++c) {
+      if(hasRow) {
+#pragma omp task default(shared) firstprivate(c)
+	for(int i=infectiveBounds[c]; i<infectiveBounds[c+1]; ++i) rowParts[c] += moveRowTerm(parms,epidata,move_index,iCanInCTWindow,i);
+      }
+#pragma omp task default(shared) firstprivate(c)
+      for(int j=infectiveBounds[c]; j<infectiveBounds[c+1]; ++j) alterParts[c] += moveAlterTerm(parms,epidata,move_index,I1can,prodCurr_vec,prodCan_vec,j);
+#pragma omp task default(shared) firstprivate(c)
+      for(int i=infectiveBounds[c]; i<infectiveBounds[c+1]; ++i) A1FromParts[c] += moveA1FromTerm(parms,epidata,move_index,i);
+#pragma omp task default(shared) firstprivate(c)
+      for(int i=infectiveBounds[c]; i<infectiveBounds[c+1]; ++i) A2Parts[c] += moveA2Term(parms,epidata,move_index,i);
+    }
+
+    for(size_t c=0; c<A1OntoParts.size(); ++c) {
+#pragma omp task default(shared) firstprivate(c)
+      for(int j=connectionBounds[c]; j<connectionBounds[c+1]; ++j) A1OntoParts[c] += moveA1OntoTerm(parms,epidata,move_index,j);
+    }
+  } // Tasks complete at the implicit barrier
+
+  double rowSum = hasRow ? sumParts(rowParts) + parms.beta[ModelTraits::BETA0] : 1.0;
+  prodCan_vec->at(move_index) = rowSum;
+
+  can.logProd = curr.logProd - log(prodCurr_vec->at(move_index)) + log(rowSum) + sumParts(alterParts);
+  can.A1 = curr.A1 + sumParts(A1OntoParts) + sumParts(A1FromParts);
+  can.A2 = curr.A2 + sumParts(A2Parts);
+}
+
+
+
 /* FUNCTIONS FOR ADDING AN INFECTION */
 
 double addInfec_log_prod(epiParms &parms, sinrEpi &epidata, double &log_prod, vector<double> *prodCurr_vec, vector<double> *prodCan_vec) 
 {
+  ComponentTimer timer(profiler,COMP_ADD_LOGPROD);
   double log_prod_can = log_prod;
   double log_prod_alter = 0;
   double Ij;
@@ -853,7 +1344,7 @@ double addInfec_log_prod(epiParms &parms, sinrEpi &epidata, double &log_prod, ve
 	row_sum += betastar(parms,epidata,epidata.infected.at(j)->label,epidata.infected.at(add_index)->label);
       }
     }
-  row_sum += parms.beta[0]; // Don't forget to add \beta_0 !
+  row_sum += parms.beta[ModelTraits::BETA0]; // Don't forget to add \beta_0 !
   }
   else {
     row_sum = 1;
@@ -893,7 +1384,7 @@ double addInfec_log_prod(epiParms &parms, sinrEpi &epidata, double &log_prod, ve
 
       if(j==epidata.I1) {
 	prodCan_vec->at(j) -= 1; // If our proposal is before current I1, we subtract 1 from the entry in the candidate vector
-	prodCan_vec->at(j) += parms.beta[0];
+	prodCan_vec->at(j) += parms.beta[ModelTraits::BETA0];
 	assert(prodCan_vec->at(j) != 0);
 	cout << "ILLEGAL ADDITION!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!" << endl;
       }
@@ -912,12 +1403,13 @@ double addInfec_log_prod(epiParms &parms, sinrEpi &epidata, double &log_prod, ve
 
 double addInfec_bgPress(epiParms &parms, sinrEpi &epidata, double bgPress) 
 {
+  ComponentTimer timer(profiler,COMP_ADD_BGPRESS);
   int add_index = epidata.infected.size()-1;
 
-  bgPress -= parms.beta[0] * ObsTime; // Subtract a $\beta_0 * T$
+  bgPress -= parms.beta[ModelTraits::BETA0] * ObsTime; // Subtract a $\beta_0 * T$
    
   if(epidata.infected[add_index]->I > epidata.infected[epidata.I1]->I) {
-    bgPress += parms.beta[0] * epidata.infected[add_index]->I;  // Add the new infection time
+    bgPress += parms.beta[ModelTraits::BETA0] * epidata.infected[add_index]->I;  // Add the new infection time
   }
   else{
     cout << "Addition before I1 is illegal!" << endl;
@@ -935,6 +1427,7 @@ double addInfec_logCT(epiParms& parms,
 		   sinrEpi& epidata,
 		   double logCTcurr)
 {
+  ComponentTimer timer(profiler,COMP_ADD_LOGCT);
   // Returns the binomial portion of the likelihood
   //  - easy, as the new infection is added before this
   //    function is called :-)
@@ -949,6 +1442,7 @@ double addInfec_logCT(epiParms& parms,
 
 double addInfec_A1(epiParms &parms, sinrEpi &epidata, double A1) 
 {
+  ComponentTimer timer(profiler,COMP_ADD_A1);
   // addInfec_A1 returns a candidate partial likelihood for A1_can if an infection time is added
   // THIS FUNCTION ASSUMES THAT WE HAVE ALREADY ALTERED THE EPIDEMIC
 
@@ -1006,6 +1500,7 @@ double addInfec_A1(epiParms &parms, sinrEpi &epidata, double A1)
 }
 
 double addInfec_A2(epiParms &parms, sinrEpi &epidata, double A2) {
+  ComponentTimer timer(profiler,COMP_ADD_A2);
 
   /* This is a 2 part algorithm to update A2 if an infection has been added */
   int add_index = epidata.infected.size()-1; // Position of our new infection is the last in the infected vector
@@ -1034,6 +1529,7 @@ double addInfec_A2(epiParms &parms, sinrEpi &epidata, double A2) {
 /* THESE FUNCTIONS ASSUME THAT THE REMOVAL PROPOSAL HAS NOT YET BEEN REMOVED FROM THE EPIDEMIC - THIS IS OPPOSITE TO THE ADDING FUNCTIONS */
 
 double delInfec_log_prod(int &remove_index, epiParms &parms, sinrEpi &epidata, double &log_prod, vector<double> *prodCurr_vec, vector<double> *prodCan_vec) {
+  ComponentTimer timer(profiler,COMP_DEL_LOGPROD);
 
   double log_prod_can = log_prod;
   double Icurr = epidata.infected[remove_index]->I;
@@ -1103,16 +1599,17 @@ double delInfec_log_prod(int &remove_index, epiParms &parms, sinrEpi &epidata, d
 /* delInfec_bgPress returns a candidate partial likelihood for bgPress if an infection time is delete */
 
 double delInfec_bgPress(int &remove_index, epiParms &parms, sinrEpi &epidata, double bgPress) {
+  ComponentTimer timer(profiler,COMP_DEL_BGPRESS);
 
   if(remove_index != epidata.I1) {
-    bgPress -= parms.beta[0] * epidata.infected[remove_index]->I;
-    bgPress += parms.beta[0] * ObsTime;
+    bgPress -= parms.beta[ModelTraits::BETA0] * epidata.infected[remove_index]->I;
+    bgPress += parms.beta[ModelTraits::BETA0] * ObsTime;
   }
   else{
     Ipos_t myI2 = epidata.I2();
-    bgPress += parms.beta[0] * (epidata.N_total - 1) * epidata.infected[epidata.I1]->I;
-    bgPress -= parms.beta[0] * (epidata.N_total - 1) * epidata.infected[myI2]->I;
-    bgPress += parms.beta[0] * ObsTime;
+    bgPress += parms.beta[ModelTraits::BETA0] * (epidata.N_total - 1) * epidata.infected[epidata.I1]->I;
+    bgPress -= parms.beta[ModelTraits::BETA0] * (epidata.N_total - 1) * epidata.infected[myI2]->I;
+    bgPress += parms.beta[ModelTraits::BETA0] * ObsTime;
   }
 
 
@@ -1126,6 +1623,7 @@ double delInfec_logCT(int& del_index,
 		      sinrEpi& epidata,
 		      double logCTcurr)
 {
+  ComponentTimer timer(profiler,COMP_DEL_LOGCT);
   // Computes the binomial portion of the likelihood
   // for deleted infection.
 
@@ -1147,7 +1645,7 @@ double delInfec_logCT(int& del_index,
 
   // A bit hacky, but we set del_index's I = N to prevent it from infecting anyone by CT
   Icurr = epidata.infected[del_index]->I;
-  epidata.infected[del_index]->I = epidata.infected[del_index]->N;
+  epidata.setI(epidata.infected[del_index]->label,epidata.infected[del_index]->N);
 
 
   prod = computeLogCT(parms,epidata);
@@ -1161,7 +1659,7 @@ double delInfec_logCT(int& del_index,
 //    }
 
    // Set del_index's I back to normal
-   epidata.infected[del_index]->I = Icurr;
+   epidata.setI(epidata.infected[del_index]->label,Icurr);
 
   return prod;
 }
@@ -1171,6 +1669,7 @@ double delInfec_logCT(int& del_index,
 /* delInfec_A1 returns a candidate partial likelihood for A1_can if an infection time is deleted */
 
 double delInfec_A1(int &remove_index, epiParms &parms, sinrEpi &epidata, double A1) {
+  ComponentTimer timer(profiler,COMP_DEL_A1);
 
   double partPressure;
   int loopSize;
@@ -1228,6 +1727,7 @@ double delInfec_A1(int &remove_index, epiParms &parms, sinrEpi &epidata, double
 /* delInfec_A2 returns a candidate partial likelihood for A2_can if an infections time is deleted */
 
 double delInfec_A2(int &remove_index, epiParms &parms, sinrEpi &epidata, double A2) {
+  ComponentTimer timer(profiler,COMP_DEL_A2);
 
   /* This is a 2 part algorithm to update A2 if an infection is deleted */
   double partPressure;
@@ -1255,6 +1755,377 @@ double delInfec_A2(int &remove_index, epiParms &parms, sinrEpi &epidata, double
 
 
 
+//////////////////////////////////////////////////////
+// PARALLEL INFECTION TIME MOVES
+//////////////////////////////////////////////////////
+
+// Infection time moves for individuals whose likelihood terms do not
+// overlap are independent given everyone else, so they can be evaluated
+// concurrently.  moveDelta computes the change in each likelihood component
+// for a single move from the mover's neighbourhood alone, leaving epidata
+// untouched.  NB: this relies on connections holding every pair with
+// non-zero beta or betastar.
+
+void initOccultGraph(sinrEpi& epidata, OccultGraph& graph)
+{
+  // Builds the reverse connection lists and, for each
+  // individual, the list of individuals it has contacted.
+
+  graph.inConnections.assign(epidata.N_total, vector<size_t>());
+  graph.contactees.assign(epidata.N_total, vector<size_t>());
+
+  for(size_t i=0; i<epidata.individuals.size(); ++i) {
+    vector<size_t>& connections = epidata.individuals[i].connections;
+    for(vector<size_t>::iterator j = connections.begin(); j != connections.end(); ++j)
+      graph.inConnections.at(*j).push_back(i);
+
+    set<Contact>& contacts = epidata.individuals[i].contacts;
+    for(set<Contact>::iterator c = contacts.begin(); c != contacts.end(); ++c) {
+      vector<size_t>& contactees = graph.contactees.at(c->source->label);
+      if(contactees.empty() || contactees.back() != i) contactees.push_back(i);
+    }
+  }
+}
+
+
+
+void indexInfecteds(sinrEpi& epidata, OccultGraph& graph)
+{
+  // Maps labels to positions in epidata.infected
+
+  graph.infecIndex.assign(epidata.N_total, -1);
+  for(size_t i=0; i<epidata.infected.size(); ++i)
+    graph.infecIndex.at(epidata.infected[i]->label) = i;
+}
+
+
+
+bool moveDelta(int move_index, double Ican, epiParms& parms, sinrEpi& epidata,
+	       const OccultGraph& graph, const vector<double>& prodCurr, MoveDelta& delta)
+{
+  // Likelihood component changes for moving infected[move_index] to Ican,
+  // matching the update_* functions.  move_index must not be I1, and Ican
+  // must be later than I1.  Returns false if the move would leave a contact
+  // infection without an infectious source.
+
+  ComponentTimer timer(profiler,COMP_MOVEDELTA);
+  infection* s = epidata.infected.at(move_index);
+  size_t sLabel = s->label;
+  double Icurr = s->I;
+  double Ns = s->N;
+
+  delta.logProd = delta.A1 = delta.A2 = delta.logCT = 0.0;
+  delta.bgPress = parms.beta[ModelTraits::BETA0] * (Ican - Icurr);
+  delta.prod.clear();
+
+  // Contact tracing: s itself, and everyone s has contacted
+  const vector<size_t>& contactees = graph.contactees[sLabel];
+  for(vector<size_t>::const_iterator c = contactees.begin(); c != contactees.end(); ++c) {
+    if(*c == sLabel) continue;
+    infection* indiv = &epidata.individuals[*c];
+    infection* mySource;
+    if(indiv->isInfecByContact(mySource) && mySource == s && Ican > indiv->I) return false;
+    delta.logCT += logBinomComponent(parms,indiv,indiv->I,s,Ican) - logBinomComponent(parms,indiv,indiv->I);
+  }
+  delta.logCT += logBinomComponent(parms,s,Ican,s,Ican) - logBinomComponent(parms,s,Icurr);
+
+  // Pressure on s from its infected in-neighbours
+  const vector<size_t>& inConnections = graph.inConnections[sLabel];
+  vector<size_t>::const_iterator iIter;
+  double jStop, jStop_can;
+  double sStop = GSL_MIN(Icurr,s->contactStart);
+  double sStopCan = GSL_MIN(Ican,s->contactStart);
+  bool iCanInCTWindow = s->inCTWindowAt(Ican);
+  bool infecContact = s->isInfecContactAt(Ican);
+  double row_sum = infecContact ? 1.0 : parms.beta[ModelTraits::BETA0];
+
+  for(iIter = inConnections.begin(); iIter != inConnections.end(); ++iIter) {
+
+    int i = graph.infecIndex[*iIter];
+    if(i < 0 || i == move_index) continue;
+    infection* ii = epidata.infected[i];
+
+    double spatial = spatialRate(parms,epidata,ii->label,sLabel);
+    double network = networkRate(parms,epidata,ii->label,sLabel);
+    double bstar = betastar(parms,epidata,ii->label,sLabel);
+
+    if(!infecContact) {
+      if(ii->I < Ican && Ican <= ii->N) {
+	row_sum += spatial * hFunc(parms,Ican - ii->I);
+	if(!iCanInCTWindow && !ii->inCTWindowAt(Ican))
+	  row_sum += network * hFunc(parms,Ican - ii->I);
+      }
+      else if(ii->N < Ican && Ican <= ii->R) {
+	row_sum += bstar;
+      }
+    }
+
+    jStop = GSL_MIN(sStop,ii->contactStart);
+    jStop_can = GSL_MIN(sStopCan,ii->contactStart);
+    delta.A1 += spatial *
+      ( infecInteg(parms, GSL_MIN(ii->N, Ican) - GSL_MIN(Ican, ii->I)) -
+	infecInteg(parms, GSL_MIN(ii->N, Icurr) - GSL_MIN(Icurr, ii->I)) );
+    delta.A1 += network *
+      ( infecInteg(parms, GSL_MIN(ii->N, jStop_can) - GSL_MIN(jStop_can, ii->I)) -
+	infecInteg(parms, GSL_MIN(ii->N, jStop) - GSL_MIN(jStop, ii->I)) );
+
+    delta.A2 += bstar *
+      ( GSL_MIN(ii->R,Ican) - GSL_MIN(Ican,ii->N) -
+	GSL_MIN(ii->R,Icurr) + GSL_MIN(Icurr,ii->N) );
+  }
+
+  delta.prod.push_back(make_pair(move_index,row_sum));
+  delta.logProd += log(row_sum) - log(prodCurr[move_index]);
+
+  // Pressure from s on its connections
+  const vector<size_t>& connections = s->connections;
+  vector<size_t>::const_iterator jIter;
+
+  for(jIter = connections.begin(); jIter != connections.end(); ++jIter) {
+
+    size_t jLabel = *jIter;
+    int j = graph.infecIndex[jLabel];
+    double spatial = spatialRate(parms,epidata,sLabel,jLabel);
+    double network = networkRate(parms,epidata,sLabel,jLabel);
+
+    if(j < 0) {  // Susceptible
+      delta.A1 += spatial *
+	( infecInteg(parms, Ns - Ican) - infecInteg(parms, Ns - Icurr) );
+      delta.A1 += network *
+	( infecInteg(parms, GSL_MAX(s->contactStart - Ican, 0.0)) -
+	  infecInteg(parms, GSL_MAX(s->contactStart - Icurr, 0.0)) );
+      continue;
+    }
+
+    infection* jj = epidata.infected[j];
+    double Ij = jj->I;
+
+    jStop = GSL_MIN(Ij,jj->contactStart);
+    jStop = GSL_MIN(jStop,s->contactStart);
+    delta.A1 += spatial *
+      ( infecInteg(parms, GSL_MIN(Ns,Ij) - GSL_MIN(Ij,Ican)) -
+	infecInteg(parms, GSL_MIN(Ns,Ij) - GSL_MIN(Ij,Icurr)) );
+    delta.A1 += network *
+      ( infecInteg(parms, GSL_MIN(Ns,jStop) - GSL_MIN(jStop,Ican)) -
+	infecInteg(parms, GSL_MIN(Ns,jStop) - GSL_MIN(jStop,Icurr)) );
+
+    if(j == epidata.I1 || jj->isInfecByContact()) continue;
+
+    double prodCan = prodCurr[j];
+    bool jNetwork = !s->inCTWindowAt(Ij) && !jj->infecInCTWindow();
+    if(Icurr < Ij && Ij < Ns) {
+      prodCan -= spatial * hFunc(parms,Ij - Icurr);
+      if(jNetwork) prodCan -= network * hFunc(parms,Ij - Icurr);
+    }
+    if(Ican < Ij && Ij < Ns) {
+      prodCan += spatial * hFunc(parms,Ij - Ican);
+      if(jNetwork) prodCan += network * hFunc(parms,Ij - Ican);
+    }
+    if(prodCan != prodCurr[j]) {
+      delta.prod.push_back(make_pair(j,prodCan));
+      delta.logProd += log(prodCan) - log(prodCurr[j]);
+    }
+  }
+
+  return true;
+}
+
+
+
+void colourMoves(sinrEpi& epidata, const OccultGraph& graph, const vector<int>& movers,
+		 const vector<double>& spanLo, vector< vector<int> >& classes)
+{
+  // Greedily partitions movers into classes of mutually independent moves.
+  // An infective can only influence terms within its span [spanLo,R], so
+  // each mover claims itself, the infected neighbours whose spans overlap
+  // its own, its contactees and its contact sources.  Moves claiming a
+  // common individual are placed in different classes.
+
+  vector< vector<int> > claimedBy(epidata.N_total);  // Classes claiming each label
+  vector<size_t> claims;
+  vector<bool> forbidden;
+
+  classes.clear();
+
+  for(vector<int>::const_iterator m = movers.begin(); m != movers.end(); ++m) {
+
+    infection* s = epidata.infected[*m];
+    double lo = spanLo[*m];
+    double hi = s->R;
+
+    claims.clear();
+    claims.push_back(s->label);
+
+    for(int dir=0; dir<2; ++dir) {
+      const vector<size_t>& nbrs = dir == 0 ? s->connections : graph.inConnections[s->label];
+      for(vector<size_t>::const_iterator j = nbrs.begin(); j != nbrs.end(); ++j) {
+	int jIdx = graph.infecIndex[*j];
+	if(jIdx < 0) continue;
+	if(spanLo[jIdx] <= hi && lo <= epidata.infected[jIdx]->R) claims.push_back(*j);
+      }
+    }
+
+    const vector<size_t>& contactees = graph.contactees[s->label];
+    claims.insert(claims.end(),contactees.begin(),contactees.end());
+    for(set<Contact>::iterator c = s->contacts.begin(); c != s->contacts.end(); ++c)
+      claims.push_back(c->source->label);
+
+    // First class not already claiming any of our labels
+    forbidden.assign(classes.size()+1,false);
+    for(vector<size_t>::iterator c = claims.begin(); c != claims.end(); ++c) {
+      vector<int>& cls = claimedBy[*c];
+      for(vector<int>::iterator k = cls.begin(); k != cls.end(); ++k) forbidden[*k] = true;
+    }
+    size_t myClass = 0;
+    while(forbidden[myClass]) ++myClass;
+
+    if(myClass == classes.size()) classes.push_back(vector<int>());
+    classes[myClass].push_back(*m);
+    for(vector<size_t>::iterator c = claims.begin(); c != claims.end(); ++c) {
+      vector<int>& cls = claimedBy[*c];
+      if(cls.empty() || cls.back() != (int)myClass) cls.push_back(myClass);
+    }
+  }
+}
+
+
+
+static bool drawMove(epiPriors& priors, sinrEpi& epidata, gsl_rng* rng, const int k,
+		     const double I1time, MoveProposal& p)
+{
+  // Draws an infection time move for infected k from the current state,
+  // as in the serial sampler.  Returns false if the proposal is rejected
+  // outright.
+
+  infection* s = epidata.infected[k];
+  bool isInfecByContact = s->isInfecByContact();
+  vector<const Contact*> myContacts = s->getInfecContacts();
+  bool crossDim = gsl_rng_uniform(rng) > 0.5;
+  bool known = s->known && !s->isDC;
+  double (*proposal_func)(const double&, const double&) = known ? rng_extreme : occultProposal;
+  double (*proposal_pdf)(double, const double&, const double&) = known ? rng_extreme_pdf : occultProposal_pdf;
+  double inProp;
+
+  if(isInfecByContact != crossDim) { // Propose an infectious contact time
+    if(myContacts.empty()) return false;
+    p.Ican = myContacts[gsl_rng_uniform_int(rng,myContacts.size())]->time;
+    inProp = s->N - p.Ican;
+    p.logQ = isInfecByContact ? 0.0 :
+      log(proposal_pdf(s->N - s->I,priors.a,priors.b)) - log(1.0/(double)myContacts.size());
+  }
+  else { // Propose from the Extreme function
+    inProp = proposal_func(priors.a,priors.b);
+    p.Ican = s->N - inProp;
+    p.logQ = (isInfecByContact ? log(1.0/(double)myContacts.size()) :
+	      log(proposal_pdf(s->N - s->I,priors.a,priors.b)))
+      - log(proposal_pdf(inProp,priors.a,priors.b));
+  }
+
+  if(p.Ican < s->niAt || p.Ican <= I1time) return false;
+
+  if(known) {
+    p.logPriorCurr = log(rng_extreme_pdf(s->N - s->I,priors.a,priors.b));
+    p.logPriorCan = log(rng_extreme_pdf(inProp,priors.a,priors.b));
+  }
+  else {
+    p.logPriorCurr = log(1 - rng_extreme_cdf(ObsTime - s->I,priors.a,priors.b));
+    p.logPriorCan = log(1 - rng_extreme_cdf(inProp,priors.a,priors.b));
+  }
+
+  p.logU = log(gsl_rng_uniform(rng));
+  return true;
+}
+
+
+
+int parallelMoveSweep(epiParms& parms, epiPriors& priors, sinrEpi& epidata, gsl_rng* rng,
+		      OccultGraph& graph, vector<double>& prodCurr, double& log_prod,
+		      double& bgPress, double& A1, double& A2, double& logCT,
+		      const bool serial)
+{
+  // Proposes an infection time move for every infective bar I1.  Movers
+  // are partitioned into classes of independent moves (see colourMoves)
+  // using the widest span a move could reach, [max(niAt,I1),R], so the
+  // classes do not depend on the proposals.  Each class draws its
+  // proposals from the state left by earlier classes, so contact sets and
+  // proposal densities are current, and evaluates them concurrently.
+  // serial puts every mover in a class of its own, giving the equivalent
+  // sequential sweep.  Proposals before I1 are rejected, so I1 is only
+  // moved by the serial sampler.  Returns the number of accepted moves.
+
+  epidata.updateI1();
+  indexInfecteds(epidata,graph);
+
+  int numInfected = epidata.infected.size();
+  double I1time = epidata.infected[epidata.I1]->I;
+  vector<MoveProposal> props(numInfected);
+  vector<double> spanLo(numInfected);
+  vector<int> movers;
+
+  for(int k=0; k<numInfected; ++k) {
+    infection* s = epidata.infected[k];
+    spanLo[k] = s->I;
+    if(k == epidata.I1) continue;
+    spanLo[k] = GSL_MIN(s->I,GSL_MAX(s->niAt,I1time));
+    movers.push_back(k);
+  }
+
+  vector< vector<int> > classes;
+  if(serial) {
+    for(vector<int>::iterator m = movers.begin(); m != movers.end(); ++m)
+      classes.push_back(vector<int>(1,*m));
+  }
+  else colourMoves(epidata,graph,movers,spanLo,classes);
+
+  vector<MoveDelta> deltas(numInfected);
+  vector<char> valid(numInfected);
+  vector<int> cls;
+  int accepted = 0;
+
+  for(size_t c=0; c<classes.size(); ++c) {
+
+    // Draw serially, so the chain does not depend on the thread count
+    cls.clear();
+    for(size_t m=0; m<classes[c].size(); ++m) {
+      int k = classes[c][m];
+      if(drawMove(priors,epidata,rng,k,I1time,props[k])) cls.push_back(k);
+    }
+    int numMoves = cls.size();
+    int m;
+
+#pragma omp parallel for default(shared) private(m) schedule(dynamic)
+    for(m=0; m<numMoves; ++m) {
+      int k = cls[m];
+      valid[k] = moveDelta(k,props[k].Ican,parms,epidata,graph,prodCurr,deltas[k]);
+    }
+
+    for(m=0; m<numMoves; ++m) {
+      int k = cls[m];
+      if(!valid[k]) continue;
+
+      MoveDelta& d = deltas[k];
+      MoveProposal& p = props[k];
+      double logLikRatio = d.logProd - d.bgPress - d.A1 - d.A2 + d.logCT;
+      if(p.logU < p.logPriorCan - p.logPriorCurr + logLikRatio + p.logQ) {
+	epidata.setI(epidata.infected[k]->label,p.Ican);
+	for(vector< pair<int,double> >::iterator it = d.prod.begin(); it != d.prod.end(); ++it)
+	  prodCurr[it->first] = it->second;
+	log_prod += d.logProd;
+	bgPress += d.bgPress;
+	A1 += d.A1;
+	A2 += d.A2;
+	logCT += d.logCT;
+	++accepted;
+      }
+    }
+  }
+
+  return accepted;
+}
+
+
+
+
 //////////////////////////////////////////////////////
 // DIAGNOSTICS FUNCTIONS 
 //////////////////////////////////////////////////////
@@ -1278,7 +2149,7 @@ void checkProdVec(vector<double> *prodVec,epiParms& parms) {
     else if(*vecIter < 0) {
       cout << "ERROR: negative value in product vector!" << endl;
     }
-    else if(*vecIter > 0 && *vecIter < parms.beta[0] - 1e-9) {
+    else if(*vecIter > 0 && *vecIter < parms.beta[ModelTraits::BETA0] - 1e-9) {
       cout << "ERROR: 0 < product vector < beta[0] at position " << counter << endl;
       cout << endl;
     }
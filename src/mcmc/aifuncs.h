@@ -27,18 +27,28 @@
 #include <gsl/gsl_math.h>
 #include <stdexcept>
 #include <set>
+#include <vector>
+#include <utility>
 
 #include "sinrEpi.h"
 #include "contactMatrix.h"
 #include "random.h"
+#include "InfectivityKernel.hpp"
+#include "SpatialKernel.hpp"
+#include "ModelTraits.hpp"
+#include "profiling.h"
 
 using namespace std;
 
 extern int total_pop_size;
 extern double ObsTime;
+extern McmcProfiler profiler;
 
 /* Next we declare our parameters extern (they are declared in the main function) */
 
+void initSpatialKernel(sinrEpi&, const SpatialKernel::family_e);
+void prepareSpatialKernel(epiParms&);
+void prepareSusceptibility(epiParms&, sinrEpi&);
 void initConnections(epiParms&, sinrEpi&);
 double beta(epiParms&, sinrEpi&, int, int);
 double betastar(epiParms&, sinrEpi&, int, int);
@@ -47,6 +57,7 @@ double networkRate(epiParms&, sinrEpi&, int, int);
 double fmRate(epiParms&, sinrEpi&, int, int);
 double species(epiParms&, sinrEpi&, int, int);
 double binomComponent(epiParms&, infection*, double);
+void initContactCache(sinrEpi&);
 
 
 
@@ -54,6 +65,8 @@ void drawBetaCan(const int&, const double[], gsl_matrix* const, double[], const
 double occultProposal_pdf(const double time, const double& a, const double& b);
 double occultProposal(const double& a, const double& b);
 
+void initInfecKernel(epiParms&, const double, const bool);
+const InfectivityKernel& getInfecKernel();
 double hFunc(epiParms&, double);
 double infecInteg(epiParms&, double );
 double log_prod_incubLik(sinrEpi&,epiPriors&);
@@ -66,6 +79,15 @@ double compute_A2(epiParms&,sinrEpi&);
 
 
 
+// Likelihood components, evaluated together as parallel tasks
+
+struct LikComponents {
+  double logProd, logCT, bgPress, A1, A2;
+};
+
+void computeLikelihood(epiParms&, sinrEpi&, vector<double>*, LikComponents&);
+void updateLikelihood(int&, epiParms&, sinrEpi&, const LikComponents&, vector<double>*, vector<double>*, LikComponents&);
+
 double update_log_prod(int&, epiParms&, sinrEpi&, double &, vector<double>*, vector<double>*);
 double updateLogCT(int&, epiParms&, sinrEpi&, double &);
 double update_bgPress(int&, epiParms&,sinrEpi&,double&);
@@ -87,6 +109,32 @@ double delInfec_A2(int&, epiParms&, sinrEpi&, double);
 
 
 
+// Neighbourhood structure for parallel infection time moves
+
+struct OccultGraph {
+  vector< vector<size_t> > inConnections; // Labels i with label in i's connections
+  vector< vector<size_t> > contactees;    // Labels with a contact sourced from label
+  vector<int> infecIndex;                 // Label -> index in infected, -1 if not infected
+};
+
+struct MoveProposal {
+  double Ican, logQ, logPriorCurr, logPriorCan, logU;
+};
+
+struct MoveDelta {
+  double logProd, bgPress, A1, A2, logCT;
+  vector< pair<int,double> > prod;        // Candidate product entries by infected index
+};
+
+void initOccultGraph(sinrEpi&, OccultGraph&);
+void indexInfecteds(sinrEpi&, OccultGraph&);
+bool moveDelta(int, double, epiParms&, sinrEpi&, const OccultGraph&, const vector<double>&, MoveDelta&);
+void colourMoves(sinrEpi&, const OccultGraph&, const vector<int>&, const vector<double>&, vector< vector<int> >&);
+int parallelMoveSweep(epiParms&, epiPriors&, sinrEpi&, gsl_rng*, OccultGraph&, vector<double>&,
+		      double&, double&, double&, double&, double&, const bool serial = false);
+
+
+
 void checkProdVec(vector<double>*,epiParms&);
 double getContactStart(sinrEpi&, size_t);
 void dumpContacts(sinrEpi&, size_t);
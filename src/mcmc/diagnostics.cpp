@@ -0,0 +1,252 @@
+/* ./src/mcmc/diagnostics.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+/////////////////////////////////////////////////////////////////////
+// Name: diagnostics.cpp                                           //
+// Author: C.P.Jewell                                              //
+// Purpose: Streaming MCMC convergence diagnostics                 //
+/////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include <gsl/gsl_math.h>
+
+#include "diagnostics.h"
+
+// Number of complete batches at which adjacent pairs are merged,
+// so the number of batches stays between MAXBATCHES/2 and MAXBATCHES
+#define MAXBATCHES 64
+
+
+
+void McmcDiagnostics::Batch::add(const double x)
+{
+  n += 1;
+  double d = x - mean;
+  mean += d / n;
+  m2 += d * (x - mean);
+}
+
+
+
+void McmcDiagnostics::Batch::merge(const Batch& other)
+{
+  // Chan et al.'s pairwise combination
+  if(other.n == 0) return;
+  double total = n + other.n;
+  double d = other.mean - mean;
+  mean += d * other.n / total;
+  m2 += other.m2 + d * d * n * other.n / total;
+  n = total;
+}
+
+
+
+McmcDiagnostics::McmcDiagnostics(const size_t numParms_, const size_t maxLag_) :
+  numParms(numParms_),
+  n(0),
+  batchSize(1),
+  batches(numParms_ + 1),
+  partial(numParms_ + 1),
+  maxLag(maxLag_),
+  occultHistory(maxLag_ + 1, 0.0),
+  lagSum(maxLag_ + 1, 0.0),
+  occultShift(0.0),
+  occultSum(0.0),
+  occultSumSq(0.0)
+{
+  for(size_t k=0; k<=numParms; ++k) batches[k].reserve(MAXBATCHES);
+}
+
+
+
+void McmcDiagnostics::add(const double parms[], const double occults)
+{
+  // Adds a row of MCMC output
+
+  if(n == 0) occultShift = occults;
+  n++;
+
+  for(size_t k=0; k<=numParms; ++k) {
+    partial[k].add(k < numParms ? parms[k] : occults);
+    if(partial[k].n == batchSize) {
+      batches[k].push_back(partial[k]);
+      partial[k] = Batch();
+    }
+  }
+
+  // Halve the number of batches by merging pairs
+  if(batches[0].size() == MAXBATCHES) {
+    for(size_t k=0; k<=numParms; ++k) {
+      vector<Batch>& b = batches[k];
+      for(size_t i=0; i<MAXBATCHES/2; ++i) {
+        b[i] = b[2*i];
+        b[i].merge(b[2*i+1]);
+      }
+      b.resize(MAXBATCHES/2);
+    }
+    batchSize *= 2;
+  }
+
+  // Occult count autocorrelation
+  double x = occults - occultShift;
+  occultHistory[n % (maxLag + 1)] = x;
+  occultSum += x;
+  occultSumSq += x * x;
+  for(size_t l=0; l<=maxLag && l<n; ++l)
+    lagSum[l] += x * occultHistory[(n - l) % (maxLag + 1)];
+}
+
+
+
+double McmcDiagnostics::ess(const size_t k) const
+{
+  // Batch means ESS over the complete batches:
+  //   n s^2 / (b * var(batch means))
+
+  const vector<Batch>& b = batches.at(k);
+  if(b.size() < 2) return 0.0;
+
+  Batch all, means;
+  for(size_t i=0; i<b.size(); ++i) {
+    all.merge(b[i]);
+    means.add(b[i].mean);
+  }
+
+  double varBM = batchSize * means.var();
+  if(varBM <= 0.0) return all.n; // Constant: nothing to estimate
+
+  return all.n * all.var() / varBM;
+}
+
+
+
+void McmcDiagnostics::halves(const size_t k, Batch& first, Batch& second) const
+{
+  // Splits the complete batches for quantity k into two halves
+  const vector<Batch>& b = batches.at(k);
+  size_t half = b.size() / 2;
+
+  first = Batch();
+  second = Batch();
+  for(size_t i=0; i<half; ++i) {
+    first.merge(b[i]);
+    second.merge(b[half + i]);
+  }
+}
+
+
+
+double McmcDiagnostics::splitRhat(const size_t k) const
+{
+  vector<const McmcDiagnostics*> chain(1, this);
+  return splitRhat(chain, k);
+}
+
+
+
+double McmcDiagnostics::splitRhat(const vector<const McmcDiagnostics*>& chains, const size_t k)
+{
+  // Gelman-Rubin potential scale reduction factor, treating
+  // each half of each chain as a separate chain.
+
+  vector<Batch> parts;
+  for(size_t c=0; c<chains.size(); ++c) {
+    Batch first, second;
+    chains[c]->halves(k, first, second);
+    if(first.n < 2 || second.n < 2) return GSL_POSINF;
+    parts.push_back(first);
+    parts.push_back(second);
+  }
+
+  double m = parts.size();
+  double len = 0.0, W = 0.0;
+  Batch means;
+  for(size_t j=0; j<parts.size(); ++j) {
+    len += parts[j].n / m;
+    W += parts[j].var() / m;
+    means.add(parts[j].mean);
+  }
+  double B = len * means.var();
+
+  if(W <= 0.0) return B <= 0.0 ? 1.0 : GSL_POSINF;
+
+  double varPlus = (len - 1) / len * W + B / len;
+  return sqrt(varPlus / W);
+}
+
+
+
+double McmcDiagnostics::minEss() const
+{
+  double rv = GSL_POSINF;
+  for(size_t k=0; k<=numParms; ++k) rv = min(rv, ess(k));
+  return rv;
+}
+
+
+
+double McmcDiagnostics::maxSplitRhat() const
+{
+  double rv = 0.0;
+  for(size_t k=0; k<=numParms; ++k) rv = max(rv, splitRhat(k));
+  return rv;
+}
+
+
+
+double McmcDiagnostics::occultAcf(const size_t lag) const
+{
+  // Lag autocorrelation of the occult count
+  if(lag > maxLag)
+    throw range_error("Lag exceeds McmcDiagnostics maximum lag");
+  if(n <= lag + 1) return 0.0;
+
+  double mean = occultSum / n;
+  double var = occultSumSq / n - mean * mean;
+  if(var <= 0.0) return 0.0;
+
+  return (lagSum[lag] / (n - lag) - mean * mean) / var;
+}
+
+
+
+bool McmcDiagnostics::converged(const double essTarget, const double rhatTarget) const
+{
+  // True if every quantity meets both targets
+  return minEss() >= essTarget && maxSplitRhat() <= rhatTarget;
+}
+
+
+
+void McmcDiagnostics::print(ostream& os) const
+{
+  os << "Diagnostics after " << n << " iterations (batch size " << batchSize << "):\n";
+  for(size_t k=0; k<=numParms; ++k) {
+    if(k < numParms) os << "  beta" << k;
+    else os << "  occults";
+    os << "\tESS: " << ess(k) << "\tsplit-Rhat: " << splitRhat(k) << "\n";
+  }
+  os << "  occult ACF lag 1: " << occultAcf(1);
+  if(maxLag >= 10) os << ", lag 10: " << occultAcf(10);
+  os << endl;
+}
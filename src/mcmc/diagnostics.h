@@ -0,0 +1,105 @@
+/* ./src/mcmc/diagnostics.h
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+/////////////////////////////////////////////////////////////////////
+// Name: diagnostics.h                                             //
+// Author: C.P.Jewell                                              //
+// Purpose: McmcDiagnostics computes convergence diagnostics from  //
+//          MCMC output as it is generated: batch means effective  //
+//          sample size, split-Rhat, and the autocorrelation of    //
+//          the number of occult infections.  Storage is constant  //
+//          in the chain length.                                   //
+/////////////////////////////////////////////////////////////////////
+
+
+/* CODE EXAMPLE - stop once every parameter has ESS >= 1000
+                  and split-Rhat <= 1.01
+
+  McmcDiagnostics diag(parms.p);
+
+  for(int mcmcIter = 0; mcmcIter < max_iter; ++mcmcIter) {
+
+    // Update parameters
+
+    diag.add(parms.beta, epidata.numAdditions());
+    if(mcmcIter % 1000 == 0 && diag.converged(1000, 1.01)) break;
+  }
+
+*/
+
+#ifndef _INCLUDE_DIAGNOSTICS_H
+#define _INCLUDE_DIAGNOSTICS_H
+
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+class McmcDiagnostics {
+private:
+
+  struct Batch {
+    // Count, mean, and sum of squared deviations
+    double n, mean, m2;
+    Batch() : n(0), mean(0), m2(0) {}
+    void add(const double x);
+    void merge(const Batch& other);
+    double var() const { return n > 1 ? m2 / (n - 1) : 0.0; }
+  };
+
+  const size_t numParms;
+  size_t n;
+  size_t batchSize;
+
+  // batches[k] holds the complete batches for quantity k, and
+  // partial[k] the batch being filled.  Quantity numParms is
+  // the occult count.
+  vector< vector<Batch> > batches;
+  vector<Batch> partial;
+
+  // Lagged products of the (shifted) occult count
+  const size_t maxLag;
+  vector<double> occultHistory;
+  vector<double> lagSum;
+  double occultShift, occultSum, occultSumSq;
+
+  void halves(const size_t k, Batch& first, Batch& second) const;
+
+public:
+  McmcDiagnostics(const size_t numParms_, const size_t maxLag_ = 50);
+
+  void add(const double parms[], const double occults);
+  size_t numSamples() const { return n; }
+
+  // Quantity k is parameter k, or the occult count if k == numParms
+  double ess(const size_t k) const;
+  double splitRhat(const size_t k) const;
+  double minEss() const;
+  double maxSplitRhat() const;
+  double occultAcf(const size_t lag) const;
+
+  // Split-Rhat for quantity k over several chains
+  static double splitRhat(const vector<const McmcDiagnostics*>& chains, const size_t k);
+
+  bool converged(const double essTarget, const double rhatTarget) const;
+  void print(ostream& os) const;
+};
+
+#endif
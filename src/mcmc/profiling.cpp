@@ -0,0 +1,166 @@
+/* ./src/mcmc/profiling.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/////////////////////////////////////////////////////////////////////
+// Name: profiling.cpp                                             //
+// Author: C.P.Jewell                                              //
+// Purpose: Per-proposal and per-component MCMC metrics            //
+/////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <stdexcept>
+
+#include "profiling.h"
+
+static const char* proposalNames[NUMPROPOSALS] = {
+  "beta", "move1", "move2", "move3", "move4", "parallel_move", "add", "delete"
+};
+
+static const char* componentNames[NUMCOMPONENTS] = {
+  "likelihood",
+  "update_log_prod", "update_logCT", "update_bgPress", "update_A1", "update_A2",
+  "addInfec_log_prod", "addInfec_logCT", "addInfec_bgPress", "addInfec_A1", "addInfec_A2",
+  "delInfec_log_prod", "delInfec_logCT", "delInfec_bgPress", "delInfec_A1", "delInfec_A2",
+  "moveDelta"
+};
+
+
+
+McmcProfiler::Counters::Counters()
+{
+  clear();
+}
+
+
+
+void McmcProfiler::Counters::clear()
+{
+  memset(calls, 0, sizeof(calls));
+  memset(accepts, 0, sizeof(accepts));
+  memset(seconds, 0, sizeof(seconds));
+  memset(compCalls, 0, sizeof(compCalls));
+  memset(compSeconds, 0, sizeof(compSeconds));
+}
+
+
+
+void McmcProfiler::Counters::merge(const Counters& other)
+{
+  for(int k=0; k<NUMPROPOSALS; ++k) {
+    calls[k] += other.calls[k];
+    accepts[k] += other.accepts[k];
+    seconds[k] += other.seconds[k];
+  }
+  for(int k=0; k<NUMCOMPONENTS; ++k) {
+    compCalls[k] += other.compCalls[k];
+    compSeconds[k] += other.compSeconds[k];
+  }
+}
+
+
+
+McmcProfiler::McmcProfiler() :
+  enabled(false),
+  file(NULL),
+  startTime(0.0),
+  lastTime(0.0),
+  local(omp_get_max_threads())
+{
+}
+
+
+
+McmcProfiler::~McmcProfiler()
+{
+  if(file != NULL) fclose(file);
+}
+
+
+
+void McmcProfiler::open(const string& filename)
+{
+  file = fopen(filename.c_str(), "w");
+  if(file == NULL)
+    throw runtime_error("Cannot open metrics file '" + filename + "'");
+
+  enabled = true;
+  startTime = lastTime = omp_get_wtime();
+}
+
+
+
+void McmcProfiler::collect(Counters& interval)
+{
+  interval.clear();
+  for(size_t t=0; t<local.size(); ++t) {
+    interval.merge(local[t]);
+    local[t].clear();
+  }
+  total.merge(interval);
+}
+
+
+
+void McmcProfiler::writeRecord(const char* kind, const long iter, const double wall, const Counters& c)
+{
+  fprintf(file, "{\"record\":\"%s\",\"iter\":%ld,\"wall\":%.6f,\"threads\":%d,\"proposals\":{",
+          kind, iter, wall, omp_get_max_threads());
+  for(int k=0; k<NUMPROPOSALS; ++k) {
+    fprintf(file, "%s\"%s\":{\"calls\":%.0f,\"accepts\":%.0f,\"rate\":%.6f,\"seconds\":%.6f}",
+            k ? "," : "", proposalNames[k], c.calls[k], c.accepts[k],
+            c.calls[k] > 0 ? c.accepts[k] / c.calls[k] : 0.0, c.seconds[k]);
+  }
+  fprintf(file, "},\"components\":{");
+  for(int k=0; k<NUMCOMPONENTS; ++k) {
+    fprintf(file, "%s\"%s\":{\"calls\":%.0f,\"seconds\":%.6f}",
+            k ? "," : "", componentNames[k], c.compCalls[k], c.compSeconds[k]);
+  }
+  fprintf(file, "}}\n");
+  fflush(file);
+}
+
+
+
+void McmcProfiler::write(const long iter)
+{
+  if(!enabled) return;
+
+  Counters interval;
+  collect(interval);
+
+  double t = omp_get_wtime();
+  writeRecord("interval", iter, t - lastTime, interval);
+  lastTime = t;
+}
+
+
+
+void McmcProfiler::close(const long iter)
+{
+  if(!enabled) return;
+
+  Counters interval;
+  collect(interval);
+  writeRecord("total", iter, omp_get_wtime() - startTime, total);
+
+  fclose(file);
+  file = NULL;
+  enabled = false;
+}
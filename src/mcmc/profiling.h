@@ -0,0 +1,186 @@
+/* ./src/mcmc/profiling.h
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/////////////////////////////////////////////////////////////////////
+// Name: profiling.h                                               //
+// Author: C.P.Jewell                                              //
+// Purpose: McmcProfiler records wall time, call counts and accept //
+//          rates per proposal type, and wall time per likelihood  //
+//          component.  Counters are per thread and are merged     //
+//          when a metrics record is written, as one JSON object   //
+//          per line.                                              //
+/////////////////////////////////////////////////////////////////////
+
+
+/* CODE EXAMPLE - write a record every 1000 iterations
+
+  McmcProfiler prof;
+  prof.open("metrics.jsonl");
+
+  for(int mcmcIter = 0; mcmcIter < max_iter; ++mcmcIter) {
+
+    {
+      ProposalTimer timer(prof, PROP_ADD);
+      ...
+      if(accepted) timer.accept();
+    }
+
+    if((mcmcIter+1) % 1000 == 0) prof.write(mcmcIter+1);
+  }
+
+  prof.close(max_iter);
+
+*/
+
+#ifndef _INCLUDE_PROFILING_H
+#define _INCLUDE_PROFILING_H
+
+#include <cstdio>
+#include <vector>
+#include <string>
+
+#include <omp.h>
+
+using namespace std;
+
+enum McmcProposal_e {
+  PROP_BETA = 0,
+  PROP_MOVE1,        // Contact -> frequency
+  PROP_MOVE2,        // Contact -> contact
+  PROP_MOVE3,        // Frequency -> contact
+  PROP_MOVE4,        // Frequency -> frequency
+  PROP_PARALLELMOVE, // One parallel sweep, accepted if any time moved
+  PROP_ADD,
+  PROP_DELETE,
+  NUMPROPOSALS
+};
+
+enum McmcComponent_e {
+  COMP_LIKELIHOOD = 0, // Full likelihood
+  COMP_UPDATE_LOGPROD,
+  COMP_UPDATE_LOGCT,
+  COMP_UPDATE_BGPRESS,
+  COMP_UPDATE_A1,
+  COMP_UPDATE_A2,
+  COMP_ADD_LOGPROD,
+  COMP_ADD_LOGCT,
+  COMP_ADD_BGPRESS,
+  COMP_ADD_A1,
+  COMP_ADD_A2,
+  COMP_DEL_LOGPROD,
+  COMP_DEL_LOGCT,
+  COMP_DEL_BGPRESS,
+  COMP_DEL_A1,
+  COMP_DEL_A2,
+  COMP_MOVEDELTA,
+  NUMCOMPONENTS
+};
+
+class McmcProfiler {
+private:
+
+  struct Counters {
+    double calls[NUMPROPOSALS], accepts[NUMPROPOSALS], seconds[NUMPROPOSALS];
+    double compCalls[NUMCOMPONENTS], compSeconds[NUMCOMPONENTS];
+    char pad[64];  // Keep threads off each other's cache lines
+    Counters();
+    void clear();
+    void merge(const Counters& other);
+  };
+
+  bool enabled;
+  FILE* file;
+  double startTime, lastTime;
+  vector<Counters> local;  // One per thread
+  Counters total;
+
+  void collect(Counters& interval);
+  void writeRecord(const char* kind, const long iter, const double wall, const Counters& c);
+
+public:
+  McmcProfiler();
+  ~McmcProfiler();
+
+  // Starts recording, writing records to filename
+  void open(const string& filename);
+  bool isEnabled() const { return enabled; }
+
+  double now() const { return enabled ? omp_get_wtime() : 0.0; }
+
+  // Thread safe, and no-ops until open() is called
+  void proposal(const McmcProposal_e type, const bool accepted, const double seconds) {
+    if(!enabled) return;
+    Counters& c = local[omp_get_thread_num()];
+    c.calls[type] += 1;
+    c.accepts[type] += accepted;
+    c.seconds[type] += seconds;
+  }
+
+  void component(const McmcComponent_e comp, const double seconds) {
+    if(!enabled) return;
+    Counters& c = local[omp_get_thread_num()];
+    c.compCalls[comp] += 1;
+    c.compSeconds[comp] += seconds;
+  }
+
+  // Merges the thread counters and writes the counts since the last
+  // record.  Call from serial code.
+  void write(const long iter);
+
+  // Writes a final record of the whole run and closes the file
+  void close(const long iter);
+};
+
+
+// Times a proposal from construction to destruction, so early
+// rejections (continue statements) are still counted.
+class ProposalTimer {
+private:
+  McmcProfiler& prof;
+  McmcProposal_e type;
+  bool accepted;
+  double start;
+
+public:
+  ProposalTimer(McmcProfiler& prof_, const McmcProposal_e type_ = NUMPROPOSALS) :
+    prof(prof_), type(type_), accepted(false), start(prof_.now()) {}
+  ~ProposalTimer() {
+    if(type != NUMPROPOSALS) prof.proposal(type, accepted, prof.now() - start);
+  }
+
+  void setType(const McmcProposal_e type_) { type = type_; }
+  void accept() { accepted = true; }
+};
+
+
+// Times a likelihood component over its scope
+class ComponentTimer {
+private:
+  McmcProfiler& prof;
+  const McmcComponent_e comp;
+  const double start;
+
+public:
+  ComponentTimer(McmcProfiler& prof_, const McmcComponent_e comp_) :
+    prof(prof_), comp(comp_), start(prof_.now()) {}
+  ~ComponentTimer() { prof.component(comp, prof.now() - start); }
+};
+
+#endif
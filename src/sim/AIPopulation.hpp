@@ -30,12 +30,13 @@
 #include "Population.hpp"
 #include "contactMatrix.h"
 #include "Individual.hpp"
+#include "ModelTraits.hpp"
 
 using namespace EpiRisk;
 
 
 // Constants
-const size_t NSPECIES(9);
+const size_t NSPECIES(ModelTraits::numSpecies);
 
 
 class AIIndividual : public EpiRisk::Individual
@@ -36,8 +36,8 @@
 // Handler methods
 // -----------------------------------------------------------------------
 
-EventParser::EventParser(EventQueue& eventQueue_) :
-  eventQueue(eventQueue_), charBuffer(NULL)
+EventParser::EventParser(EventList& events_) :
+  events(events_), charBuffer(NULL)
 {
 
   TAG_tracedcontacts = XMLString::transcode("tracedcontacts");
@@ -182,11 +182,13 @@ void EventParser::endElement(const XMLCh* const name)
 
     case FROM:
       if(state == FROM) {
-        currEvent = new ContactEvent(contactee,eventTime,contactor,eventType);
-        pair<EventQueue::iterator, bool> rv = eventQueue.insert(currEvent);
-        if(rv.second == false) {
-          cerr << "Duplicate time: " << eventTime << endl;
-        }
+        EventRecord event;
+        event.time = eventTime;
+        event.id = contactee;
+        event.from = contactor;
+        event.type = eventType;
+        event.reserved = 0;
+        events.push_back(event);
         state = CONTACT;
         inFrom = false;
       }
@@ -70,7 +70,7 @@ enum XMLState {
 class EventParser : public HandlerBase
 {
 public:
-  EventParser(EventQueue& eventQueue_);
+  EventParser(EventList& events_);
   virtual
   ~EventParser();
   void startDocument();
@@ -89,9 +89,8 @@ private:
   // Private data members
   // ---------------------------------------------------------------
 
-  EventQueue& eventQueue;
+  EventList& events;
 
-  ContactEvent* currEvent;
   size_t contactee;
   size_t contactor;
   double eventTime;
@@ -26,9 +26,18 @@
  */
 
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "EventQueue.hpp"
 
@@ -40,6 +49,11 @@ using namespace xercesc;
 XERCES_CPP_NAMESPACE_USE
 
 
+#define EVENTFILE_MAGIC "INFEREV1"
+#define EVENTFILE_MAGIC_LEN 8
+#define EVENTFILE_HEADER_LEN (EVENTFILE_MAGIC_LEN + sizeof(uint64_t))
+
+
 
 Event::Event(const size_t id_, const double time_) : id(id_), time(time_)
 {
@@ -66,18 +80,237 @@ ContactEvent::ContactEvent(const size_t id_,
 
 
 
-bool ContactQueueComp::operator()(const ContactEvent* lhs, const ContactEvent* rhs) const
+EventFile::EventFile(const string filename) :
+  fd_(-1), map_(MAP_FAILED), mapSize_(0), records_(NULL), size_(0)
+{
+  //! Maps filename read-only
+
+  fd_ = open(filename.c_str(), O_RDONLY);
+  if (fd_ < 0)
+    throw runtime_error("Cannot open event file " + filename);
+
+  struct stat fileStat;
+  if (fstat(fd_, &fileStat) != 0 || (size_t)fileStat.st_size < EVENTFILE_HEADER_LEN)
+    {
+      ::close(fd_);
+      throw runtime_error("Event file " + filename + " is truncated");
+    }
+  mapSize_ = fileStat.st_size;
+
+  map_ = mmap(NULL, mapSize_, PROT_READ, MAP_PRIVATE, fd_, 0);
+  if (map_ == MAP_FAILED)
+    {
+      ::close(fd_);
+      throw runtime_error("Cannot map event file " + filename);
+    }
+
+  // Events are read front to back
+  madvise(map_, mapSize_, MADV_SEQUENTIAL);
+
+  const char* bytes = (const char*) map_;
+  uint64_t count;
+  memcpy(&count, bytes + EVENTFILE_MAGIC_LEN, sizeof(count));
+
+  if (memcmp(bytes, EVENTFILE_MAGIC, EVENTFILE_MAGIC_LEN) != 0 ||
+      EVENTFILE_HEADER_LEN + count * sizeof(EventRecord) > mapSize_)
+    {
+      munmap(map_, mapSize_);
+      ::close(fd_);
+      throw runtime_error("Event file " + filename + " is corrupt");
+    }
+
+  records_ = (const EventRecord*) (bytes + EVENTFILE_HEADER_LEN);
+  size_ = count;
+}
+
+
+
+EventFile::~EventFile()
+{
+  if (map_ != MAP_FAILED) munmap(map_, mapSize_);
+  if (fd_ >= 0) ::close(fd_);
+}
+
+
+
+bool
+EventFile::isEventFile(const string filename)
+{
+  //! Returns true if filename carries the event file magic
+  char magic[EVENTFILE_MAGIC_LEN];
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (file == NULL) return false;
+
+  bool rv = fread(magic, 1, EVENTFILE_MAGIC_LEN, file) == EVENTFILE_MAGIC_LEN &&
+            memcmp(magic, EVENTFILE_MAGIC, EVENTFILE_MAGIC_LEN) == 0;
+  fclose(file);
+
+  return rv;
+}
+
+
+
+EventFileWriter::EventFileWriter(const string filename) :
+  file_(NULL), size_(0), lastTime_(-HUGE_VAL)
+{
+  file_ = fopen(filename.c_str(), "wb");
+  if (file_ == NULL)
+    throw runtime_error("Cannot open event file " + filename + " for writing");
+
+  // Count is patched in by close()
+  uint64_t count = 0;
+  if (fwrite(EVENTFILE_MAGIC, 1, EVENTFILE_MAGIC_LEN, file_) != EVENTFILE_MAGIC_LEN ||
+      fwrite(&count, sizeof(count), 1, file_) != 1)
+    {
+      fclose(file_);
+      file_ = NULL;
+      throw runtime_error("Error writing event file header");
+    }
+}
+
+
+
+EventFileWriter::~EventFileWriter()
+{
+  try
+    {
+      close();
+    }
+  catch (...)
+    {
+      // Nothing more can be done in a destructor
+    }
+}
+
+
+
+void
+EventFileWriter::write(const EventRecord& event)
 {
-  return lhs->time < rhs->time;
+  if (file_ == NULL)
+    throw logic_error("Write to closed event file");
+  if (event.time < lastTime_)
+    throw logic_error("Events must be written to an event file in time order");
+
+  if (fwrite(&event, sizeof(EventRecord), 1, file_) != 1)
+    throw runtime_error("Error writing event file");
+
+  lastTime_ = event.time;
+  size_++;
 }
 
 
 
+void
+EventFileWriter::close()
+{
+  //! Patches in the event count and closes the file.  The file
+  //! is closed even if the count cannot be written.
+
+  if (file_ == NULL)
+    return;
+
+  uint64_t count = size_;
+  bool ok = fseek(file_, EVENTFILE_MAGIC_LEN, SEEK_SET) == 0 &&
+            fwrite(&count, sizeof(count), 1, file_) == 1;
+  ok = fclose(file_) == 0 && ok;
+  file_ = NULL;
+
+  if (!ok)
+    throw runtime_error("Error closing event file");
+}
+
 
-ContactQueue::ContactQueue(const string filename)
+
+bool
+ContactQueue::CursorComp::operator()(const size_t lhs, const size_t rhs) const
+{
+  // Min-heap on time, ties going to the earlier source
+  const EventRecord* l = (*cursors)[lhs].pos;
+  const EventRecord* r = (*cursors)[rhs].pos;
+  if (l->time != r->time) return l->time > r->time;
+  return lhs > rhs;
+}
+
+
+
+ContactQueue::ContactQueue(const string filename) :
+  currEvent(0, 0.0, 0, BACKGROUND)
+{
+  // Takes a comma separated list of event files and/or
+  //  contact XML files, and merges them into time order
+
+  string token;
+  istringstream tokens(filename);
+  while (getline(tokens, token, ','))
+    if (!token.empty()) addSource(token);
+
+  heapComp.cursors = &cursors;
+  this->reset();
+
+  cerr << "Received " << size() << " events in total." << endl;
+}
+
+
+
+ContactQueue::ContactQueue(const vector<string>& filenames) :
+  currEvent(0, 0.0, 0, BACKGROUND)
+{
+  for (vector<string>::const_iterator it = filenames.begin(); it != filenames.end(); ++it)
+    addSource(*it);
+
+  heapComp.cursors = &cursors;
+  this->reset();
+
+  cerr << "Received " << size() << " events in total." << endl;
+}
+
+
+
+ContactQueue::~ContactQueue()
+{
+  // Destroy event sources
+
+  for (size_t i = 0; i < files.size(); ++i) delete files[i];
+  for (size_t i = 0; i < lists.size(); ++i) delete lists[i];
+}
+
+
+
+void
+ContactQueue::addSource(const string filename)
+{
+  //! Adds filename as an event source, detecting its format
+
+  Cursor source;
+
+  if (EventFile::isEventFile(filename))
+    {
+      EventFile* file = new EventFile(filename);
+      files.push_back(file);
+      source.pos = file->begin();
+      source.end = file->end();
+    }
+  else
+    {
+      EventList* events = new EventList;
+      lists.push_back(events);
+      loadXml(filename, *events);
+      // Stable, so events at equal times keep file order
+      stable_sort(events->begin(), events->end());
+      source.pos = events->empty() ? NULL : &(*events)[0];
+      source.end = source.pos + events->size();
+    }
+
+  sources.push_back(source);
+}
+
+
+
+void
+ContactQueue::loadXml(const string filename, EventList& events)
 {
   // Takes an XML file and reads in contact event data
-  //  putting it into a sorted list
 
   try {
     XMLPlatformUtils::Initialize();
@@ -103,7 +336,7 @@ ContactQueue::ContactQueue(const string filename)
   EventParserErrorReporter* errorReporter;
 
   try{
-    docHandler = new EventParser(eventQueue);
+    docHandler = new EventParser(events);
     errorReporter = new EventParserErrorReporter;
     parser->setDocumentHandler(docHandler);
     parser->setErrorHandler(errorReporter);
@@ -146,49 +379,44 @@ ContactQueue::ContactQueue(const string filename)
     cerr << errCount << " XML parse errors present.  Cannot continue" << endl;
     throw logic_error("Fatal error: XML parse errors present");
   }
-
-  XMLPlatformUtils::Terminate();
-
-  // Set the current event iterator
-  this->reset();
-
-  cerr << "Received " << eventQueue.size() << " events in total." << endl;
-
 }
 
 
 
-ContactQueue::~ContactQueue()
+size_t
+ContactQueue::size() const
 {
-  // Destroy event objects
-
-  EventQueue::iterator iter = eventQueue.begin();
-  while(iter != eventQueue.end()) {
-    delete *iter;
-    iter++;
-  }
-
+  //! Returns the total number of events over all sources
+  size_t n = 0;
+  for (size_t i = 0; i < sources.size(); ++i)
+    n += sources[i].end - sources[i].pos;
+  return n;
 }
 
 
 
 void ContactQueue::dumpEvents()
 {
-  // Dumps events to stdout
+  // Dumps events to stdout, then rewinds the queue
 
-  EventQueue::iterator iter = eventQueue.begin();
-  while(iter != eventQueue.end()) {
-    cerr << (*iter)->from << " -> " << (*iter)->id << " via method " << (*iter)->type << " at time " << (*iter)->time << endl;
-    iter++;
+  reset();
+  ContactEvent* event;
+  while((event = next()) != NULL) {
+    cerr << event->from << " -> " << event->id << " via method " << event->type << " at time " << event->time << endl;
   }
+  reset();
 }
 
 
 
 void ContactQueue::reset()
 {
-  //! Resets the current event iterator to the beginning of the event queue
-  itCurrEvent = eventQueue.begin();
+  //! Rewinds every source and rebuilds the merge heap
+  cursors = sources;
+  heap.clear();
+  for (size_t i = 0; i < cursors.size(); ++i)
+    if (cursors[i].pos != cursors[i].end) heap.push_back(i);
+  make_heap(heap.begin(), heap.end(), heapComp);
 }
 
 
@@ -197,10 +425,21 @@ ContactEvent* ContactQueue::next()
 {
   //! Returns a pointer to the next event in the queue
 
-  if (itCurrEvent == eventQueue.end()) return NULL;
+  if (heap.empty()) return NULL;
 
-  ContactEvent* rv = *itCurrEvent;
-  itCurrEvent++;
+  pop_heap(heap.begin(), heap.end(), heapComp);
+  size_t source = heap.back();
+  const EventRecord* rec = cursors[source].pos++;
 
-  return rv;
+  if (cursors[source].pos == cursors[source].end)
+    heap.pop_back();
+  else
+    push_heap(heap.begin(), heap.end(), heapComp);
+
+  currEvent.id = rec->id;
+  currEvent.time = rec->time;
+  currEvent.from = rec->from;
+  currEvent.type = (ContactType) rec->type;
+
+  return &currEvent;
 }
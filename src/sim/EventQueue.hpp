@@ -28,16 +28,13 @@
 #ifndef EVENT_HPP_
 #define EVENT_HPP_
 
+#include <cstdio>
 #include <string>
-#include <set>
+#include <vector>
 
-using namespace std;
-
-// FWD DECLS
-class ContactEvent;
-class ContactQueueComp;
+#include <stdint.h>
 
-typedef set< ContactEvent*, ContactQueueComp > EventQueue;
+using namespace std;
 
 
 enum ContactType { BACKGROUND = 0,
@@ -57,8 +54,8 @@ public:
   virtual
   ~Event();
 
-  const size_t id;
-  const double time;
+  size_t id;
+  double time;
 
 };
 
@@ -73,16 +70,66 @@ public:
                const size_t from_,
                const ContactType type_);
 
-  const size_t from;
-  const ContactType type;
+  size_t from;
+  ContactType type;
+};
+
+
+
+struct EventRecord
+{
+  //! On-disk (and in-memory) representation of a contact event
+  double time;
+  uint32_t id;       // Contactee
+  uint32_t from;     // Contactor
+  uint32_t type;     // ContactType
+  uint32_t reserved;
+
+  bool operator<(const EventRecord& rhs) const { return time < rhs.time; }
+};
+
+typedef vector<EventRecord> EventList;
+
+
+
+class EventFile
+{
+  //! A time-sorted binary event file, mapped read-only.
+  //! Layout: "INFEREV1" <uint64 count> count x EventRecord
+public:
+  EventFile(const string filename);
+  ~EventFile();
+
+  const EventRecord* begin() const { return records_; }
+  const EventRecord* end() const { return records_ + size_; }
+  size_t size() const { return size_; }
+
+  static bool isEventFile(const string filename);
+
+private:
+  int fd_;
+  void* map_;
+  size_t mapSize_;
+  const EventRecord* records_;
+  size_t size_;
 };
 
 
 
-class ContactQueueComp
+class EventFileWriter
 {
+  //! Writes a binary event file.  Events must arrive in time order.
 public:
-  bool operator() (const ContactEvent* lhs, const ContactEvent* rhs) const;
+  EventFileWriter(const string filename);
+  ~EventFileWriter();
+  void write(const EventRecord& event);
+  void close();
+  size_t size() const { return size_; }
+
+private:
+  FILE* file_;
+  size_t size_;
+  double lastTime_;
 };
 
 
@@ -90,18 +137,43 @@ public:
 class ContactQueue
 {
   // Represents an ordered (early -> late) queue of events
-  //  accessed by a next() method
+  //  accessed by a next() method.  Events are k-way merged from
+  //  one or more sources: sorted binary event files (mapped, so
+  //  memory use is constant) or contact XML files (parsed into
+  //  memory).
 public:
-  ContactQueue(const string filename);
+  ContactQueue(const string filename); // Comma separated list of sources
+  ContactQueue(const vector<string>& filenames);
   ~ContactQueue();
   void dumpEvents();
   void reset();  // Resets the queue pointer to the start
-  ContactEvent* next(); // Returns the next contact event, NULL if no more contact data
+  ContactEvent* next(); // Returns the next contact event, NULL if no more contact data.
+                        // Valid until the following call to next()
+  size_t size() const;
 
 private:
-
-  EventQueue eventQueue;
-  EventQueue::const_iterator itCurrEvent;
+  struct Cursor
+  {
+    const EventRecord* pos;
+    const EventRecord* end;
+  };
+
+  struct CursorComp
+  {
+    const vector<Cursor>* cursors;
+    bool operator()(const size_t lhs, const size_t rhs) const;
+  };
+
+  vector<EventFile*> files;
+  vector<EventList*> lists;
+  vector<Cursor> sources;
+  vector<Cursor> cursors;
+  vector<size_t> heap;
+  CursorComp heapComp;
+  ContactEvent currEvent;
+
+  void addSource(const string filename);
+  void loadXml(const string filename, EventList& events);
 };
 
 #endif /* EVENT_HPP_ */
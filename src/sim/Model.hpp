@@ -54,6 +54,15 @@ public:
   virtual double I2Ncdf(const double d) = 0;
   virtual double I2Nrandist(const double u) = 0;
 
+  // Fills js with the individuals j for which beta(i,j) or
+  // betastar(i,j) may be non-zero.  Everyone but i by default.
+  virtual void neighbours(const int i, std::vector<int>& js)
+  {
+    js.clear();
+    for (int j = 0; j < (int)population->size(); ++j)
+      if (j != i) js.push_back(j);
+  }
+
   // Data
   Parameters* parms;
   Popn* population;
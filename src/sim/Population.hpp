@@ -39,6 +39,7 @@
 
 #include "aiTypes.hpp"
 #include "Individual.hpp"
+#include "PopulationStore.hpp"
 
 using namespace std;
 
@@ -76,6 +77,7 @@ namespace EpiRisk
       double obsTime;
       size_t N_total;
       size_t knownInfections;
+      PopulationStore store; // Hot fields by label, kept in step with individuals
 
 
       // Ctor & Dtor
@@ -98,6 +100,10 @@ namespace EpiRisk
       resetOccults(); // Deletes all occults
       void
       clear(); // Clears all infected individuals
+      void
+      syncStore(); // Recopies store from individuals and infectives
+      void
+      syncStore(const size_t label); // Recopies one individual's event times
 
       // Data access
       Indiv*
@@ -152,6 +158,7 @@ namespace EpiRisk
       {
         individuals.push_back(Indiv(i, obsTime, obsTime, obsTime));
       }
+      syncStore();
 
     }
 
@@ -177,6 +184,22 @@ namespace EpiRisk
         individuals[i].N = obsTime;
         individuals[i].R = obsTime;
       }
+    syncStore();
+    }
+
+  template<typename Indiv>
+    void
+    Population<Indiv>::syncStore()
+    {
+      store.assign(individuals.begin(), individuals.end());
+      store.indexInfectives(infectives.begin(), infectives.end());
+    }
+
+  template<typename Indiv>
+    void
+    Population<Indiv>::syncStore(const size_t label)
+    {
+      store.set(individuals[label]);
     }
 
   template<typename Indiv>
@@ -259,6 +282,8 @@ namespace EpiRisk
             }
         }
 
+      syncStore();
+
       cout << "Done" << endl;
     }
 
@@ -269,6 +294,7 @@ namespace EpiRisk
       // Function associates infections with CT data
       SAXContactParse(filename, individuals);
       updateInfecMethod();
+      syncStore();
     }
 
   template<typename Indiv>
@@ -295,6 +321,8 @@ namespace EpiRisk
       susceptibles.at(susc_pos)->status = Indiv::INFECTED;
       infectives.push_back(susceptibles.at(susc_pos));
       susceptibles.erase(susceptibles.begin() + susc_pos);
+      store.set(*infectives.back());
+      store.addInfective(infectives.back()->label);
       return (0);
     }
 
@@ -309,6 +337,8 @@ namespace EpiRisk
       susceptibles.back()->status = Indiv::SUSCEPTIBLE;
       susceptibles.back()->I = susceptibles.back()->N;
       infectives.erase(infectives.begin() + infec_pos);
+      store.set(*susceptibles.back());
+      store.indexInfectives(infectives.begin(), infectives.end());
       return (0);
     }
 
@@ -317,8 +347,7 @@ namespace EpiRisk
     Population<Indiv>::exposureI(Ipos_t i, Ipos_t j)
     {
       // NB: This gives time that susceptible j is exposed to infective i before becoming infected
-      return GSL_MIN(individuals[i].N, individuals[j].I) - GSL_MIN(
-          individuals[i].I, individuals[j].I);
+      return store.exposureI(i, j);
     }
 
   template<typename Indiv>
@@ -331,14 +360,14 @@ namespace EpiRisk
 
       double stopTime;
       double startTime;
-      double earliestContactStart = GSL_MIN(individuals[i].contactStart,
-          individuals[j].contactStart);
+      double earliestContactStart = GSL_MIN(store.contactStart[i],
+          store.contactStart[j]);
 
-      stopTime = GSL_MIN(individuals[i].N, individuals[j].I);
+      stopTime = GSL_MIN(store.N[i], store.I[j]);
       stopTime = GSL_MIN(earliestContactStart, stopTime);
 
-      startTime = GSL_MIN(individuals[j].I, individuals[i].I);
-      startTime = GSL_MIN(earliestContactStart, stopTime);
+      startTime = GSL_MIN(store.I[j], store.I[i]);
+      startTime = GSL_MIN(earliestContactStart, startTime);
 
       return stopTime - startTime;
     }
@@ -350,7 +379,7 @@ namespace EpiRisk
       // Returns the amount of time between I and start of CT window
       // Non-neg if CTstart > I, 0 otherwise
 
-      double iTime = individuals.at(i).contactStart - individuals[i].I;
+      double iTime = store.contactStart.at(i) - store.I[i];
 
       if (iTime > 0)
         return iTime;
@@ -363,8 +392,7 @@ namespace EpiRisk
     Population<Indiv>::exposureN(Ipos_t i, Ipos_t j)
     {
       // NB: This gives time that susceptible j is exposed to notified i before becoming infected
-      return GSL_MIN(individuals[i].R, individuals[j].I) - GSL_MIN(
-          individuals[j].I, individuals[i].N);
+      return store.exposureN(i, j);
     }
 
   template<typename Indiv>
@@ -372,7 +400,7 @@ namespace EpiRisk
     Population<Indiv>::ITime(Ipos_t i)
     {
       // NB: Gives the time for which i was infectious but not notified
-      return individuals.at(i).N - individuals[i].I;
+      return store.ITime(i);
     }
 
   template<typename Indiv>
@@ -380,7 +408,7 @@ namespace EpiRisk
     Population<Indiv>::NTime(Ipos_t i)
     {
       // NB: Gives the time for which i was notified
-      return individuals[i].R - individuals[i].N;
+      return store.NTime(i);
     }
 
   template<typename Indiv>
@@ -25,20 +25,297 @@
  *      Author: stsiab
  */
 
+#include <fstream>
+#include <stdexcept>
+
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_randist.h>
+
 #include "SellkeSim.hpp"
+#include "EpiRiskException.hpp"
+
+
 
-SellkeSim::SellkeSim(const int nTotal_,
-                     const double tObs_,
-                     const string epiFilename_,
-                     const string dataPrefix_)
+SellkeSim::SellkeSim(EpiModel<AIPopulation>* model_, const unsigned long seed) :
+  model(model_), population(model_->population), rng(NULL),
+  nTotal(model_->population->size()), numInfec(0),
+  maxTime(model_->population->obsTime), nrTime(1.0)
 {
   // Simulates epidemics using the Sellke construction
 
-  // First population the dataset
-  data = new AIPopulation(nTotal_,tObs_);
+  rng = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, seed);
+
+  drawThresholds();
+  reset();
+}
+
+
+
+SellkeSim::~SellkeSim()
+{
+  gsl_rng_free(rng);
+}
+
+
 
+void
+SellkeSim::drawThresholds()
+{
+  thresholds.resize(nTotal);
+  i2nU.resize(nTotal);
+
+  for (size_t j = 0; j < nTotal; ++j)
+    {
+      thresholds[j] = gsl_ran_exponential(rng, 1.0);
+      i2nU[j] = gsl_rng_uniform_pos(rng);
+    }
 }
 
-SellkeSim::~SellkeSim() {
-	// TODO Auto-generated destructor stub
+
+
+void
+SellkeSim::reset()
+{
+  // Resets to a fully susceptible population.  Every individual
+  // is subject to background pressure from the start.
+
+  double background = model->parms->at(ModelTraits::BETA0).value;
+
+  population->resetEventTimes();
+
+  infections = InfectionQueue();
+  transitions = TransitionQueue();
+  numInfec = 0;
+
+  pressure.resize(nTotal);
+  susceptible.assign(nTotal, true);
+
+  for (size_t j = 0; j < nTotal; ++j)
+    {
+      pressure[j].lambda = 0.0;
+      pressure[j].rate = 0.0;
+      pressure[j].updated = 0.0;
+      pressure[j].version = 0;
+      changeRate(j, background, 0.0);
+    }
+}
+
+
+
+void
+SellkeSim::setMaxTime(const double maxTime_)
+{
+  maxTime = maxTime_;
+}
+
+
+
+double
+SellkeSim::getMaxTime() const
+{
+  return maxTime;
+}
+
+
+
+void
+SellkeSim::setNRTime(const double nrTime_)
+{
+  nrTime = nrTime_;
+}
+
+
+
+double
+SellkeSim::getNRTime() const
+{
+  return nrTime;
+}
+
+
+
+size_t
+SellkeSim::numInfected() const
+{
+  return numInfec;
+}
+
+
+
+void
+SellkeSim::addInfection(const size_t label, const double time)
+{
+  // Adds an index case
+  if (label >= nTotal)
+    throw EpiRisk::range_exception("Individual out of range");
+  if (!susceptible[label])
+    throw logic_error("Individual to infect is not susceptible");
+
+  infect(label, time);
+}
+
+
+
+size_t
+SellkeSim::simulate()
+{
+  // Processes infections in the order in which individuals'
+  // cumulative pressure reaches their threshold, interleaved with
+  // notifications and removals.  Returns the number infected.
+
+  while (true)
+    {
+      // Discard candidates invalidated by a change in rate
+      while (!infections.empty() &&
+             (!susceptible[infections.top().label] ||
+              infections.top().version != pressure[infections.top().label].version))
+        infections.pop();
+
+      double tInfec = infections.empty() ? GSL_POSINF : infections.top().time;
+      double tTrans = transitions.empty() ? GSL_POSINF : transitions.top().time;
+
+      if (GSL_MIN(tInfec, tTrans) > maxTime) break;
+
+      if (tTrans <= tInfec)
+        {
+          Transition trans = transitions.top();
+          transitions.pop();
+          if (trans.type == NOTIFICATION)
+            notify(trans.label, trans.time);
+          else
+            remove(trans.label, trans.time);
+        }
+      else
+        {
+          Candidate cand = infections.top();
+          infections.pop();
+          infect(cand.label, cand.time);
+        }
+    }
+
+  return numInfec;
+}
+
+
+
+void
+SellkeSim::changeRate(const size_t j, const double delta, const double time)
+{
+  //! Brings j's cumulative pressure up to time, alters its rate,
+  //! and schedules the time at which its threshold will be reached.
+
+  Pressure& p = pressure[j];
+
+  p.lambda += p.rate * (time - p.updated);
+  p.updated = time;
+  p.rate += delta;
+  if (p.rate < 0.0) p.rate = 0.0; // Rounding
+  p.version++;
+
+  if (p.rate > 0.0)
+    {
+      Candidate cand;
+      cand.time = time + GSL_MAX(thresholds[j] - p.lambda, 0.0) / p.rate;
+      cand.label = j;
+      cand.version = p.version;
+      infections.push(cand);
+    }
+}
+
+
+
+void
+SellkeSim::infect(const size_t label, const double time)
+{
+  AIIndividual* indiv = (*population)[label];
+
+  susceptible[label] = false;
+  numInfec++;
+
+  // Event times, censored at maxTime
+  double N = time + model->I2Nrandist(i2nU[label]);
+  double R = N + nrTime;
+  indiv->I = time;
+  indiv->N = GSL_MIN(N, maxTime);
+  indiv->R = GSL_MIN(R, maxTime);
+  population->syncStore(label);
+
+  Transition trans;
+  trans.time = N;
+  trans.label = label;
+  trans.type = NOTIFICATION;
+  transitions.push(trans);
+
+  model->neighbours(label, neighbours);
+  for (size_t k = 0; k < neighbours.size(); ++k)
+    {
+      size_t j = neighbours[k];
+      if (!susceptible[j]) continue;
+      double beta = model->beta(label, j);
+      if (beta != 0.0) changeRate(j, beta, time);
+    }
+}
+
+
+
+void
+SellkeSim::notify(const size_t label, const double time)
+{
+  Transition trans;
+  trans.time = time + nrTime;
+  trans.label = label;
+  trans.type = REMOVAL;
+  transitions.push(trans);
+
+  model->neighbours(label, neighbours);
+  for (size_t k = 0; k < neighbours.size(); ++k)
+    {
+      size_t j = neighbours[k];
+      if (!susceptible[j]) continue;
+      double delta = model->betastar(label, j) - model->beta(label, j);
+      if (delta != 0.0) changeRate(j, delta, time);
+    }
+}
+
+
+
+void
+SellkeSim::remove(const size_t label, const double time)
+{
+  model->neighbours(label, neighbours);
+  for (size_t k = 0; k < neighbours.size(); ++k)
+    {
+      size_t j = neighbours[k];
+      if (!susceptible[j]) continue;
+      double betastar = model->betastar(label, j);
+      if (betastar != 0.0) changeRate(j, -betastar, time);
+    }
+}
+
+
+
+void
+SellkeSim::writeSimToFile(const string filename, const bool includeCensored) const
+{
+  // Write .ipt file
+
+  ofstream output;
+  output.open(filename.c_str(), ios::out);
+  if (!output.is_open())
+    throw EpiRisk::output_exception("Cannot open simulation output file for writing");
+
+  output.precision(9);
+  for (size_t i = 0; i < nTotal; ++i)
+    {
+      if (susceptible[i]) continue;
+      const AIIndividual& indiv = population->individuals[i];
+      if (indiv.I >= maxTime) continue;
+      if (indiv.N == maxTime && !includeCensored) continue;
+
+      output << fixed << indiv.label << " " << indiv.I << " " << indiv.N
+             << " " << indiv.R << endl;
+    }
+
+  output.close();
 }
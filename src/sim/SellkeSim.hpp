@@ -23,39 +23,110 @@
  *
  *  Created on: 4 Dec 2009
  *      Author: Chris Jewell
+ *     Purpose: Simulates SINR epidemics by the Sellke construction.
+ *              Each individual has an Exp(1) resistance threshold and
+ *              is infected when its cumulative infectious pressure
+ *              reaches it.  Thresholds (and the uniforms driving the
+ *              I->N periods) are drawn once and reused across
+ *              parameter sets as common random numbers.
  */
 
 #ifndef SELLKESIM_HPP_
 #define SELLKESIM_HPP_
 
 #include <string>
+#include <vector>
+#include <queue>
 
-#include "AIPopulation.hpp"
-#include "aiModel.hpp"
+#include <gsl/gsl_rng.h>
 
-class SellkeSim;
+#include "AIPopulation.hpp"
+#include "Model.hpp"
 
+using namespace std;
 
-// Alias infection as Individual, makes more sense!
 
 
-class SellkeSim {
+class SellkeSim
+{
 public:
-	SellkeSim(const int nTotal_,
-                  const double tObs_,
-                  const string epiFilename_,
-		  const string dataPrefix_);
-	virtual ~SellkeSim();
+  SellkeSim(EpiModel<AIPopulation>* model_, const unsigned long seed);
+  virtual
+  ~SellkeSim();
 
-private:
-	AIPopulation* data;
-	AIModel* model;
+  // Draws new thresholds.  Until called again, every simulation
+  // uses the same thresholds whatever the parameters.
+  void drawThresholds();
 
-};
+  void reset();
+  void addInfection(const size_t label, const double time = 0.0);
+  size_t simulate();
 
+  // Getters and setters
+  void setMaxTime(const double maxTime_);
+  double getMaxTime() const;
+  void setNRTime(const double nrTime_);
+  double getNRTime() const;
+  size_t numInfected() const;
 
+  // Write data
+  void writeSimToFile(const string filename, const bool includeCensored = false) const;
 
+private:
 
+  struct Pressure
+  {
+    double lambda;   // Cumulative pressure at time updated
+    double rate;     // Current pressure rate
+    double updated;
+    unsigned int version;
+  };
+
+  struct Candidate
+  {
+    //! Time at which label's pressure reaches its threshold,
+    //! stale if version no longer matches
+    double time;
+    size_t label;
+    unsigned int version;
+    bool operator<(const Candidate& rhs) const { return time > rhs.time; }
+  };
+
+  enum TransitionType { NOTIFICATION=0, REMOVAL };
+
+  struct Transition
+  {
+    double time;
+    size_t label;
+    TransitionType type;
+    bool operator<(const Transition& rhs) const { return time > rhs.time; }
+  };
+
+  typedef priority_queue<Candidate> InfectionQueue;
+  typedef priority_queue<Transition> TransitionQueue;
+
+  void infect(const size_t label, const double time);
+  void notify(const size_t label, const double time);
+  void remove(const size_t label, const double time);
+  void changeRate(const size_t j, const double delta, const double time);
+
+  EpiModel<AIPopulation>* model;
+  AIPopulation* population;
+  gsl_rng* rng;
+
+  vector<double> thresholds;
+  vector<double> i2nU;
+  vector<Pressure> pressure;
+  vector<bool> susceptible;
+  vector<int> neighbours; // Of the individual being infected, notified or removed
+  InfectionQueue infections;
+  TransitionQueue transitions;
+
+  size_t nTotal;
+  size_t numInfec;
+  double maxTime;
+  double nrTime;
+};
 
 
 
@@ -126,6 +126,71 @@ ThresholdMatrix::get(const int i, const int j)
   return *(th_ + nTotal_ * i + j);
 }
 
+
+
+namespace
+{
+  inline uint64_t
+  mix64(uint64_t x)
+  {
+    // SplitMix64 finaliser
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+}
+
+
+
+HashedThresholds::HashedThresholds(const uint64_t seed, const uint64_t stream) :
+  streamKey_(mix64(mix64(seed) + stream * 0x9e3779b97f4a7c15ULL))
+{
+}
+
+
+
+double
+HashedThresholds::hash(const uint64_t key, const uint64_t streamKey)
+{
+  //! Returns a Uniform(0,1) variate, never exactly 0 or 1
+  uint64_t h = mix64(mix64(key ^ streamKey) + streamKey);
+  return ((h >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+
+
+double
+HashedThresholds::get(const int i, const int j)
+{
+  uint64_t key = ((uint64_t) (uint32_t) i << 32) | (uint32_t) j;
+
+  Cache::const_iterator found = cache_.find(key);
+  if (found != cache_.end()) return found->second;
+
+  double th = hash(key, streamKey_);
+  cache_.insert(make_pair(key, th));
+  return th;
+}
+
+
+
+void
+HashedThresholds::writeCache(const string filename) const
+{
+  ofstream file(filename.c_str());
+  if (!file.is_open())
+    throw EpiRisk::output_exception("Cannot open threshold cache file for writing");
+
+  file.precision(9);
+  for (Cache::const_iterator it = cache_.begin(); it != cache_.end(); ++it)
+    file << (it->first >> 32) << " " << (it->first & 0xffffffffULL) << " " << it->second << "\n";
+
+  file.close();
+}
+
 /////////////////////////////////////
 ///// MAIN CLASS IMPLEMENTATION /////
 /////////////////////////////////////
@@ -134,7 +199,7 @@ SimOnContact::SimOnContact(const string contactDataFile, const size_t nTotal) :
   numS(nTotal), numI(0), numN(0), numR(0), currTime(0.0), hFuncTh(NULL),
       fmThres(NULL), shThres(NULL), inTimes(NULL), nrTime(1.0), ctWriter(NULL),
       nTotal(nTotal), ctWindowSize(21.0), maxTime(GSL_POSINF), minTime(0.0),
-      P1(0.5), P2(0.5), mu(0), nu(0)
+      P1(0.5), P2(0.5), mu(0), nu(0), trace(NULL), traceRun(0)
 {
 
   // Set up contact queue
@@ -322,6 +387,25 @@ SimOnContact::loadThresholds(const string filePrefix)
 
 }
 
+void
+SimOnContact::generateThresholds(const uint64_t seed)
+{
+  // Derives thresholds on demand from seed, in place of
+  // loading dense matrices with loadThresholds
+
+  if (hFuncTh)
+    delete hFuncTh;
+  hFuncTh = new HashedThresholds(seed, 0);
+
+  if (fmThres)
+    delete fmThres;
+  fmThres = new HashedThresholds(seed, 1);
+
+  if (shThres)
+    delete shThres;
+  shThres = new HashedThresholds(seed, 2);
+}
+
 void
 SimOnContact::addInfection(const Individual& indiv)
 {
@@ -333,6 +417,7 @@ SimOnContact::addInfection(const Individual& indiv)
   (*individuals)[indiv.label]->I = indiv.I;
   (*individuals)[indiv.label]->N = indiv.N;
   (*individuals)[indiv.label]->R = indiv.R;
+  individuals->syncStore(indiv.label);
 
 }
 
@@ -379,6 +464,8 @@ SimOnContact::simulate()
     delete ctWriter;
   contactData.clear();
   ctWriter = new XmlCTWriter();
+  if (!ctFilename.empty())
+    ctWriter->open(ctFilename);
 
   Population::iterator iter = individuals->begin();
   pair<ContactData::iterator, bool> rv;
@@ -400,6 +487,7 @@ SimOnContact::simulate()
     (*individuals)[dcIter->first]->I = dcIter->second.N;
     (*individuals)[dcIter->first]->N = dcIter->second.N;
     (*individuals)[dcIter->first]->R = dcIter->second.R;
+    individuals->syncStore(dcIter->first);
     dcIter++;
   }
 
@@ -414,6 +502,7 @@ SimOnContact::simulate()
         break;
 
       contactee = (*individuals)[currEvent->id];
+      bool wasSusceptible = contactee->isSAt(currTime);
 
       // Check notifications
       testNotify.N = currTime;
@@ -427,6 +516,9 @@ SimOnContact::simulate()
           data->setCTStartTime((*iter)->N - ctWindowSize);
           data->truncate();
           ctWriter->addCTData(data);
+          if (trace)
+            trace->record(EventTrace::NOTIFICATION, EVENTTRACE_NONE,
+                (*iter)->label, BACKGROUND, (*iter)->N, 0.0, traceRun);
           numN--;
           numR++;
           iter++;
@@ -556,6 +648,9 @@ SimOnContact::simulate()
 
         }
 
+      if (trace)
+        traceContact(*currEvent, wasSusceptible && !contactee->isSAt(currTime));
+
       currEvent = contactQueue->next();
 
     } // while(numN > 0 && currEvent != NULL)
@@ -564,6 +659,41 @@ SimOnContact::simulate()
 
 }
 
+void
+SimOnContact::setCtOutput(const string filename)
+{
+  //! Blocks are written as each premises is notified, so memory use
+  //! does not grow with the length of the simulation
+  ctFilename = filename;
+}
+
+void
+SimOnContact::setTrace(EventTrace* Trace, const uint32_t run)
+{
+  //! Records each contact, and whether it infected, to Trace
+  trace = Trace;
+  traceRun = run;
+}
+
+void
+SimOnContact::traceContact(const ContactEvent& event, const bool infected)
+{
+  // Records a contact with the contactor's infectivity at the time
+  size_t sender = EVENTTRACE_NONE;
+  double h = 0.0;
+  if (event.type != BACKGROUND)
+    {
+      sender = event.from;
+      Individual* contactor = (*individuals)[event.from];
+      if (contactor->isIAt(event.time))
+        h = hFunc(event.time - contactor->I);
+      else if (contactor->isNAt(event.time))
+        h = 1.0;
+    }
+  trace->record(infected ? EventTrace::INFECTION : EventTrace::CONTACT,
+      sender, event.id, event.type, event.time, h, traceRun);
+}
+
 void
 SimOnContact::reset()
 {
@@ -663,6 +793,7 @@ SimOnContact::infect(const size_t label)
 
   }
 
+  individuals->syncStore(label);
   notifications.insert((*individuals)[label]);
 
   numS--;
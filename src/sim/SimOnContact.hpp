@@ -45,6 +45,9 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <stdint.h>
 
 #include <gsl/gsl_math.h>
 
@@ -52,14 +55,26 @@
 #include "Population.hpp"
 #include "EventQueue.hpp"
 #include "XmlCTWriter.hpp"
+#include "EventTrace.hpp"
 
 using namespace std;
 using namespace EpiRisk;
 
 
 
-class ThresholdMatrix
+class ThresholdProvider
 {
+  //! Supplies the uniform threshold for contactor i infecting contactee j
+public:
+  virtual ~ThresholdProvider() {}
+  virtual double get(const int i, const int j) = 0;
+};
+
+
+
+class ThresholdMatrix : public ThresholdProvider
+{
+  //! Dense thresholds read from an ASCII nTotal x nTotal matrix
 public:
   ThresholdMatrix(const string filename, const size_t nTotal);
   ~ThresholdMatrix();
@@ -72,6 +87,33 @@ private:
 };
 
 
+
+class HashedThresholds : public ThresholdProvider
+{
+  //! Thresholds derived on demand from (seed, stream, i, j) by a
+  //! counter-based hash, so a given seed always reproduces the same
+  //! thresholds without storing them.  Values are cached as they are
+  //! drawn, so memory is proportional to the number of pairs that
+  //! actually make contact, and the used thresholds can be dumped.
+public:
+  HashedThresholds(const uint64_t seed, const uint64_t stream);
+
+  double get(const int i, const int j);
+
+  // Writes the cached thresholds as "<i> <j> <threshold>" lines
+  void writeCache(const string filename) const;
+  size_t cacheSize() const { return cache_.size(); }
+  void clearCache() { cache_.clear(); }
+
+  static double hash(const uint64_t key, const uint64_t streamKey);
+
+private:
+  typedef boost::unordered_map<uint64_t, double> Cache;
+  uint64_t streamKey_;
+  Cache cache_;
+};
+
+
 // Comparison functor
 
 class CompInfectionTime
@@ -102,6 +144,7 @@ public:
   // Load data
   void loadContactData(const string filename);
   void loadThresholds(const string filePrefix);
+  void generateThresholds(const uint64_t seed);
   void loadInTimes(const string filename);
   void loadDCData(const string filename);
   void loadOccults(const string filename);
@@ -119,6 +162,12 @@ public:
   void setCtWindowSize(const double CTWindowSize);
   double getCtWindowSize() const;
 
+  void setTrace(EventTrace* Trace, const uint32_t run = 0); // Not owned, NULL for none
+
+  // Streams contact tracing to filename while simulate() runs, closed
+  // by writeCTToFile(filename).  Empty keeps it in memory instead.
+  void setCtOutput(const string filename);
+
 
   // Write data
   void writeSimToFile(const string filePrefix, const bool includeCensored = false, const bool includeDC = false) const;
@@ -140,6 +189,7 @@ private:
   void remove(const size_t label);
   void appendContact(size_t& contacteeId, size_t& contactorId, const char* type, const double& time, bool caused);
   double hFunc(const double t);
+  void traceContact(const ContactEvent& event, const bool infected);
 
   typedef EpiRisk::Population<EpiRisk::Individual> Population;
   typedef multiset<EpiRisk::Individual*, CompNotificationTimePtr> NotificationSet;
@@ -161,9 +211,9 @@ private:
 
   // Input data
   ContactQueue* contactQueue;
-  ThresholdMatrix* hFuncTh;
-  ThresholdMatrix* fmThres;
-  ThresholdMatrix* shThres;
+  ThresholdProvider* hFuncTh;
+  ThresholdProvider* fmThres;
+  ThresholdProvider* shThres;
   double* inTimes;
   double nrTime;
   DCData dcData;
@@ -171,6 +221,7 @@ private:
   // Output data
   XmlCTWriter* ctWriter;
   ContactData contactData;
+  string ctFilename;
 
   // Constants
   string epiDataPrefix;
@@ -180,6 +231,10 @@ private:
   double P1, P2;
   double mu, nu;
 
+  // Tracing
+  EventTrace* trace;
+  uint32_t traceRun;
+
 
 
 
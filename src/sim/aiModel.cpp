@@ -25,6 +25,7 @@
  *      Author: Chris Jewell
  */
 
+#include <algorithm>
 #include <gsl/gsl_math.h>
 #include <string.h>
 
@@ -35,6 +36,7 @@
 AIModel::AIModel(Parameters* parms_, AIPopulation* population_) : EpiModel<AIPopulation>(parms_, population_)
 {
   // Initialise members
+  spatialKernel.setDistances(population->rho, population->size());
 }
 
 
@@ -46,6 +48,15 @@ AIModel::~AIModel()
 
 
 
+void AIModel::prepare()
+{
+  // Caches the spatial kernel for the current parameters.  Not thread
+  // safe, so call it serially whenever parms change.
+  spatialKernel.prepare(parms->at(ModelTraits::RHO).value);
+}
+
+
+
 double AIModel::speciesSusc(const size_t j)
 {
   double susc = 1.0;
@@ -53,7 +64,7 @@ double AIModel::speciesSusc(const size_t j)
 
   for(int k = 0; k < NSPECIES; ++k) {
     if (indiv->species[k] == true) {
-      susc *= parms->at(k+7).value;
+      susc *= parms->at(ModelTraits::SPECIES+k).value;
       break;
     }
   }
@@ -66,7 +77,7 @@ double AIModel::speciesSusc(const size_t j)
 double AIModel::fmRate(const int i, const int j)
 {
   // Feedmill rate
-  double rate = 10 * population->fmContact.isConn(i,j) * ( 0.5 * (*population)[j]->fm * ( 3.0 / ((*population)[j]->fm_N) ) );
+  double rate = ModelTraits::ctMultiplier() * population->fmContact.isConn(i,j) * ( 0.5 * (*population)[j]->fm * ( 3.0 / ((*population)[j]->fm_N) ) );
   return rate;
 }
 
@@ -75,7 +86,7 @@ double AIModel::fmRate(const int i, const int j)
 double AIModel::shRate(const int i, const int j)
 {
   // Slaughterhouse rate
-  double rate = 10 * population->shContact.isConn(i,j) * ( 0.5 * (*population)[j]->sh * ( 3.0 / ((*population)[j]->sh_N) ) );
+  double rate = ModelTraits::ctMultiplier() * population->shContact.isConn(i,j) * ( 0.5 * (*population)[j]->sh * ( 3.0 / ((*population)[j]->sh_N) ) );
   return rate;
 }
 
@@ -84,7 +95,7 @@ double AIModel::shRate(const int i, const int j)
 double AIModel::cpRate(const int i, const int j)
 {
   // Company rate
-  double rate = parms->at(3).value*population->cpContact.isConn(i,j);
+  double rate = parms->at(ModelTraits::BETA_CP).value*population->cpContact.isConn(i,j);
   return rate;
 }
 
@@ -93,7 +104,7 @@ double AIModel::cpRate(const int i, const int j)
 double AIModel::iSpatRate(const int i, const int j)
 {
   // Spatial rate I->S
-  double rate = parms->at(4).value*exp(-parms->at(6).value*(population->getRho(i,j) - 5.0));
+  double rate = parms->at(ModelTraits::BETA_SPATIAL_I).value*spatialKernel.at(i,j,parms->at(ModelTraits::RHO).value);
   return rate;
 }
 
@@ -102,7 +113,7 @@ double AIModel::iSpatRate(const int i, const int j)
 double AIModel::nSpatRate(const int i, const int j)
 {
   // Spatial rate N->S
-  double rate = parms->at(5).value*exp(-parms->at(6).value*(population->getRho(i,j) - 5.0));
+  double rate = parms->at(ModelTraits::BETA_SPATIAL_N).value*spatialKernel.at(i,j,parms->at(ModelTraits::RHO).value);
   return rate;
 }
 
@@ -131,10 +142,30 @@ double AIModel::betastar(const int i, const int j)
 
 
 
+void AIModel::neighbours(const int i, vector<int>& js)
+{
+  // i's spatial kernel targets and network connections, each once
+  const uint32_t* targets = spatialKernel.targets(i);
+  js.assign(targets, targets + spatialKernel.degree(i));
+
+  vector<int> conns;
+  contactMat* nets[] = { &population->fmContact, &population->shContact, &population->cpContact };
+  for(int k = 0; k < 3; ++k) {
+    nets[k]->connections(i, conns);
+    js.insert(js.end(), conns.begin(), conns.end());
+  }
+
+  sort(js.begin(), js.end());
+  js.erase(unique(js.begin(), js.end()), js.end());
+  js.erase(remove(js.begin(), js.end(), i), js.end());
+}
+
+
+
 double AIModel::I2Npdf(const double d)
 {
-  double a = parms->at(17).value;
-  double b = parms->at(18).value;
+  double a = parms->at(ModelTraits::I2N_A).value;
+  double b = parms->at(ModelTraits::I2N_B).value;
 
   return a*b*exp(a + b*d - a*exp(b*d));
 }
@@ -143,8 +174,8 @@ double AIModel::I2Npdf(const double d)
 
 double AIModel::I2Ncdf(const double d)
 {
-  double a = parms->at(17).value;
-  double b = parms->at(18).value;
+  double a = parms->at(ModelTraits::I2N_A).value;
+  double b = parms->at(ModelTraits::I2N_B).value;
 
   return 1 - exp(-a*(exp(b*d) - 1));
 }
@@ -153,8 +184,8 @@ double AIModel::I2Ncdf(const double d)
 
 double AIModel::I2Nrandist(const double u)
 {
-  double a = parms->at(17).value;
-  double b = parms->at(18).value;
+  double a = parms->at(ModelTraits::I2N_A).value;
+  double b = parms->at(ModelTraits::I2N_B).value;
 
   return 1.0/b * log(1 - log( 1 - u )/a);
 }
@@ -34,6 +34,7 @@
 #include "AIPopulation.hpp"
 #include "speciesMat.h"
 #include "contactMatrix.h"
+#include "SpatialKernel.hpp"
 
 
 
@@ -48,6 +49,9 @@ public:
   AIModel(Parameters* parms_, AIPopulation* population_);
   ~AIModel();
 
+  // Call serially after changing parms, before any parallel use
+  void prepare();
+
   // Maths
   double fmRate(const int i, const int j);
   double shRate(const int i, const int j);
@@ -60,6 +64,12 @@ public:
   double I2Ncdf(const double d);
   double I2Nrandist(const double u);
   double speciesSusc(const size_t j);
+  void neighbours(const int i, vector<int>& js);
+
+  const SpatialKernel& getSpatialKernel() const { return spatialKernel; }
+
+private:
+  SpatialKernel spatialKernel;
 
 };
 
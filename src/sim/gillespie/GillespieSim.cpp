@@ -38,12 +38,16 @@
 /////////////////////////////////////////////////////////////////////
 
 GillespieSim::GillespieSim(const size_t popSize, gsl_rng* rng) :
-  contactWriter(0), rng(rng), init_done(0), NPARMS(16), rho(NULL), f(F_VALUE),
-      g(G_VALUE), ctOutput(true), N_total(popSize)
+  contactWriter(0), rng(rng), init_done(0), rho(NULL), f(F_VALUE),
+      g(G_VALUE), ctOutput(true), prepared(false), storeResults(true), verbose(true), observer(NULL), tauTolerance(0.0),
+      tauExactThreshold(10), trace(NULL), traceRun(0),
+      N_total(popSize)
 {
   // Set default values
   setStartTime(0.0);
   setMaxTime(5000);
+  eventCount = 0;
+  kernel.set(f, g);
 
   // Set up Contact Writer
   contactWriter = new XmlCTWriter();
@@ -55,6 +59,8 @@ GillespieSim::GillespieSim(const size_t popSize, gsl_rng* rng) :
 
 GillespieSim::~GillespieSim()
 {
+  for (ContactData::iterator it = contactData.begin(); it != contactData.end(); ++it)
+    delete it->second;
   gsl_rng_free(rng);
   delete[] rho;
 }
@@ -67,10 +73,12 @@ GillespieSim::loadCovariates(const string dataPrefix)
 
   string filename;
 
+  network.reset(new Network);
+
   // Set up contact matrix
   filename = dataPrefix + ".fm";
   cerr << "Contact matrix: " << filename << endl;
-  rv = fm_Mat.init(filename.c_str(), N_total);
+  rv = network->fm_Mat.init(filename.c_str(), N_total);
   if (rv != 0)
     {
       throw EpiRisk::data_exception("Feed Mill Contact Matrix setup failed!");
@@ -78,7 +86,7 @@ GillespieSim::loadCovariates(const string dataPrefix)
 
   filename = dataPrefix + ".sh";
   cerr << "Contact matrix: " << filename << endl;
-  rv = sh_Mat.init(filename.c_str(), N_total);
+  rv = network->sh_Mat.init(filename.c_str(), N_total);
   if (rv != 0)
     {
       throw EpiRisk::data_exception("SH Contact Matrix setup failed!");
@@ -86,7 +94,7 @@ GillespieSim::loadCovariates(const string dataPrefix)
 
   filename = dataPrefix + ".cp";
   cerr << "Contact matrix: " << filename << endl;
-  rv = cp_Mat.init(filename.c_str(), N_total);
+  rv = network->cp_Mat.init(filename.c_str(), N_total);
   if (rv != 0)
     {
       throw EpiRisk::data_exception("Feed Mill Contact Matrix setup failed!");
@@ -152,35 +160,48 @@ GillespieSim::loadEpiData(const string filename, const double obsTime, const dou
       N = atof(tokens[2].c_str());
       R = atof(tokens[3].c_str());
 
-      if (I > obsTime)
-        {
-          stringstream msg;
-          msg << "Individual " << label << " has infection time (" << I
-              << ") > obsTime (" << obsTime << ")";
-          throw logic_error(msg.str().c_str());
-        }
+      setObservedInfection(label, I, N, R, obsTime, a, b, c);
+    }
 
-      // Check what information we have actually observed
-      if (N == obsTime)
-        { // This means both N and R have not occurred yet.
-          while (1)
-            { // Rejection sampling.  Algorithm could well stick here!!
-              N = I + rng_extreme(a, b);
-              if (N > obsTime)
-                break;
-            }
-          R = N + c;
-        }
-      else if (R == obsTime)
-        {
-          R = N + c;
-        }
+}
 
-      individuals.at(label).I = I;
-      individuals.at(label).N = N;
-      individuals.at(label).R = R;
+
+
+void
+GillespieSim::setObservedInfection(const size_t label, const double I,
+    double N, double R, const double obsTime, const double a, const double b,
+    const double c)
+{
+  //! Sets an infection observed up to obsTime.  N == obsTime means
+  //! neither N nor R have occurred, R == obsTime that R has not.
+
+  if (I > obsTime)
+    {
+      stringstream msg;
+      msg << "Individual " << label << " has infection time (" << I
+          << ") > obsTime (" << obsTime << ")";
+      throw logic_error(msg.str().c_str());
+    }
+
+  // Check what information we have actually observed
+  if (N == obsTime)
+    { // This means both N and R have not occurred yet.
+      while (1)
+        { // Rejection sampling.  Algorithm could well stick here!!
+          N = I + rng_extreme(a, b);
+          if (N > obsTime)
+            break;
+        }
+      R = N + c;
+    }
+  else if (R == obsTime)
+    {
+      R = N + c;
     }
 
+  individuals.at(label).I = I;
+  individuals.at(label).N = N;
+  individuals.at(label).R = R;
 }
 
 
@@ -279,13 +300,133 @@ GillespieSim::loadDCData(const string filename)
       N = atof(tokens[1].c_str());
       R = atof(tokens[2].c_str());
 
-      //individuals.at(label).I = N;
-      individuals.at(label).N = N;
-      individuals.at(label).R = R;
-      individuals.at(label).isDC = true;
+      setDC(label, N, R);
     }
 }
 
+
+
+void
+GillespieSim::setDC(const size_t label, const double N, const double R)
+{
+  //! Sets a Dangerous Contact cull
+
+  //individuals.at(label).I = N;
+  individuals.at(label).N = N;
+  individuals.at(label).R = R;
+  individuals.at(label).isDC = true;
+}
+
+
+
+void
+GillespieSim::shareCovariates(const GillespieSim& source)
+{
+  //! Uses the covariates loaded by source.  The contact networks
+  //! are shared, the species and spatial kernel caches are copied
+  //! as they depend on the parameters.
+
+  if (source.init_done != 1)
+    throw logic_error("Sharing covariates before they are loaded");
+  if (source.N_total != N_total)
+    throw logic_error("Sharing covariates between populations of different size");
+
+  network = source.network;
+  species = source.species;
+  spatialKernel = source.spatialKernel;
+  init_done = 1;
+}
+
+
+
+void
+GillespieSim::setCTOutput(const bool ctOutput)
+{
+  //! Switches recording of contacts on or off
+  this->ctOutput = ctOutput;
+}
+
+
+void
+GillespieSim::setTauLeap(const double tolerance, const size_t exactThreshold)
+{
+  //! Switches to approximate tau-leaping if tolerance > 0.  Leaps
+  //! are limited so that the expected number of infections in each
+  //! is at most tolerance times the number of infectious premises,
+  //! and so that no infectivity changes by more than tolerance.
+  //! Exact steps are used while there are fewer than exactThreshold
+  //! susceptible or infectious premises.  No contacts are recorded
+  //! during leaps.
+
+  tauTolerance = tolerance;
+  tauExactThreshold = exactThreshold;
+}
+
+
+
+void
+GillespieSim::setTrace(EventTrace* trace, const uint32_t run)
+{
+  //! Records contacts, infections, notifications and removals to
+  //! trace, tagged with run.  Sources of tau-leap infections are not
+  //! known, so their sender is EVENTTRACE_NONE.
+
+  this->trace = trace;
+  traceRun = run;
+}
+
+
+
+void
+GillespieSim::traceEvent(const EventTrace::event_e event,
+    const CONTACT& contact, const double h)
+{
+  if (trace)
+    trace->record(event, contact.sender ? contact.sender->label
+        : EVENTTRACE_NONE, contact.receiver->label, contact.method,
+        contact.time, h, traceRun);
+}
+
+
+
+void
+GillespieSim::traceEvent(const EventTrace::event_e event,
+    const Individual* indiv)
+{
+  if (trace)
+    trace->record(event, EVENTTRACE_NONE, indiv->label, OTHER, curr_time,
+        0.0, traceRun);
+}
+
+
+
+void
+GillespieSim::setObserver(Observer* observer)
+{
+  //! Passes events to observer as they happen.  The observer is
+  //! not owned by the simulation.  NULL removes it.
+  this->observer = observer;
+}
+
+
+
+void
+GillespieSim::setStoreResults(const bool storeResults)
+{
+  //! Switches storing of events for getResults() on or off
+  this->storeResults = storeResults;
+}
+
+
+
+void
+GillespieSim::setVerbose(const bool verbose)
+{
+  //! Switches progress messages on or off.  Turn them off for
+  //! replicates and when simulating from several threads.
+  this->verbose = verbose;
+}
+
 void
 GillespieSim::addInfection(const size_t label, const double I)
 {
@@ -313,6 +454,26 @@ GillespieSim::simulate(vector<double>& transmissionParms, const double my_a,
 {
   // Runs an epidemic from scratch with a randomly assigned I1
 
+  prepare(transmissionParms, my_a, my_b, my_c);
+  execute(); // Execute the simulation
+}
+
+void
+GillespieSim::simulate(const Snapshot& state)
+{
+  //! Runs an epidemic from a state captured by snapshot()
+
+  restore(state);
+  execute();
+}
+
+void
+GillespieSim::prepare(vector<double>& transmissionParms, const double my_a,
+    const double my_b, const double my_c)
+{
+  //! Sets up the parameters, event queues and contact rates at the
+  //! start time without simulating
+
   if (init_done != 1)
     {
       throw logic_error("Fatal error: AI_sim::run  called before AI_sim::init");
@@ -321,27 +482,32 @@ GillespieSim::simulate(vector<double>& transmissionParms, const double my_a,
   // Decls
   Population::iterator itIndiv;
 
-  // Switch on ctOutput
-  ctOutput = true;
   numFMInfecs = 0;
   numFMNonInfecs = 0;
   numSHInfecs = 0;
   numSHNonInfecs = 0;
   numOtherInfecs = 0;
+  eventCount = 0;
+  result.clear();
 
   // Parameters
   beta = transmissionParms;
+  spatialKernel.prepare(beta[ModelTraits::RHO]);
+  species.setSusceptibility(&beta[ModelTraits::SPECIES], ModelTraits::numSpecies);
   a = my_a;
   b = my_b;
   c = my_c;
 
-  for (size_t h = 0; h < NPARMS; ++h)
+  if (verbose)
     {
-      cout << "Beta" << h << ": " << beta[h] << endl;
+      for (size_t h = 0; h < NPARMS; ++h)
+        {
+          cout << "Beta" << h << ": " << beta[h] << endl;
+        }
+      cout << "a: " << a << endl;
+      cout << "b: " << b << endl;
+      cout << "c: " << c << endl;
     }
-  cout << "a: " << a << endl;
-  cout << "b: " << b << endl;
-  cout << "c: " << c << endl;
 
   // Set up initial event queues
   infective.clear();
@@ -403,7 +569,8 @@ GillespieSim::simulate(vector<double>& transmissionParms, const double my_a,
       itIndiv++;
     }
 
-  cout << "Simulating from model........." << endl;
+  if (verbose)
+    cout << "Simulating from model........." << endl;
 
 
   // Set curr_time
@@ -412,9 +579,103 @@ GillespieSim::simulate(vector<double>& transmissionParms, const double my_a,
   // Set up contact index
   contactCDFInit();
   contactCDF = contactCDFCached;
+  prepared = true;
+}
 
-  execute(); // Execute the simulation
+boost::shared_ptr<const GillespieSim::Snapshot>
+GillespieSim::snapshot() const
+{
+  //! Captures the state set up by prepare().  Event queues are
+  //! stored by label so that the snapshot can be restored into any
+  //! simulation sharing the same covariates.
+
+  if (!prepared)
+    throw logic_error("Snapshot taken before prepare or after simulation");
+
+  boost::shared_ptr<Snapshot> state(new Snapshot);
+  state->individuals = individuals;
+  state->contactCDF.reserve(contactCDF.size());
+  for (B_INDEX::const_iterator it = contactCDF.begin(); it != contactCDF.end(); ++it)
+    state->contactCDF.push_back(make_pair(it->first, it->second->label));
+  for (B_INDEX::const_iterator it = infective.begin(); it != infective.end(); ++it)
+    state->infective.push_back(make_pair(it->first, it->second->label));
+  for (B_INDEX::const_iterator it = notified.begin(); it != notified.end(); ++it)
+    state->notified.push_back(make_pair(it->first, it->second->label));
+  state->S = S;
+  state->R = R;
+  state->startTime = startTime;
+  state->sum_beta = sum_beta;
+  state->beta = beta;
+  state->a = a;
+  state->b = b;
+  state->c = c;
+  for (ContactData::const_iterator it = contactData.begin(); it
+      != contactData.end(); ++it)
+    if (it->second->hasContacts())
+      state->contacts.push_back(make_pair(it->first, *it->second));
+
+  return state;
+}
 
+void
+GillespieSim::restore(const Snapshot& state)
+{
+  //! Returns to a state captured by snapshot() in O(N), without
+  //! reloading epi data or recalculating contact rates.  The
+  //! captured indices are sorted, so each map insert is at the end.
+
+  if (init_done != 1)
+    throw logic_error("Restoring a snapshot before covariates are loaded");
+  if (state.individuals.size() != N_total)
+    throw logic_error("Restoring a snapshot from a population of different size");
+
+  numFMInfecs = 0;
+  numFMNonInfecs = 0;
+  numSHInfecs = 0;
+  numSHNonInfecs = 0;
+  numOtherInfecs = 0;
+  eventCount = 0;
+  result.clear();
+
+  beta = state.beta;
+  spatialKernel.prepare(beta[ModelTraits::RHO]);
+  species.setSusceptibility(&beta[ModelTraits::SPECIES], ModelTraits::numSpecies);
+  a = state.a;
+  b = state.b;
+  c = state.c;
+
+  individuals = state.individuals;
+  contactCDF.clear();
+  for (Snapshot::Index::const_iterator it = state.contactCDF.begin(); it
+      != state.contactCDF.end(); ++it)
+    contactCDF.insert(contactCDF.end(), make_pair(it->first,
+        &individuals[it->second]));
+  infective.clear();
+  for (Snapshot::Index::const_iterator it = state.infective.begin(); it
+      != state.infective.end(); ++it)
+    infective.insert(infective.end(), make_pair(it->first,
+        &individuals[it->second]));
+  notified.clear();
+  for (Snapshot::Index::const_iterator it = state.notified.begin(); it
+      != state.notified.end(); ++it)
+    notified.insert(notified.end(), make_pair(it->first,
+        &individuals[it->second]));
+
+  S = state.S;
+  R = state.R;
+  startTime = state.startTime;
+  curr_time = startTime;
+  sum_beta = state.sum_beta;
+
+  // Contact tracing, so that replicates do not accumulate contacts
+  for (ContactData::iterator it = contactData.begin(); it
+      != contactData.end(); ++it)
+    it->second->clear();
+  for (vector<pair<int, XmlCTData> >::const_iterator it =
+      state.contacts.begin(); it != state.contacts.end(); ++it)
+    contactData[it->first]->assign(it->second);
+
+  prepared = true;
 }
 
 void
@@ -440,6 +701,7 @@ void
 GillespieSim::resetEpidemic()
 {
   //! Resets the epidemic data only
+  prepared = false;
   S = 0;
   infective.clear();
   notified.clear();
@@ -452,6 +714,8 @@ GillespieSim::resetCTData()
 {
   // (Re)initialize CT data
   Population::iterator itIndiv = individuals.begin();
+  for (ContactData::iterator it = contactData.begin(); it != contactData.end(); ++it)
+    delete it->second;
   contactData.clear();
   while (itIndiv != individuals.end())
     {
@@ -505,8 +769,18 @@ GillespieSim::writeCTToFile(const string filename, const bool censored)
 {
   //! Writes the contact tracing data to filename
 
-  // First empty the DOM
+  // First empty the DOM, then stream each block out as it is published
   contactWriter->resetDOM();
+  try
+    {
+      contactWriter->open(filename);
+    }
+  catch (const exception& e)
+    {
+      string msg = "Error opening contact tracing output: " + string(
+          e.what());
+      throw EpiRisk::output_exception(msg.c_str());
+    }
 
   Population::iterator itPopn = individuals.begin();
   while(itPopn != individuals.end()) {
@@ -532,6 +806,10 @@ GillespieSim::writeCTToFile(const string filename, const bool censored)
       throw EpiRisk::output_exception(msg.c_str());
     }
 
+  // Summary comments only make sense in XML output
+  if (CTStreamWriter::formatFromFilename(filename) != CTStreamWriter::XMLFORMAT)
+    return;
+
   ofstream output;
   output.open(filename.c_str(), ios::app);
   output << "\n<!-- Num FM infecs: " << numFMInfecs << "-->\n";
@@ -551,6 +829,23 @@ GillespieSim::totalSize()
 }
 
 
+size_t
+GillespieSim::numEvents() const
+{
+  //! Returns the number of events, including non-infectious
+  //! contacts, in the last simulation
+  return eventCount;
+}
+
+
+const vector<GillespieSim::result_row>&
+GillespieSim::getResults() const
+{
+  //! Returns the infection, notification and removal events
+  return result;
+}
+
+
 bool
 GillespieSim::isEpidemicOver()
 {
@@ -569,8 +864,7 @@ GillespieSim::fmRate(const size_t& i, const size_t& j)
 {
   // Rate at which contacts occur via feed mills
 
-  return fm_Mat.isConn(i, j) * 10 * (0.5 * cFreq.at(j).fm * (3
-      / (cFreq.at(j).fm_N)));
+  return ModelTraits::ctMultiplier() * Rates::fmContact(*network, i, j);
 }
 
 inline double
@@ -578,7 +872,7 @@ GillespieSim::fmInfecRate(const size_t& i, const size_t& j)
 {
   // Rate at which infections occur via feed mills
 
-  return beta[1] * fmRate(i, j);
+  return beta[ModelTraits::BETA_FM] * fmRate(i, j);
 }
 
 inline double
@@ -586,7 +880,7 @@ GillespieSim::shRate(const size_t& i, const size_t& j)
 {
   // Rate at which slaughterhouse contacts occur
 
-  return sh_Mat.isConn(i, j) * 10 * (0.5 * cFreq[j].sh * (3 / (cFreq[j].sh_N)));
+  return ModelTraits::ctMultiplier() * Rates::shContact(*network, i, j);
 }
 
 inline double
@@ -594,7 +888,7 @@ GillespieSim::shInfecRate(const size_t& i, const size_t& j)
 {
   // Slaughterhouse contact freq between i and j
 
-  return beta[2] * shRate(i, j);
+  return beta[ModelTraits::BETA_SH] * shRate(i, j);
 }
 
 inline double
@@ -602,7 +896,7 @@ GillespieSim::cpInfecRate(const size_t& i, const size_t& j)
 {
   // Company contact freq - currently either 0 or 1
 
-  return beta[3] * cp_Mat.isConn(i, j);
+  return Rates::company(&beta[0], *network, i, j);
 }
 
 inline double
@@ -610,7 +904,8 @@ GillespieSim::spatialRateI(const size_t& i, const size_t& j)
 {
   // Spatial infection rate if i infected
 
-  return beta[4] * exp(-beta[6] * (*(rho + i + N_total * j) - 5));
+  return beta[ModelTraits::BETA_SPATIAL_I] * spatialKernel.at(i, j,
+      beta[ModelTraits::RHO]);
 }
 
 inline double
@@ -618,7 +913,7 @@ GillespieSim::spatialRateN(const size_t& i, const size_t& j)
 {
   // Spatial infection rate if i infected
 
-  return beta[5] * exp(-beta[6] * (*(rho + i + N_total * j) - 5));
+  return Rates::notified(&beta[0], spatialKernel, i, j);
 }
 
 inline double
@@ -633,26 +928,13 @@ GillespieSim::betaij(const size_t i, const size_t j)
       throw range_error(errMsg);
     }
 
-  // Feed Mills
-  betaij += fmRate(i, j);
-
-  // Slaughterhouse
-  betaij += shRate(i, j);
-
-  // Company
-  betaij += cpInfecRate(i, j);
-
-  // Spatial
-  betaij += spatialRateI(i, j);
+  // Contacts via feed mills and slaughterhouses, company and spatial
+  // infections
+  betaij = Rates::infected(&beta[0], *network, spatialKernel, i, j,
+      ModelTraits::ctMultiplier(), ModelTraits::ctMultiplier());
 
   // Species susceptibility
-  for (size_t k = 7; k < NPARMS; ++k)
-    {
-      if (species.at(j, k - 7) == 1)
-        {
-          betaij *= beta[k];
-        }
-    }
+  betaij *= species.susceptibility(j);
 
   return betaij;
 }
@@ -668,13 +950,7 @@ GillespieSim::betaijstar(const size_t i, const size_t j)
   betaijstar += spatialRateN(i, j);
 
   // Species
-  for (size_t k = 7; k < NPARMS; ++k)
-    {
-      if (species.at(j, k - 7) == 1)
-        {
-          betaijstar *= beta[k];
-        }
-    }
+  betaijstar *= species.susceptibility(j);
 
   return betaijstar;
 }
@@ -682,14 +958,7 @@ GillespieSim::betaijstar(const size_t i, const size_t j)
 inline double
 GillespieSim::speciesj(const size_t& j)
 {
-  for (size_t k = 7; k < NPARMS; ++k)
-    {
-      if (species.at(j, k - 7) == 1)
-        {
-          return beta[k];
-        }
-    }
-  return 1.0;
+  return species.susceptibility(j);
 }
 
 double
@@ -729,8 +998,7 @@ GillespieSim::hFunc(const double t)
     {
       throw logic_error("t < 0 in hFunc!");
     }
-  double expg = exp(g * t);
-  return expg / (f + expg);
+  return kernel.h(t);
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -748,6 +1016,7 @@ GillespieSim::freqInit(const string filename)
   char *element_ptr;
   frequencies freqRow;
 
+  vector<frequencies>& cFreq = network->cFreq;
   cFreq.clear();
 
   datafile.open(filename.c_str(), ios::in);
@@ -845,6 +1114,8 @@ GillespieSim::distanceInit(const string filename)
 
   datafile.close();
 
+  spatialKernel.setDistances(rho, N_total);
+
   return (0);
 }
 
@@ -854,6 +1125,7 @@ GillespieSim::contactCDFInit()
   // Initialises the cached contactCDF
 
   sum_beta = 0.0;
+  contactCDFCached.clear();
   vector<Individual>::iterator itReceiver = individuals.begin();
   vector<Individual>::iterator itSender;
   while (itReceiver != individuals.end())
@@ -864,7 +1136,7 @@ GillespieSim::contactCDFInit()
         continue;
       }
 
-      sum_beta += beta[0];
+      sum_beta += beta[ModelTraits::BETA0];
       itSender = individuals.begin();
       while (itSender != individuals.end())
         {
@@ -895,13 +1167,13 @@ GillespieSim::execute()
 {
   // Now we begin our simulation loop
 
+  prepared = false; // The state moves on from here
 
-  CONTACT contact;
-  double eventTime;
-  EVENTTYPE eventType;
-  Individual* pEventIndiv;
+  if (observer)
+    observer->start(currentState());
 
-  cout << "Here we go...." << endl;
+  if (verbose)
+    cout << "Here we go...." << endl;
   while (1)
     {
 
@@ -911,91 +1183,25 @@ GillespieSim::execute()
       if (notified.size() + R > maxN)
         break;
 
+      if (observer && observer->done())
+        break;
+
       if (infective.empty() && notified.empty())
         {
-          cout << "No infectives or notifieds left.  Epidemic over :-) "
-              << endl;
+          if (verbose)
+            cout << "No infectives or notifieds left.  Epidemic over :-) "
+                << endl;
           break;
         }
 
-      eventTime = GSL_POSINF;
-
-      // First we calculate time to next contact
-      if (S + infective.size() + notified.size() != 0)
-        { // If we have possible contacts
-          eventTime = getTimeToNextContact() + curr_time;
-          contact.receiver = getReceiver();
-          contact.sender = getSender(contact.receiver);
-          contact.method = getContactMethod(contact.sender, contact.receiver);
-          contact.time = eventTime;
-
-          // Work out if this contact was infectious
-          if (isInfectious(contact))
-            eventType = INFECTIONEVENT;
-          else
-            eventType = CONTACTEVENT;
-
-          pEventIndiv = contact.receiver;
-        }
-
-      // Evaluate Time to next Notification
-      B_INDEX::iterator itInfective = infective.begin();
-      if (itInfective->first < eventTime && !infective.empty())
+      if (tauTolerance > 0.0 && (size_t) S >= tauExactThreshold
+          && infective.size() + notified.size() >= tauExactThreshold)
         {
-          eventTime = itInfective->first;
-          eventType = NOTIFICATIONEVENT;
-          pEventIndiv = itInfective->second;
-        }
-
-      // Evaluate Time to next Removal
-      B_INDEX::iterator itNotified = notified.begin();
-      if (itNotified->first < eventTime && !notified.empty())
-        {
-          eventTime = itNotified->first;
-          eventType = REMOVALEVENT;
-          pEventIndiv = itNotified->second;
+          if (!leap())
+            break; // Reached maxTime
         }
-
-      // We see which event has occurred first, and update the corresponding populations
-      assert(eventTime > curr_time);
-      curr_time = eventTime; // Update current time
-
-      switch (eventType)
-        {
-
-      case CONTACTEVENT:
-        assert(contact.receiver->status != Individual::NOTIFIED); // No received contacts
-        assert(contact.receiver->status != Individual::REMOVED); // if after notification
-
-        if (contact.sender != NULL && contact.sender->status
-            == Individual::INFECTED)
-          addContact(contact, false);
-        break;
-
-      case INFECTIONEVENT:
-        infect(pEventIndiv);
-        addContact(contact, true);
-        break;
-
-      case NOTIFICATIONEVENT:
-        notify(pEventIndiv);
-        //publishContacts(pEventIndiv,pEventIndiv->N - CT_PERIOD);
-        break;
-
-      case REMOVALEVENT:
-        remove(pEventIndiv);
-        break;
-
-      default:
-        //BP
-        throw logic_error("No such event!");
-
-        }
-
-      // Update sum_beta
-      sum_beta = beta_max();
-
-      addResult(eventType, pEventIndiv);
+      else
+        step();
 
       //cout << "\r" << curr_time;
 
@@ -1011,7 +1217,7 @@ GillespieSim::execute()
           throw logic_error(errMsg);
         }
 
-      if (S + infective.size() != contactCDF.size())
+      if (verbose && S + infective.size() != contactCDF.size())
         {
           cout << "S+infective.size() != contactCDF.size() in "
               << __PRETTY_FUNCTION__ << endl;
@@ -1019,13 +1225,278 @@ GillespieSim::execute()
 
     } // while(1)
 
-  cout << endl;
+  if (verbose)
+    {
+      cout << endl;
+      //cout << "Finished running model" << endl;
+      cout << R << " individuals removed out of " << N_total << endl;
+    }
 
-  //cout << "Finished running model" << endl;
-  cout << R << " individuals removed out of " << N_total << endl;
+  if (observer)
+    observer->finish(currentState());
 
 }
 
+void
+GillespieSim::step()
+{
+  // Simulates the next event exactly, including non-infectious contacts
+
+  CONTACT contact;
+  double eventTime;
+  EVENTTYPE eventType;
+  Individual* pEventIndiv;
+
+  eventTime = GSL_POSINF;
+
+  // First we calculate time to next contact
+  if (!contactCDF.empty())
+    { // If we have possible contacts
+      eventTime = getTimeToNextContact() + curr_time;
+      contact.receiver = getReceiver();
+      contact.sender = getSender(contact.receiver);
+      contact.method = getContactMethod(contact.sender, contact.receiver);
+      contact.time = eventTime;
+
+      // Work out if this contact was infectious
+      if (isInfectious(contact))
+        eventType = INFECTIONEVENT;
+      else
+        eventType = CONTACTEVENT;
+
+      pEventIndiv = contact.receiver;
+    }
+
+  // Evaluate Time to next Notification
+  B_INDEX::iterator itInfective = infective.begin();
+  if (!infective.empty() && itInfective->first < eventTime)
+    {
+      eventTime = itInfective->first;
+      eventType = NOTIFICATIONEVENT;
+      pEventIndiv = itInfective->second;
+    }
+
+  // Evaluate Time to next Removal
+  B_INDEX::iterator itNotified = notified.begin();
+  if (!notified.empty() && itNotified->first < eventTime)
+    {
+      eventTime = itNotified->first;
+      eventType = REMOVALEVENT;
+      pEventIndiv = itNotified->second;
+    }
+
+  // We see which event has occurred first, and update the corresponding populations
+  assert(eventTime > curr_time);
+  curr_time = eventTime; // Update current time
+
+  switch (eventType)
+    {
+
+  case CONTACTEVENT:
+    assert(contact.receiver->status != Individual::NOTIFIED); // No received contacts
+    assert(contact.receiver->status != Individual::REMOVED); // if after notification
+
+    if (contact.sender != NULL && contact.sender->status
+        == Individual::INFECTED)
+      addContact(contact, false);
+    break;
+
+  case INFECTIONEVENT:
+    infect(pEventIndiv);
+    addContact(contact, true);
+    break;
+
+  case NOTIFICATIONEVENT:
+    notify(pEventIndiv);
+    traceEvent(EventTrace::NOTIFICATION, pEventIndiv);
+    //publishContacts(pEventIndiv,pEventIndiv->N - CT_PERIOD);
+    break;
+
+  case REMOVALEVENT:
+    remove(pEventIndiv);
+    traceEvent(EventTrace::REMOVAL, pEventIndiv);
+    break;
+
+  default:
+    //BP
+    throw logic_error("No such event!");
+
+    }
+
+  ++eventCount;
+
+  // Update sum_beta
+  sum_beta = beta_max();
+
+  addResult(eventType, pEventIndiv);
+}
+
+void
+GillespieSim::addLeapPressure(const size_t i, const double weight,
+    const bool isInfected, vector<double>& pressure)
+{
+  // Adds weight times the infection rates from source i to pressure,
+  // visiting only i's spatial and network neighbours
+
+  double rate = beta[isInfected ? ModelTraits::BETA_SPATIAL_I
+      : ModelTraits::BETA_SPATIAL_N] * weight;
+  const uint32_t* targets = spatialKernel.targets(i);
+  const double* values = spatialKernel.values(i, beta[ModelTraits::RHO]);
+  for (size_t k = 0; k < spatialKernel.degree(i); ++k)
+    pressure[targets[k]] += rate * (values ? values[k] : spatialKernel.at(i,
+        targets[k], beta[ModelTraits::RHO]));
+
+  if (!isInfected)
+    return;
+
+  vector<int> conns;
+  if (ModelTraits::feedMill)
+    {
+      network->fm_Mat.connections(i, conns);
+      for (size_t k = 0; k < conns.size(); ++k)
+        if (conns[k] != (int) i)
+          pressure[conns[k]] += weight * fmInfecRate(i, conns[k]);
+    }
+  if (ModelTraits::slaughterhouse)
+    {
+      network->sh_Mat.connections(i, conns);
+      for (size_t k = 0; k < conns.size(); ++k)
+        if (conns[k] != (int) i)
+          pressure[conns[k]] += weight * shInfecRate(i, conns[k]);
+    }
+  if (ModelTraits::company)
+    {
+      network->cp_Mat.connections(i, conns);
+      for (size_t k = 0; k < conns.size(); ++k)
+        if (conns[k] != (int) i)
+          pressure[conns[k]] += weight * cpInfecRate(i, conns[k]);
+    }
+}
+
+bool
+GillespieSim::leap()
+{
+  // Advances time by a leap tau in which the infection hazards are
+  // held at their values at the start.  Each susceptible has a
+  // Poisson number of infectious contacts over the leap, and is
+  // infected at a uniform time in it if there are any.  Leaps end at
+  // the next notification or removal, and are short enough that the
+  // expected number of infections is at most tauTolerance times the
+  // number of infectious premises, and that no infectivity h changes
+  // by more than a fraction tauTolerance.  Returns false at maxTime.
+  //
+  // As in step(), DCs that are still susceptible can be infected.
+
+  double leapEnd = maxTime;
+  if (!infective.empty())
+    leapEnd = min(leapEnd, infective.begin()->first);
+  if (!notified.empty())
+    leapEnd = min(leapEnd, notified.begin()->first);
+
+  // Pressure on every premises at the start of the leap, built from
+  // each source's neighbours.  h grows at relative rate g(1 - h), so
+  // the youngest infective bounds the leap.
+  vector<double> pressure(N_total, 0.0);
+  double hRate = 0.0;
+  for (B_INDEX::const_iterator it = infective.begin(); it != infective.end(); ++it)
+    {
+      double h = hFunc(curr_time - it->second->I);
+      hRate = max(hRate, g * (1.0 - h));
+      addLeapPressure(it->second->label, h, true, pressure);
+    }
+  for (B_INDEX::const_iterator it = notified.begin(); it != notified.end(); ++it)
+    addLeapPressure(it->second->label, 1.0, false, pressure);
+  size_t numSources = infective.size() + notified.size();
+
+  if (hRate > 0.0)
+    leapEnd = min(leapEnd, curr_time + tauTolerance / hRate);
+
+  vector<pair<Individual*, double> > hazards;
+  double totalHazard = 0.0;
+  for (Population::iterator itIndiv = individuals.begin(); itIndiv
+      != individuals.end(); ++itIndiv)
+    {
+      if (itIndiv->status != Individual::SUSCEPTIBLE)
+        continue;
+
+      size_t j = itIndiv->label;
+      double hazard = beta[ModelTraits::BETA0] + species.susceptibility(j)
+          * pressure[j];
+      hazards.push_back(make_pair(&(*itIndiv), hazard));
+      totalHazard += hazard;
+    }
+
+  if (totalHazard > 0.0)
+    leapEnd = min(leapEnd, curr_time + tauTolerance
+        * numSources / totalHazard);
+
+  // Infections in the leap, in time order
+  double tau = leapEnd - curr_time;
+  vector<pair<double, Individual*> > infections;
+  if (tau > 0.0)
+    for (size_t k = 0; k < hazards.size(); ++k)
+      if (gsl_ran_poisson(rng, hazards[k].second * tau) > 0)
+        infections.push_back(make_pair(curr_time + gsl_rng_uniform(rng) * tau,
+            hazards[k].first));
+  sort(infections.begin(), infections.end());
+
+  for (size_t k = 0; k < infections.size(); ++k)
+    {
+      processScheduled(infections[k].first);
+      curr_time = infections[k].first;
+      infect(infections[k].second);
+      if (trace)
+        trace->record(EventTrace::INFECTION, EVENTTRACE_NONE,
+            infections[k].second->label, OTHER, curr_time, 0.0, traceRun);
+      ++eventCount;
+      addResult(INFECTIONEVENT, infections[k].second);
+    }
+
+  // Includes the notification or removal that ended the leap
+  processScheduled(nextafter(leapEnd, GSL_POSINF));
+  curr_time = max(curr_time, leapEnd);
+  sum_beta = beta_max();
+
+  return leapEnd < maxTime;
+}
+
+void
+GillespieSim::processScheduled(const double until)
+{
+  // Carries out notifications and removals due before until
+
+  while (1)
+    {
+      double tInfective = infective.empty() ? GSL_POSINF
+          : infective.begin()->first;
+      double tNotified = notified.empty() ? GSL_POSINF
+          : notified.begin()->first;
+      if (min(tInfective, tNotified) >= until)
+        break;
+
+      Individual* pIndiv;
+      EVENTTYPE eventType;
+      if (tInfective < tNotified)
+        {
+          curr_time = tInfective;
+          pIndiv = infective.begin()->second;
+          notify(pIndiv);
+          traceEvent(EventTrace::NOTIFICATION, pIndiv);
+          eventType = NOTIFICATIONEVENT;
+        }
+      else
+        {
+          curr_time = tNotified;
+          pIndiv = notified.begin()->second;
+          remove(pIndiv);
+          traceEvent(EventTrace::REMOVAL, pIndiv);
+          eventType = REMOVALEVENT;
+        }
+      ++eventCount;
+      addResult(eventType, pIndiv);
+    }
+}
+
 /////////////////////////////////////////////////////////////////////////////////
 // Stochastic methods ///////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////
@@ -1063,7 +1534,7 @@ GillespieSim::getSender(const Individual* const pReceiver)
   // Construct CDF
 
   // Do \beta_0 infection
-  sum_i += beta[0];
+  sum_i += beta[ModelTraits::BETA0];
   infector.insert(pair<double, Individual*> (sum_i, NULL));
 
   // Now the rest of the CDF
@@ -1165,6 +1636,7 @@ GillespieSim::isInfectious(const CONTACT& contact)
   // Cannot be infected if receiver not susceptible
   if (contact.receiver->status != Individual::SUSCEPTIBLE)
     {
+      traceEvent(EventTrace::CONTACT, contact, 0.0);
       return false;
     }
 
@@ -1176,29 +1648,24 @@ GillespieSim::isInfectious(const CONTACT& contact)
 
       if (contact.sender->status == Individual::SUSCEPTIBLE)
         {
+          traceEvent(EventTrace::CONTACT, contact, 0.0);
           return false; // Can't be infected from a susceptible
         }
       else if (contact.sender->status == Individual::INFECTED)
         {
-          double infectiousness;
-          infectiousness = hFunc(contact.time - contact.sender->I);
+          double h = hFunc(contact.time - contact.sender->I);
+          double infectiousness = h;
 
           // Modify for FEEDMILL and SHOUSE
           if (contact.method == FEEDMILL)
-            infectiousness *= beta[1];
+            infectiousness *= beta[ModelTraits::BETA_FM];
           else if (contact.method == SHOUSE)
-            infectiousness *= beta[2];
+            infectiousness *= beta[ModelTraits::BETA_SH];
 
           // Choose whether we have an infection:
           if (gsl_ran_flat(rng, 0, 1) < infectiousness)
             {
-              if (hFuncOut.is_open())
-                {
-                  hFuncOut << contact.receiver->label << " "
-                      << contact.sender->label << " " << contact.method << " "
-                      << hFunc(contact.time - contact.sender->I) << " 1"
-                      << endl;
-                }
+              traceEvent(EventTrace::INFECTION, contact, h);
               if (contact.method == FEEDMILL)
                 numFMInfecs++;
               else if (contact.method == SHOUSE)
@@ -1207,13 +1674,7 @@ GillespieSim::isInfectious(const CONTACT& contact)
             }
           else
             {
-              if (hFuncOut.is_open())
-                {
-                  hFuncOut << contact.receiver->label << " "
-                      << contact.sender->label << " " << contact.method << " "
-                      << hFunc(contact.time - contact.sender->I) << " 0"
-                      << endl;
-                }
+              traceEvent(EventTrace::CONTACT, contact, h);
               if (contact.method == FEEDMILL)
                 numFMNonInfecs++;
               else if (contact.method == SHOUSE)
@@ -1223,11 +1684,13 @@ GillespieSim::isInfectious(const CONTACT& contact)
         }
       else
         { // NOTIFIED
+          traceEvent(EventTrace::INFECTION, contact, 1.0);
           return true;
         }
     }
   else
     { // \beta_0 infection
+      traceEvent(EventTrace::INFECTION, contact, 0.0);
       return true;
     }
   cout << "Outside if statement in " << __PRETTY_FUNCTION__ << endl;
@@ -1362,10 +1825,7 @@ GillespieSim::notify(Individual* const pInfection)
         "Duplicate key during insertion to notified index in function notify");
 
   // Update sum_beta
-
-  itLocal = contactCDF.end();
-  itLocal--;
-  sum_beta = itLocal->first;
+  sum_beta = beta_max();
 
   return;
 }
@@ -1411,7 +1871,7 @@ void
 GillespieSim::addResult(EVENTTYPE event, Individual* pIndiv)
 {
 
-  struct result_row newRow;
+  struct result_row newRow = currentState();
 
   if (event == INFECTIONEVENT)
     newRow.event = 'i';
@@ -1422,15 +1882,31 @@ GillespieSim::addResult(EVENTTYPE event, Individual* pIndiv)
   else
     return;
 
-  newRow.event_time = curr_time;
   newRow.label = pIndiv->label;
-  newRow.S = S;
-  newRow.I = infective.size();
-  newRow.N = notified.size();
-  newRow.R = R;
 
-  result.push_back(newRow);
+  if (storeResults)
+    result.push_back(newRow);
+  if (observer)
+    observer->event(newRow);
+
+}
+
+GillespieSim::result_row
+GillespieSim::currentState() const
+{
+  // Returns the population state at the current time
+
+  struct result_row state;
+
+  state.event_time = curr_time;
+  state.label = -1;
+  state.event = ' ';
+  state.S = S;
+  state.I = infective.size();
+  state.N = notified.size();
+  state.R = R;
 
+  return state;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////
@@ -1446,7 +1922,7 @@ GillespieSim::addContact(CONTACT& contact, bool caused)
 
   // Don't add anything if we've a \beta_0 infection
   //   as no contact was made.
-  if (contact.sender == NULL)
+  if (contact.sender == NULL || !ctOutput)
     return;
 
   XmlCTData* myCTData = NULL;
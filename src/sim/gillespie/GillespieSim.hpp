@@ -36,11 +36,17 @@
 #include<map>
 #include<cassert>
 
+#include<boost/shared_ptr.hpp>
+
 // Custom headers
 #include "contactMatrix.h"
 #include "speciesMat.h"
 
 #include "XmlCTWriter.hpp"
+#include "EventTrace.hpp"
+#include "InfectivityKernel.hpp"
+#include "SpatialKernel.hpp"
+#include "ModelTraits.hpp"
 
 
 // Fwd decls
@@ -189,6 +195,14 @@ public:
   double getMaxTime();
   void loadDCData(const string filename);
   void addInfection(const size_t label, const double I);
+  void setObservedInfection(const size_t label, const double I, double N, double R,
+                            const double obsTime, const double a, const double b, const double c);
+  void setDC(const size_t label, const double N, const double R);
+
+  // Uses the covariates loaded by source rather than reloading them
+  void shareCovariates(const GillespieSim& source);
+  void setCTOutput(const bool ctOutput); // Records contacts if true (the default)
+  void setTauLeap(const double tolerance, const size_t exactThreshold = 10); // Approximate if tolerance > 0
 
 
   // Run the simulation
@@ -198,6 +212,31 @@ public:
                 const double my_c); // Run model
 
 
+  // State at the start of a simulation, for replicates
+  class Snapshot {
+    friend class GillespieSim;
+    typedef vector<pair<double,size_t> > Index; // Event time or CDF, label
+    Population individuals;
+    Index contactCDF;
+    Index infective;
+    Index notified;
+    int S,R;
+    double startTime;
+    double sum_beta;
+    vector<double> beta;
+    double a,b,c;
+    vector<pair<int,XmlCTData> > contacts; // Non-empty contact tracing data
+  };
+
+  void prepare(vector<double>& myBeta,
+               const double my_a,
+               const double my_b,
+               const double my_c); // Sets up the model without running it
+  boost::shared_ptr<const Snapshot> snapshot() const; // Captures the state set up by prepare()
+  void restore(const Snapshot& state); // Returns to a captured state
+  void simulate(const Snapshot& state); // Runs the model from a captured state
+
+
   // Reset the simulation
   void resetPopulation();
   void resetEpidemic();
@@ -210,6 +249,36 @@ public:
                       const bool includeDC = false) const; // Writes model output to a file
   void writeCTToFile(const string filename, const bool censored = false);
   bool isEpidemicOver();  // Returns true if the epidemic is over at the end of the simulation
+  size_t numEvents() const; // Returns the number of events in the last simulation, including contacts
+
+
+  struct result_row {      // Struct to hold a row of simulation output
+    double event_time;
+    int label;
+    char event;
+    int S;
+    int I;
+    int N;
+    int R;
+  };
+
+  const vector<result_row>& getResults() const; // Infection, notification and removal events of the last simulation
+
+
+  // Receives events from a simulation as they happen
+  class Observer {
+  public:
+    virtual ~Observer() {}
+    virtual void start(const result_row& state) {}  // State at the start time
+    virtual void event(const result_row& row) = 0;  // Infection, notification or removal
+    virtual void finish(const result_row& state) {} // State at the end of the simulation
+    virtual bool done() const { return false; }     // Stops the simulation early if true
+  };
+
+  void setObserver(Observer* observer); // Not owned, NULL for none
+  void setStoreResults(const bool storeResults); // Keeps events for getResults() if true (the default)
+  void setVerbose(const bool verbose); // Reports progress on stdout if true (the default)
+  void setTrace(EventTrace* trace, const uint32_t run = 0); // Not owned, NULL for none
 
 
   // Bit of maths
@@ -220,12 +289,22 @@ public:
 
 private:
 
+  typedef PairRates<ModelTraits> Rates; // See ModelTraits.hpp
+
   // XML bits
   XmlCTWriter* contactWriter;
   typedef map<int,XmlCTData*> ContactData;
   ContactData contactData;
 
   bool ctOutput;
+  bool prepared;       // True between prepare() or restore() and execute()
+  bool storeResults;
+  bool verbose;
+  Observer* observer;
+  double tauTolerance;  // Tau-leaping if > 0
+  size_t tauExactThreshold;
+  EventTrace* trace;
+  uint32_t traceRun;
 
 
   class frequencies {
@@ -244,9 +323,7 @@ private:
   double curr_time;     // The current time in the simulation
   bool init_done;      // Boolean to make sure we've called init before run
 
-  const size_t NPARMS;
-
-  ofstream hFuncOut;
+  static const size_t NPARMS = ModelTraits::numParms;
 
   size_t N_total;     // Total population size
   float *rho;         // Euclidean distance matrix
@@ -254,8 +331,11 @@ private:
   float *betastar_ij; // Transmission parms for N(i) -> S(j)
   double sum_beta;     // The sum of the transmission rates
 
-  contactMat fm_Mat,sh_Mat,cp_Mat;
-  vector<frequencies> cFreq;
+  struct Network {      // Contact networks, read only once loaded
+    contactMat fm_Mat,sh_Mat,cp_Mat;
+    vector<frequencies> cFreq;
+  };
+  boost::shared_ptr<Network> network;  // Shared between simulations
 
   size_t I1;
   double startTime;
@@ -265,6 +345,8 @@ private:
   double a,b,c,delta;        // Contains extreme value distn hazard rate and decay rate, time to cull, and kernel decay respectively
   const double f;
   const double g;
+  InfectivityKernel kernel;  // Tabulated h for f and g
+  SpatialKernel spatialKernel;  // Cached spatial kernel over rho
   vector<double> beta;  // Contains the betas
 
   size_t numFMInfecs;
@@ -272,6 +354,7 @@ private:
   size_t numSHInfecs;
   size_t numSHNonInfecs;
   size_t numOtherInfecs;
+  size_t eventCount;
 
 
   // Population storage
@@ -283,23 +366,21 @@ private:
   int S,R;
 
 
-  struct result_row {      // Struct to hold a row of simulation output
-    double event_time;
-    int label;
-    char event;
-    int S;
-    int I;
-    int N;
-    int R;
-  } newRow;
+  result_row newRow;
 
   vector<result_row> result;// Vector of structs (see above) - may require pointers and dynamic memory allocation
 
   void addResult(EVENTTYPE,Individual*); // Appends a row of results to the output
+  result_row currentState() const;
   int distanceInit(const string filename);
   int freqInit(const string filename);
   void contactCDFInit();
   void execute();
+  void step();
+  bool leap();
+  void addLeapPressure(const size_t i, const double weight,
+      const bool isInfected, vector<double>& pressure);
+  void processScheduled(const double until);
 
   // Maths methods
   double fmRate(const size_t&, const size_t&);
@@ -322,6 +403,8 @@ private:
   Individual* getSender(const Individual* const);
   CONTYPE getContactMethod(const Individual* const, const Individual* const);
   bool isInfectious(const CONTACT&);
+  void traceEvent(const EventTrace::event_e event, const CONTACT& contact, const double h);
+  void traceEvent(const EventTrace::event_e event, const Individual* indiv);
 
   // Population maintenance functions
   void infect(Individual*);
@@ -0,0 +1,266 @@
+/* ./src/sim/gillespie/SimSummary.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SimSummary.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ */
+
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+#include "SimSummary.hpp"
+#include "EpiRiskException.hpp"
+
+double
+SimSummary::Moments::mean(const size_t n) const
+{
+  return n > 0 ? sum / n : 0.0;
+}
+
+double
+SimSummary::Moments::sd(const size_t n) const
+{
+  if (n < 2)
+    return 0.0;
+  double var = (sumSq - sum * sum / n) / (n - 1);
+  return var > 0.0 ? sqrt(var) : 0.0;
+}
+
+SimSummary::SimSummary(const size_t popSize, const double startTime,
+    const double maxTime, const double binWidth, const bool trackPremises) :
+  popSize_(popSize), startTime_(startTime), maxTime_(maxTime), binWidth_(
+      binWidth), trackPremises_(trackPremises), numBins_(0)
+{
+  if (binWidth_ > 0.0)
+    {
+      if (!(maxTime_ - startTime_ < GSL_POSINF) || maxTime_ <= startTime_)
+        throw invalid_argument(
+            "Incidence bins need a finite maxTime after startTime");
+      numBins_ = (size_t) ceil((maxTime_ - startTime_) / binWidth_);
+    }
+
+  clear();
+}
+
+void
+SimSummary::clear()
+{
+  //! Forgets all replicates
+
+  numReplicates_ = 0;
+  finalSize_ = Moments();
+  peakIncidence_ = Moments();
+  duration_ = Moments();
+  binInfections_.assign(numBins_, Moments());
+  binNotifications_.assign(numBins_, Moments());
+  riskCount_.assign(trackPremises_ ? popSize_ : 0, 0);
+
+  initialInfected_ = 0;
+  newInfections_ = 0;
+  lastEvent_ = startTime_;
+  infections_.assign(numBins_, 0);
+  notifications_.assign(numBins_, 0);
+  peak_ = 0;
+  peakBin_ = 0;
+}
+
+size_t
+SimSummary::bin(const double time) const
+{
+  size_t b = (size_t) ((time - startTime_) / binWidth_);
+  return b < numBins_ ? b : numBins_ - 1;
+}
+
+void
+SimSummary::start(const GillespieSim::result_row& state)
+{
+  //! Starts a replicate
+
+  initialInfected_ = popSize_ - state.S;
+  newInfections_ = 0;
+  lastEvent_ = startTime_;
+  infections_.assign(numBins_, 0);
+  notifications_.assign(numBins_, 0);
+  peak_ = 0;
+  peakBin_ = 0;
+}
+
+void
+SimSummary::event(const GillespieSim::result_row& row)
+{
+  if (row.event_time > maxTime_)
+    return;
+
+  lastEvent_ = row.event_time;
+
+  if (row.event == 'i')
+    {
+      ++newInfections_;
+      if (numBins_ > 0)
+        ++infections_[bin(row.event_time)];
+      if (trackPremises_)
+        ++riskCount_.at(row.label);
+    }
+  else if (row.event == 'n')
+    {
+      if (numBins_ > 0)
+        ++notifications_[bin(row.event_time)];
+    }
+}
+
+void
+SimSummary::finish(const GillespieSim::result_row& state)
+{
+  //! Adds the replicate to the summaries
+
+  for (size_t b = 0; b < numBins_; ++b)
+    {
+      if (infections_[b] > peak_)
+        {
+          peak_ = infections_[b];
+          peakBin_ = b;
+        }
+      binInfections_[b].add(infections_[b]);
+      binNotifications_[b].add(notifications_[b]);
+    }
+
+  finalSize_.add(finalSize());
+  peakIncidence_.add(peak_);
+  duration_.add(duration());
+  ++numReplicates_;
+}
+
+void
+SimSummary::merge(const SimSummary& other)
+{
+  if (other.popSize_ != popSize_ || other.numBins_ != numBins_
+      || other.trackPremises_ != trackPremises_)
+    throw logic_error("Merging summaries with different settings");
+
+  numReplicates_ += other.numReplicates_;
+  finalSize_.merge(other.finalSize_);
+  peakIncidence_.merge(other.peakIncidence_);
+  duration_.merge(other.duration_);
+  for (size_t b = 0; b < numBins_; ++b)
+    {
+      binInfections_[b].merge(other.binInfections_[b]);
+      binNotifications_[b].merge(other.binNotifications_[b]);
+    }
+  for (size_t i = 0; i < riskCount_.size(); ++i)
+    riskCount_[i] += other.riskCount_[i];
+}
+
+size_t
+SimSummary::numReplicates() const
+{
+  return numReplicates_;
+}
+
+size_t
+SimSummary::finalSize() const
+{
+  return initialInfected_ + newInfections_;
+}
+
+size_t
+SimSummary::newInfections() const
+{
+  return newInfections_;
+}
+
+size_t
+SimSummary::peakIncidence() const
+{
+  return peak_;
+}
+
+double
+SimSummary::peakTime() const
+{
+  return startTime_ + peakBin_ * binWidth_;
+}
+
+double
+SimSummary::duration() const
+{
+  return lastEvent_ - startTime_;
+}
+
+void
+SimSummary::writeReplicateHeader(ostream& out)
+{
+  out << "final_size new_infections peak_incidence peak_time duration\n";
+}
+
+void
+SimSummary::writeReplicate(ostream& out) const
+{
+  out << finalSize() << " " << newInfections() << " " << peakIncidence()
+      << " " << peakTime() << " " << duration() << "\n";
+}
+
+void
+SimSummary::write(const string& prefix) const
+{
+  //! Writes means and standard deviations over replicates
+
+  string filename = prefix + ".summary";
+  ofstream summary(filename.c_str());
+  if (!summary.is_open())
+    throw EpiRisk::output_exception("Cannot open summary output file");
+  summary << "statistic mean sd\n";
+  summary << "final_size " << finalSize_.mean(numReplicates_) << " "
+      << finalSize_.sd(numReplicates_) << "\n";
+  summary << "peak_incidence " << peakIncidence_.mean(numReplicates_) << " "
+      << peakIncidence_.sd(numReplicates_) << "\n";
+  summary << "duration " << duration_.mean(numReplicates_) << " "
+      << duration_.sd(numReplicates_) << "\n";
+  summary << "replicates " << numReplicates_ << " 0\n";
+
+  if (numBins_ > 0)
+    {
+      filename = prefix + ".incidence";
+      ofstream incidence(filename.c_str());
+      if (!incidence.is_open())
+        throw EpiRisk::output_exception("Cannot open incidence output file");
+      incidence << "time infec_mean infec_sd notif_mean notif_sd\n";
+      for (size_t b = 0; b < numBins_; ++b)
+        incidence << startTime_ + b * binWidth_ << " "
+            << binInfections_[b].mean(numReplicates_) << " "
+            << binInfections_[b].sd(numReplicates_) << " "
+            << binNotifications_[b].mean(numReplicates_) << " "
+            << binNotifications_[b].sd(numReplicates_) << "\n";
+    }
+
+  if (trackPremises_)
+    {
+      filename = prefix + ".risk";
+      ofstream risk(filename.c_str());
+      if (!risk.is_open())
+        throw EpiRisk::output_exception("Cannot open risk output file");
+      for (size_t i = 0; i < riskCount_.size(); ++i)
+        risk << i << " " << (numReplicates_ > 0 ? (double) riskCount_[i]
+            / numReplicates_ : 0.0) << "\n";
+    }
+}
@@ -0,0 +1,115 @@
+/* ./src/sim/gillespie/SimSummary.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * SimSummary.hpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Accumulates summaries of GillespieSim replicates as the
+ *              events happen, so that no event rows need be stored.
+ *              Per replicate it keeps the final size, peak incidence and
+ *              duration; over replicates it keeps sums and sums of
+ *              squares of these and of incidence per time bin, and how
+ *              often each premises was infected.  Memory does not grow
+ *              with the number of replicates or events.
+ */
+
+#ifndef SIMSUMMARY_HPP_
+#define SIMSUMMARY_HPP_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "GillespieSim.hpp"
+
+using namespace std;
+
+class SimSummary : public GillespieSim::Observer
+{
+public:
+  // Events after maxTime are ignored.  binWidth <= 0 turns off the
+  // incidence bins, trackPremises = false the per-premises counts.
+  SimSummary(const size_t popSize, const double startTime,
+      const double maxTime, const double binWidth,
+      const bool trackPremises = true);
+
+  void start(const GillespieSim::result_row& state);
+  void event(const GillespieSim::result_row& row);
+  void finish(const GillespieSim::result_row& state);
+
+  // Adds the replicates of other, which must have the same settings
+  void merge(const SimSummary& other);
+  void clear();
+
+  size_t numReplicates() const;
+
+  // The last replicate
+  size_t finalSize() const;        // Ever infected, including at the start time
+  size_t newInfections() const;
+  size_t peakIncidence() const;    // Most infections in one bin
+  double peakTime() const;         // Start of that bin
+  double duration() const;         // Start time to last event
+
+  void writeReplicate(ostream& out) const; // One line for the last replicate
+  static void writeReplicateHeader(ostream& out);
+
+  // Writes <prefix>.summary, <prefix>.incidence and, if tracked,
+  // <prefix>.risk
+  void write(const string& prefix) const;
+
+private:
+  struct Moments
+  {
+    double sum, sumSq;
+    Moments() : sum(0.0), sumSq(0.0) {}
+    void add(const double x) { sum += x; sumSq += x * x; }
+    void merge(const Moments& other) { sum += other.sum; sumSq += other.sumSq; }
+    double mean(const size_t n) const;
+    double sd(const size_t n) const;
+  };
+
+  size_t popSize_;
+  double startTime_;
+  double maxTime_;
+  double binWidth_;
+  bool trackPremises_;
+  size_t numBins_;
+
+  // Current replicate
+  size_t initialInfected_;
+  size_t newInfections_;
+  double lastEvent_;
+  vector<unsigned int> infections_;
+  vector<unsigned int> notifications_;
+  size_t peak_;
+  size_t peakBin_;
+
+  // Over replicates
+  size_t numReplicates_;
+  Moments finalSize_, peakIncidence_, duration_;
+  vector<Moments> binInfections_, binNotifications_;
+  vector<unsigned int> riskCount_;
+
+  size_t bin(const double time) const;
+};
+
+#endif /* SIMSUMMARY_HPP_ */
@@ -0,0 +1,761 @@
+/* ./src/sim/gillespie/aiABC.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * aiABC.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Approximate Bayesian computation by sequential Monte
+ *              Carlo (Beaumont et al. 2009), with GillespieSim as the
+ *              forward model.  The data are the notification times in
+ *              an .ipt file, simulated from the earliest infection.
+ *
+ * Parameters with a prior ("lower upper" or "lower upper log") in the
+ * <priors> block are estimated, the rest are fixed at their values in
+ * <parameters>.  Generation 0 samples the prior.  Each later generation
+ * resamples the previous one, perturbs with a Gaussian kernel of twice
+ * the weighted variance, and accepts if the distance is within the
+ * tolerance, which is the alpha quantile of the previous generation's
+ * distances.
+ *
+ * The distance is Euclidean over the selected summaries of
+ * notifications before obstime, each scaled by max(1, observed):
+ *   total      number of notifications
+ *   incidence  notifications per bin of binwidth
+ *   peak       most notifications in one bin
+ * All three can only increase as a simulation runs, so a simulation
+ * is stopped as soon as its distance must exceed the tolerance.
+ *
+ * Particles are simulated in parallel.  Each particle has its own rng
+ * stream, seeded from the seed, generation and particle number, so
+ * results do not depend on the number of threads.
+ *
+ * Writes <output>.abc, one line per particle per generation.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <omp.h>
+
+#include "GillespieSim.hpp"
+#include "stlStrTok.hpp"
+
+#define NUMPARMS ModelTraits::numParms  // See ModelTraits.hpp
+
+static const char* parmNames[NUMPARMS] =
+  { "epsilon", "p1", "p2", "beta1", "beta2", "beta3", "psi", "eta2", "eta3",
+      "eta4", "eta5", "eta6", "eta7", "eta8", "eta9", "eta10" };
+
+struct Prior
+{
+  size_t index;       // Into the parameter vector
+  double lower, upper; // On the log scale if logScale
+  bool logScale;
+
+  double
+  toParm(const double x) const
+  {
+    return logScale ? exp(x) : x;
+  }
+  bool
+  contains(const double x) const
+  {
+    return lower <= x && x <= upper;
+  }
+};
+
+struct Settings
+{
+
+  size_t popSize;
+  size_t maxN;
+  double startTime, obsTime, binWidth;
+  int indexCase;
+
+  size_t particles, generations, maxAttempts;
+  double alpha, minTolerance, minAcceptance;
+
+  string dataPrefix;
+  string epiData;
+  string outputPrefix;
+
+  bool useTotal, useIncidence, usePeak;
+  double a, b, c;
+
+  vector<double> parms;  // Fixed values
+  vector<Prior> priors;
+
+  void
+  load(const string& filename)
+  {
+    using boost::property_tree::ptree;
+    ptree pt;
+
+    read_xml(filename, pt);
+
+    dataPrefix = pt.get<string> ("aiABC.paths.dataprefix");
+    epiData = pt.get<string> ("aiABC.paths.epidata");
+    outputPrefix = pt.get<string> ("aiABC.paths.outputprefix");
+
+    popSize = pt.get<size_t> ("aiABC.options.popsize");
+    maxN = pt.get<size_t> ("aiABC.options.maxN", popSize);
+    startTime = pt.get<double> ("aiABC.options.starttime", 0.0);
+    obsTime = pt.get<double> ("aiABC.options.obstime");
+    binWidth = pt.get<double> ("aiABC.options.binwidth", 7.0);
+    indexCase = pt.get<int> ("aiABC.options.indexcase", -1);
+    particles = pt.get<size_t> ("aiABC.options.particles", 1000);
+    generations = pt.get<size_t> ("aiABC.options.generations", 10);
+    maxAttempts = pt.get<size_t> ("aiABC.options.maxattempts", 100000);
+    alpha = pt.get<double> ("aiABC.options.alpha", 0.5);
+    minTolerance = pt.get<double> ("aiABC.options.mintolerance", 0.0);
+    minAcceptance = pt.get<double> ("aiABC.options.minacceptance", 0.0);
+
+    vector<string> tokens;
+    string summaries = pt.get<string> ("aiABC.options.summaries",
+        "total incidence");
+    stlStrTok(tokens, summaries, " ,");
+    useTotal = useIncidence = usePeak = false;
+    for (size_t k = 0; k < tokens.size(); ++k)
+      {
+        if (tokens[k] == "total")
+          useTotal = true;
+        else if (tokens[k] == "incidence")
+          useIncidence = true;
+        else if (tokens[k] == "peak")
+          usePeak = true;
+        else
+          throw runtime_error("Unknown summary statistic '" + tokens[k] + "'");
+      }
+
+    a = pt.get<double> ("aiABC.constants.a");
+    b = pt.get<double> ("aiABC.constants.b");
+    c = pt.get<double> ("aiABC.constants.c");
+
+    parms.assign(NUMPARMS, 0.0);
+    priors.clear();
+    for (size_t k = 0; k < NUMPARMS; ++k)
+      {
+        boost::optional<string> prior = pt.get_optional<string> (
+            string("aiABC.priors.") + parmNames[k]);
+        if (prior)
+          {
+            stlStrTok(tokens, *prior, " ");
+            if (tokens.size() < 2 || tokens.size() > 3 || (tokens.size()
+                == 3 && tokens[2] != "log"))
+              throw runtime_error(string("Prior for ") + parmNames[k]
+                  + " should be 'lower upper' or 'lower upper log'");
+            Prior p;
+            p.index = k;
+            p.logScale = tokens.size() == 3;
+            p.lower = atof(tokens[0].c_str());
+            p.upper = atof(tokens[1].c_str());
+            if (p.logScale)
+              {
+                if (p.lower <= 0.0)
+                  throw runtime_error(string("Log prior for ") + parmNames[k]
+                      + " needs lower > 0");
+                p.lower = log(p.lower);
+                p.upper = log(p.upper);
+              }
+            if (!(p.lower < p.upper))
+              throw runtime_error(string("Prior for ") + parmNames[k]
+                  + " needs lower < upper");
+            priors.push_back(p);
+          }
+        else
+          parms[k] = pt.get<double> (string("aiABC.parameters.")
+              + parmNames[k]);
+      }
+
+    if (priors.empty())
+      throw runtime_error("No parameters have priors");
+    if (particles < 2 || generations == 0 || maxAttempts == 0)
+      throw runtime_error("Need particles > 1, generations > 0 and maxattempts > 0");
+    if (!(alpha > 0.0 && alpha < 1.0))
+      throw runtime_error("Need 0 < alpha < 1");
+    if (binWidth <= 0.0 || obsTime <= startTime)
+      throw runtime_error("Need binwidth > 0 and obstime > starttime");
+  }
+
+};
+
+
+
+// Distance between simulated and observed summaries.  Updates a lower
+// bound as notifications arrive, and reports done() once the bound
+// exceeds the tolerance.
+class ABCDistance : public GillespieSim::Observer
+{
+public:
+  ABCDistance(const Settings& config, const vector<double>& notifyTimes) :
+    useTotal_(config.useTotal), useIncidence_(config.useIncidence),
+        usePeak_(config.usePeak), startTime_(config.startTime), obsTime_(
+            config.obsTime), binWidth_(config.binWidth), tolerance_(
+            GSL_POSINF)
+  {
+    numBins_ = (size_t) ceil((obsTime_ - startTime_) / binWidth_);
+    obsIncidence_.assign(numBins_, 0.0);
+    obsTotal_ = 0.0;
+    for (size_t k = 0; k < notifyTimes.size(); ++k)
+      if (startTime_ < notifyTimes[k] && notifyTimes[k] < obsTime_)
+        {
+          obsIncidence_[bin(notifyTimes[k])] += 1.0;
+          obsTotal_ += 1.0;
+        }
+    obsPeak_ = *max_element(obsIncidence_.begin(), obsIncidence_.end());
+    reset();
+  }
+
+  void
+  setTolerance(const double tolerance)
+  {
+    tolerance_ = tolerance;
+  }
+
+  void
+  start(const GillespieSim::result_row& state)
+  {
+    reset();
+  }
+
+  void
+  event(const GillespieSim::result_row& row)
+  {
+    if (row.event_time >= obsTime_)
+      {
+        complete(numBins_);
+        updateBound();
+        return;
+      }
+    complete(bin(row.event_time));
+    if (row.event != 'n' || row.event_time <= startTime_)
+      {
+        updateBound();
+        return;
+      }
+
+    size_t b = bin(row.event_time);
+    ++incidence_[b];
+    ++total_;
+    peak_ = max(peak_, incidence_[b]);
+    updateBound();
+  }
+
+  void
+  finish(const GillespieSim::result_row& state)
+  {
+    distanceSq_ = 0.0;
+    if (useIncidence_)
+      for (size_t b = 0; b < numBins_; ++b)
+        distanceSq_ += diffSq(incidence_[b], obsIncidence_[b]);
+    if (useTotal_)
+      distanceSq_ += diffSq(total_, obsTotal_);
+    if (usePeak_)
+      distanceSq_ += diffSq(peak_, obsPeak_);
+  }
+
+  bool
+  done() const
+  {
+    return boundSq_ > tolerance_ * tolerance_;
+  }
+
+  // After a simulation, infinite if it was stopped early
+  double
+  distance() const
+  {
+    return done() ? GSL_POSINF : sqrt(distanceSq_);
+  }
+
+private:
+  bool useTotal_, useIncidence_, usePeak_;
+  double startTime_, obsTime_, binWidth_;
+  size_t numBins_;
+  vector<double> obsIncidence_;
+  double obsTotal_, obsPeak_;
+
+  vector<unsigned int> incidence_;
+  unsigned int total_, peak_;
+  size_t numComplete_;  // Bins before this are final
+  double completeSq_;   // Their contribution to the distance
+  double boundSq_;
+  double distanceSq_;
+  double tolerance_;
+
+  size_t
+  bin(const double time) const
+  {
+    size_t b = (size_t) ((time - startTime_) / binWidth_);
+    return b < numBins_ ? b : numBins_ - 1;
+  }
+
+  static double
+  diffSq(const double sim, const double obs)
+  {
+    double d = (sim - obs) / max(1.0, obs);
+    return d * d;
+  }
+
+  static double
+  excessSq(const double sim, const double obs)
+  {
+    return sim > obs ? diffSq(sim, obs) : 0.0;
+  }
+
+  void
+  reset()
+  {
+    incidence_.assign(numBins_, 0);
+    total_ = peak_ = 0;
+    numComplete_ = 0;
+    completeSq_ = boundSq_ = distanceSq_ = 0.0;
+  }
+
+  void
+  complete(const size_t upTo)
+  {
+    // Events are in time order, so bins before upTo are final
+    for (; numComplete_ < upTo; ++numComplete_)
+      if (useIncidence_)
+        completeSq_ += diffSq(incidence_[numComplete_],
+            obsIncidence_[numComplete_]);
+  }
+
+  void
+  updateBound()
+  {
+    // Only the first incomplete bin has notifications yet, and it
+    // and the total and peak can only grow
+    boundSq_ = completeSq_;
+    if (useIncidence_ && numComplete_ < numBins_)
+      boundSq_ += excessSq(incidence_[numComplete_],
+          obsIncidence_[numComplete_]);
+    if (useTotal_)
+      boundSq_ += excessSq(total_, obsTotal_);
+    if (usePeak_)
+      boundSq_ += excessSq(peak_, obsPeak_);
+  }
+};
+
+
+
+struct Particle
+{
+  vector<double> theta; // Estimated parameters, on the prior scale
+  double distance;
+  double weight;
+};
+
+typedef vector<Particle> Generation;
+
+
+
+// Independent stream for each particle
+unsigned long
+streamSeed(const unsigned long seed, const size_t generation,
+    const size_t particle, const size_t numParticles)
+{
+  unsigned long long z = seed + 0x9E3779B97F4A7C15ULL * (generation
+      * numParticles + particle + 1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return (unsigned long) (z ^ (z >> 31));
+}
+
+
+
+void
+writeGeneration(ostream& out, const Settings& config, const size_t t,
+    const double tolerance, const Generation& particles)
+{
+  for (size_t i = 0; i < particles.size(); ++i)
+    {
+      out << t << " " << tolerance << " " << particles[i].weight << " "
+          << particles[i].distance;
+      for (size_t k = 0; k < config.priors.size(); ++k)
+        out << " " << config.priors[k].toParm(particles[i].theta[k]);
+      out << "\n";
+    }
+  out.flush();
+}
+
+
+
+int
+main(int argc, char* argv[])
+{
+
+  string configFilename;
+  string outputPrefix;
+  unsigned long seed = 0;
+
+  cout << "aiABC (c) C. Jewell 2012" << endl;
+
+  try
+    {
+      po::options_description desc("Allowed options");
+      desc.add_options()("help,h", "Show help message")
+                        ("config,c", po::value<string>(), "config file to use")
+                        ("seed,s", po::value<int>(),"random seed")
+                        ("output,o", po::value<string>(), "output file prefix");
+
+      po::variables_map vm;
+      po::store(po::parse_command_line(argc, argv, desc), vm);
+      po::notify(vm);
+
+      if (vm.count("help"))
+        {
+          cout << desc << "\n";
+          return 2;
+        }
+
+      if (vm.count("config"))
+        {
+          configFilename = vm["config"].as<string> ();
+        }
+      else
+        {
+          cerr << "Config file required" << "\n";
+          cerr << desc << "\n";
+          return 2;
+        }
+
+      if (vm.count("seed"))
+        seed = vm["seed"].as<int> ();
+
+      if (vm.count("output"))
+        outputPrefix = vm["output"].as<string> ();
+    }
+  catch (exception& e)
+    {
+      cerr << "Exception: " << e.what() << "\n";
+      return 2;
+    }
+
+  // Set up config
+  Settings config;
+  try
+    {
+      config.load(configFilename);
+    }
+  catch (exception& e)
+    {
+      cerr << "Loading config failed: " << e.what() << endl;
+      return 1;
+    }
+  if (!outputPrefix.empty())
+    config.outputPrefix = outputPrefix;
+
+  // Observed notifications and the index case
+  vector<double> notifyTimes;
+  size_t indexLabel = 0;
+  double indexI = GSL_POSINF, indexN = 0.0, indexR = 0.0;
+  try
+    {
+      ifstream file(config.epiData.c_str());
+      if (!file.is_open())
+        throw runtime_error("Cannot open " + config.epiData);
+
+      string buffer;
+      vector<string> tokens;
+      while (getline(file, buffer))
+        {
+          if (buffer.size() < 2)
+            continue;
+          stlStrTok(tokens, buffer, " ");
+          if (tokens.size() != 4)
+            throw runtime_error("Malformed line in " + config.epiData);
+
+          size_t label = atoi(tokens[0].c_str());
+          double I = atof(tokens[1].c_str());
+          double N = atof(tokens[2].c_str());
+          double R = atof(tokens[3].c_str());
+          notifyTimes.push_back(N);
+
+          if (config.indexCase < 0 ? I < indexI : (int) label
+              == config.indexCase)
+            {
+              indexLabel = label;
+              indexI = I;
+              indexN = N;
+              indexR = R;
+            }
+        }
+      if (indexI == GSL_POSINF || indexLabel >= config.popSize)
+        throw runtime_error("Index case not found in epi data");
+    }
+  catch (exception& e)
+    {
+      cerr << "Exception occurred loading epi data.  Error: " << e.what()
+          << endl;
+      return 2;
+    }
+
+  // One simulation per thread, sharing the covariates
+  int numThreads = omp_get_max_threads();
+  GillespieSim* covariates;
+  vector<GillespieSim*> simulations(numThreads);
+  vector<gsl_rng*> rngs(numThreads);
+  vector<ABCDistance> distances(numThreads, ABCDistance(config, notifyTimes));
+  try
+    {
+      covariates = new GillespieSim(config.popSize, gsl_rng_alloc(
+          gsl_rng_mt19937));
+      covariates->loadCovariates(config.dataPrefix);
+
+      for (int t = 0; t < numThreads; ++t)
+        {
+          rngs[t] = gsl_rng_alloc(gsl_rng_mt19937);
+          simulations[t] = new GillespieSim(config.popSize, rngs[t]); // Frees rngs[t]
+          simulations[t]->shareCovariates(*covariates);
+          simulations[t]->setCTOutput(false);
+          simulations[t]->setStoreResults(false);
+          simulations[t]->setVerbose(false);
+          simulations[t]->setObserver(&distances[t]);
+          simulations[t]->setStartTime(config.startTime);
+          simulations[t]->setMaxTime(config.obsTime);
+          simulations[t]->setMaxN(config.maxN);
+        }
+    }
+  catch (exception& e)
+    {
+      cerr << "Exception occurred loading covariates.  Error: " << e.what()
+          << endl;
+      return 2;
+    }
+
+  string outputFile = config.outputPrefix + ".abc";
+  ofstream output(outputFile.c_str());
+  if (!output.is_open())
+    {
+      cerr << "Cannot open " << outputFile << endl;
+      return 2;
+    }
+  output << "generation tolerance weight distance";
+  for (size_t k = 0; k < config.priors.size(); ++k)
+    output << " " << parmNames[config.priors[k].index];
+  output << "\n";
+
+  size_t dim = config.priors.size();
+  Generation previous, current(config.particles);
+  vector<double> cumWeight;      // Of previous, for resampling
+  vector<double> kernelSd(dim);  // Perturbation kernel
+  double tolerance = GSL_POSINF;
+  int status = 0;
+
+  for (size_t gen = 0; gen < config.generations; ++gen)
+    {
+      size_t numAttempts = 0;
+      bool failed = false;
+      double t0 = omp_get_wtime();
+
+      for (int t = 0; t < numThreads; ++t)
+        distances[t].setTolerance(tolerance);
+
+#pragma omp parallel for schedule(dynamic) default(shared) reduction(+:numAttempts)
+      for (int i = 0; i < (int) config.particles; ++i)
+        {
+          int t = omp_get_thread_num();
+          GillespieSim& sim = *simulations[t];
+          gsl_rng* rng = rngs[t];
+          gsl_rng_set(rng, streamSeed(seed, gen, i, config.particles));
+
+          Particle& particle = current[i];
+          particle.theta.resize(dim);
+          vector<double> parms(config.parms);
+          size_t attempt = 0;
+          bool accepted = false;
+
+          try
+            {
+              while (!accepted && attempt < config.maxAttempts)
+                {
+                  ++attempt;
+
+                  // Propose
+                  bool inPrior = true;
+                  if (gen == 0)
+                    {
+                      for (size_t k = 0; k < dim; ++k)
+                        particle.theta[k] = gsl_ran_flat(rng,
+                            config.priors[k].lower, config.priors[k].upper);
+                    }
+                  else
+                    {
+                      double u = gsl_rng_uniform(rng) * cumWeight.back();
+                      size_t j = min(previous.size() - 1, (size_t) (upper_bound(
+                          cumWeight.begin(), cumWeight.end(), u)
+                          - cumWeight.begin()));
+                      for (size_t k = 0; k < dim; ++k)
+                        {
+                          particle.theta[k] = previous[j].theta[k]
+                              + gsl_ran_gaussian(rng, kernelSd[k]);
+                          inPrior = inPrior && config.priors[k].contains(
+                              particle.theta[k]);
+                        }
+                    }
+                  if (!inPrior)
+                    continue;
+
+                  // Simulate
+                  for (size_t k = 0; k < dim; ++k)
+                    parms[config.priors[k].index] = config.priors[k].toParm(
+                        particle.theta[k]);
+
+                  sim.resetPopulation();
+                  sim.setIndexCase(indexLabel, indexI, indexN, indexR);
+                  sim.simulate(parms, config.a, config.b, config.c);
+
+                  particle.distance = distances[t].distance();
+                  accepted = particle.distance <= tolerance;
+                }
+              if (!accepted)
+                {
+#pragma omp critical
+                  failed = true;
+                }
+            }
+          catch (exception& e)
+            {
+#pragma omp critical
+                {
+                  cerr << "Simulation of particle " << i << " failed: "
+                      << e.what() << endl;
+                  failed = true;
+                }
+            }
+          numAttempts += attempt;
+        }
+
+      if (failed)
+        {
+          cerr << "Generation " << gen << " stopped after "
+              << config.maxAttempts
+              << " attempts at a particle or a failed simulation" << endl;
+          status = 1;
+          break;
+        }
+
+      // Weights, prior uniform on its scale.  Kept as logs, with the
+      // kernel mixture summed by log-sum-exp, so distant particles do
+      // not underflow to a zero denominator.
+      vector<double> logWeight(current.size(), 0.0);
+#pragma omp parallel for default(shared)
+      for (int i = 0; i < (int) current.size(); ++i)
+        {
+          if (gen == 0)
+            continue;
+
+          vector<double> logTerm;
+          double maxTerm = GSL_NEGINF;
+          for (size_t j = 0; j < previous.size(); ++j)
+            {
+              if (previous[j].weight <= 0.0)
+                continue;
+              double logK = 0.0;
+              for (size_t k = 0; k < dim; ++k)
+                {
+                  double z = (current[i].theta[k] - previous[j].theta[k])
+                      / kernelSd[k];
+                  logK -= 0.5 * z * z;
+                }
+              logTerm.push_back(log(previous[j].weight) + logK);
+              maxTerm = max(maxTerm, logTerm.back());
+            }
+          double sum = 0.0;
+          for (size_t j = 0; j < logTerm.size(); ++j)
+            sum += exp(logTerm[j] - maxTerm);
+          logWeight[i] = -(maxTerm + log(sum));
+        }
+      double maxLogWeight = *max_element(logWeight.begin(), logWeight.end());
+      double sumWeight = 0.0;
+      for (size_t i = 0; i < current.size(); ++i)
+        {
+          current[i].weight = exp(logWeight[i] - maxLogWeight);
+          sumWeight += current[i].weight;
+        }
+      for (size_t i = 0; i < current.size(); ++i)
+        current[i].weight /= sumWeight;
+
+      writeGeneration(output, config, gen, tolerance, current);
+
+      double acceptance = (double) config.particles / numAttempts;
+      cout << "Generation " << gen << ": tolerance " << tolerance
+          << ", acceptance " << acceptance << ", "
+          << omp_get_wtime() - t0 << "s" << endl;
+
+      // Next tolerance and kernel
+      vector<double> d(current.size());
+      for (size_t i = 0; i < current.size(); ++i)
+        d[i] = current[i].distance;
+      size_t q = (size_t) (config.alpha * (d.size() - 1));
+      nth_element(d.begin(), d.begin() + q, d.end());
+      double nextTolerance = min(tolerance, d[q]);
+
+      for (size_t k = 0; k < dim; ++k)
+        {
+          double mean = 0.0, var = 0.0;
+          for (size_t i = 0; i < current.size(); ++i)
+            mean += current[i].weight * current[i].theta[k];
+          for (size_t i = 0; i < current.size(); ++i)
+            var += current[i].weight * (current[i].theta[k] - mean)
+                * (current[i].theta[k] - mean);
+          kernelSd[k] = sqrt(2.0 * var);
+          if (!(kernelSd[k] > 0.0))
+            kernelSd[k] = 1e-3 * (config.priors[k].upper
+                - config.priors[k].lower);
+        }
+
+      previous.swap(current);
+      current.assign(config.particles, Particle());
+      cumWeight.resize(previous.size());
+      double cum = 0.0;
+      for (size_t i = 0; i < previous.size(); ++i)
+        {
+          cum += previous[i].weight;
+          cumWeight[i] = cum;
+        }
+
+      if (nextTolerance <= config.minTolerance || (gen > 0 && acceptance
+          < config.minAcceptance))
+        break;
+      tolerance = nextTolerance;
+    }
+
+  for (int t = 0; t < numThreads; ++t)
+    delete simulations[t];
+  delete covariates;
+
+  return status;
+}
@@ -0,0 +1,576 @@
+/* ./src/sim/gillespie/aiForecast.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * aiForecast.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Posterior predictive forecasts.  Reads draws from the
+ *              .parms and .occ output of epiMCMC, sets up the observed
+ *              and imputed epidemic at the observation time, and
+ *              simulates forward with GillespieSim, one simulation
+ *              per thread sharing a single copy of the covariates.
+ *
+ * Writes <output>.incidence (new infections and notifications per
+ * time bin, mean and 2.5%, 50% and 97.5% quantiles over simulations),
+ * <output>.finalsize (one line per simulation) and <output>.risk
+ * (proportion of simulations in which each premises is infected
+ * after the observation time).
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <map>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include <gsl/gsl_rng.h>
+#include <omp.h>
+
+#include "GillespieSim.hpp"
+#include "posterior.h"
+#include "occultReader.h"
+#include "stlStrTok.hpp"
+
+#define NUMPARMS ModelTraits::numParms  // See ModelTraits.hpp
+
+struct Settings
+{
+
+  size_t popSize;
+  double obsTime, maxTime;
+  size_t burnin, thin, draws, reps, batch;
+  double binWidth;
+
+  string dataPrefix;
+  string epiData;
+  string dcData;
+  string parmsFile;
+  string occFile;
+  string outputPrefix;
+
+  double a, b, c;
+
+  void
+  load(const string& filename)
+  {
+    using boost::property_tree::ptree;
+    ptree pt;
+
+    read_xml(filename, pt);
+
+    dataPrefix = pt.get<string> ("aiForecast.paths.dataprefix");
+    epiData = pt.get<string> ("aiForecast.paths.epidata");
+    dcData = pt.get<string> ("aiForecast.paths.dcdata", "");
+    parmsFile = pt.get<string> ("aiForecast.paths.parameters");
+    occFile = pt.get<string> ("aiForecast.paths.occults");
+    outputPrefix = pt.get<string> ("aiForecast.paths.outputprefix");
+
+    popSize = pt.get<size_t> ("aiForecast.options.popsize");
+    obsTime = pt.get<double> ("aiForecast.options.obstime");
+    maxTime = pt.get<double> ("aiForecast.options.maxtime");
+    burnin = pt.get<size_t> ("aiForecast.options.burnin", 0);
+    thin = pt.get<size_t> ("aiForecast.options.thin", 1);
+    draws = pt.get<size_t> ("aiForecast.options.draws", 0);
+    reps = pt.get<size_t> ("aiForecast.options.reps", 1);
+    binWidth = pt.get<double> ("aiForecast.options.binwidth", 1.0);
+    batch = pt.get<size_t> ("aiForecast.options.batch", 64);
+
+    a = pt.get<double> ("aiForecast.constants.a");
+    b = pt.get<double> ("aiForecast.constants.b");
+    c = pt.get<double> ("aiForecast.constants.c");
+
+    if (thin == 0 || reps == 0 || batch == 0 || binWidth <= 0.0 || maxTime
+        <= obsTime)
+      throw runtime_error(
+          "Need thin, reps, batch, binwidth > 0 and maxtime > obstime");
+  }
+
+};
+
+
+
+struct EpiRecord
+{
+  size_t label;
+  double I, N, R;
+};
+
+
+
+void
+readRecords(const string& filename, const size_t numFields,
+    vector<EpiRecord>& records)
+{
+  // Reads "label I N R" (.ipt) or "label N R" (.dc) lines
+
+  ifstream file(filename.c_str());
+  if (!file.is_open())
+    throw runtime_error("Cannot open " + filename);
+
+  string buffer;
+  vector<string> tokens;
+  while (getline(file, buffer))
+    {
+      if (buffer.size() < 2)
+        continue;
+      stlStrTok(tokens, buffer, " ");
+      if (tokens.size() != numFields)
+        throw runtime_error("Malformed line in " + filename);
+
+      EpiRecord rec;
+      rec.label = atoi(tokens[0].c_str());
+      rec.I = numFields == 4 ? atof(tokens[1].c_str()) : 0.0;
+      rec.N = atof(tokens[numFields - 2].c_str());
+      rec.R = atof(tokens[numFields - 1].c_str());
+      records.push_back(rec);
+    }
+}
+
+
+
+// One posterior draw
+struct Draw
+{
+  size_t row;
+  vector<double> parms;
+  OccultReader::OccultMap infecTimes; // All infections, known and occult
+};
+
+
+
+// Forecast summaries, one per thread, merged at the end
+struct Forecast
+{
+  size_t numBins;
+  vector<size_t> run;                  // Draw row * reps + rep
+  vector<vector<unsigned int> > infections, notifications; // By run, then bin
+  vector<size_t> newInfections, finalSize;
+  vector<size_t> riskCount;            // By label
+
+  Forecast(const size_t numBins_, const size_t popSize) :
+    numBins(numBins_), riskCount(popSize, 0)
+  {
+  }
+
+  void
+  add(const size_t runId, const vector<GillespieSim::result_row>& events,
+      const size_t numInfected, const double obsTime, const double binWidth)
+  {
+    vector<unsigned int> infec(numBins, 0), notif(numBins, 0);
+    size_t numNew = 0;
+
+    for (size_t k = 0; k < events.size(); ++k)
+      {
+        const GillespieSim::result_row& e = events[k];
+        if (e.event_time <= obsTime)
+          continue;
+        size_t bin = min(numBins - 1, (size_t) ((e.event_time - obsTime)
+            / binWidth));
+        if (e.event == 'i')
+          {
+            ++infec[bin];
+            ++riskCount[e.label];
+            ++numNew;
+          }
+        else if (e.event == 'n')
+          ++notif[bin];
+      }
+
+    run.push_back(runId);
+    infections.push_back(infec);
+    notifications.push_back(notif);
+    newInfections.push_back(numNew);
+    finalSize.push_back(numInfected + numNew);
+  }
+
+  void
+  merge(const Forecast& other)
+  {
+    run.insert(run.end(), other.run.begin(), other.run.end());
+    infections.insert(infections.end(), other.infections.begin(),
+        other.infections.end());
+    notifications.insert(notifications.end(), other.notifications.begin(),
+        other.notifications.end());
+    newInfections.insert(newInfections.end(), other.newInfections.begin(),
+        other.newInfections.end());
+    finalSize.insert(finalSize.end(), other.finalSize.begin(),
+        other.finalSize.end());
+    for (size_t i = 0; i < riskCount.size(); ++i)
+      riskCount[i] += other.riskCount[i];
+  }
+};
+
+
+
+void
+summarise(ostream& out, const vector<vector<unsigned int> >& curves,
+    const size_t bin)
+{
+  // Mean and 2.5%, 50%, 97.5% quantiles of one bin over simulations
+
+  vector<unsigned int> values(curves.size());
+  double sum = 0.0;
+  for (size_t k = 0; k < curves.size(); ++k)
+    {
+      values[k] = curves[k][bin];
+      sum += values[k];
+    }
+  sort(values.begin(), values.end());
+  size_t n = values.size();
+
+  out << " " << sum / n << " " << values[(size_t) (0.025 * (n - 1))] << " "
+      << values[(size_t) (0.5 * (n - 1))] << " " << values[(size_t) (0.975
+      * (n - 1))];
+}
+
+
+
+struct ByRun
+{
+  const vector<size_t>& run;
+  ByRun(const vector<size_t>& run_) :
+    run(run_)
+  {
+  }
+  bool
+  operator()(const size_t lhs, const size_t rhs) const
+  {
+    return run[lhs] < run[rhs];
+  }
+};
+
+
+
+void
+writeForecast(const Settings& config, const Forecast& forecast)
+{
+  string filename = config.outputPrefix + ".incidence";
+  ofstream incidence(filename.c_str());
+  if (!incidence.is_open())
+    throw runtime_error("Cannot open " + filename);
+  incidence
+      << "time infec_mean infec_q025 infec_q50 infec_q975 notif_mean notif_q025 notif_q50 notif_q975\n";
+  for (size_t bin = 0; bin < forecast.numBins; ++bin)
+    {
+      incidence << config.obsTime + bin * config.binWidth;
+      summarise(incidence, forecast.infections, bin);
+      summarise(incidence, forecast.notifications, bin);
+      incidence << "\n";
+    }
+
+  filename = config.outputPrefix + ".finalsize";
+  ofstream finalSize(filename.c_str());
+  if (!finalSize.is_open())
+    throw runtime_error("Cannot open " + filename);
+  finalSize << "row rep new_infections final_size\n";
+  vector<size_t> order(forecast.run.size());
+  for (size_t k = 0; k < order.size(); ++k)
+    order[k] = k;
+  sort(order.begin(), order.end(), ByRun(forecast.run)); // Runs finish out of order
+  for (size_t k = 0; k < order.size(); ++k)
+    {
+      size_t r = order[k];
+      finalSize << forecast.run[r] / config.reps << " " << forecast.run[r]
+          % config.reps << " " << forecast.newInfections[r] << " "
+          << forecast.finalSize[r] << "\n";
+    }
+
+  filename = config.outputPrefix + ".risk";
+  ofstream risk(filename.c_str());
+  if (!risk.is_open())
+    throw runtime_error("Cannot open " + filename);
+  for (size_t i = 0; i < forecast.riskCount.size(); ++i)
+    risk << i << " " << (double) forecast.riskCount[i] / forecast.run.size()
+        << "\n";
+}
+
+
+
+int
+main(int argc, char* argv[])
+{
+
+  string configFilename;
+  string outputPrefix;
+  unsigned long seed = 0;
+
+  cout << "aiForecast (c) C. Jewell 2012" << endl;
+
+  try
+    {
+      po::options_description desc("Allowed options");
+      desc.add_options()("help,h", "Show help message")
+                        ("config,c", po::value<string>(), "config file to use")
+                        ("seed,s", po::value<int>(),"random seed")
+                        ("output,o", po::value<string>(), "output file prefix");
+
+      po::variables_map vm;
+      po::store(po::parse_command_line(argc, argv, desc), vm);
+      po::notify(vm);
+
+      if (vm.count("help"))
+        {
+          cout << desc << "\n";
+          return 2;
+        }
+
+      if (vm.count("config"))
+        {
+          configFilename = vm["config"].as<string> ();
+        }
+      else
+        {
+          cerr << "Config file required" << "\n";
+          cerr << desc << "\n";
+          return 2;
+        }
+
+      if (vm.count("seed"))
+        seed = vm["seed"].as<int> ();
+
+      if (vm.count("output"))
+        outputPrefix = vm["output"].as<string> ();
+    }
+  catch (exception& e)
+    {
+      cerr << "Exception: " << e.what() << "\n";
+      return 2;
+    }
+
+  // Set up config
+  Settings config;
+  try
+    {
+      config.load(configFilename);
+    }
+  catch (exception& e)
+    {
+      cerr << "Loading config failed: " << e.what() << endl;
+      return 1;
+    }
+  if (!outputPrefix.empty())
+    config.outputPrefix = outputPrefix;
+
+  // Observed epidemic
+  vector<EpiRecord> known, dcs;
+  vector<char> isKnown(config.popSize, 0), isDC(config.popSize, 0);
+  try
+    {
+      readRecords(config.epiData, 4, known);
+      if (!config.dcData.empty())
+        readRecords(config.dcData, 3, dcs);
+      for (size_t k = 0; k < known.size(); ++k)
+        isKnown.at(known[k].label) = 1;
+      for (size_t k = 0; k < dcs.size(); ++k)
+        isDC.at(dcs[k].label) = 1;
+    }
+  catch (exception& e)
+    {
+      cerr << "Exception occurred loading epi data.  Error: " << e.what()
+          << endl;
+      return 2;
+    }
+
+  // Posterior
+  Posterior posterior;
+  OccultReader occults;
+  size_t numDraws;
+  try
+    {
+      if (posterior.initialize(config.parmsFile.c_str()) != 0)
+        throw runtime_error("Cannot read " + config.parmsFile);
+      occults.open(config.occFile.c_str());
+
+      size_t numRows = min(posterior.numIterations(), occults.size());
+      if (numRows <= config.burnin)
+        throw runtime_error("No posterior draws after burnin");
+      numDraws = (numRows - config.burnin + config.thin - 1) / config.thin;
+      if (config.draws > 0)
+        numDraws = min(numDraws, config.draws);
+    }
+  catch (exception& e)
+    {
+      cerr << "Exception occurred opening posterior.  Error: " << e.what()
+          << endl;
+      return 2;
+    }
+
+  // One simulation per thread, sharing the covariates
+  int numThreads = omp_get_max_threads();
+  GillespieSim* covariates;
+  vector<GillespieSim*> simulations(numThreads);
+  vector<gsl_rng*> rngs(numThreads);
+  try
+    {
+      covariates = new GillespieSim(config.popSize, gsl_rng_alloc(
+          gsl_rng_mt19937));
+      covariates->loadCovariates(config.dataPrefix);
+
+      for (int t = 0; t < numThreads; ++t)
+        {
+          rngs[t] = gsl_rng_alloc(gsl_rng_mt19937);
+          simulations[t] = new GillespieSim(config.popSize, rngs[t]); // Frees rngs[t]
+          simulations[t]->shareCovariates(*covariates);
+          simulations[t]->setCTOutput(false);
+          simulations[t]->setVerbose(false);
+          simulations[t]->setStartTime(config.obsTime);
+          simulations[t]->setMaxTime(config.maxTime);
+          simulations[t]->setMaxN(config.popSize);
+        }
+    }
+  catch (exception& e)
+    {
+      cerr << "Exception occurred loading covariates.  Error: " << e.what()
+          << endl;
+      return 2;
+    }
+
+  size_t numBins = (size_t) ceil((config.maxTime - config.obsTime)
+      / config.binWidth);
+  vector<Forecast> forecasts(numThreads, Forecast(numBins, config.popSize));
+  size_t numFailed = 0;
+
+  cout << "Forecasting " << numDraws << " draws x " << config.reps
+      << " reps on " << numThreads << " threads" << endl;
+
+  // Draws are read serially in batches, then simulated in parallel
+  for (size_t first = 0; first < numDraws; first += config.batch)
+    {
+      vector<Draw> draws(min(config.batch, numDraws - first));
+      try
+        {
+          for (size_t d = 0; d < draws.size(); ++d)
+            {
+              draws[d].row = config.burnin + (first + d) * config.thin;
+              if (posterior.fetch(draws[d].parms, draws[d].row) != 0
+                  || draws[d].parms.size() < NUMPARMS)
+                throw runtime_error("Bad row in " + config.parmsFile);
+              draws[d].parms.resize(NUMPARMS);
+              draws[d].infecTimes = occults.fetch(draws[d].row);
+            }
+        }
+      catch (exception& e)
+        {
+          cerr << "Exception occurred reading posterior.  Error: "
+              << e.what() << endl;
+          return 2;
+        }
+
+      // Replicates of a draw run on one thread from a snapshot of
+      // the state at obsTime, so the conditioning is only done once
+#pragma omp parallel for schedule(dynamic) default(shared)
+      for (int d = 0; d < (int) draws.size(); ++d)
+        {
+          int t = omp_get_thread_num();
+          GillespieSim& sim = *simulations[t];
+          const Draw& draw = draws[d];
+
+          try
+            {
+              // The same draw gives the same forecast on any number of threads
+              gsl_rng_set(rngs[t], seed + draw.row);
+              sim.resetPopulation();
+
+              size_t numInfected = 0;
+              for (size_t r = 0; r < known.size(); ++r)
+                {
+                  const EpiRecord& rec = known[r];
+                  OccultReader::OccultMap::const_iterator it =
+                      draw.infecTimes.find(rec.label);
+                  sim.setObservedInfection(rec.label, it
+                      == draw.infecTimes.end() ? rec.I : it->second, rec.N,
+                      rec.R, config.obsTime, config.a, config.b, config.c);
+                  ++numInfected;
+                }
+              for (OccultReader::OccultMap::const_iterator it =
+                  draw.infecTimes.begin(); it != draw.infecTimes.end(); ++it)
+                {
+                  if (isKnown[it->first] || isDC[it->first])
+                    continue;
+                  sim.setObservedInfection(it->first, it->second,
+                      config.obsTime, config.obsTime, config.obsTime,
+                      config.a, config.b, config.c);
+                  ++numInfected;
+                }
+              for (size_t r = 0; r < dcs.size(); ++r)
+                sim.setDC(dcs[r].label, dcs[r].N, dcs[r].R);
+
+              vector<double> parms(draw.parms);
+              sim.prepare(parms, config.a, config.b, config.c);
+              boost::shared_ptr<const GillespieSim::Snapshot> state =
+                  sim.snapshot();
+
+              for (size_t rep = 0; rep < config.reps; ++rep)
+                {
+                  sim.simulate(*state);
+                  forecasts[t].add(draw.row * config.reps + rep,
+                      sim.getResults(), numInfected, config.obsTime,
+                      config.binWidth);
+                }
+            }
+          catch (exception& e)
+            {
+#pragma omp critical
+                {
+                  cerr << "Simulation of row " << draw.row << " failed: "
+                      << e.what() << endl;
+                  ++numFailed;
+                }
+            }
+        }
+    }
+
+  for (int t = 1; t < numThreads; ++t)
+    forecasts[0].merge(forecasts[t]);
+
+  for (int t = 0; t < numThreads; ++t)
+    delete simulations[t];
+  delete covariates;
+
+  if (forecasts[0].run.empty())
+    {
+      cerr << "No simulations succeeded" << endl;
+      return 2;
+    }
+
+  try
+    {
+      writeForecast(config, forecasts[0]);
+    }
+  catch (exception& e)
+    {
+      cerr << "Exception occurred writing output.  Error: " << e.what()
+          << endl;
+      return 2;
+    }
+
+  cout << forecasts[0].run.size() << " simulations, " << numFailed
+      << " draws failed" << endl;
+
+  return numFailed > 0 ? 1 : 0;
+}
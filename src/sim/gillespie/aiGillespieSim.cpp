@@ -26,6 +26,7 @@
  */
 
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <map>
 
@@ -33,6 +34,7 @@
 #include <boost/property_tree/xml_parser.hpp>
 
 #include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <boost/program_options.hpp>
 namespace po = boost::program_options;
@@ -40,6 +42,9 @@ namespace po = boost::program_options;
 #include <gsl/gsl_rng.h>
 
 #include "GillespieSim.hpp"
+#include "SimSummary.hpp"
+#include "EventTrace.hpp"
+#include "EpiRiskException.hpp"
 
 typedef map<string, double> ParmMap;
 
@@ -51,6 +56,10 @@ struct Settings
   int maxN;
   int I1;
   size_t reps;
+  double binWidth;
+  double tauLeap;
+  size_t tauLeapExact;
+  bool trace;
 
   string dataPrefix;
   string epiData;
@@ -103,6 +112,13 @@ struct Settings
     maxN = pt.get<double> ("aiGillespieSim.options.maxN", GSL_POSINF);
     I1 = pt.get("aiGillespieSim.options.I1", -1);
     reps = pt.get("aiGillespieSim.options.reps", 1);
+    binWidth = pt.get("aiGillespieSim.options.binwidth", 1.0);
+    tauLeap = pt.get("aiGillespieSim.options.tauleap", 0.0);
+    tauLeapExact = pt.get("aiGillespieSim.options.tauleapexact", 10);
+    trace = pt.get("aiGillespieSim.options.trace", false);
+    if (reps > 1 && binWidth > 0.0 && !(maxTime < GSL_POSINF))
+      throw invalid_argument(
+          "aiGillespieSim.options.maxtime is required for incidence bins when reps > 1");
     outputPrefix = pt.get<string> ("aiGillespieSim.paths.outputprefix");
     contactTracing = pt.get<bool> ("aiGillespieSim.options.contacttracing",
         false);
@@ -329,9 +345,75 @@ main(int argc, char* argv[])
             inTime, inTime + config.c);
     }
 
+  simulation->setTauLeap(config.tauLeap, config.tauLeapExact);
+
+  // Binary event trace, decoded with traceDecode
+  boost::scoped_ptr<EventTrace> trace;
+  if (config.trace)
+    {
+      try
+        {
+          trace.reset(new EventTrace(outputPrefix + ".trace"));
+        }
+      catch (exception& e)
+        {
+          cerr << "Exception occurred opening trace.  Error: " << e.what()
+              << endl;
+          return 2;
+        }
+      simulation->setTrace(trace.get());
+    }
+
+  if (config.reps > 1)
+    {
+      // Replicates from the same start state, keeping only summaries
+      try
+        {
+          SimSummary summary(config.popSize, config.minTime, config.maxTime,
+              config.binWidth);
+          simulation->setObserver(&summary);
+          simulation->setStoreResults(false);
+          simulation->setCTOutput(false);
+          simulation->setVerbose(false);
+
+          simulation->prepare(params, config.a, config.b, config.c);
+          boost::shared_ptr<const GillespieSim::Snapshot> state =
+              simulation->snapshot();
+
+          string outputFile = outputPrefix + ".reps";
+          ofstream repsFile(outputFile.c_str());
+          if (!repsFile.is_open())
+            throw EpiRisk::output_exception("Cannot open replicates output file");
+          SimSummary::writeReplicateHeader(repsFile);
+
+          for (size_t r = 0; r < config.reps; ++r)
+            {
+              if (trace)
+                simulation->setTrace(trace.get(), r);
+              simulation->simulate(*state);
+              summary.writeReplicate(repsFile);
+            }
+
+          simulation->setObserver(NULL);
+          summary.write(outputPrefix);
+          if (trace)
+            trace->close();
+        }
+      catch (exception& e)
+        {
+          cerr << "Exception occurred during replicates.  Error: "
+              << e.what() << endl;
+          return 2;
+        }
+
+      return 0;
+    }
+
   try
     {
       simulation->simulate(params, config.a, config.b, config.c);
+      if (trace)
+        trace->close();
     }
   catch (exception& e)
     {
@@ -23,33 +23,143 @@
  *
  *  Created on: 14 Dec 2009
  *      Author: Chris Jewell
+ *     Purpose: Simulates epidemics with SellkeSim for one or more
+ *              parameter sets, using common random numbers.
  */
 
 
 #include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
 
+#include <gsl/gsl_rng.h>
+
 #include "aiModel.hpp"
 #include "Parameter.hpp"
+#include "SellkeSim.hpp"
+#include "EpiRiskException.hpp"
+
+
+
+// CONSTANTS
+const int NTOTAL(8636);
+const double OBSTIME(50.0);
+
+
 
-class SellkeSim
+using namespace std;
+
+
+
+void
+defaultParameters(Parameters& parms)
 {
+  parms.clear();
+  parms.push_back(Parameter(1e-6)); // Beta0
+  parms.push_back(Parameter(1));  // p1 - dummy, fix to 1
+  parms.push_back(Parameter(1));  // p2 - dummy, fix to 1
+  parms.push_back(Parameter(0.008));// beta1
+  parms.push_back(Parameter(0.018));// beta2
+  parms.push_back(Parameter(0.0074));// beta3
+  parms.push_back(Parameter(0.2)); // psi
+  parms.push_back(Parameter(0.6)); // CLayers
+  parms.push_back(Parameter(0.3)); // DLayers
+  parms.push_back(Parameter(0.3)); // DMeat
+  parms.push_back(Parameter(0.3)); // GLayers
+  parms.push_back(Parameter(0.3)); // GMeat
+  parms.push_back(Parameter(0.3)); // Partridge
+  parms.push_back(Parameter(0.3)); // Pheasant
+  parms.push_back(Parameter(0.3)); // Quail Layers
+  parms.push_back(Parameter(0.3)); // Turkey
+  parms.push_back(Parameter(1));  // dummy
+  parms.push_back(Parameter(0.5)); // I2N a
+  parms.push_back(Parameter(0.2)); // I2N b
+}
+
+
+
+void
+readParameterSets(const string filename, vector<Parameters>& sets)
+{
+  //! Reads one whitespace separated parameter set per line
+  ifstream file(filename.c_str());
+  if (!file.is_open())
+    throw EpiRisk::data_exception("Cannot open parameter file");
+
+  Parameters defaults;
+  defaultParameters(defaults);
+
+  string buff;
+  while (getline(file, buff)) {
+    istringstream line(buff);
+    Parameters parms;
+    double value;
+    while (line >> value) parms.push_back(Parameter(value));
+    if (parms.empty()) continue;
+    if (parms.size() != defaults.size())
+      throw EpiRisk::data_exception("Wrong number of parameters in parameter file");
+    sets.push_back(parms);
+  }
+}
+
+
+
+int main(int argc, char* argv[])
+{
+
+  if (argc < 4 || argc > 7) {
+    cerr << "Usage: sellkeSim <data prefix> <output prefix> <seed> [parameter file] [population size] [obs time]" << endl;
+    cerr << "       Each line of the parameter file is a parameter set.  All sets are" << endl;
+    cerr << "       simulated from the same index case and thresholds." << endl;
+    return EXIT_FAILURE;
+  }
+
+  string dataPrefix = argv[1];
+  string outputPrefix = argv[2];
+  unsigned long seed = atol(argv[3]);
+  int nTotal = argc > 5 ? atoi(argv[5]) : NTOTAL;
+  double obsTime = argc > 6 ? atof(argv[6]) : OBSTIME;
 
-};
+  vector<Parameters> parmSets;
 
+  try {
+    if (argc > 4) readParameterSets(argv[4], parmSets);
+    else {
+      parmSets.resize(1);
+      defaultParameters(parmSets[0]);
+    }
 
-int main(int argc, char* argv[]) {
+    AIPopulation population(nTotal, obsTime, dataPrefix);
+    Parameters parms = parmSets[0];
+    AIModel model(&parms, &population);
+    SellkeSim simulation(&model, seed);
 
+    gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
+    gsl_rng_set(rng, seed);
+    size_t I1 = gsl_rng_uniform_int(rng, nTotal);
+    gsl_rng_free(rng);
 
-  const size_t N_total(8636);
-  const double obsTime(50.0);
+    for (size_t k = 0; k < parmSets.size(); ++k) {
+      parms = parmSets[k];
+      model.prepare();
 
-  Parameters parms;
-  AIPopulation population(8636,50.0,"/home/stsiab/AI/trunk/MCMC_input/kieran");
+      simulation.reset();
+      simulation.addInfection(I1);
+      size_t numInfec = simulation.simulate();
 
-  AIModel model(&parms, &population);
+      stringstream filename;
+      filename << outputPrefix << "." << k << ".ipt";
+      simulation.writeSimToFile(filename.str());
 
-  population.loadEpiData("/home/stsiab/AI/trunk/MCMC_input/ss.18.0.1.ipt");
+      cout << k << " " << numInfec << endl;
+    }
+  }
+  catch (exception& e) {
+    cerr << "Error: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
 
   return EXIT_SUCCESS;
 }
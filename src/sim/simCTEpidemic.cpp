@@ -47,6 +47,7 @@ struct Settings
   string contactsFile;
   string dcDataFile;
   string thresholdPrefix;
+  long thresholdSeed;
   string inTimesFile;
   double nrTime;
   size_t popSize;
@@ -55,6 +56,7 @@ struct Settings
   size_t reps;
   string outputPrefix;
   bool contactTracing;
+  bool trace;
 
   double mu;
   double nu;
@@ -73,7 +75,10 @@ struct Settings
     read_xml(filename, pt);
     contactsFile = pt.get<string>("simOnContacts.contactFile");
     dcDataFile = pt.get("simOnContacts.dcdatafile","");
-    thresholdPrefix = pt.get<string>("simOnContacts.thresholdPrefix");
+    thresholdPrefix = pt.get("simOnContacts.thresholdPrefix","");
+    thresholdSeed = pt.get("simOnContacts.thresholdSeed",-1L);
+    if (thresholdPrefix.empty() && thresholdSeed < 0)
+      throw boost::property_tree::ptree_error("One of thresholdPrefix or thresholdSeed is required");
     inTimesFile = pt.get<string>("simOnContacts.inTimes");
     nrTime = pt.get<double>("simOnContacts.nrTime");
     popSize = pt.get<size_t>("simOnContacts.popSize");
@@ -82,6 +87,7 @@ struct Settings
     reps = pt.get("simOnContacts.reps",1);
     outputPrefix = pt.get<string>("simOnContacts.outputPrefix");
     contactTracing = pt.get<bool>("simOnContacts.contactTracing",false);
+    trace = pt.get<bool>("simOnContacts.trace",false);
 
     mu = pt.get<double>("simOnContacts.constants.mu");
     nu = pt.get<double>("simOnContacts.constants.nu");
@@ -130,9 +136,13 @@ int main(int argc, char* argv[])
   SimOnContact* simulation = new SimOnContact(config.contactsFile,config.popSize);
   cerr << "Done" << endl;
 
-  cerr << "Loading thresholds..." << flush;
-  simulation->loadThresholds(config.thresholdPrefix);
-  cerr << "Done" << endl;
+  if (!config.thresholdPrefix.empty()) {
+    cerr << "Loading thresholds..." << flush;
+    simulation->loadThresholds(config.thresholdPrefix);
+    cerr << "Done" << endl;
+  }
+  else simulation->generateThresholds(config.thresholdSeed);
+
   cerr << "Loading inTimes" << flush;
   simulation->loadInTimes(config.inTimesFile);
   cerr << "Done" << endl;
@@ -147,6 +157,16 @@ int main(int argc, char* argv[])
   // Seed the PRNG
   if(config.I1 == -1) srand(time(NULL));
 
+  // Binary event trace of all replicates, decoded with traceDecode
+  EventTrace* trace = NULL;
+  if (config.trace) {
+    trace = new EventTrace(config.outputPrefix + ".trace");
+  }
+
+  // Contact tracing is streamed out as the simulation runs
+  if (config.contactTracing)
+    simulation->setCtOutput(config.outputPrefix + ".contact.xml");
+
   // Perform simulation
   int I1; // Our initial infective
   stringstream outputPrefix;
@@ -162,6 +182,7 @@ int main(int argc, char* argv[])
 
 
     simulation->reset();
+    simulation->setTrace(trace,i);
     simulation->addInfection(I1);
     simulation->simulate();
 
@@ -189,6 +210,11 @@ int main(int argc, char* argv[])
 
   delete simulation;
 
+  if (trace) {
+    trace->close();
+    delete trace;
+  }
+
 
   return 0;
 }
@@ -31,13 +31,19 @@
 // Standard
 #include <cstdlib>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+
+// OpenMP
+#include <omp.h>
 
 // GSL
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
+#include <gsl/gsl_math.h>
 
-// XML
-#include "XmlCTWriter.hpp"
+// Output
+#include "CTStreamWriter.hpp"
 
 // AIPopulation
 #include "aiModel.hpp"
@@ -48,34 +54,176 @@
 // CONSTANTS
 const int NTOTAL(8636);
 const float OBSTIME(500.0);
+const size_t BACKGROUND_ID(9000);
+const int BLOCKSIZE(1024);
 
 
 
 using namespace std;
-using namespace xercesc;
+
+
+
+struct ContactTypes
+{
+  unsigned char background, feedmill, shouse, company, ispatial, nspatial;
+};
+
+
+
+void
+poissonContacts(gsl_rng* rng, const size_t i, const unsigned char type,
+                const double rate, const double obsTime, vector<CTRecord>& contacts)
+{
+  //! Appends a realisation of a Poisson(rate) contact process on
+  //! [0,obsTime) from i.  Given the count, times are iid uniform.
+  if (rate <= 0.0) return;
+
+  unsigned int n = gsl_ran_poisson(rng, rate * obsTime);
+  for (unsigned int k = 0; k < n; ++k)
+    contacts.push_back(CTRecord(i, true, type, gsl_rng_uniform(rng) * obsTime));
+}
+
+
+
+void
+spatialContacts(gsl_rng* rng, const vector<int>& senders,
+                const vector<double>& cumRate, const unsigned char type,
+                const double obsTime, vector<CTRecord>& contacts)
+{
+  //! Superposes the spatial processes from all senders: draws the
+  //! total count, then picks each sender in proportion to its rate.
+  if (cumRate.empty() || cumRate.back() <= 0.0) return;
+
+  unsigned int n = gsl_ran_poisson(rng, cumRate.back() * obsTime);
+  for (unsigned int k = 0; k < n; ++k) {
+    double u = gsl_rng_uniform(rng) * cumRate.back();
+    size_t pos = upper_bound(cumRate.begin(), cumRate.end(), u) - cumRate.begin();
+    if (pos == cumRate.size()) pos--;
+    contacts.push_back(CTRecord(senders[pos], true, type, gsl_rng_uniform(rng) * obsTime));
+  }
+}
+
+
+
+void
+spatialSenders(const SpatialKernel& kernel, vector< vector<int> >& senders)
+{
+  //! Transposes the kernel's edges, which are stored by sender, into
+  //! the senders of each receiver in ascending order
+  senders.assign(kernel.size(), vector<int>());
+  for (size_t i = 0; i < kernel.size(); ++i) {
+    const uint32_t* targets = kernel.targets(i);
+    for (size_t e = 0; e < kernel.degree(i); ++e)
+      senders[targets[e]].push_back(i);
+  }
+}
+
+
+
+void
+simReceiver(const int j, AIModel& model, AIPopulation& popn, Parameters& parms,
+            const vector<int>& spatial, const double obsTime, const ContactTypes& types,
+            gsl_rng* rng, vector<int>& conns, vector<int>& senders,
+            vector<double>& cumI, vector<double>& cumN, vector<CTRecord>& contacts)
+{
+  //! Simulates all incoming contacts on receiver j.  Only senders
+  //! with a non-zero rate are visited.
+
+  contacts.clear();
+  double suscep = model.speciesSusc(j);
+  size_t segment;
+
+  // Background
+  poissonContacts(rng, BACKGROUND_ID, types.background, parms[0].value, obsTime, contacts);
+  sort(contacts.begin(), contacts.end());
+
+  // Feedmills
+  segment = contacts.size();
+  popn.fmContact.connections(j, conns);
+  for (size_t k = 0; k < conns.size(); ++k) {
+    if (conns[k] == j) continue;
+    poissonContacts(rng, conns[k], types.feedmill, model.fmRate(conns[k],j) * suscep, obsTime, contacts);
+  }
+  sort(contacts.begin() + segment, contacts.end());
+
+  // Slaughterhouse
+  segment = contacts.size();
+  popn.shContact.connections(j, conns);
+  for (size_t k = 0; k < conns.size(); ++k) {
+    if (conns[k] == j) continue;
+    poissonContacts(rng, conns[k], types.shouse, model.shRate(conns[k],j) * suscep, obsTime, contacts);
+  }
+  sort(contacts.begin() + segment, contacts.end());
+
+  // Company
+  segment = contacts.size();
+  popn.cpContact.connections(j, conns);
+  for (size_t k = 0; k < conns.size(); ++k) {
+    if (conns[k] == j) continue;
+    poissonContacts(rng, conns[k], types.company, model.cpRate(conns[k],j) * suscep, obsTime, contacts);
+  }
+  sort(contacts.begin() + segment, contacts.end());
+
+  // Spatial: only pairs with a finite distance have a non-zero kernel
+  senders.clear(); cumI.clear(); cumN.clear();
+  double sumI = 0.0, sumN = 0.0;
+  for (size_t k = 0; k < spatial.size(); ++k) {
+    int i = spatial[k];
+    if (i == j) continue;
+    sumI += model.iSpatRate(i,j) * suscep;
+    sumN += model.nSpatRate(i,j) * suscep;
+    senders.push_back(i);
+    cumI.push_back(sumI);
+    cumN.push_back(sumN);
+  }
+
+  // Spatial if I->S
+  segment = contacts.size();
+  spatialContacts(rng, senders, cumI, types.ispatial, obsTime, contacts);
+  sort(contacts.begin() + segment, contacts.end());
+
+  // Spatial if N->S
+  segment = contacts.size();
+  spatialContacts(rng, senders, cumN, types.nspatial, obsTime, contacts);
+  sort(contacts.begin() + segment, contacts.end());
+}
 
 
 
 int main(int argc, char* argv[])
 {
 
-  if (argc != 4) {
-    cout << "Usage: simContacts <data prefix> <XML output file> <seed>"  << endl;
+  if (argc < 4 || argc > 6) {
+    cout << "Usage: simContacts <data prefix> <output file> <seed> [population size] [obs time]" << endl;
+    cout << "       Output is binary if <output file> ends in .ctb, contact tracing XML otherwise." << endl;
     return 1;
   }
 
-  char* xmlFilename = argv[2];
+  char* outFilename = argv[2];
   char* dataPrefix = argv[1];
   int seed = atoi(argv[3]);
+  int nTotal = argc > 4 ? atoi(argv[4]) : NTOTAL;
+  double obsTime = argc > 5 ? atof(argv[5]) : OBSTIME;
+
+  if (nTotal <= 0 || obsTime <= 0.0) {
+    cerr << "Population size and observation time must be positive" << endl;
+    return 1;
+  }
 
 
-  // XML Framework
-  XmlCTWriter* ctWriter;
-  ctWriter = new XmlCTWriter();
+  // Output stream
+  CTStreamWriter ctWriter(outFilename, CTStreamWriter::formatFromFilename(outFilename));
+  ContactTypes types;
+  types.background = ctWriter.typeCode("background");
+  types.feedmill = ctWriter.typeCode("feedmill");
+  types.shouse = ctWriter.typeCode("shouse");
+  types.company = ctWriter.typeCode("company");
+  types.ispatial = ctWriter.typeCode("ispatial");
+  types.nspatial = ctWriter.typeCode("nspatial");
 
 
   // Set up population
-  AIPopulation popn(NTOTAL,OBSTIME,dataPrefix);
+  AIPopulation popn(nTotal,obsTime,dataPrefix);
   Parameters parms;
 
   parms.push_back(Parameter(1e-6)); // Beta0
@@ -97,6 +245,10 @@ int main(int argc, char* argv[])
 
 
   AIModel model(&parms, &popn);
+  model.prepare();
+
+  vector< vector<int> > spatial;
+  spatialSenders(model.getSpatialKernel(), spatial);
 
 
 
@@ -104,128 +256,66 @@ int main(int argc, char* argv[])
    *
    * Receiver j, sender i;
    *
-   * Foreach j:
+   * Foreach block of receivers, in parallel:
+   *
+   *   Foreach j, with its own RNG stream:
+   *     // Do background
+   *     n ~ Poisson(beta0 * tObs), times ~ U(0,tObs)
    *
-   *   // Do background
-   *   Exp(beta0)
+   *     Foreach k in networks, foreach i connected to j by k:
+   *       n ~ Poisson(betaijk * tObs), times ~ U(0,tObs)
    *
-   *   Foreach i:
-   *     Foreach k in networks:
-   *       t = 0;
-   *       while(t < tObs):
-   *         t' = t + Exp(betaijk);
-   *         Store t' in contact tracing for j
+   *     Foreach spatial process:
+   *       n ~ Poisson(sum_i betaij * tObs), i ~ betaij / sum_i betaij
    *
+   *   Write the block in receiver order.
+   *
+   * Seeding each receiver from (seed,j) makes the output independent
+   * of the number of threads.
    */
 
-  gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
-  gsl_rng_set (rng, seed);
-  double time;
-  double beta;
+  int nThreads = omp_get_max_threads();
+  vector<gsl_rng*> rngs(nThreads);
+  for (int t = 0; t < nThreads; ++t) rngs[t] = gsl_rng_alloc(gsl_rng_mt19937);
 
-  for(int j = 0; j < NTOTAL; j++) {
+  vector< vector<CTRecord> > block(BLOCKSIZE);
+  size_t numContacts = 0;
 
-    XmlCTData* ctData = ctWriter->createCTData(j);
-    ctData->setCTStartTime(0.0);
+  for (int blockStart = 0; blockStart < nTotal; blockStart += BLOCKSIZE) {
 
-    // Get species susceptibility
-    double suscep = 1.0;
-    for(size_t k = 0; k<NSPECIES; k++) {
-      if((*popn[j]).species[k] == true) {
-        suscep *= parms[k+7].value;
-        break;
-      }
-    }
+    int blockEnd = GSL_MIN(blockStart + BLOCKSIZE, nTotal);
+    int j;
 
-    cout << "Suscep = " << suscep << endl;
-    // Background
-    time = 0.0;
-    while(time < OBSTIME) {
-      time += gsl_ran_exponential(rng, 1 / parms[0].value);
-      if (time > OBSTIME) break;
-      ctData->appendContact(9000,true,"background",time,false);
-    }
+#pragma omp parallel default(shared) private(j)
+    {
+      gsl_rng* rng = rngs[omp_get_thread_num()];
+      vector<int> conns, senders;
+      vector<double> cumI, cumN;
 
-    // Feedmills
-    for(int i = 0; i < NTOTAL; i++) {
-      if (i == j) continue;
-
-      time = 0.0;
-      beta = model.fmRate(i,j) * model.speciesSusc(j);
-      //if(beta > 0) cout << "beta(" << i << "," << j << ") = " << beta << endl;
-      while(time < OBSTIME) {
-        time = time + gsl_ran_exponential(rng, 1 / beta);
-        if (time > OBSTIME) break;
-        ctData->appendContact(i, true, "feedmill", time, false);
+#pragma omp for schedule(dynamic,16)
+      for (j = blockStart; j < blockEnd; ++j) {
+        gsl_rng_set(rng, (unsigned long)seed * nTotal + j);
+        simReceiver(j, model, popn, parms, spatial[j], obsTime, types, rng,
+                    conns, senders, cumI, cumN, block[j - blockStart]);
       }
     }
 
-    // Slaughterhouse
-    for(int i = 0; i < NTOTAL; i++) {
-      if (i == j) continue;
-
-      time = 0.0;
-      beta = model.shRate(i,j) * model.speciesSusc(j);
-      //if (beta > 0) cout << "beta(" << i << "," << j << ") = " << beta << endl;
-      while(time < OBSTIME) {
-        time = time + gsl_ran_exponential(rng, 1 / beta);
-        if (time > OBSTIME) break;
-        ctData->appendContact(i, true, "shouse", time, false);
-      }
+    // Write in receiver order
+    for (j = blockStart; j < blockEnd; ++j) {
+      ctWriter.writeBlock(j, 0.0, block[j - blockStart]);
+      numContacts += block[j - blockStart].size();
     }
 
-    // Company
-    for(int i = 0; i < NTOTAL; i++) {
-      if (i == j) continue;
-
-      time = 0.0;
-      beta = model.cpRate(i,j) * model.speciesSusc(j);
-      while(time < OBSTIME) {
-        time = time + gsl_ran_exponential(rng, 1 / beta);
-        if (time > OBSTIME) break;
-        ctData->appendContact(i, true, "company", time, false);
-      }
-    }
-
-    // Spatial if I->S
-    for(int i = 0; i < NTOTAL; i++) {
-      if (i == j) continue;
-
-      time = 0.0;
-      beta = model.iSpatRate(i,j) * model.speciesSusc(j);
-      while(time < OBSTIME) {
-        time = time + gsl_ran_exponential(rng, 1 / beta);
-        if (time > OBSTIME) break;
-        ctData->appendContact(i, true, "ispatial", time, false);
-      }
-    }
-
-    // Spatial if N->S
-    for(int i = 0; i < NTOTAL; i++) {
-      if (i == j) continue;
-
-      time = 0.0;
-      beta = model.nSpatRate(i,j) * model.speciesSusc(j);
-      while(time < OBSTIME) {
-        time = time + gsl_ran_exponential(rng, 1 / beta);
-        if (time > OBSTIME) break;
-        ctData->appendContact(i, true, "nspatial", time, false);
-      }
-    }
-
-    // Add CT Data
-    ctWriter->addCTData(ctData);
+    cerr << "Simulated " << blockEnd << " of " << nTotal << " receivers" << endl;
   }
 
-
-  // Now write CT Data to file
-  ctWriter->writeToFile(xmlFilename);
+  ctWriter.close();
+  cout << "Wrote " << numContacts << " contacts to " << outFilename << endl;
 
 
   // Clean up
-  delete ctWriter;
+  for (int t = 0; t < nThreads; ++t) gsl_rng_free(rngs[t]);
 
   // Done
   return 0;
 }
-
@@ -0,0 +1,204 @@
+/* ./src/sim/sortContacts.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+/*
+ * sortContacts.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: Chris Jewell
+ *     Purpose: Converts contact data (contact tracing XML, or a binary
+ *              stream from simContacts) into time-sorted binary event
+ *              files for ContactQueue.  Large inputs are sorted in
+ *              bounded memory by writing sorted runs, then k-way
+ *              merging them.
+ */
+
+// Standard
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+#include "CTStreamWriter.hpp"
+#include "EventQueue.hpp"
+
+
+
+// CONSTANTS
+const size_t RUNSIZE(1 << 24); // Events held in memory per sorted run
+const int NCONTACTTYPES(6);
+const char* CONTACTTYPES[NCONTACTTYPES] = { "background", "feedmill", "shouse",
+                                            "company", "ispatial", "nspatial" };
+
+
+
+using namespace std;
+
+
+
+bool
+contactTypeFromString(const string& name, ContactType& type)
+{
+  //! Maps a contact type string onto ContactType, as EventParser does
+  for (int k = 0; k < NCONTACTTYPES; ++k) {
+    if (name == CONTACTTYPES[k]) {
+      type = (ContactType) k;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+
+void
+writeRun(EventList& events, vector<string>& runs, const string& prefix)
+{
+  //! Sorts events and writes them to a new run file
+
+  if (events.empty()) return;
+
+  stable_sort(events.begin(), events.end());
+
+  stringstream filename;
+  filename << prefix << ".run" << runs.size();
+  EventFileWriter writer(filename.str());
+  for (EventList::const_iterator it = events.begin(); it != events.end(); ++it)
+    writer.write(*it);
+  writer.close();
+
+  runs.push_back(filename.str());
+  events.clear();
+}
+
+
+
+void
+mergeTo(ContactQueue& queue, const string& output, const bool split)
+{
+  //! Writes the merged queue to output, or to one file per
+  //! contact type if split is set.
+
+  vector<EventFileWriter*> writers;
+  if (split) {
+    for (int k = 0; k < NCONTACTTYPES; ++k)
+      writers.push_back(new EventFileWriter(output + "." + CONTACTTYPES[k] + ".ev"));
+  }
+  else {
+    writers.push_back(new EventFileWriter(output));
+  }
+
+  EventRecord rec;
+  rec.reserved = 0;
+  ContactEvent* event;
+  while ((event = queue.next()) != NULL) {
+    rec.time = event->time;
+    rec.id = event->id;
+    rec.from = event->from;
+    rec.type = event->type;
+    writers[split ? rec.type : 0]->write(rec);
+  }
+
+  for (size_t k = 0; k < writers.size(); ++k) {
+    cout << "Wrote " << writers[k]->size() << " events" << (split ? string(" of type ") + CONTACTTYPES[k] : string("")) << endl;
+    writers[k]->close();
+    delete writers[k];
+  }
+}
+
+
+
+int main(int argc, char* argv[])
+{
+  bool split = false;
+  int arg = 1;
+  if (argc > 1 && strcmp(argv[1], "-n") == 0) {
+    split = true;
+    arg++;
+  }
+
+  if (argc - arg != 2) {
+    cout << "Usage: sortContacts [-n] <contact file> <output event file>" << endl;
+    cout << "       -n writes one event file per network, <output>.<type>.ev" << endl;
+    return 1;
+  }
+
+  string input = argv[arg];
+  string output = argv[arg+1];
+
+  try {
+
+    if (!CTStreamReader::isBinary(input)) {
+      // Contact tracing XML is parsed into memory by ContactQueue
+      ContactQueue queue(input);
+      mergeTo(queue, output, split);
+      return 0;
+    }
+
+    // Binary contact stream: sort in runs of bounded size
+    CTStreamReader reader(input);
+    size_t id;
+    double start;
+    vector<CTRecord> contacts;
+    EventList events;
+    vector<string> runs;
+    ContactType type;
+    EventRecord rec;
+    rec.reserved = 0;
+
+    events.reserve(RUNSIZE);
+
+    while (reader.next(id, start, contacts)) {
+      for (vector<CTRecord>::const_iterator it = contacts.begin(); it != contacts.end(); ++it) {
+        // Only incoming contacts are events, as in EventParser
+        if (!it->incoming) continue;
+        if (!contactTypeFromString(reader.typeName(it->type), type)) {
+          cerr << "Unrecognised contact type '" << reader.typeName(it->type) << "'" << endl;
+          continue;
+        }
+        rec.time = it->time;
+        rec.id = id;
+        rec.from = it->id;
+        rec.type = type;
+        events.push_back(rec);
+
+        if (events.size() == RUNSIZE) writeRun(events, runs, output);
+      }
+    }
+    writeRun(events, runs, output);
+
+    ContactQueue queue(runs);
+    mergeTo(queue, output, split);
+
+    for (size_t k = 0; k < runs.size(); ++k) remove(runs[k].c_str());
+
+  }
+  catch (exception& e) {
+    cerr << "Error sorting contacts: " << e.what() << endl;
+    return 1;
+  }
+
+  return 0;
+}
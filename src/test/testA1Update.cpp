@@ -0,0 +1,228 @@
+/* ./src/test/testA1Update.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Writes a small epidemic from a fixed seed, with contact tracing
+   starting part way through each infectious period, and moves random
+   infection times.  The change in A1 from update_A1 and from moveDelta
+   must match the change in compute_A1 after each move, so that A1
+   tracked through a chain stays equal to a recomputation. */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+
+#include "aifuncs.h"
+#include "CTStreamWriter.hpp"
+
+using namespace std;
+
+#define NUMPARMS ModelTraits::numParms  // See ModelTraits.hpp
+#define NUMSPECIES ModelTraits::numSpecies
+
+#define POPSIZE 80
+#define NUMINFEC 20
+#define SIDE 10.0      // km
+#define NUMMOVES 2000
+
+// Globals required by aifuncs and random.cpp
+int total_pop_size;
+double ObsTime;
+McmcProfiler profiler;
+gsl_rng* rng;
+
+// Parameter values as in aiGillespieConfTemplate.xml, with the network
+// rates scaled up so that network pressure dominates A1
+static const double testParms[NUMPARMS] =
+  { 1e-6, 0.8, 0.6, 0.008, 0.018, 0.0074, 0.2, 0.6, 0.3, 0.3, 0.3, 0.3, 0.3,
+    0.3, 0.3, 0.3 };
+
+static const char* prefix = "testA1Update";
+static const char* suffixes[] = { ".fm", ".sh", ".cp", ".freq", ".sp", "_dist.txt",
+                                  ".ipt", ".dc", ".ni", ".contact.xml" };
+static const char* networkType[3] = { "feedmill", "shouse", "company" };
+
+void writeData(gsl_rng* r)
+{
+  // Premises in a square with dense networks.  The first NUMINFEC are
+  // known infections, each traced from a contact start up to six days
+  // before notification, so the window often cuts the infectious
+  // period.
+
+  string p(prefix);
+  ofstream fm((p + ".fm").c_str()), sh((p + ".sh").c_str()), cp((p + ".cp").c_str());
+  ofstream freq((p + ".freq").c_str()), sp((p + ".sp").c_str());
+  ofstream dist((p + "_dist.txt").c_str()), ipt((p + ".ipt").c_str());
+  ofstream dc((p + ".dc").c_str()), ni((p + ".ni").c_str());
+  if(!fm.is_open() || !sh.is_open() || !cp.is_open() || !freq.is_open() || !sp.is_open() ||
+     !dist.is_open() || !ipt.is_open() || !dc.is_open() || !ni.is_open())
+    throw runtime_error("Cannot open data files");
+  ofstream* nets[3] = { &fm, &sh, &cp };
+  ipt.precision(9);
+
+  vector<double> x(POPSIZE), y(POPSIZE);
+  for(int i=0; i < POPSIZE; ++i) {
+    x[i] = SIDE * gsl_rng_uniform(r);
+    y[i] = SIDE * gsl_rng_uniform(r);
+    freq << gsl_ran_gamma(r, 2.0, 0.5) << " " << gsl_ran_gamma(r, 2.0, 0.5) << " "
+         << gsl_ran_gamma(r, 2.0, 0.5) << " " << gsl_ran_gamma(r, 2.0, 0.5) << "\n";
+    string species(NUMSPECIES, '0');
+    species[gsl_rng_uniform_int(r, NUMSPECIES)] = '1';
+    sp << species << "\n";
+  }
+
+  for(int i=0; i < POPSIZE; ++i)
+    for(int j=0; j < POPSIZE; ++j) {
+      if(i == j) continue;
+      dist << i << " " << j << " " << hypot(x[i]-x[j], y[i]-y[j]) << "\n";
+      if(j < i)
+        for(int net=0; net < 3; ++net)
+          if(gsl_rng_uniform(r) < 0.2) *nets[net] << i << " " << j << "\n";
+    }
+
+  CTStreamWriter ct(p + ".contact.xml", CTStreamWriter::XMLFORMAT);
+  unsigned char typeCode[3];
+  for(int net=0; net < 3; ++net) typeCode[net] = ct.typeCode(networkType[net]);
+
+  double obsTime = 0.0, I = 0.0;
+  for(int label=0; label < NUMINFEC; ++label) {
+    double N = I + 4.0 + gsl_ran_exponential(r, 3.0);
+    ipt << label << " " << I << " " << N << " " << N + 1.0 << "\n";
+    if(obsTime < N + 1.0) obsTime = N + 1.0;
+
+    double start = N - 6.0 * gsl_rng_uniform_pos(r);
+    vector<CTRecord> block;
+    for(int other = NUMINFEC; other < POPSIZE; ++other)
+      if(gsl_rng_uniform(r) < 0.1)
+        block.push_back(CTRecord(other, false, typeCode[gsl_rng_uniform_int(r, 3)],
+                                 start + (N - start) * gsl_rng_uniform(r)));
+    sort(block.begin(), block.end());
+    ct.writeBlock(label, start, block);
+
+    I += 2.0 * gsl_rng_uniform_pos(r);
+  }
+  ct.close();
+  ObsTime = obsTime;
+}
+
+bool nearlyEqual(const double a, const double b)
+{
+  return fabs(a - b) <= 1e-7 * (1.0 + fabs(b));
+}
+
+int checkMoves()
+{
+  // Returns the number of moves whose A1 update disagrees with
+  // compute_A1, plus one if the tracked A1 ends up away from it
+
+  string p(prefix), distFile = p + "_dist.txt";
+  sinrEpi epidata;
+  if(epidata.init(POPSIZE, prefix, prefix, distFile.c_str(), NUMSPECIES, ObsTime) != 0)
+    throw runtime_error("Cannot initialise data");
+
+  epiParms parms(NUMPARMS);
+  for(size_t k=0; k < NUMPARMS; ++k) parms.beta[k] = testParms[k];
+  parms.f = 60.0;
+  parms.g = 1.3;
+
+  initSpatialKernel(epidata, SpatialKernel::EXPONENTIAL);
+  prepareSpatialKernel(parms);
+  prepareSusceptibility(parms, epidata);
+  initConnections(parms, epidata);
+  initContactCache(epidata);
+  initInfecKernel(parms, 1e-10, false);
+  OccultGraph graph;
+  initOccultGraph(epidata, graph);
+  epidata.updateI1();
+  indexInfecteds(epidata, graph);
+
+  vector<double> prodCurr(epidata.infected.size());
+  compute_log_prod_pressure(parms, epidata, &prodCurr);
+  double A1 = compute_A1(parms, epidata);
+  double tracked = A1;
+
+  int numFailed = 0, numMoves = 0;
+  for(int n=0; n < NUMMOVES; ++n) {
+    int m = gsl_rng_uniform_int(rng, epidata.infected.size());
+    if(m == (int)epidata.I1) continue;
+    infection* s = epidata.infected[m];
+    double Ican = s->I + gsl_ran_gaussian(rng, 1.0);
+    if(Ican >= s->N || Ican <= epidata.infected[epidata.I1]->I || Ican < s->niAt) continue;
+
+    MoveDelta delta;
+    if(!moveDelta(m, Ican, parms, epidata, graph, prodCurr, delta)) continue;
+    parms.Ican = Ican;
+    double updated = update_A1(m, parms, epidata, A1) - A1;
+
+    epidata.setI(s->label, Ican);
+    compute_log_prod_pressure(parms, epidata, &prodCurr);
+    double A1new = compute_A1(parms, epidata);
+    double change = A1new - A1;
+    if(!nearlyEqual(updated, change) || !nearlyEqual(delta.A1, change)) {
+      cerr << "Move of infection " << s->label << " to " << Ican << ": compute_A1 changed by "
+           << change << ", update_A1 by " << updated << ", moveDelta by " << delta.A1 << endl;
+      ++numFailed;
+    }
+    A1 = A1new;
+    tracked += delta.A1;
+    ++numMoves;
+  }
+
+  if(!nearlyEqual(tracked, A1)) {
+    cerr << "Tracked A1 " << tracked << " != " << A1 << " after " << numMoves << " moves" << endl;
+    ++numFailed;
+  }
+  if(numMoves < NUMMOVES / 4) {
+    cerr << "Only " << numMoves << " moves made" << endl;
+    ++numFailed;
+  }
+
+  return numFailed;
+}
+
+int main(int argc, char* argv[])
+{
+  rng = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, 1);
+  total_pop_size = POPSIZE;
+
+  int numFailed = 0;
+  try {
+    writeData(rng);
+    numFailed = checkMoves();
+  }
+  catch(exception& e) {
+    cerr << "Moving infection times failed: " << e.what() << endl;
+    numFailed = 1;
+  }
+
+  for(size_t k=0; k < sizeof(suffixes)/sizeof(char*); ++k)
+    remove((string(prefix) + suffixes[k]).c_str());
+  gsl_rng_free(rng);
+
+  cout << numFailed << " failures" << endl;
+  return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+/* ./src/test/testContactMatrix.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Writes contactSim's random networks from a fixed seed as a text
+   triangle, an edge list and a CMTX binary triangle, as contactSim does,
+   and checks that contactMat reads each back to the same matrix.
+   Population sizes cover partial bytes at the end of the triangle, and
+   densities cover runs of empty bytes.  Truncated and mismatched binary
+   files must be rejected.  Each of contactSim's models must give no
+   edges for p = 0, or for p too small to skip by, and every pair in
+   range for p = 1. */
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <gsl/gsl_rng.h>
+
+#include "contactMatrix.h"
+#include "networkGen.hpp"
+
+using namespace std;
+
+void writeText(ofstream& outFile, const int N, const vector<Edge>& edges)
+{
+  vector<Edge>::const_iterator edge = edges.begin();
+  string row;
+  for(int i=0; i < N; ++i) {
+    row.assign(i,'0');
+    for(; edge != edges.end() && edge->first == i; ++edge)
+      row[edge->second] = '1';
+    outFile << row << "1\n";
+  }
+}
+
+void writeEdges(ofstream& outFile, const int N, const vector<Edge>& edges)
+{
+  outFile << "# " << N << " individuals, " << edges.size() << " edges\n";
+  for(vector<Edge>::const_iterator edge = edges.begin(); edge != edges.end(); ++edge)
+    outFile << edge->first << " " << edge->second << "\n";
+}
+
+void writeBinary(ofstream& outFile, const int N, const vector<Edge>& edges,
+                 const unsigned long long headerN, const bool truncate)
+{
+  outFile.write(CONTACTMAT_MAGIC,CONTACTMAT_MAGIC_LEN);
+  for(int k=0; k < 8; ++k) outFile.put((char)((headerN >> (8*k)) & 0xff));
+
+  unsigned long long numBytes = ((unsigned long long)N*(N-1)/2 + 7) / 8;
+  if(truncate) --numBytes;
+  vector<unsigned char> bytes(numBytes + 1, 0x00);
+  for(vector<Edge>::const_iterator edge = edges.begin(); edge != edges.end(); ++edge) {
+    unsigned long long k = (unsigned long long)edge->first*(edge->first-1)/2 + edge->second;
+    bytes[k/8] |= 0x80 >> (k%8);
+  }
+  outFile.write((const char*)&bytes[0],numBytes);
+}
+
+int check(const char* filename, const int N, const vector<Edge>& edges)
+{
+  // Returns the number of pairs that differ from edges
+
+  contactMat mat;
+  if(mat.init(filename,N) != 0) {
+    cerr << "Could not read '" << filename << "'" << endl;
+    return 1;
+  }
+
+  vector<vector<char> > expected(N, vector<char>(N,0));
+  for(int i=0; i < N; ++i) expected[i][i] = 1;
+  for(size_t k=0; k < edges.size(); ++k) {
+    expected[edges[k].first][edges[k].second] = 1;
+    expected[edges[k].second][edges[k].first] = 1;
+  }
+
+  int numFailed = 0;
+  vector<int> conns;
+  for(int i=0; i < N; ++i) {
+    size_t degree = 0;
+    for(int j=0; j < N; ++j) {
+      if(mat.isConn(i,j) != (float)expected[i][j]) ++numFailed;
+      degree += expected[i][j];
+    }
+    if(mat.connections(i,conns) != degree) ++numFailed;
+  }
+
+  if(numFailed > 0)
+    cerr << "'" << filename << "' (" << N << " individuals): " << numFailed << " differences" << endl;
+  return numFailed;
+}
+
+int checkGenerated(const char* model, const int N, const vector<Edge>& edges,
+                   const size_t expected)
+{
+  // Returns the number of edges out of range or repeated, plus one if
+  // the count is not expected
+
+  int numFailed = 0;
+  set<Edge> seen;
+  for(size_t k=0; k < edges.size(); ++k) {
+    const Edge& e = edges[k];
+    if(e.second < 0 || e.first <= e.second || e.first >= N || !seen.insert(e).second)
+      ++numFailed;
+  }
+  if(edges.size() != expected) ++numFailed;
+  if(numFailed > 0)
+    cerr << model << " model: " << edges.size() << " edges, expected " << expected
+         << ", " << numFailed << " failures" << endl;
+  return numFailed;
+}
+
+int checkGenerators(gsl_rng* rng)
+{
+  // p = 0, p small enough that log(1-p) rounds to 0, and p = 1
+
+  const int N = 150;
+  const double cutoff = 3.0;
+  vector<double> weights(N, 2.0), x(N), y(N);
+  for(int i=0; i < N; ++i) {
+    x[i] = 20 * gsl_rng_uniform(rng);
+    y[i] = 20 * gsl_rng_uniform(rng);
+  }
+  size_t allPairs = N*(N-1)/2, nearPairs = 0;
+  for(int i=1; i < N; ++i)
+    for(int j=0; j < i; ++j)
+      if(hypot(x[i]-x[j], y[i]-y[j]) < cutoff) ++nearPairs;
+
+  int numFailed = 0;
+  const double ps[] = { 0.0, 1e-300, 1.0 };
+  vector<Edge> edges;
+  for(size_t k=0; k < sizeof(ps)/sizeof(double); ++k) {
+    bool all = ps[k] == 1.0;
+    edges.clear();
+    simER(N, ps[k], rng, edges);
+    numFailed += checkGenerated("er", N, edges, all ? allPairs : 0);
+    edges.clear();
+    simDegree(N, ps[k], weights, rng, edges);
+    numFailed += checkGenerated("degree", N, edges, all ? allPairs : 0);
+    edges.clear();
+    simSpatial(N, ps[k], x, y, 1e300, cutoff, rng, edges); // No thinning by distance
+    numFailed += checkGenerated("spatial", N, edges, all ? nearPairs : 0);
+  }
+  return numFailed;
+}
+
+int main(int argc, char* argv[])
+{
+  gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, 1);
+
+  const int sizes[] = { 2, 8, 9, 17, 200 };
+  const double densities[] = { 0.0, 0.005, 0.3, 1.0 };
+  const char* textFile = "testContactMatrix.txt";
+  const char* edgeFile = "testContactMatrix.edges";
+  const char* binaryFile = "testContactMatrix.ctb";
+
+  int numFailed = 0;
+  vector<Edge> edges;
+  for(size_t s=0; s < sizeof(sizes)/sizeof(int); ++s) {
+    for(size_t d=0; d < sizeof(densities)/sizeof(double); ++d) {
+      int N = sizes[s];
+      edges.clear();
+      simER(N, densities[d], rng, edges);
+
+      ofstream text(textFile), edgeList(edgeFile), binary(binaryFile, ios::out | ios::binary);
+      writeText(text, N, edges);
+      writeEdges(edgeList, N, edges);
+      writeBinary(binary, N, edges, N, false);
+      text.close(); edgeList.close(); binary.close();
+
+      numFailed += check(textFile, N, edges);
+      numFailed += check(edgeFile, N, edges);
+      numFailed += check(binaryFile, N, edges);
+    }
+  }
+
+  // Malformed binary files
+  int N = 200;
+  edges.clear();
+  simER(N, 0.3, rng, edges);
+  contactMat truncated, mismatched;
+  ofstream binary(binaryFile, ios::out | ios::binary);
+  writeBinary(binary, N, edges, N, true);
+  binary.close();
+  if(truncated.init(binaryFile, N) == 0) {
+    cerr << "Truncated binary file accepted" << endl;
+    ++numFailed;
+  }
+  binary.open(binaryFile, ios::out | ios::binary);
+  writeBinary(binary, N, edges, N+1, false);
+  binary.close();
+  if(mismatched.init(binaryFile, N) == 0) {
+    cerr << "Binary file for another population size accepted" << endl;
+    ++numFailed;
+  }
+
+  numFailed += checkGenerators(rng);
+
+  remove(textFile);
+  remove(edgeFile);
+  remove(binaryFile);
+  gsl_rng_free(rng);
+
+  cout << numFailed << " differences" << endl;
+  return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,127 @@
+/* ./src/test/testEventTrace.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Records events from several OpenMP threads into an EventTrace with
+   small buffers, so that the rings wrap and threads wait for the
+   writer, then reads the file back with EventTraceReader.  Every
+   record must come back intact, and each thread's records in the
+   order it made them.  Records from threads beyond those the trace was
+   sized for must be dropped and reported by flush(). */
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <omp.h>
+
+#include "EventTrace.hpp"
+
+using namespace std;
+
+#define NUMRECORDS 10000 // Per thread
+
+bool expected(const TraceRecord& rec, const int thread, const size_t k)
+{
+  return rec.time == 0.5 * k && rec.hFunc == thread + 1e-3 * k &&
+    rec.sender == (uint32_t) thread && rec.receiver == k &&
+    rec.run == (uint32_t) (k / 1000) && rec.thread == thread &&
+    rec.event == k % 4 && rec.type == k % 7;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* filename = "testEventTrace.trace";
+  int numFailed = 0;
+  int numThreads = 0;
+
+  try {
+    omp_set_dynamic(0);
+    omp_set_num_threads(4);
+    EventTrace trace(filename, 64, 2);
+
+#pragma omp parallel
+    {
+#pragma omp single
+      numThreads = omp_get_num_threads();
+      int thread = omp_get_thread_num();
+      for(size_t k=0; k < NUMRECORDS; ++k)
+        trace.record((EventTrace::event_e) (k % 4), thread, k, k % 7, 0.5 * k,
+                     thread + 1e-3 * k, k / 1000);
+    }
+
+    trace.close();
+    if(trace.numRecords() != (size_t) numThreads * NUMRECORDS) {
+      cerr << "Trace wrote " << trace.numRecords() << " records" << endl;
+      ++numFailed;
+    }
+  }
+  catch(exception& e) {
+    cerr << "Writing trace failed: " << e.what() << endl;
+    return 1;
+  }
+
+  if(!EventTraceReader::isTrace(filename)) {
+    cerr << "Trace file not recognised" << endl;
+    ++numFailed;
+  }
+
+  vector<size_t> next(numThreads, 0);
+  try {
+    EventTraceReader reader(filename);
+    TraceRecord rec;
+    while(reader.next(rec)) {
+      if(rec.thread >= numThreads || !expected(rec, rec.thread, next[rec.thread])) {
+        ++numFailed;
+        continue;
+      }
+      ++next[rec.thread];
+    }
+  }
+  catch(exception& e) {
+    cerr << "Reading trace failed: " << e.what() << endl;
+    return 1;
+  }
+  for(int t=0; t < numThreads; ++t)
+    if(next[t] != NUMRECORDS) {
+      cerr << "Thread " << t << ": read " << next[t] << " records in order" << endl;
+      ++numFailed;
+    }
+
+  // More threads than the trace was sized for
+  {
+    EventTrace trace(filename, 64, 2);
+    omp_set_num_threads(omp_get_num_procs() + omp_get_max_threads() + 1);
+#pragma omp parallel
+    trace.record(EventTrace::CONTACT, omp_get_thread_num(), 0, 0, 0.0, 0.0);
+    try {
+      trace.flush();
+      cerr << "Dropped records not reported" << endl;
+      ++numFailed;
+    }
+    catch(logic_error& e) {
+    }
+    trace.close();
+  }
+
+  remove(filename);
+
+  cout << numThreads << " threads, " << numFailed << " failures" << endl;
+  return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+/* ./src/test/testModelTraits.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks PairRates against the pair rates it replaced, on random
+   networks from a fixed seed: the utils' beta_ij (R_iCalc, R2_calc and
+   prCalc), which has no contact tracing multiplier, and the simulator's
+   betaij, which scales the feed mill and slaughterhouse rates by 10.
+   The spatial model must give the spatial rates alone. */
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <gsl/gsl_rng.h>
+
+#include "contactMatrix.h"
+#include "SpatialKernel.hpp"
+#include "ModelTraits.hpp"
+
+using namespace std;
+
+#define POPSIZE 200
+#define EDGEPROB 0.05
+
+struct Frequencies
+{
+  float fm, fm_N, sh, sh_N;
+};
+
+struct TestNetwork
+{
+  contactMat fm_Mat, sh_Mat, cp_Mat;
+  vector<Frequencies> cFreq;
+};
+
+int writeNetwork(const char* filename, gsl_rng* rng)
+{
+  // Random edge list for contactMat
+  ofstream file(filename);
+  if(!file.is_open()) return -1;
+  for(int i=1; i < POPSIZE; ++i)
+    for(int j=0; j < i; ++j)
+      if(gsl_rng_uniform(rng) < EDGEPROB) file << i << " " << j << "\n";
+  return 0;
+}
+
+bool nearlyEqual(const double a, const double b)
+{
+  return fabs(a - b) <= 1e-12 * fabs(b);
+}
+
+int main(int argc, char* argv[])
+{
+  gsl_rng* rng = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, 1);
+
+  // Networks
+  const char* files[3] = { "testModelTraits.fm", "testModelTraits.sh", "testModelTraits.cp" };
+  TestNetwork net;
+  contactMat* mats[3] = { &net.fm_Mat, &net.sh_Mat, &net.cp_Mat };
+  for(int k=0; k < 3; ++k) {
+    if(writeNetwork(files[k], rng) != 0 || mats[k]->init(files[k], POPSIZE) != 0) {
+      cerr << "Could not create network '" << files[k] << "'" << endl;
+      return 1;
+    }
+    remove(files[k]);
+  }
+
+  net.cFreq.resize(POPSIZE);
+  for(int j=0; j < POPSIZE; ++j) {
+    net.cFreq[j].fm = gsl_rng_uniform(rng);
+    net.cFreq[j].fm_N = 1 + gsl_rng_uniform_int(rng, 5);
+    net.cFreq[j].sh = gsl_rng_uniform(rng);
+    net.cFreq[j].sh_N = 1 + gsl_rng_uniform_int(rng, 5);
+  }
+
+  // Spatial kernel over random locations
+  vector<float> dist(POPSIZE*POPSIZE);
+  vector<double> x(POPSIZE), y(POPSIZE);
+  for(int i=0; i < POPSIZE; ++i) {
+    x[i] = 20 * gsl_rng_uniform(rng);
+    y[i] = 20 * gsl_rng_uniform(rng);
+  }
+  for(int i=0; i < POPSIZE; ++i)
+    for(int j=0; j < POPSIZE; ++j)
+      dist[i + POPSIZE*j] = hypot(x[i]-x[j], y[i]-y[j]);
+
+  vector<double> parms(ModelTraits::numParms);
+  for(size_t k=0; k < parms.size(); ++k) parms[k] = gsl_rng_uniform_pos(rng);
+
+  SpatialKernel kernel;
+  kernel.setDistances(&dist[0], POPSIZE);
+  kernel.prepare(parms[AIModelTraits::RHO]);
+
+  size_t numFailed = 0;
+  for(int i=0; i < POPSIZE; ++i) {
+    for(int j=0; j < POPSIZE; ++j) {
+      if(i == j) continue;
+      Frequencies& fq = net.cFreq[j];
+      double spatialI = parms[4] * kernel.at(i, j, parms[6]);
+      double spatialN = parms[5] * kernel.at(i, j, parms[6]);
+
+      // Utils' beta_ij network terms, before PairRates
+      double utils = parms[1] * net.fm_Mat.isConn(i,j) * (0.5 * fq.fm * (3 / fq.fm_N));
+      utils += parms[2] * net.sh_Mat.isConn(i,j) * (0.5 * fq.sh * (3 / fq.sh_N));
+      utils += parms[3] * net.cp_Mat.isConn(i,j);
+      double utilsNew = parms[AIModelTraits::BETA_FM] * AIPairRates::fmContact(net, i, j);
+      utilsNew += parms[AIModelTraits::BETA_SH] * AIPairRates::shContact(net, i, j);
+      utilsNew += AIPairRates::company(&parms[0], net, i, j);
+      if(utilsNew != utils) {
+        cerr << "Utils rate " << i << "->" << j << ": " << utilsNew << " != " << utils << endl;
+        ++numFailed;
+      }
+
+      // Simulator's betaij, before PairRates
+      double sim = net.fm_Mat.isConn(i,j) * 10 * (0.5 * fq.fm * (3 / fq.fm_N));
+      sim += net.sh_Mat.isConn(i,j) * 10 * (0.5 * fq.sh * (3 / fq.sh_N));
+      sim += parms[3] * net.cp_Mat.isConn(i,j);
+      sim += spatialI;
+      double simNew = AIPairRates::infected(&parms[0], net, kernel, i, j, 10.0, 10.0);
+      if(!nearlyEqual(simNew, sim)) {
+        cerr << "Simulator rate " << i << "->" << j << ": " << simNew << " != " << sim << endl;
+        ++numFailed;
+      }
+
+      // Notified, and the spatial model
+      if(AIPairRates::notified(&parms[0], kernel, i, j) != spatialN ||
+         SpatialPairRates::notified(&parms[0], kernel, i, j) != spatialN ||
+         SpatialPairRates::infected(&parms[0], net, kernel, i, j, 10.0, 10.0) != spatialI) {
+        cerr << "Spatial rate " << i << "->" << j << " differs" << endl;
+        ++numFailed;
+      }
+    }
+  }
+
+  gsl_rng_free(rng);
+
+  cout << numFailed << " pair rates differ" << endl;
+  return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+/* ./src/test/testParallelMoves.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Writes a small epidemic from a fixed seed, in clusters of premises
+   that only connect within their cluster, so that moves in different
+   clusters are independent.  Runs parallelMoveSweep with the infection
+   times moved in independent batches on several threads, and again
+   with one move at a time, from the same start.  Both chains must give
+   the same posterior mean total infectious period, to within four
+   batch means standard errors, and the likelihood components tracked
+   by each chain must match a recomputation at the end. */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <gsl/gsl_rng.h>
+#include <gsl/gsl_randist.h>
+#include <omp.h>
+
+#include "aifuncs.h"
+#include "CTStreamWriter.hpp"
+
+using namespace std;
+
+#define NUMPARMS ModelTraits::numParms  // See ModelTraits.hpp
+#define NUMSPECIES ModelTraits::numSpecies
+
+#define NUMCLUSTERS 8
+#define CLUSTERSIZE 12
+#define POPSIZE (NUMCLUSTERS * CLUSTERSIZE)
+#define INFECPERCLUSTER 4
+#define CLUSTERSIDE 5.0 // km
+#define BURNIN 500      // Sweeps
+#define NUMSWEEPS 20000
+#define NUMBATCHES 50
+
+// Globals required by aifuncs and random.cpp
+int total_pop_size;
+double ObsTime;
+McmcProfiler profiler;
+gsl_rng* rng;
+
+// Parameter values as in aiGillespieConfTemplate.xml, with the network
+// rates scaled down so that moves are often accepted
+static const double testParms[NUMPARMS] =
+  { 1e-6, 0.02, 0.015, 0.0002, 0.018, 0.0074, 0.2, 0.6, 0.3, 0.3, 0.3, 0.3, 0.3,
+    0.3, 0.3, 0.3 };
+
+static const char* prefix = "testParallelMoves";
+static const char* suffixes[] = { ".fm", ".sh", ".cp", ".freq", ".sp", "_dist.txt",
+                                  ".ipt", ".dc", ".ni", ".contact.xml" };
+static const char* networkType[3] = { "feedmill", "shouse", "company" };
+
+struct ChainSummary
+{
+  double mean, se;
+  int accepted;
+};
+
+void writeData(gsl_rng* r)
+{
+  // Premises in NUMCLUSTERS squares, with distances and network edges
+  // only within a square.  Each square has INFECPERCLUSTER known
+  // infections, each after the one before, and contacts traced from
+  // the one before.
+
+  string p(prefix);
+  ofstream fm((p + ".fm").c_str()), sh((p + ".sh").c_str()), cp((p + ".cp").c_str());
+  ofstream freq((p + ".freq").c_str()), sp((p + ".sp").c_str());
+  ofstream dist((p + "_dist.txt").c_str()), ipt((p + ".ipt").c_str());
+  ofstream dc((p + ".dc").c_str()), ni((p + ".ni").c_str());
+  if(!fm.is_open() || !sh.is_open() || !cp.is_open() || !freq.is_open() || !sp.is_open() ||
+     !dist.is_open() || !ipt.is_open() || !dc.is_open() || !ni.is_open())
+    throw runtime_error("Cannot open data files");
+  ofstream* nets[3] = { &fm, &sh, &cp };
+  ipt.precision(9);
+
+  vector<double> x(POPSIZE), y(POPSIZE);
+  for(int i=0; i < POPSIZE; ++i) {
+    x[i] = CLUSTERSIDE * gsl_rng_uniform(r);
+    y[i] = CLUSTERSIDE * gsl_rng_uniform(r);
+    freq << gsl_ran_gamma(r, 2.0, 0.5) << " " << gsl_ran_gamma(r, 2.0, 0.5) << " "
+         << gsl_ran_gamma(r, 2.0, 0.5) << " " << gsl_ran_gamma(r, 2.0, 0.5) << "\n";
+    string species(NUMSPECIES, '0');
+    species[gsl_rng_uniform_int(r, NUMSPECIES)] = '1';
+    sp << species << "\n";
+  }
+
+  for(int i=0; i < POPSIZE; ++i)
+    for(int j=0; j < POPSIZE; ++j) {
+      if(i == j || i / CLUSTERSIZE != j / CLUSTERSIZE) continue;
+      dist << i << " " << j << " " << hypot(x[i]-x[j], y[i]-y[j]) << "\n";
+      if(j < i)
+        for(int net=0; net < 3; ++net)
+          if(gsl_rng_uniform(r) < 0.2) *nets[net] << i << " " << j << "\n";
+    }
+
+  CTStreamWriter ct(p + ".contact.xml", CTStreamWriter::XMLFORMAT);
+  unsigned char typeCode[3];
+  for(int net=0; net < 3; ++net) typeCode[net] = ct.typeCode(networkType[net]);
+
+  double obsTime = 0.0;
+  vector<double> N(POPSIZE, 0.0);
+  for(int c=0; c < NUMCLUSTERS; ++c) {
+    int parent = -1;
+    double I = 5.0 * gsl_rng_uniform(r);
+    for(int k=0; k < INFECPERCLUSTER; ++k) {
+      int label = c * CLUSTERSIZE + k;
+      N[label] = I + 4.0 + gsl_ran_exponential(r, 3.0);
+      ipt << label << " " << I << " " << N[label] << " " << N[label] + 1.0 << "\n";
+      if(obsTime < N[label] + 1.0) obsTime = N[label] + 1.0;
+
+      vector<CTRecord> block;
+      if(parent >= 0)
+        block.push_back(CTRecord(parent, true, typeCode[gsl_rng_uniform_int(r, 3)], I, true));
+      for(int other = c * CLUSTERSIZE + INFECPERCLUSTER; other < (c+1) * CLUSTERSIZE; ++other)
+        if(gsl_rng_uniform(r) < 0.3)
+          block.push_back(CTRecord(other, false, typeCode[gsl_rng_uniform_int(r, 3)],
+                                   N[label] - 21.0 * gsl_rng_uniform_pos(r)));
+      sort(block.begin(), block.end());
+      ct.writeBlock(label, N[label] - 21.0, block);
+
+      parent = label;
+      I += gsl_rng_uniform_pos(r) * (N[label] - I);
+    }
+  }
+  ct.close();
+  ObsTime = obsTime;
+}
+
+bool nearlyEqual(const double a, const double b)
+{
+  return fabs(a - b) <= 1e-6 * (1.0 + fabs(b));
+}
+
+int runChain(const bool serial, const unsigned long seed, ChainSummary& summary)
+{
+  // Returns the number of failed checks: likelihood components that
+  // differ from a recomputation at the end of the chain, and for the
+  // parallel chain, no independent moves to batch
+
+  string p(prefix), distFile = p + "_dist.txt";
+  sinrEpi epidata;
+  if(epidata.init(POPSIZE, prefix, prefix, distFile.c_str(), NUMSPECIES, ObsTime) != 0)
+    throw runtime_error("Cannot initialise data");
+
+  epiParms parms(NUMPARMS);
+  for(size_t k=0; k < NUMPARMS; ++k) parms.beta[k] = testParms[k];
+  parms.f = 60.0;
+  parms.g = 1.3;
+  epiPriors priors(NUMPARMS);
+  priors.a = 0.1;
+  priors.b = 0.3;
+
+  initSpatialKernel(epidata, SpatialKernel::EXPONENTIAL);
+  prepareSpatialKernel(parms);
+  prepareSusceptibility(parms, epidata);
+  initConnections(parms, epidata);
+  initContactCache(epidata);
+  initInfecKernel(parms, 1e-10, false);
+  OccultGraph graph;
+  initOccultGraph(epidata, graph);
+  epidata.updateI1();
+
+  vector<double> prodCurr(epidata.infected.size());
+  double logProd = compute_log_prod_pressure(parms, epidata, &prodCurr);
+  double bgPress = compute_bgPress(parms, epidata);
+  double A1 = compute_A1(parms, epidata);
+  double A2 = compute_A2(parms, epidata);
+  double logCT = computeLogCT(parms, epidata);
+
+  gsl_rng_set(rng, seed);
+  vector<double> batches(NUMBATCHES, 0.0);
+  summary.accepted = 0;
+  for(int sweep = -BURNIN; sweep < NUMSWEEPS; ++sweep) {
+    int accepted = parallelMoveSweep(parms, priors, epidata, rng, graph, prodCurr,
+                                     logProd, bgPress, A1, A2, logCT, serial);
+    if(sweep < 0) continue;
+    summary.accepted += accepted;
+    double period = 0.0;
+    for(size_t k=0; k < epidata.infected.size(); ++k)
+      period += epidata.infected[k]->N - epidata.infected[k]->I;
+    batches[sweep / (NUMSWEEPS / NUMBATCHES)] += period / (NUMSWEEPS / NUMBATCHES);
+  }
+
+  double sum = 0.0, sumSq = 0.0;
+  for(int b=0; b < NUMBATCHES; ++b) {
+    sum += batches[b];
+    sumSq += batches[b] * batches[b];
+  }
+  summary.mean = sum / NUMBATCHES;
+  summary.se = sqrt((sumSq / NUMBATCHES - summary.mean * summary.mean) / (NUMBATCHES - 1));
+
+  int numFailed = 0;
+  vector<double> prodCheck(epidata.infected.size());
+  const char* names[5] = { "logProd", "bgPress", "A1", "A2", "logCT" };
+  double tracked[5] = { logProd, bgPress, A1, A2, logCT };
+  double computed[5] = { compute_log_prod_pressure(parms, epidata, &prodCheck),
+                         compute_bgPress(parms, epidata), compute_A1(parms, epidata),
+                         compute_A2(parms, epidata), computeLogCT(parms, epidata) };
+  for(int k=0; k < 5; ++k)
+    if(!nearlyEqual(tracked[k], computed[k])) {
+      cerr << (serial ? "Serial" : "Parallel") << " chain " << names[k] << " " << tracked[k]
+           << " != " << computed[k] << endl;
+      ++numFailed;
+    }
+
+  // The parallel sweep must have had independent moves to batch
+  if(!serial) {
+    indexInfecteds(epidata, graph);
+    vector<int> movers;
+    vector<double> spanLo(epidata.infected.size());
+    for(size_t k=0; k < epidata.infected.size(); ++k) {
+      spanLo[k] = epidata.infected[k]->I;
+      if(k != epidata.I1) movers.push_back(k);
+    }
+    vector< vector<int> > classes;
+    colourMoves(epidata, graph, movers, spanLo, classes);
+    if(classes.size() >= movers.size()) {
+      cerr << "No independent moves: " << classes.size() << " classes for "
+           << movers.size() << " moves" << endl;
+      ++numFailed;
+    }
+  }
+
+  return numFailed;
+}
+
+int main(int argc, char* argv[])
+{
+  rng = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(rng, 1);
+  total_pop_size = POPSIZE;
+
+  int numFailed = 0;
+  ChainSummary parallel, serial;
+  try {
+    writeData(rng);
+    omp_set_dynamic(0);
+    omp_set_num_threads(4);
+    numFailed += runChain(false, 2, parallel);
+    numFailed += runChain(true, 3, serial);
+  }
+  catch(exception& e) {
+    cerr << "Running chains failed: " << e.what() << endl;
+    numFailed = -1;
+  }
+
+  for(size_t k=0; k < sizeof(suffixes)/sizeof(char*); ++k)
+    remove((string(prefix) + suffixes[k]).c_str());
+  gsl_rng_free(rng);
+  if(numFailed < 0) return 1;
+
+  double diff = parallel.mean - serial.mean;
+  double se = sqrt(parallel.se * parallel.se + serial.se * serial.se);
+  cout << "Mean total infectious period: parallel " << parallel.mean << " (" << parallel.se
+       << "), serial " << serial.mean << " (" << serial.se << ")" << endl;
+  cout << "Accepted moves: parallel " << parallel.accepted << ", serial "
+       << serial.accepted << endl;
+  if(fabs(diff) > 4 * se) {
+    cerr << "Posterior means differ by " << diff / se << " standard errors" << endl;
+    ++numFailed;
+  }
+
+  cout << numFailed << " failures" << endl;
+  return numFailed == 0 ? 0 : 1;
+}
@@ -50,6 +50,7 @@
 // Local includes
 #include "epiCovars.h"
 #include "speciesMat.h"
+#include "ModelTraits.hpp"
 
 // MPI
 #ifdef __MPI__
@@ -58,6 +59,8 @@
 
 using namespace std;
 
+typedef PairRates<ModelTraits> Rates;
+
 ///////////// Lapack definitions \\\\\\\\\\\\\\\\
 
 extern "C" {
@@ -415,17 +418,17 @@ inline double EpiMath::beta_ij(const int& i, const int& j, const vector<double>&
 
   double beta;
 
-  beta = parms.at(1) * epidata.fm_Mat.isConn(i,j) * (0.5 * epidata.cFreq[j].fm * ( 3 / epidata.cFreq[j].fm_N ) );
+  beta = parms.at(ModelTraits::BETA_FM) * Rates::fmContact(epidata,i,j);
 
-  beta += parms.at(2) * epidata.sh_Mat.isConn(i,j) * (0.5 * epidata.cFreq[j].sh * (3 / epidata.cFreq[j].sh_N) );
+  beta += parms.at(ModelTraits::BETA_SH) * Rates::shContact(epidata,i,j);
 
-  beta += parms.at(3) * epidata.cp_Mat.isConn(i,j);
+  beta += Rates::company(&parms[0],epidata,i,j);
 
-  beta += parms.at(4) * exp(-parms.at(6) * (epidata.dist(i,j) - 5) ); 
+  beta += parms.at(ModelTraits::BETA_SPATIAL_I) * exp(-parms.at(ModelTraits::RHO) * (epidata.dist(i,j) - 5) ); 
 
-  for(size_t k=7;k<16;++k) {
-    if(epidata.species.at(j,k-7) == 1) {
-      beta *= parms.at(k);
+  for(size_t k=0;k<ModelTraits::numSpecies;++k) {
+    if(epidata.species.at(j,k) == 1) {
+      beta *= parms.at(ModelTraits::SPECIES+k);
       break;
     }
   }
@@ -15,46 +15,198 @@
  * GNU General Public License for more details.
  *
  * You should have received a copy of the GNU General Public License
- * along with InFER.  If not, see <http://www.gnu.org/licenses/>. 
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* Simulates a random contact network for contactMat.  Edges are found
+   by skipping a geometric number of pairs between them, so the time
+   taken grows with the number of edges rather than pairs.  Models are
+
+     er:      each pair connected with probability p
+     degree:  i and j connected with probability min(1, p w_i w_j / wbar^2)
+              for weights w read from a file (Chung-Lu)
+     spatial: i and j connected with probability p exp(-d_ij / scale) if
+              d_ij < cutoff, for coordinates read from a file
+
+   and output is a text lower triangle, an edge list or bit-packed binary
+   (see contactMatrix.h). */
+
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 #include <math.h>
 
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+
+#include "contactMatrix.h"
+#include "networkGen.hpp"
+
 using namespace std;
 
+void writeText(ofstream& outFile, const int N, const vector<Edge>& edges) {
+  vector<Edge>::const_iterator edge = edges.begin();
+  string row;
+  for(int i=0; i < N; ++i) {
+    row.assign(i,'0');
+    for(; edge != edges.end() && edge->first == i; ++edge)
+      row[edge->second] = '1';
+    outFile << row << "1\n";
+  }
+}
+
+void writeEdges(ofstream& outFile, const int N, const vector<Edge>& edges) {
+  outFile << "# " << N << " individuals, " << edges.size() << " edges\n";
+  for(vector<Edge>::const_iterator edge = edges.begin(); edge != edges.end(); ++edge)
+    outFile << edge->first << " " << edge->second << "\n";
+}
+
+void writeBinary(ofstream& outFile, const int N, const vector<Edge>& edges) {
+  outFile.write(CONTACTMAT_MAGIC,CONTACTMAT_MAGIC_LEN);
+  unsigned long long size = N;
+  for(int k=0; k < 8; ++k) outFile.put((char)((size >> (8*k)) & 0xff));
+
+  unsigned long long numBytes = ((unsigned long long)N*(N-1)/2 + 7) / 8;
+  unsigned long long byte = 0;
+  unsigned char bits = 0x00;
+  for(vector<Edge>::const_iterator edge = edges.begin(); edge != edges.end(); ++edge) {
+    unsigned long long k = (unsigned long long)edge->first*(edge->first-1)/2 + edge->second;
+    for(; byte < k/8; ++byte) {
+      outFile.put(bits);
+      bits = 0x00;
+    }
+    bits |= 0x80 >> (k%8);
+  }
+  for(; byte < numBytes; ++byte) {
+    outFile.put(bits);
+    bits = 0x00;
+  }
+}
+
+int readColumns(const string& filename, const int N, const int numCols,
+                vector<double>& col1, vector<double>& col2) {
+  ifstream inFile(filename.c_str());
+  if(!inFile.is_open()) {
+    cerr << "Could not open '" << filename << "'" << endl;
+    return(-1);
+  }
+  double a, b;
+  while(inFile >> a) {
+    col1.push_back(a);
+    if(numCols == 2) {
+      if(!(inFile >> b)) break;
+      col2.push_back(b);
+    }
+  }
+  if(col1.size() != (size_t)N || (numCols == 2 && col2.size() != (size_t)N)) {
+    cerr << "Expected " << N << " rows in '" << filename << "'" << endl;
+    return(-1);
+  }
+  return(0);
+}
+
 int main(int argc, char *argv[]) {
 
-  int N_total = atoi(argv[1]);
-  float p = atof(argv[2]);
-  char *outFile_name = argv[3];
+  int N_total;
+  double p;
+  string outFile_name, model, format, weightsFile, coordsFile;
+  double scale, cutoff;
 
-  gsl_rng *rng = gsl_rng_alloc(gsl_rng_ranlux);
+  gsl_rng *rng = gsl_rng_alloc(gsl_rng_mt19937);
+
+  try {
+    po::options_description desc("Allowed options");
+    desc.add_options()("help,h", "Show help message")
+                      ("popsize", po::value<int>(&N_total)->required(), "number of individuals")
+                      ("p", po::value<double>(&p)->required(), "edge probability")
+                      ("output", po::value<string>(&outFile_name)->required(), "output file")
+                      ("model,m", po::value<string>(&model)->default_value("er"), "er, degree or spatial")
+                      ("format,f", po::value<string>(&format)->default_value("text"), "text, edges or binary")
+                      ("seed,s", po::value<int>(), "random seed")
+                      ("weights,w", po::value<string>(&weightsFile), "weights, one per line (degree)")
+                      ("coords,x", po::value<string>(&coordsFile), "x y coordinates, one pair per line (spatial)")
+                      ("scale,r", po::value<double>(&scale)->default_value(1.0), "distance kernel scale (spatial)")
+                      ("cutoff,c", po::value<double>(&cutoff)->default_value(0.0), "maximum distance, default 5*scale (spatial)");
+
+    po::positional_options_description positional;
+    positional.add("popsize",1).add("p",1).add("output",1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc,argv).options(desc).positional(positional).run(),vm);
+
+    if(vm.count("help")) {
+      cout << "Usage: contactSim popsize p output [options]\n" << desc << "\n";
+      return(2);
+    }
+
+    po::notify(vm);
+
+    gsl_rng_set(rng, vm.count("seed") ? vm["seed"].as<int>() : 0);
+  }
+  catch(exception& e) {
+    cerr << "Exception: " << e.what() << "\n";
+    return(2);
+  }
+
+  if(N_total < 1 || p < 0.0 || p > 1.0) {
+    cerr << "Need popsize > 0 and 0 <= p <= 1" << endl;
+    return(-1);
+  }
+  if(cutoff <= 0.0) cutoff = 5.0 * scale;
+
+  vector<Edge> edges;
+  if(model == "er") {
+    simER(N_total,p,rng,edges);
+  }
+  else if(model == "degree") {
+    vector<double> weights, unused;
+    if(weightsFile.empty()) {
+      cerr << "The degree model needs a weights file" << endl;
+      return(-1);
+    }
+    if(readColumns(weightsFile,N_total,1,weights,unused) != 0) return(-1);
+    simDegree(N_total,p,weights,rng,edges);
+  }
+  else if(model == "spatial") {
+    vector<double> x, y;
+    if(coordsFile.empty()) {
+      cerr << "The spatial model needs a coordinates file" << endl;
+      return(-1);
+    }
+    if(readColumns(coordsFile,N_total,2,x,y) != 0) return(-1);
+    simSpatial(N_total,p,x,y,scale,cutoff,rng,edges);
+  }
+  else {
+    cerr << "Unknown model '" << model << "'" << endl;
+    return(-1);
+  }
+  sort(edges.begin(),edges.end());
 
   ofstream outFile;
 
-  outFile.open(outFile_name,ios::out);
+  outFile.open(outFile_name.c_str(),ios::out | ios::binary);
   if(!outFile.is_open()) {
     cout << "Could not open file for writing!" << endl;
     return(-1);
   }
 
-  for(int i=0; i < N_total; ++i) {
-    for(int j=0; j < i; ++j) {
-      if(gsl_rng_uniform(rng) < p) {
-	outFile << "1";
-      }
-      else {
-	outFile << "0";
-      }
-    }
-    outFile << "1\n";
+  if(format == "text") writeText(outFile,N_total,edges);
+  else if(format == "edges") writeEdges(outFile,N_total,edges);
+  else if(format == "binary") writeBinary(outFile,N_total,edges);
+  else {
+    cerr << "Unknown format '" << format << "'" << endl;
+    return(-1);
   }
 
   outFile.close();
 
+  cout << edges.size() << " edges between " << N_total << " individuals" << endl;
+
+  gsl_rng_free(rng);
+
   return(0);
 }
@@ -0,0 +1,125 @@
+/* ./src/utils/contactSim/networkGen.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <math.h>
+
+#include "networkGen.hpp"
+
+#define MAXSKIP (LLONG_MAX / 4) // Past any pair, without overflowing a sum
+
+// Number of pairs to pass over before the next edge
+inline long long skip(const gsl_rng* rng, const double logq) {
+  if(isinf(logq)) return 0; // p = 1
+  double gap = floor(log(gsl_rng_uniform_pos(rng)) / logq);
+  if(gap < 0.0 || !(gap < MAXSKIP)) return MAXSKIP; // p rounds to 0, so logq = 0
+  return (long long)gap;
+}
+
+inline Edge makeEdge(const int a, const int b) {
+  return a > b ? Edge(a,b) : Edge(b,a);
+}
+
+void simER(const int N, const double p, const gsl_rng* rng, vector<Edge>& edges) {
+  // Walks the lower triangle row by row (Batagelj & Brandes 2005)
+  if(p <= 0.0) return;
+  double logq = log(1.0 - p);
+  long long v = 1, w = -1;
+  while(v < N) {
+    w += 1 + skip(rng,logq);
+    while(w >= v && v < N) {
+      w -= v;
+      ++v;
+    }
+    if(v < N) edges.push_back(Edge(v,w));
+  }
+}
+
+void simDegree(const int N, const double p, const vector<double>& weights,
+               const gsl_rng* rng, vector<Edge>& edges) {
+  // Pairs in order of decreasing weight so that the probability only
+  // falls along a row, skipping with the current probability and
+  // thinning to the next (Miller & Hagberg 2011)
+  if(p <= 0.0) return;
+  vector<pair<double,int> > order(N);
+  double wbar = 0.0;
+  for(int i=0; i < N; ++i) {
+    order[i] = make_pair(-weights[i],i);
+    wbar += weights[i];
+  }
+  wbar /= N;
+  sort(order.begin(),order.end());
+  double c = p / (wbar*wbar);
+
+  for(int u=0; u < N-1; ++u) {
+    double wu = -order[u].first;
+    int v = u+1;
+    double pr = min(c * wu * -order[v].first, 1.0);
+    while(v < N && pr > 0.0) {
+      if(pr < 1.0) v = (int)min<long long>(v + skip(rng,log(1.0 - pr)),N);
+      if(v < N) {
+        double q = min(c * wu * -order[v].first, 1.0);
+        if(gsl_rng_uniform(rng) < q / pr)
+          edges.push_back(makeEdge(order[u].second,order[v].second));
+        pr = q;
+        ++v;
+      }
+    }
+  }
+}
+
+void simSpatial(const int N, const double p, const vector<double>& x,
+                const vector<double>& y, const double scale, const double cutoff,
+                const gsl_rng* rng, vector<Edge>& edges) {
+  // Candidates j < i are in the cells next to i's on a grid of side
+  // cutoff.  Skips run across the cells with probability p, and are
+  // thinned by the distance kernel.
+  if(p <= 0.0) return;
+  typedef map<pair<long,long>,vector<int> > Grid;
+  Grid grid;
+  vector<pair<long,long> > cell(N);
+  for(int i=0; i < N; ++i) {
+    cell[i] = make_pair((long)floor(x[i]/cutoff),(long)floor(y[i]/cutoff));
+    grid[cell[i]].push_back(i);
+  }
+
+  double logq = log(1.0 - p);
+  long long gap = skip(rng,logq);
+  for(int i=1; i < N; ++i) {
+    for(long dx=-1; dx <= 1; ++dx) {
+      for(long dy=-1; dy <= 1; ++dy) {
+        Grid::const_iterator it = grid.find(make_pair(cell[i].first+dx,cell[i].second+dy));
+        if(it == grid.end()) continue;
+        const vector<int>& members = it->second;
+        long long len = lower_bound(members.begin(),members.end(),i) - members.begin();
+        while(gap < len) {
+          int j = members[gap];
+          double d = hypot(x[i]-x[j],y[i]-y[j]);
+          if(d < cutoff && gsl_rng_uniform(rng) < exp(-d/scale))
+            edges.push_back(Edge(i,j));
+          gap += 1 + skip(rng,logq);
+        }
+        gap -= len;
+      }
+    }
+  }
+}
@@ -0,0 +1,43 @@
+/* ./src/utils/contactSim/networkGen.hpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Random network generators used by contactSim (see contactSim.cpp for
+   the models).  Each appends edges (i,j) with j < i, ordered by i then
+   j for simER, and gives no edges for p <= 0. */
+
+#ifndef INCLUDE_NETWORKGEN_HPP
+#define INCLUDE_NETWORKGEN_HPP
+
+#include <utility>
+#include <vector>
+#include <gsl/gsl_rng.h>
+
+using namespace std;
+
+typedef pair<int,int> Edge; // (i,j) with j < i
+
+void simER(const int N, const double p, const gsl_rng* rng, vector<Edge>& edges);
+void simDegree(const int N, const double p, const vector<double>& weights,
+               const gsl_rng* rng, vector<Edge>& edges);
+void simSpatial(const int N, const double p, const vector<double>& x,
+                const vector<double>& y, const double scale, const double cutoff,
+                const gsl_rng* rng, vector<Edge>& edges);
+
+#endif
@@ -0,0 +1,77 @@
+/* ./src/utils/traceDecode/traceDecode.cpp
+ *
+ * Copyright 2012 Chris Jewell <chrism0dwk@gmail.com>
+ *
+ * This file is part of InFER.
+ *
+ * InFER is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * InFER is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with InFER.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// traceDecode writes an EventTrace file as text or CSV on stdout,
+// optionally for a single run.  Records are in file order; sort on
+// run and time to follow transmission chains.
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+#include "EventTrace.hpp"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+
+  if(argc < 2 || argc > 4) {
+    cout << "Usage: traceDecode <trace file> [text|csv] [run]\n" << endl;
+    exit(-1);
+  }
+
+  bool csv = argc > 2 && strcmp(argv[2],"csv") == 0;
+  if(argc > 2 && !csv && strcmp(argv[2],"text") != 0) {
+    cerr << "Unknown format '" << argv[2] << "'" << endl;
+    exit(-1);
+  }
+  long run = argc > 3 ? atol(argv[3]) : -1;
+
+  const char* sep = csv ? "," : " ";
+  size_t numRecords = 0;
+
+  try {
+    EventTraceReader reader(argv[1]);
+    TraceRecord rec;
+
+    if(csv) printf("run,thread,time,event,sender,receiver,type,hfunc\n");
+
+    while(reader.next(rec)) {
+      if(run >= 0 && rec.run != (uint32_t)run) continue;
+
+      printf("%u%s%u%s%.9f%s%s%s", rec.run, sep, rec.thread, sep, rec.time, sep,
+             EventTrace::eventName(rec.event), sep);
+      if(rec.sender == EVENTTRACE_NONE) printf(csv ? "" : "-");
+      else printf("%u", rec.sender);
+      printf("%s%u%s%u%s%.6g\n", sep, rec.receiver, sep, rec.type, sep, rec.hFunc);
+      ++numRecords;
+    }
+  }
+  catch(exception& e) {
+    cerr << "Error reading trace: " << e.what() << endl;
+    exit(-1);
+  }
+
+  cerr << numRecords << " records" << endl;
+
+  return(0);
+}